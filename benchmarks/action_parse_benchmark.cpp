@@ -0,0 +1,103 @@
+// Parse-cost microbenchmark for inbound ACTION frames.
+//
+// Compares the DOM path the session used for every message
+// (extract_message_type_and_json + parse_action_from_envelope, which builds a
+// nlohmann::json tree and copies it into a message_envelope) with the
+// single-pass parse_action_fast scanner, on a FOLD and a RAISE frame, and
+// message-type dispatch through the perfect hash with the if-chain of string
+// comparisons it replaced.
+
+#include <benchmark/benchmark.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "common/protocol.hpp"
+
+namespace {
+
+using namespace cppsim::protocol;
+
+const std::string FOLD_FRAME =
+    R"({"message_type":"ACTION","protocol_version":"v1.0","payload":)"
+    R"({"session_id":"sess_00000001a3f29c4e","action_type":"FOLD","sequence_number":1042}})";
+const std::string RAISE_FRAME =
+    R"({"message_type":"ACTION","protocol_version":"v1.0","payload":)"
+    R"({"session_id":"sess_00000001a3f29c4e","action_type":"RAISE","amount":250000,"sequence_number":1043}})";
+
+const std::string& frame_for(const benchmark::State& state) {
+  return state.range(0) == 0 ? FOLD_FRAME : RAISE_FRAME;
+}
+
+void BM_ParseActionDom(benchmark::State& state) {
+  const std::string& frame = frame_for(state);
+  for (auto _ : state) {
+    auto header = extract_message_type_and_json(frame);
+    std::optional<action_message> action;
+    if (header && header->message_type == message_types::ACTION) {
+      action = parse_action_from_envelope(header->envelope_json);
+    }
+    if (!action) {
+      state.SkipWithError("DOM path rejected the frame");
+      break;
+    }
+    benchmark::DoNotOptimize(action->sequence_number);
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(frame.size()));
+}
+
+void BM_ParseActionFast(benchmark::State& state) {
+  const std::string& frame = frame_for(state);
+  // Reused across frames, as websocket_session does.
+  action_message action{};
+  for (auto _ : state) {
+    if (parse_action_fast(frame, action) != fast_parse_status::ok) {
+      state.SkipWithError("fast path did not accept the frame");
+      break;
+    }
+    benchmark::DoNotOptimize(action.sequence_number);
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(frame.size()));
+}
+
+// Every inbound type, plus one the server rejects.
+const std::vector<std::string> MESSAGE_TYPES = {message_types::ACTION, message_types::RELOAD_REQUEST,
+                                                message_types::DISCONNECT, message_types::STATE_ACK,
+                                                message_types::HANDSHAKE, "NOT_A_TYPE"};
+
+int dispatch_by_strings(const std::string& type) {
+  if (type == message_types::ACTION) return 1;
+  if (type == message_types::RELOAD_REQUEST) return 2;
+  if (type == message_types::DISCONNECT) return 3;
+  if (type == message_types::STATE_ACK) return 4;
+  if (type == message_types::HANDSHAKE) return 5;
+  return 0;
+}
+
+int dispatch_by_kind(const std::string& type) {
+  switch (lookup_message_kind(type)) {
+    case message_kind::action: return 1;
+    case message_kind::reload_request: return 2;
+    case message_kind::disconnect: return 3;
+    case message_kind::state_ack: return 4;
+    case message_kind::handshake: return 5;
+    default: return 0;
+  }
+}
+
+template <int (*Dispatch)(const std::string&)>
+void BM_DispatchMessageType(benchmark::State& state) {
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Dispatch(MESSAGE_TYPES[i]));
+    i = i + 1 == MESSAGE_TYPES.size() ? 0 : i + 1;
+  }
+}
+
+BENCHMARK(BM_ParseActionDom)->Arg(0)->Arg(1);
+BENCHMARK(BM_ParseActionFast)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_DispatchMessageType, dispatch_by_strings);
+BENCHMARK_TEMPLATE(BM_DispatchMessageType, dispatch_by_kind);
+
+}  // namespace
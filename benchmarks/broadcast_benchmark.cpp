@@ -0,0 +1,70 @@
+// Fan-out microbenchmark for broadcasting one serialized message.
+//
+// Queues the same STATE_UPDATE-sized payload on N session write queues, the
+// way a table broadcast does: once as a private std::string copy per session
+// (the old send(std::string) path) and once as a single shared_payload that
+// every queue references.
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "server/bounded_mpsc_queue.hpp"
+#include "server/outbound_message.hpp"
+
+namespace {
+
+using cppsim::server::bounded_mpsc_queue;
+using cppsim::server::make_shared_payload;
+using cppsim::server::outbound_message;
+
+constexpr size_t PAYLOAD_SIZE = 2048;
+
+std::vector<std::unique_ptr<bounded_mpsc_queue<outbound_message>>> make_queues(size_t n) {
+  std::vector<std::unique_ptr<bounded_mpsc_queue<outbound_message>>> queues;
+  queues.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    queues.push_back(std::make_unique<bounded_mpsc_queue<outbound_message>>(4));
+  }
+  return queues;
+}
+
+void drain(std::vector<std::unique_ptr<bounded_mpsc_queue<outbound_message>>>& queues) {
+  outbound_message out;
+  for (auto& q : queues) {
+    while (q->try_pop(out)) {
+      benchmark::DoNotOptimize(out.bytes().data());
+    }
+  }
+}
+
+void BM_BroadcastCopy(benchmark::State& state) {
+  auto queues = make_queues(static_cast<size_t>(state.range(0)));
+  const std::string payload(PAYLOAD_SIZE, 'x');
+  for (auto _ : state) {
+    for (auto& q : queues) {
+      benchmark::DoNotOptimize(q->try_push(outbound_message(std::string(payload))));
+    }
+    drain(queues);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_BroadcastShared(benchmark::State& state) {
+  auto queues = make_queues(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    auto shared = make_shared_payload(std::string(PAYLOAD_SIZE, 'x'));
+    for (auto& q : queues) {
+      benchmark::DoNotOptimize(q->try_push(outbound_message(shared)));
+    }
+    drain(queues);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_BroadcastCopy)->Arg(2)->Arg(6)->Arg(10);
+BENCHMARK(BM_BroadcastShared)->Arg(2)->Arg(6)->Arg(10);
+
+}  // namespace
@@ -0,0 +1,50 @@
+// Cost of producing one session log line on the calling thread.
+//
+// The "Validated ACTION" line, built the old way — operator+ over
+// format_session_id and std::to_string — and as a structured record that
+// stores the template ID and raw arguments and leaves formatting to the
+// sink.  Neither variant writes anywhere; only the caller's share is timed.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+
+#include "server/log_record.hpp"
+#include "server/session_handle.hpp"
+
+namespace {
+
+using cppsim::server::format_session_id;
+using cppsim::server::log_id;
+using cppsim::server::log_record_builder;
+using cppsim::server::log_session;
+using cppsim::server::session_handle;
+
+constexpr session_handle HANDLE = 0x00000042deadbeefULL;
+const std::string ACTION_TYPE = "RAISE";
+
+void BM_LogLineConcat(benchmark::State& state) {
+  int64_t seq = 0;
+  for (auto _ : state) {
+    std::string line = std::string("[WebSocketSession] Validated ACTION from ") + format_session_id(HANDLE) +
+                       ": type=" + ACTION_TYPE + " seq=" + std::to_string(++seq);
+    benchmark::DoNotOptimize(line.data());
+  }
+}
+
+void BM_LogRecordBuild(benchmark::State& state) {
+  int64_t seq = 0;
+  for (auto _ : state) {
+    log_record_builder record(log_id::action_validated);
+    cppsim::server::add_log_arg(record, log_session{HANDLE});
+    cppsim::server::add_log_arg(record, ACTION_TYPE);
+    cppsim::server::add_log_arg(record, ++seq);
+    benchmark::DoNotOptimize(record.view().data());
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_LogLineConcat);
+BENCHMARK(BM_LogRecordBuild);
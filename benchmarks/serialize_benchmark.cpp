@@ -0,0 +1,107 @@
+// Serialization microbenchmark for outbound STATE_UPDATE messages.
+//
+// Compares the DOM serializer the server used before (to_json into a payload
+// tree, wrapped in a message_envelope and another tree, then dump()) with the
+// direct writer, both returning a fresh string and appending into a reused
+// buffer, on a river-street update for a 6- and a 9-handed table — and the
+// frame size and decode cost of the negotiated binary encodings.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "common/protocol.hpp"
+
+namespace {
+
+using namespace cppsim::protocol;
+
+state_update_message make_update(int seats) {
+  state_update_message msg;
+  msg.game_phase = "RIVER";
+  msg.pot_size = 1250000;
+  msg.current_bet = 40000;
+  for (int seat = 0; seat < seats; ++seat) {
+    msg.player_stacks.push_back({seat, 1000000 + 12345 * seat});
+  }
+  msg.community_cards = std::vector<std::string>{"Ah", "Kd", "7c", "7s", "2h"};
+  msg.hole_cards = std::vector<std::string>{"Qs", "Qh"};
+  msg.valid_actions = {"FOLD", "CALL", "RAISE", "ALL_IN"};
+  msg.acting_seat = 3;
+  return msg;
+}
+
+void BM_SerializeStateUpdateDom(benchmark::State& state) {
+  const auto msg = make_update(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    message_envelope env;
+    env.message_type = message_types::STATE_UPDATE;
+    env.protocol_version = PROTOCOL_VERSION;
+    to_json(env.payload, msg);
+    nlohmann::json j;
+    to_json(j, env);
+    std::string out = j.dump();
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SerializeStateUpdateDirect(benchmark::State& state) {
+  const auto msg = make_update(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    std::string out = serialize_state_update(msg);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_WriteStateUpdateReusedBuffer(benchmark::State& state) {
+  const auto msg = make_update(static_cast<int>(state.range(0)));
+  std::string buffer;
+  for (auto _ : state) {
+    buffer.clear();
+    write_state_update(buffer, msg);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Negotiated binary encodings; the "bytes" counter is the frame size.
+void BM_SerializeStateUpdateEncoded(benchmark::State& state) {
+  const auto msg = make_update(9);
+  const auto encoding = static_cast<wire_encoding>(state.range(0));
+  size_t size = 0;
+  for (auto _ : state) {
+    std::string out = serialize_state_update(msg, encoding);
+    size = out.size();
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.counters["bytes"] = static_cast<double>(size);
+  state.SetLabel(wire_encoding_name(encoding));
+}
+
+// Inbound side: decoding a STATE_UPDATE-sized frame into the envelope DOM.
+void BM_DecodeStateUpdate(benchmark::State& state) {
+  const auto encoding = static_cast<wire_encoding>(state.range(0));
+  const std::string frame = serialize_state_update(make_update(9), encoding);
+  for (auto _ : state) {
+    auto header = extract_message_type_and_json(frame, encoding);
+    benchmark::DoNotOptimize(header);
+  }
+  state.SetLabel(wire_encoding_name(encoding));
+}
+
+BENCHMARK(BM_SerializeStateUpdateDom)->Arg(6)->Arg(9);
+BENCHMARK(BM_SerializeStateUpdateDirect)->Arg(6)->Arg(9);
+BENCHMARK(BM_WriteStateUpdateReusedBuffer)->Arg(6)->Arg(9);
+BENCHMARK(BM_SerializeStateUpdateEncoded)
+    ->Arg(static_cast<int64_t>(wire_encoding::json))
+    ->Arg(static_cast<int64_t>(wire_encoding::cbor))
+    ->Arg(static_cast<int64_t>(wire_encoding::msgpack));
+BENCHMARK(BM_DecodeStateUpdate)
+    ->Arg(static_cast<int64_t>(wire_encoding::json))
+    ->Arg(static_cast<int64_t>(wire_encoding::cbor))
+    ->Arg(static_cast<int64_t>(wire_encoding::msgpack));
+
+}  // namespace
@@ -0,0 +1,129 @@
+// Contention microbenchmark for the connection_manager session registry.
+//
+// Compares the single std::map + std::mutex connection_manager used to keep
+// with session_registry (one shard, and the default shard count).  Each
+// iteration registers and then unregisters 100k sessions split across N
+// threads, the way accept and close storms hit the registry in production.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "server/config.hpp"
+#include "server/session_registry.hpp"
+
+namespace {
+
+constexpr int TOTAL_SESSIONS = 100000;
+
+using session_handle = std::shared_ptr<int>;
+
+// Baseline: the ordered map behind one mutex connection_manager used before.
+class locked_map_registry {
+ public:
+  locked_map_registry(size_t capacity, size_t /*shards*/) : capacity_(capacity) {}
+
+  bool insert(const std::string& key, session_handle&& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sessions_.size() >= capacity_) return false;
+    return sessions_.try_emplace(key, std::move(value)).second;
+  }
+
+  bool erase(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sessions_.erase(key) != 0;
+  }
+
+ private:
+  const size_t capacity_;
+  std::mutex mutex_;
+  std::map<std::string, session_handle, std::less<>> sessions_;
+};
+
+class sharded_registry {
+ public:
+  sharded_registry(size_t capacity, size_t shards) : registry_(capacity, shards) {}
+
+  bool insert(const std::string& key, session_handle&& value) {
+    return registry_.try_insert(key, std::move(value)) == registry_type::insert_result::inserted;
+  }
+
+  bool erase(const std::string& key) { return registry_.erase(key); }
+
+ private:
+  using registry_type = cppsim::server::session_registry<std::string, session_handle>;
+  registry_type registry_;
+};
+
+// Session IDs in the production "sess_" + 16 hex format.
+std::vector<std::string> make_session_ids() {
+  std::vector<std::string> ids;
+  ids.reserve(TOTAL_SESSIONS);
+  char buf[32];
+  for (unsigned long long i = 0; i < TOTAL_SESSIONS; ++i) {
+    std::snprintf(buf, sizeof(buf), "sess_%016llx", (i << 32) ^ (i * 0x9E3779B9ULL));
+    ids.emplace_back(buf);
+  }
+  return ids;
+}
+
+template <typename Registry>
+void BM_SessionRegistryChurn(benchmark::State& state) {
+  const auto threads_count = static_cast<size_t>(state.range(0));
+  const auto shards = static_cast<size_t>(state.range(1));
+  static const std::vector<std::string> ids = make_session_ids();
+  const size_t per_thread = ids.size() / threads_count;
+
+  for (auto _ : state) {
+    Registry registry(ids.size(), shards);
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> threads;
+    threads.reserve(threads_count);
+    for (size_t t = 0; t < threads_count; ++t) {
+      threads.emplace_back([&registry, &failures, per_thread, t]() {
+        // One object per thread: the benchmark measures the registry, not
+        // refcount contention on a shared session.
+        auto session = std::make_shared<int>(0);
+        const size_t begin = t * per_thread;
+        const size_t end = begin + per_thread;
+        for (size_t i = begin; i < end; ++i) {
+          session_handle copy = session;
+          if (!registry.insert(ids[i], std::move(copy))) ++failures;
+        }
+        for (size_t i = begin; i < end; ++i) {
+          if (!registry.erase(ids[i])) ++failures;
+        }
+      });
+    }
+    for (auto& th : threads) th.join();
+    if (failures.load() != 0) {
+      state.SkipWithError("registry rejected a register/unregister");
+      break;
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(per_thread * threads_count) * 2);
+}
+
+constexpr int64_t DEFAULT_SHARDS = cppsim::server::config::SESSION_REGISTRY_SHARDS;
+
+BENCHMARK_TEMPLATE(BM_SessionRegistryChurn, locked_map_registry)
+    ->Args({1, 1})->Args({2, 1})->Args({4, 1})->Args({8, 1})->Args({16, 1})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SessionRegistryChurn, sharded_registry)
+    ->Args({1, 1})->Args({8, 1})
+    ->Args({1, DEFAULT_SHARDS})->Args({2, DEFAULT_SHARDS})->Args({4, DEFAULT_SHARDS})
+    ->Args({8, DEFAULT_SHARDS})->Args({16, DEFAULT_SHARDS})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace cppsim {
+
+// Perfect hash over a fixed list of short keys, built at compile time.
+//
+// The hash reads only the length and three bytes of the key (first, middle,
+// last), so a lookup is a few loads, one table probe and one string compare
+// to confirm the hit.  The constructor searches for a seed under which every
+// key lands in its own slot; if none exists it throws, which in a constexpr
+// context is a compile error — add slots or change the key set.
+template <size_t N, size_t Slots>
+class perfect_hash final {
+  static_assert(N > 0 && N < 0xFF, "key count must fit a slot byte");
+  static_assert(Slots >= N && (Slots & (Slots - 1)) == 0, "Slots must be a power of two >= N");
+
+ public:
+  // Returned by find() for keys not in the list.
+  static constexpr size_t npos = N;
+
+  constexpr explicit perfect_hash(const char* const (&keys)[N]) : keys_{}, slots_{}, seed_{0} {
+    for (size_t i = 0; i < N; ++i) keys_[i] = keys[i];
+    for (uint32_t seed = 1; seed < MAX_SEED; ++seed) {
+      if (try_seed(seed)) {
+        seed_ = seed;
+        return;
+      }
+    }
+    throw std::logic_error("perfect_hash: no collision-free seed");
+  }
+
+  // Index of `key` in the constructor's list, or npos.
+  [[nodiscard]] constexpr size_t find(std::string_view key) const noexcept {
+    if (key.empty()) return npos;
+    const uint8_t index = slots_[slot(key, seed_)];
+    return index != EMPTY && keys_[index] == key ? index : npos;
+  }
+
+  [[nodiscard]] constexpr std::string_view key(size_t index) const noexcept {
+    return index < N ? keys_[index] : std::string_view{};
+  }
+
+ private:
+  static constexpr uint8_t EMPTY = 0xFF;
+  static constexpr uint32_t MAX_SEED = 1u << 16;
+
+  static constexpr size_t slot(std::string_view key, uint32_t seed) noexcept {
+    constexpr uint32_t FNV_PRIME = 0x01000193u;
+    uint32_t h = seed ^ static_cast<uint32_t>(key.size());
+    h = (h ^ static_cast<unsigned char>(key.front())) * FNV_PRIME;
+    h = (h ^ static_cast<unsigned char>(key[key.size() / 2])) * FNV_PRIME;
+    h = (h ^ static_cast<unsigned char>(key.back())) * FNV_PRIME;
+    return (h ^ (h >> 16)) & (Slots - 1);
+  }
+
+  constexpr bool try_seed(uint32_t seed) noexcept {
+    for (auto& s : slots_) s = EMPTY;
+    for (size_t i = 0; i < N; ++i) {
+      auto& s = slots_[slot(keys_[i], seed)];
+      if (s != EMPTY) return false;
+      s = static_cast<uint8_t>(i);
+    }
+    return true;
+  }
+
+  std::array<std::string_view, N> keys_;
+  std::array<uint8_t, Slots> slots_;
+  uint32_t seed_;
+};
+
+}  // namespace cppsim
@@ -2,9 +2,11 @@
 #include "string_utils.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <limits>
+#include <memory>
 #include <mutex>
-#include <unordered_set>
+#include <vector>
 
 namespace cppsim {
 namespace protocol {
@@ -17,7 +19,7 @@ constexpr bool is_valid_session_id_char(char c) noexcept {
   return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
 }
 
-bool validate_session_id_format(const std::string& sid) noexcept {
+bool validate_session_id_format(std::string_view sid) noexcept {
   // Minimum: "sess_" + at least 1 hex char
   if (sid.size() < 6 || sid.size() > MAX_SESSION_ID_LENGTH) return false;
   if (sid[0] != 's' || sid[1] != 'e' || sid[2] != 's' || sid[3] != 's' || sid[4] != '_') return false;
@@ -29,63 +31,41 @@ bool validate_session_id_format(const std::string& sid) noexcept {
 
 }  // namespace detail
 
-std::mutex error_logger_mutex;
-std::function<void(std::string_view)> error_logger =
-    [](std::string_view msg) {
-      constexpr size_t max_safe_size = static_cast<size_t>(std::numeric_limits<int>::max());
-      auto safe_size = static_cast<int>(std::min(msg.size(), max_safe_size));
-      std::fprintf(stderr, "%.*s\n", safe_size, msg.data());
-    };
+using error_logger_fn = std::function<void(std::string_view)>;
+
+namespace {
+
+const error_logger_fn default_error_logger = [](std::string_view msg) {
+  constexpr size_t max_safe_size = static_cast<size_t>(std::numeric_limits<int>::max());
+  auto safe_size = static_cast<int>(std::min(msg.size(), max_safe_size));
+  std::fprintf(stderr, "%.*s\n", safe_size, msg.data());
+};
+
+// Every logger ever installed, never freed, so log_protocol_error() — which
+// runs for every rejected frame — reads the current one with a single
+// acquire load: no lock, no refcount, and a replaced logger stays valid for
+// any thread still calling it.
+std::mutex error_loggers_mutex;
+std::vector<std::unique_ptr<const error_logger_fn>> error_loggers;
+std::atomic<const error_logger_fn*> error_logger{&default_error_logger};
+
+}  // namespace
 
 namespace {
 
 constexpr size_t MAX_MESSAGE_TYPE_LENGTH = 32;
 constexpr size_t MAX_CLIENT_NAME_LENGTH = 128;
+constexpr size_t MAX_ENCODING_NAME_LENGTH = 32;
 constexpr size_t MAX_DISCONNECT_REASON_LENGTH = 256;
 
 // trunc_field is provided by common/string_utils.hpp in the cppsim namespace.
 // It is accessible via unqualified lookup from cppsim::protocol (enclosing namespace).
 
-using string_view_set = std::unordered_set<std::string_view>;
-
-const string_view_set& get_valid_action_types() noexcept {
-  static const string_view_set valid_types = {
-    action_types::FOLD,
-    action_types::CHECK,
-    action_types::CALL,
-    action_types::RAISE,
-    action_types::ALL_IN
-  };
-  return valid_types;
-}
-
-const string_view_set& get_amount_required_types() noexcept {
-  static const string_view_set amount_required = {
-    action_types::RAISE,
-    action_types::ALL_IN
-  };
-  return amount_required;
-}
-
-const string_view_set& get_amount_forbidden_types() noexcept {
-  static const string_view_set amount_forbidden = {
-    action_types::FOLD,
-    action_types::CHECK,
-    action_types::CALL
-  };
-  return amount_forbidden;
-}
-
 void log_protocol_error(std::string_view msg) noexcept {
   try {
-    std::function<void(std::string_view)> logger_copy;
-    {
-      std::lock_guard<std::mutex> lock(error_logger_mutex);
-      logger_copy = error_logger;
-    }
-    // Call the logger while holding the copy to ensure thread safety
-    if (logger_copy) {
-      logger_copy(msg);
+    const error_logger_fn* logger = error_logger.load(std::memory_order_acquire);
+    if (*logger) {
+      (*logger)(msg);
     }
   } catch (...) {
     // Last resort: fprintf to stderr is atomic on POSIX
@@ -113,8 +93,38 @@ bool validate_session_id_field(const std::string& session_id, const char* messag
   return true;
 }
 
+// Decodes one frame into a DOM; discarded on malformed input.  Never throws
+// for bad input, so a flood of garbage costs a scan, not a throw per frame.
+nlohmann::json decode_frame(std::string_view data, wire_encoding encoding) {
+  switch (encoding) {
+    case wire_encoding::cbor:
+      return nlohmann::json::from_cbor(data.begin(), data.end(), /*strict=*/true, /*allow_exceptions=*/false);
+    case wire_encoding::msgpack:
+      return nlohmann::json::from_msgpack(data.begin(), data.end(), /*strict=*/true, /*allow_exceptions=*/false);
+    case wire_encoding::json:
+      break;
+  }
+  return nlohmann::json::parse(data, nullptr, /*allow_exceptions=*/false);
+}
+
 }  // namespace
 
+std::optional<wire_encoding> parse_wire_encoding(std::string_view name) noexcept {
+  if (name == encodings::JSON) return wire_encoding::json;
+  if (name == encodings::CBOR) return wire_encoding::cbor;
+  if (name == encodings::MSGPACK) return wire_encoding::msgpack;
+  return std::nullopt;
+}
+
+const char* wire_encoding_name(wire_encoding encoding) noexcept {
+  switch (encoding) {
+    case wire_encoding::cbor: return encodings::CBOR;
+    case wire_encoding::msgpack: return encodings::MSGPACK;
+    case wire_encoding::json: break;
+  }
+  return encodings::JSON;
+}
+
 std::optional<std::string> extract_message_type(std::string_view json_str) noexcept {
   auto result = extract_message_type_and_json(json_str);
   if (result) {
@@ -123,16 +133,22 @@ std::optional<std::string> extract_message_type(std::string_view json_str) noexc
   return std::nullopt;
 }
 
-std::optional<parsed_message_header> extract_message_type_and_json(std::string_view json_str) noexcept {
+std::optional<parsed_message_header> extract_message_type_and_json(std::string_view data,
+                                                                   wire_encoding encoding) noexcept {
   try {
-    auto j = nlohmann::json::parse(json_str);
+    auto j = decode_frame(data, encoding);
+    if (j.is_discarded()) {
+      log_protocol_error("[Protocol] JSON parse error in extract_message_type");
+      return std::nullopt;
+    }
     if (j.contains("message_type") && j["message_type"].is_string()) {
       auto msg_type = j["message_type"].get<std::string>();
       if (msg_type.size() > MAX_MESSAGE_TYPE_LENGTH) {
         log_protocol_error("[Protocol] message_type exceeds maximum length");
         return std::nullopt;
       }
-      return parsed_message_header{std::move(msg_type), std::move(j)};
+      const auto kind = lookup_message_kind(msg_type);
+      return parsed_message_header{std::move(msg_type), std::move(j), kind};
     }
     log_protocol_error("[Protocol] Missing or invalid 'message_type' field in message");
     return std::nullopt;
@@ -147,18 +163,14 @@ std::optional<parsed_message_header> extract_message_type_and_json(std::string_v
 
 namespace {
 
-template <typename MessageType>
-std::string serialize_message(const MessageType& msg, const char* message_type) {
-  message_envelope env;
-  env.message_type = message_type;
-  env.protocol_version = PROTOCOL_VERSION;
-  nlohmann::json payload;
-  to_json(payload, msg);
-  env.payload = std::move(payload);
-
-  nlohmann::json j;
-  to_json(j, env);
-  return j.dump();
+// True when from_json(message_envelope) would succeed.  Checked up front so
+// wrongly shaped envelopes are rejected without a throw.
+bool has_envelope_shape(const nlohmann::json& j) noexcept {
+  if (!j.is_object()) return false;
+  const auto type = j.find("message_type");
+  const auto version = j.find("protocol_version");
+  return type != j.end() && type->is_string() && version != j.end() && version->is_string() &&
+         j.find("payload") != j.end();
 }
 
 // Parse from pre-parsed envelope JSON (avoids double JSON parse)
@@ -166,6 +178,10 @@ template <typename T>
 std::optional<T> parse_from_envelope(const nlohmann::json& envelope_json, std::string_view expected_type,
                                       std::string_view message_name) {
   try {
+    if (!has_envelope_shape(envelope_json)) {
+      log_protocol_error("[Protocol] " + std::string(message_name) + " Parse Error: malformed envelope");
+      return std::nullopt;
+    }
     auto envelope = envelope_json.get<message_envelope>();
     if (envelope.message_type != expected_type) {
       return std::nullopt;
@@ -188,10 +204,15 @@ std::optional<T> parse_from_envelope(const nlohmann::json& envelope_json, std::s
 }
 
 template <typename T>
-std::optional<T> parse_message(std::string_view json_str, std::string_view expected_type,
+std::optional<T> parse_message(std::string_view data, wire_encoding encoding, std::string_view expected_type,
                                  std::string_view message_name) {
   try {
-    auto j = nlohmann::json::parse(json_str);
+    auto j = decode_frame(data, encoding);
+    if (j.is_discarded()) {
+      log_protocol_error("[Protocol] " + std::string(message_name) + " Parse Error: invalid " +
+                         wire_encoding_name(encoding));
+      return std::nullopt;
+    }
     return parse_from_envelope<T>(j, expected_type, message_name);
   } catch (const std::exception& e) {
     try {
@@ -205,8 +226,11 @@ std::optional<T> parse_message(std::string_view json_str, std::string_view expec
 }  // namespace
 
 void set_error_logger(std::function<void(std::string_view)> logger) {
-  std::lock_guard<std::mutex> lock(error_logger_mutex);
-  error_logger = std::move(logger);
+  auto installed = std::make_unique<const error_logger_fn>(std::move(logger));
+  std::lock_guard<std::mutex> lock(error_loggers_mutex);
+  error_loggers.reserve(error_loggers.size() + 1);
+  error_loggers.push_back(std::move(installed));
+  error_logger.store(error_loggers.back().get(), std::memory_order_release);
 }
 
 // NOTE: Unlike parse_message<>, parse_handshake does NOT validate the envelope
@@ -215,7 +239,11 @@ void set_error_logger(std::function<void(std::string_view)> logger) {
 // This is intentional — see HandshakeEnvelopeVersionMismatch test.
 std::optional<handshake_message> parse_handshake(std::string_view json_str) {
   try {
-    auto j = nlohmann::json::parse(json_str);
+    auto j = nlohmann::json::parse(json_str, nullptr, /*allow_exceptions=*/false);
+    if (j.is_discarded() || !has_envelope_shape(j)) {
+      log_protocol_error("[Protocol] Handshake Parse Error: invalid JSON or envelope");
+      return std::nullopt;
+    }
     auto envelope = j.get<message_envelope>();
     
     if (envelope.message_type != message_types::HANDSHAKE) {
@@ -235,6 +263,11 @@ std::optional<handshake_message> parse_handshake(std::string_view json_str) {
       return std::nullopt;
     }
 
+    if (msg.encoding && msg.encoding->size() > MAX_ENCODING_NAME_LENGTH) {
+      log_protocol_error("[Protocol] Encoding name exceeds maximum length");
+      return std::nullopt;
+    }
+
     if (msg.client_name) {
       const auto& name = *msg.client_name;
       bool all_blank = true;
@@ -274,7 +307,7 @@ std::optional<handshake_message> parse_handshake(std::string_view json_str) {
 // copies (pointer swaps vs. heap allocations).
 std::optional<action_message> validate_action(std::optional<action_message> result) {
   if (!result) return std::nullopt;
-  const auto& msg = *result;
+  auto& msg = *result;
 
   if (!validate_session_id_field(msg.session_id, "ACTION")) {
     return std::nullopt;
@@ -290,8 +323,8 @@ std::optional<action_message> validate_action(std::optional<action_message> resu
     return std::nullopt;
   }
 
-  const auto& valid_types = get_valid_action_types();
-  if (valid_types.find(msg.action_type) == valid_types.end()) {
+  msg.kind = lookup_action_kind(msg.action_type);
+  if (msg.kind == action_kind::unknown) {
     try {
       log_protocol_error("[Protocol] Invalid action_type: " + trunc_field(msg.action_type));
     } catch (...) {
@@ -307,13 +340,9 @@ std::optional<action_message> validate_action(std::optional<action_message> resu
     return std::nullopt;
   }
 
-  // Combined amount-policy check: determine whether the action type
-  // requires an amount, forbids it, or allows either.  A single lookup
-  // into the valid_types set was already performed above; now check
-  // the two policy sets with early-return on violation.
+  // Every action type either requires an amount or forbids one.
   {
-    const auto& amount_required = get_amount_required_types();
-    bool needs_amount = amount_required.find(msg.action_type) != amount_required.end();
+    const bool needs_amount = action_requires_amount(msg.kind);
     if (needs_amount && !msg.amount) {
       try {
         log_protocol_error("[Protocol] " + trunc_field(msg.action_type) + " action requires amount field");
@@ -323,9 +352,7 @@ std::optional<action_message> validate_action(std::optional<action_message> resu
       return std::nullopt;
     }
 
-    const auto& amount_forbidden = get_amount_forbidden_types();
-    bool forbids_amount = amount_forbidden.find(msg.action_type) != amount_forbidden.end();
-    if (forbids_amount && msg.amount) {
+    if (!needs_amount && msg.amount) {
       try {
         log_protocol_error("[Protocol] " + trunc_field(msg.action_type) + " action should not have amount field");
       } catch (...) {
@@ -338,8 +365,8 @@ std::optional<action_message> validate_action(std::optional<action_message> resu
   return result;
 }
 
-std::optional<action_message> parse_action(std::string_view json_str) {
-  return validate_action(parse_message<action_message>(json_str, message_types::ACTION, "Action"));
+std::optional<action_message> parse_action(std::string_view data, wire_encoding encoding) {
+  return validate_action(parse_message<action_message>(data, encoding, message_types::ACTION, "Action"));
 }
 
 std::optional<action_message> parse_action_from_envelope(const nlohmann::json& envelope_json) {
@@ -365,8 +392,8 @@ std::optional<reload_request_message> validate_reload(std::optional<reload_reque
   return result;
 }
 
-std::optional<reload_request_message> parse_reload_request(std::string_view json_str) {
-  return validate_reload(parse_message<reload_request_message>(json_str, message_types::RELOAD_REQUEST,
+std::optional<reload_request_message> parse_reload_request(std::string_view data, wire_encoding encoding) {
+  return validate_reload(parse_message<reload_request_message>(data, encoding, message_types::RELOAD_REQUEST,
                                                 "Reload Request"));
 }
 
@@ -401,28 +428,117 @@ std::optional<disconnect_message> validate_disconnect(std::optional<disconnect_m
   return result;
 }
 
-std::optional<disconnect_message> parse_disconnect(std::string_view json_str) {
-  return validate_disconnect(parse_message<disconnect_message>(json_str, message_types::DISCONNECT, "Disconnect"));
+std::optional<disconnect_message> parse_disconnect(std::string_view data, wire_encoding encoding) {
+  return validate_disconnect(
+      parse_message<disconnect_message>(data, encoding, message_types::DISCONNECT, "Disconnect"));
 }
 
 std::optional<disconnect_message> parse_disconnect_from_envelope(const nlohmann::json& envelope_json) {
   return validate_disconnect(parse_from_envelope<disconnect_message>(envelope_json, message_types::DISCONNECT, "Disconnect"));
 }
 
-std::string serialize_state_update(const state_update_message& msg) {
-  return serialize_message(msg, message_types::STATE_UPDATE);
+// Validate state_ack_message fields after deserialization.
+std::optional<state_ack_message> validate_state_ack(std::optional<state_ack_message> result) {
+  if (!result) return std::nullopt;
+
+  if (!validate_session_id_field(result->session_id, "STATE_ACK")) {
+    return std::nullopt;
+  }
+
+  if (result->state_sequence < 0) {
+    log_protocol_error("[Protocol] Negative state_sequence in STATE_ACK message");
+    return std::nullopt;
+  }
+
+  return result;
 }
 
-std::string serialize_error(const error_message& msg) {
-  return serialize_message(msg, message_types::ERROR);
+std::optional<state_ack_message> parse_state_ack(std::string_view data, wire_encoding encoding) {
+  return validate_state_ack(parse_message<state_ack_message>(data, encoding, message_types::STATE_ACK, "State Ack"));
 }
 
-std::string serialize_handshake_response(const handshake_response& msg) {
-  return serialize_message(msg, message_types::HANDSHAKE_RESPONSE);
+std::optional<state_ack_message> parse_state_ack_from_envelope(const nlohmann::json& envelope_json) {
+  return validate_state_ack(parse_from_envelope<state_ack_message>(envelope_json, message_types::STATE_ACK, "State Ack"));
+}
+
+std::optional<batch_request> parse_batch_from_envelope(nlohmann::json envelope_json) {
+  try {
+    if (!has_envelope_shape(envelope_json)) {
+      log_protocol_error("[Protocol] Batch Parse Error: malformed envelope");
+      return std::nullopt;
+    }
+    if (envelope_json["message_type"].get_ref<const std::string&>() != message_types::BATCH) {
+      return std::nullopt;
+    }
+    if (envelope_json["protocol_version"].get_ref<const std::string&>() != PROTOCOL_VERSION) {
+      log_protocol_error("[Protocol] Batch version mismatch: expected " + std::string(PROTOCOL_VERSION));
+      return std::nullopt;
+    }
+
+    auto& payload = envelope_json["payload"];
+    const auto session_id = payload.is_object() ? payload.find("session_id") : payload.end();
+    const auto messages = payload.is_object() ? payload.find("messages") : payload.end();
+    if (session_id == payload.end() || !session_id->is_string() || messages == payload.end() ||
+        !messages->is_array()) {
+      log_protocol_error("[Protocol] Batch Parse Error: payload needs session_id and messages");
+      return std::nullopt;
+    }
+    if (messages->empty() || messages->size() > MAX_BATCH_MESSAGES) {
+      log_protocol_error("[Protocol] BATCH must carry 1 to " + std::to_string(MAX_BATCH_MESSAGES) + " messages");
+      return std::nullopt;
+    }
+
+    batch_request batch;
+    batch.session_id = session_id->get<std::string>();
+    if (!validate_session_id_field(batch.session_id, "BATCH")) {
+      return std::nullopt;
+    }
+
+    batch.messages.reserve(messages->size());
+    for (auto& element : *messages) {
+      if (!has_envelope_shape(element)) {
+        log_protocol_error("[Protocol] Batch Parse Error: malformed message envelope");
+        return std::nullopt;
+      }
+      auto type = element["message_type"].get<std::string>();
+      const auto kind = lookup_message_kind(type);
+      switch (kind) {
+        case message_kind::action:
+        case message_kind::reload_request:
+        case message_kind::state_ack:
+        case message_kind::disconnect:
+          break;
+        default:
+          log_protocol_error("[Protocol] Message type not allowed in BATCH: " + trunc_field(type));
+          return std::nullopt;
+      }
+      batch.messages.push_back(parsed_message_header{std::move(type), std::move(element), kind});
+    }
+    return batch;
+  } catch (const std::exception& e) {
+    try {
+      log_protocol_error(std::string("[Protocol] Batch Parse Error: ") + e.what());
+    } catch (...) {
+    }
+    return std::nullopt;
+  }
 }
 
-std::string serialize_reload_response(const reload_response_message& msg) {
-  return serialize_message(msg, message_types::RELOAD_RESPONSE);
+std::optional<batch_request> parse_batch(std::string_view data, wire_encoding encoding) {
+  try {
+    auto j = decode_frame(data, encoding);
+    if (j.is_discarded()) {
+      log_protocol_error(std::string("[Protocol] Batch Parse Error: invalid ") + wire_encoding_name(encoding));
+      return std::nullopt;
+    }
+    return parse_batch_from_envelope(std::move(j));
+  } catch (const std::exception& e) {
+    try {
+      log_protocol_error(std::string("[Protocol] Batch Parse Error: ") + e.what());
+    } catch (...) {
+    }
+    return std::nullopt;
+  }
 }
 
 }  // namespace protocol
@@ -3,6 +3,8 @@
 #include <cmath>
 #include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <iterator>
 #include <limits>
 #include <optional>
 #include <stdexcept>
@@ -12,6 +14,8 @@
 
 #include <nlohmann/json.hpp>
 
+#include "perfect_hash.hpp"
+
 namespace cppsim {
 namespace protocol {
 
@@ -21,15 +25,17 @@ namespace protocol {
  * Provides comprehensive validation functions for all protocol message types
  * with detailed error reporting and input sanitization.
  */
+enum class message_kind : uint8_t;
+
 namespace validation {
     /**
      * @brief Validates message types against allowed values
      * @param message_type The message type to validate
-     * @param allowed_types List of allowed message types
+     * @param allowed_types List of allowed message kinds
      * @return true if valid, false otherwise
      */
-    [[nodiscard]] bool is_valid_message_type(const std::string& message_type,
-                                            const std::vector<std::string>& allowed_types) noexcept;
+    [[nodiscard]] bool is_valid_message_type(std::string_view message_type,
+                                            std::initializer_list<message_kind> allowed_types) noexcept;
     
     /**
      * @brief Validates protocol version format
@@ -89,6 +95,9 @@ namespace validation {
     
 } // namespace validation
 
+// Installs the logger for rejected frames.  Replaced loggers are kept for the
+// life of the process, so install one at startup rather than per request.
+// Can throw std::bad_alloc.
 void set_error_logger(std::function<void(std::string_view)> logger);
 
 // Protocol version constant
@@ -102,6 +111,9 @@ constexpr int64_t MAX_AMOUNT = 1000000000000000LL;  // Maximum valid amount (in
 // Maximum length for session IDs. Must match server config.
 // Generated IDs are "sess_" + 32 hex chars = 37 bytes; the limit allows future formats.
 constexpr size_t MAX_SESSION_ID_LENGTH = 128;
+// Most messages one BATCH may carry.  The server also refuses a batch whose
+// rate-limit cost exceeds its per-session burst (max_messages_per_window).
+constexpr size_t MAX_BATCH_MESSAGES = 32;
 
 // Error Codes
 namespace error_codes {
@@ -122,8 +134,26 @@ constexpr const char* ERROR = "ERROR";
 constexpr const char* RELOAD_REQUEST = "RELOAD_REQUEST";
 constexpr const char* RELOAD_RESPONSE = "RELOAD_RESPONSE";
 constexpr const char* DISCONNECT = "DISCONNECT";
+constexpr const char* STATE_DELTA = "STATE_DELTA";
+constexpr const char* STATE_ACK = "STATE_ACK";
+constexpr const char* BATCH = "BATCH";
+}
+
+// Wire encodings a client may request in its HANDSHAKE.  The handshake and
+// its response are always JSON text; after that, a session that negotiated
+// CBOR or MessagePack exchanges binary frames carrying the same envelope.
+namespace encodings {
+constexpr const char* JSON = "json";
+constexpr const char* CBOR = "cbor";
+constexpr const char* MSGPACK = "msgpack";
 }
 
+enum class wire_encoding { json, cbor, msgpack };
+
+// nullopt for names the server does not support.
+[[nodiscard]] std::optional<wire_encoding> parse_wire_encoding(std::string_view name) noexcept;
+[[nodiscard]] const char* wire_encoding_name(wire_encoding encoding) noexcept;
+
 // Action Types
 namespace action_types {
 constexpr const char* FOLD = "FOLD";
@@ -133,6 +163,65 @@ constexpr const char* RAISE = "RAISE";
 constexpr const char* ALL_IN = "ALL_IN";
 }
 
+// The message_types / action_types names as enums, for dispatch.  The
+// lookup_* functions map a wire name through a compile-time perfect hash
+// (no string hashing, one compare), so handlers switch on the enum instead
+// of walking a chain of string comparisons.  Enumerators follow the order
+// of the name tables below; `unknown` is anything else.
+enum class message_kind : uint8_t {
+  handshake,
+  handshake_response,
+  action,
+  state_update,
+  error,
+  reload_request,
+  reload_response,
+  disconnect,
+  state_delta,
+  state_ack,
+  batch,
+  unknown
+};
+
+enum class action_kind : uint8_t { fold, check, call, raise, all_in, unknown };
+
+namespace detail {
+inline constexpr const char* MESSAGE_TYPE_NAMES[] = {
+    message_types::HANDSHAKE,       message_types::HANDSHAKE_RESPONSE, message_types::ACTION,
+    message_types::STATE_UPDATE,    message_types::ERROR,              message_types::RELOAD_REQUEST,
+    message_types::RELOAD_RESPONSE, message_types::DISCONNECT,         message_types::STATE_DELTA,
+    message_types::STATE_ACK,       message_types::BATCH};
+inline constexpr const char* ACTION_TYPE_NAMES[] = {action_types::FOLD, action_types::CHECK, action_types::CALL,
+                                                    action_types::RAISE, action_types::ALL_IN};
+static_assert(std::size(MESSAGE_TYPE_NAMES) == static_cast<size_t>(message_kind::unknown));
+static_assert(std::size(ACTION_TYPE_NAMES) == static_cast<size_t>(action_kind::unknown));
+
+inline constexpr perfect_hash<std::size(MESSAGE_TYPE_NAMES), 16> MESSAGE_TYPE_HASH{MESSAGE_TYPE_NAMES};
+inline constexpr perfect_hash<std::size(ACTION_TYPE_NAMES), 8> ACTION_TYPE_HASH{ACTION_TYPE_NAMES};
+}  // namespace detail
+
+[[nodiscard]] constexpr message_kind lookup_message_kind(std::string_view name) noexcept {
+  return static_cast<message_kind>(detail::MESSAGE_TYPE_HASH.find(name));
+}
+
+[[nodiscard]] constexpr action_kind lookup_action_kind(std::string_view name) noexcept {
+  return static_cast<action_kind>(detail::ACTION_TYPE_HASH.find(name));
+}
+
+// Wire name of `kind`; empty for unknown.
+[[nodiscard]] constexpr std::string_view message_kind_name(message_kind kind) noexcept {
+  return detail::MESSAGE_TYPE_HASH.key(static_cast<size_t>(kind));
+}
+
+[[nodiscard]] constexpr std::string_view action_kind_name(action_kind kind) noexcept {
+  return detail::ACTION_TYPE_HASH.key(static_cast<size_t>(kind));
+}
+
+// RAISE and ALL_IN carry an amount; FOLD, CHECK and CALL must not.
+[[nodiscard]] constexpr bool action_requires_amount(action_kind kind) noexcept {
+  return kind == action_kind::raise || kind == action_kind::all_in;
+}
+
 // Player stack information for state updates
 struct player_stack {
   int seat;
@@ -143,6 +232,7 @@ struct player_stack {
 struct handshake_message {
   std::string protocol_version;
   std::optional<std::string> client_name;
+  std::optional<std::string> encoding;  // Requested wire encoding (encodings::*)
 };
 
 // HANDSHAKE response - Server assigns session
@@ -150,6 +240,9 @@ struct handshake_response {
   std::string session_id;
   int seat_number;
   int64_t starting_stack;  // Amount in cents
+  // Encoding the session uses from now on; only sent when the client asked
+  // for one, so existing clients see an unchanged response.
+  std::optional<std::string> encoding;
 };
 
 // ACTION message - Client sends poker action
@@ -158,6 +251,7 @@ struct action_message {
   std::string action_type;  // "FOLD", "CALL", "RAISE", "CHECK", "ALL_IN"
   std::optional<int64_t> amount;  // Amount in cents, if applicable
   int64_t sequence_number;
+  action_kind kind = action_kind::unknown;  // action_type, set by the parsers
 };
 
 // STATE_UPDATE message - Server broadcasts game state
@@ -171,6 +265,34 @@ struct state_update_message {
   std::optional<std::vector<std::string>> hole_cards;
   std::vector<std::string> valid_actions;
   std::optional<int> acting_seat;
+  // Per-session update number; set when the session tracks deltas, so the
+  // client can acknowledge it with STATE_ACK.
+  std::optional<int64_t> state_sequence;
+};
+
+// STATE_DELTA message - Changes relative to a state the client acknowledged.
+// Absent fields are unchanged; fields named in `cleared` were removed.
+struct state_delta_message {
+  int64_t state_sequence;
+  int64_t base_sequence;  // state_sequence of the baseline this applies to
+  std::optional<std::string> game_phase;
+  std::optional<int64_t> pot_size;
+  std::optional<int64_t> current_bet;
+  std::vector<player_stack> player_stacks;  // Seats added or changed
+  std::vector<int> removed_seats;
+  std::optional<std::vector<std::string>> community_cards;
+  std::optional<std::vector<std::string>> hole_cards;
+  std::optional<std::vector<std::string>> valid_actions;
+  std::optional<int> acting_seat;
+  std::vector<std::string> cleared;  // "community_cards", "hole_cards", "acting_seat"
+};
+
+// STATE_ACK message - Client confirms it holds state `state_sequence`, or
+// (resync) asks for a full STATE_UPDATE because it lost track.
+struct state_ack_message {
+  std::string session_id;
+  int64_t state_sequence;
+  bool resync{false};
 };
 
 // ERROR message - Server reports error
@@ -210,21 +332,29 @@ struct message_envelope {
 // Not part of the public API — callers should use validation::is_valid_session_id()
 // or rely on the parse_* functions which call it internally.
 namespace detail {
-[[nodiscard]] bool validate_session_id_format(const std::string& sid) noexcept;
+[[nodiscard]] bool validate_session_id_format(std::string_view sid) noexcept;
 }  // namespace detail
 
 // Parsing functions - return std::optional for safe error handling
 // These functions log errors internally and return std::nullopt on parse failure
+// `data` is JSON text, or a CBOR / MessagePack document for those encodings.
+// The handshake is always JSON.
 [[nodiscard]] std::optional<handshake_message> parse_handshake(std::string_view json_str);
-[[nodiscard]] std::optional<action_message> parse_action(std::string_view json_str);
-[[nodiscard]] std::optional<reload_request_message> parse_reload_request(std::string_view json_str);
-[[nodiscard]] std::optional<disconnect_message> parse_disconnect(std::string_view json_str);
+[[nodiscard]] std::optional<action_message> parse_action(std::string_view data,
+                                                         wire_encoding encoding = wire_encoding::json);
+[[nodiscard]] std::optional<reload_request_message> parse_reload_request(std::string_view data,
+                                                                         wire_encoding encoding = wire_encoding::json);
+[[nodiscard]] std::optional<disconnect_message> parse_disconnect(std::string_view data,
+                                                                 wire_encoding encoding = wire_encoding::json);
 
 /// Parse from pre-parsed envelope JSON (avoids double-parsing).
 /// The envelope_json must contain "payload" and "protocol_version" fields.
 [[nodiscard]] std::optional<action_message> parse_action_from_envelope(const nlohmann::json& envelope_json);
 [[nodiscard]] std::optional<reload_request_message> parse_reload_from_envelope(const nlohmann::json& envelope_json);
 [[nodiscard]] std::optional<disconnect_message> parse_disconnect_from_envelope(const nlohmann::json& envelope_json);
+[[nodiscard]] std::optional<state_ack_message> parse_state_ack(std::string_view data,
+                                                               wire_encoding encoding = wire_encoding::json);
+[[nodiscard]] std::optional<state_ack_message> parse_state_ack_from_envelope(const nlohmann::json& envelope_json);
 
 [[nodiscard]] std::optional<std::string> extract_message_type(std::string_view json_str) noexcept;
 
@@ -233,13 +363,86 @@ namespace detail {
 struct parsed_message_header {
   std::string message_type;
   nlohmann::json envelope_json;
+  message_kind kind;  // lookup_message_kind(message_type)
+};
+[[nodiscard]] std::optional<parsed_message_header> extract_message_type_and_json(
+    std::string_view data, wire_encoding encoding = wire_encoding::json) noexcept;
+
+// BATCH message - Several client messages in one frame:
+//   {"session_id": ..., "messages": [<envelope>, ...]}
+// Each element is a complete ACTION, RELOAD_REQUEST, STATE_ACK or DISCONNECT
+// envelope; the server handles them in order.  Replies to a batch come back
+// the same way, wrapped in one outbound BATCH (see write_batch).
+struct batch_request {
+  std::string session_id;
+  std::vector<parsed_message_header> messages;  // Envelopes not yet validated
+};
+
+/// Checks the BATCH envelope, its session_id, the message count
+/// (1..MAX_BATCH_MESSAGES) and each element's message_type; the elements
+/// themselves are left to the matching parse_*_from_envelope.  Takes the
+/// envelope by value so a caller done with it can move it in.
+[[nodiscard]] std::optional<batch_request> parse_batch(std::string_view data,
+                                                       wire_encoding encoding = wire_encoding::json);
+[[nodiscard]] std::optional<batch_request> parse_batch_from_envelope(nlohmann::json envelope_json);
+
+/// Outcome of a fast-path parse.
+enum class fast_parse_status {
+  ok,           ///< A valid message; the output has been filled in.
+  not_action,   ///< Well-formed envelope of another message type.
+  malformed,    ///< Not JSON, or no usable message_type: the DOM path's
+                ///< extract_message_type_and_json would fail.
+  rejected,     ///< An ACTION envelope the DOM path would reject.
+  unsupported,  ///< Valid but unusual encoding (escapes, float amounts,
+                ///< duplicate keys, ...) — use the DOM path.
 };
-[[nodiscard]] std::optional<parsed_message_header> extract_message_type_and_json(std::string_view json_str) noexcept;
 
-[[nodiscard]] std::string serialize_state_update(const state_update_message& msg);
-[[nodiscard]] std::string serialize_error(const error_message& msg);
+/// Single-pass ACTION parser: scans the raw frame once, with no JSON DOM and
+/// no exceptions, and writes straight into `out` (reuse one action_message
+/// so its strings keep their capacity).  Applies exactly the checks of
+/// parse_action_from_envelope + validate_action: whenever it returns ok, the
+/// DOM path would have produced the same action_message, and malformed /
+/// rejected are as definitive as the DOM path's own rejection.  Logs nothing,
+/// so callers can reject garbage without exceptions or protocol-error logs.
+[[nodiscard]] fast_parse_status parse_action_fast(std::string_view json_str, action_message& out) noexcept;
+
+/// Wire bytes for outbound messages, written directly with no JSON DOM.
+/// Byte-identical to dump() / to_cbor() / to_msgpack() of the to_json()
+/// envelope below.  Like dump(), JSON output throws
+/// nlohmann::json::type_error on strings that are not UTF-8.
+[[nodiscard]] std::string serialize_state_update(const state_update_message& msg,
+                                                 wire_encoding encoding = wire_encoding::json);
+[[nodiscard]] std::string serialize_error(const error_message& msg, wire_encoding encoding = wire_encoding::json);
 [[nodiscard]] std::string serialize_handshake_response(const handshake_response& msg);
-[[nodiscard]] std::string serialize_reload_response(const reload_response_message& msg);
+[[nodiscard]] std::string serialize_reload_response(const reload_response_message& msg,
+                                                    wire_encoding encoding = wire_encoding::json);
+[[nodiscard]] std::string serialize_state_delta(const state_delta_message& msg,
+                                                wire_encoding encoding = wire_encoding::json);
+/// Wraps messages already serialized in `encoding` in one BATCH envelope,
+/// {"messages": [...]}, without re-encoding them.
+[[nodiscard]] std::string serialize_batch(const std::vector<std::string>& messages,
+                                          wire_encoding encoding = wire_encoding::json);
+
+/// Same output, appended to `out` — e.g. a buffer reused across messages
+/// (clear() keeps its capacity).  On exception `out` holds a partial message.
+void write_state_update(std::string& out, const state_update_message& msg,
+                        wire_encoding encoding = wire_encoding::json);
+void write_error(std::string& out, const error_message& msg, wire_encoding encoding = wire_encoding::json);
+void write_handshake_response(std::string& out, const handshake_response& msg);
+void write_reload_response(std::string& out, const reload_response_message& msg,
+                           wire_encoding encoding = wire_encoding::json);
+void write_state_delta(std::string& out, const state_delta_message& msg,
+                       wire_encoding encoding = wire_encoding::json);
+void write_batch(std::string& out, const std::vector<std::string>& messages,
+                 wire_encoding encoding = wire_encoding::json);
+
+/// Delta that turns `base` into `next`.  Sequences are left to the caller;
+/// player stacks are matched by seat.
+[[nodiscard]] state_delta_message make_state_delta(const state_update_message& base,
+                                                   const state_update_message& next);
+/// Applies `delta` to `state` (the client side of make_state_delta) and sets
+/// state.state_sequence.  Does not check base_sequence.
+void apply_state_delta(state_update_message& state, const state_delta_message& delta);
 
 // nlohmann/json serialization functions
 // Manual to_json/from_json for proper std::optional support
@@ -257,6 +460,7 @@ inline void from_json(const nlohmann::json& j, player_stack& p) {
 inline void to_json(nlohmann::json& j, const handshake_message& m) {
   j = nlohmann::json{{"protocol_version", m.protocol_version}};
   if (m.client_name) j["client_name"] = *m.client_name;
+  if (m.encoding) j["encoding"] = *m.encoding;
 }
 
 inline void from_json(const nlohmann::json& j, handshake_message& m) {
@@ -264,18 +468,25 @@ inline void from_json(const nlohmann::json& j, handshake_message& m) {
   if (j.contains("client_name") && !j["client_name"].is_null()) {
     m.client_name = j["client_name"].template get<std::string>();
   }
+  if (j.contains("encoding") && !j["encoding"].is_null()) {
+    m.encoding = j["encoding"].template get<std::string>();
+  }
 }
 
 inline void to_json(nlohmann::json& j, const handshake_response& m) {
   j = nlohmann::json{{"session_id", m.session_id},
                      {"seat_number", m.seat_number},
                      {"starting_stack", m.starting_stack}};
+  if (m.encoding) j["encoding"] = *m.encoding;
 }
 
 inline void from_json(const nlohmann::json& j, handshake_response& m) {
   j.at("session_id").get_to(m.session_id);
   j.at("seat_number").get_to(m.seat_number);
   j.at("starting_stack").get_to(m.starting_stack);
+  if (j.contains("encoding") && !j["encoding"].is_null()) {
+    m.encoding = j["encoding"].get<std::string>();
+  }
 }
 
 inline void to_json(nlohmann::json& j, const action_message& m) {
@@ -321,6 +532,7 @@ inline void to_json(nlohmann::json& j, const state_update_message& m) {
   if (m.community_cards) j["community_cards"] = *m.community_cards;
   if (m.hole_cards) j["hole_cards"] = *m.hole_cards;
   if (m.acting_seat) j["acting_seat"] = *m.acting_seat;
+  if (m.state_sequence) j["state_sequence"] = *m.state_sequence;
 }
 
 inline void from_json(const nlohmann::json& j, state_update_message& m) {
@@ -340,6 +552,49 @@ inline void from_json(const nlohmann::json& j, state_update_message& m) {
   if (j.contains("acting_seat") && !j["acting_seat"].is_null()) {
     m.acting_seat = j["acting_seat"].get<int>();
   }
+  if (j.contains("state_sequence") && !j["state_sequence"].is_null()) {
+    m.state_sequence = j["state_sequence"].get<int64_t>();
+  }
+}
+
+inline void to_json(nlohmann::json& j, const state_delta_message& m) {
+  j = nlohmann::json{{"state_sequence", m.state_sequence}, {"base_sequence", m.base_sequence}};
+  if (m.game_phase) j["game_phase"] = *m.game_phase;
+  if (m.pot_size) j["pot_size"] = *m.pot_size;
+  if (m.current_bet) j["current_bet"] = *m.current_bet;
+  if (!m.player_stacks.empty()) j["player_stacks"] = m.player_stacks;
+  if (!m.removed_seats.empty()) j["removed_seats"] = m.removed_seats;
+  if (m.community_cards) j["community_cards"] = *m.community_cards;
+  if (m.hole_cards) j["hole_cards"] = *m.hole_cards;
+  if (m.valid_actions) j["valid_actions"] = *m.valid_actions;
+  if (m.acting_seat) j["acting_seat"] = *m.acting_seat;
+  if (!m.cleared.empty()) j["cleared"] = m.cleared;
+}
+
+inline void from_json(const nlohmann::json& j, state_delta_message& m) {
+  j.at("state_sequence").get_to(m.state_sequence);
+  j.at("base_sequence").get_to(m.base_sequence);
+  if (j.contains("game_phase")) m.game_phase = j["game_phase"].get<std::string>();
+  if (j.contains("pot_size")) m.pot_size = j["pot_size"].get<int64_t>();
+  if (j.contains("current_bet")) m.current_bet = j["current_bet"].get<int64_t>();
+  if (j.contains("player_stacks")) j["player_stacks"].get_to(m.player_stacks);
+  if (j.contains("removed_seats")) j["removed_seats"].get_to(m.removed_seats);
+  if (j.contains("community_cards")) m.community_cards = j["community_cards"].get<std::vector<std::string>>();
+  if (j.contains("hole_cards")) m.hole_cards = j["hole_cards"].get<std::vector<std::string>>();
+  if (j.contains("valid_actions")) m.valid_actions = j["valid_actions"].get<std::vector<std::string>>();
+  if (j.contains("acting_seat")) m.acting_seat = j["acting_seat"].get<int>();
+  if (j.contains("cleared")) j["cleared"].get_to(m.cleared);
+}
+
+inline void to_json(nlohmann::json& j, const state_ack_message& m) {
+  j = nlohmann::json{{"session_id", m.session_id}, {"state_sequence", m.state_sequence}};
+  if (m.resync) j["resync"] = true;
+}
+
+inline void from_json(const nlohmann::json& j, state_ack_message& m) {
+  j.at("session_id").get_to(m.session_id);
+  j.at("state_sequence").get_to(m.state_sequence);
+  m.resync = j.contains("resync") && j["resync"].get<bool>();
 }
 
 inline void to_json(nlohmann::json& j, const error_message& m) {
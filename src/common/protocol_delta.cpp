@@ -0,0 +1,94 @@
+#include "protocol.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace cppsim {
+namespace protocol {
+
+namespace {
+
+// Names used in state_delta_message::cleared.
+constexpr const char* COMMUNITY_CARDS = "community_cards";
+constexpr const char* HOLE_CARDS = "hole_cards";
+constexpr const char* ACTING_SEAT = "acting_seat";
+
+const player_stack* find_seat(const std::vector<player_stack>& stacks, int seat) noexcept {
+  const auto it = std::find_if(stacks.begin(), stacks.end(), [seat](const player_stack& p) { return p.seat == seat; });
+  return it == stacks.end() ? nullptr : &*it;
+}
+
+// Optional field: copied when it changed, named in `cleared` when removed.
+template <typename T>
+void diff_optional(const std::optional<T>& base, const std::optional<T>& next, std::optional<T>& out,
+                   std::vector<std::string>& cleared, const char* name) {
+  if (next) {
+    if (base != next) out = next;
+  } else if (base) {
+    cleared.emplace_back(name);
+  }
+}
+
+template <typename T>
+void apply_optional(std::optional<T>& field, const std::optional<T>& change,
+                    const std::vector<std::string>& cleared, const char* name) {
+  if (change) {
+    field = change;
+  } else if (std::find(cleared.begin(), cleared.end(), name) != cleared.end()) {
+    field.reset();
+  }
+}
+
+}  // namespace
+
+state_delta_message make_state_delta(const state_update_message& base, const state_update_message& next) {
+  state_delta_message delta{};
+  if (next.game_phase != base.game_phase) delta.game_phase = next.game_phase;
+  if (next.pot_size != base.pot_size) delta.pot_size = next.pot_size;
+  if (next.current_bet != base.current_bet) delta.current_bet = next.current_bet;
+  if (next.valid_actions != base.valid_actions) delta.valid_actions = next.valid_actions;
+
+  // Tables have at most a handful of seats: a linear match beats a map.
+  for (const auto& p : next.player_stacks) {
+    const player_stack* old = find_seat(base.player_stacks, p.seat);
+    if (!old || old->stack != p.stack) delta.player_stacks.push_back(p);
+  }
+  for (const auto& p : base.player_stacks) {
+    if (!find_seat(next.player_stacks, p.seat)) delta.removed_seats.push_back(p.seat);
+  }
+
+  diff_optional(base.community_cards, next.community_cards, delta.community_cards, delta.cleared, COMMUNITY_CARDS);
+  diff_optional(base.hole_cards, next.hole_cards, delta.hole_cards, delta.cleared, HOLE_CARDS);
+  diff_optional(base.acting_seat, next.acting_seat, delta.acting_seat, delta.cleared, ACTING_SEAT);
+  return delta;
+}
+
+void apply_state_delta(state_update_message& state, const state_delta_message& delta) {
+  if (delta.game_phase) state.game_phase = *delta.game_phase;
+  if (delta.pot_size) state.pot_size = *delta.pot_size;
+  if (delta.current_bet) state.current_bet = *delta.current_bet;
+  if (delta.valid_actions) state.valid_actions = *delta.valid_actions;
+
+  auto& stacks = state.player_stacks;
+  for (const int seat : delta.removed_seats) {
+    stacks.erase(std::remove_if(stacks.begin(), stacks.end(), [seat](const player_stack& p) { return p.seat == seat; }),
+                 stacks.end());
+  }
+  for (const auto& p : delta.player_stacks) {
+    auto it = std::find_if(stacks.begin(), stacks.end(), [&p](const player_stack& s) { return s.seat == p.seat; });
+    if (it != stacks.end()) {
+      it->stack = p.stack;
+    } else {
+      stacks.push_back(p);
+    }
+  }
+
+  apply_optional(state.community_cards, delta.community_cards, delta.cleared, COMMUNITY_CARDS);
+  apply_optional(state.hole_cards, delta.hole_cards, delta.cleared, HOLE_CARDS);
+  apply_optional(state.acting_seat, delta.acting_seat, delta.cleared, ACTING_SEAT);
+  state.state_sequence = delta.state_sequence;
+}
+
+}  // namespace protocol
+}  // namespace cppsim
@@ -0,0 +1,433 @@
+#include "protocol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+namespace cppsim {
+namespace protocol {
+
+namespace {
+
+// Every decision below mirrors what nlohmann::json::parse followed by
+// parse_from_envelope<action_message> and validate_action would decide.
+// Where matching that exactly would need real work (string unescaping,
+// float amounts, nlohmann's bool/float-to-integer coercions, duplicate-key
+// overwrite order) the scanner answers `unsupported` and the caller falls
+// back to the DOM path.
+
+constexpr size_t MAX_SKIP_DEPTH = 64;
+// Same limit extract_message_type_and_json applies.
+constexpr size_t MAX_MESSAGE_TYPE_LENGTH = 32;
+
+enum class step { ok, rejected, unsupported };
+
+class scanner {
+ public:
+  explicit scanner(std::string_view input) noexcept : p_(input.data()), end_(input.data() + input.size()) {}
+
+  void skip_ws() noexcept {
+    while (p_ != end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) ++p_;
+  }
+
+  [[nodiscard]] bool at_end() const noexcept { return p_ == end_; }
+  [[nodiscard]] char peek() const noexcept { return *p_; }
+  [[nodiscard]] size_t remaining() const noexcept { return static_cast<size_t>(end_ - p_); }
+
+  [[nodiscard]] bool consume(char c) noexcept {
+    skip_ws();
+    if (p_ != end_ && *p_ == c) {
+      ++p_;
+      return true;
+    }
+    return false;
+  }
+
+  // Scans a string starting at the opening quote.  `out` views the raw
+  // (still escaped) contents; `escaped` reports whether any escape occurred.
+  // \u escapes are left to the DOM path (surrogate-pair rules).
+  [[nodiscard]] step string(std::string_view& out, bool& escaped) noexcept {
+    escaped = false;
+    if (p_ == end_ || *p_ != '"') return step::rejected;
+    const char* begin = ++p_;
+    while (p_ != end_) {
+      const auto c = static_cast<unsigned char>(*p_);
+      if (c == '"') {
+        out = std::string_view(begin, static_cast<size_t>(p_ - begin));
+        ++p_;
+        return step::ok;
+      }
+      if (c < 0x20) return step::rejected;
+      if (c == '\\') {
+        escaped = true;
+        if (++p_ == end_) return step::rejected;
+        switch (*p_) {
+          case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+            ++p_;
+            continue;
+          case 'u':
+            return step::unsupported;
+          default:
+            return step::rejected;
+        }
+      }
+      if (c < 0x80) {
+        ++p_;
+        continue;
+      }
+      if (!utf8_sequence()) return step::rejected;
+    }
+    return step::rejected;
+  }
+
+  // Scans a JSON number.  `integral` is false when it has a fraction or an
+  // exponent (nlohmann stores those as floats).
+  [[nodiscard]] step number(std::string_view& out, bool& integral) noexcept {
+    const char* begin = p_;
+    integral = true;
+    if (p_ != end_ && *p_ == '-') ++p_;
+    if (p_ == end_) return step::rejected;
+    if (*p_ == '0') {
+      ++p_;
+    } else if (*p_ >= '1' && *p_ <= '9') {
+      while (p_ != end_ && is_digit(*p_)) ++p_;
+    } else {
+      return step::rejected;
+    }
+    if (p_ != end_ && *p_ == '.') {
+      integral = false;
+      ++p_;
+      if (p_ == end_ || !is_digit(*p_)) return step::rejected;
+      while (p_ != end_ && is_digit(*p_)) ++p_;
+    }
+    if (p_ != end_ && (*p_ == 'e' || *p_ == 'E')) {
+      integral = false;
+      ++p_;
+      if (p_ != end_ && (*p_ == '+' || *p_ == '-')) ++p_;
+      if (p_ == end_ || !is_digit(*p_)) return step::rejected;
+      while (p_ != end_ && is_digit(*p_)) ++p_;
+    }
+    out = std::string_view(begin, static_cast<size_t>(p_ - begin));
+    return step::ok;
+  }
+
+  [[nodiscard]] step literal(std::string_view word) noexcept {
+    if (remaining() < word.size() || std::string_view(p_, word.size()) != word) return step::rejected;
+    p_ += word.size();
+    return step::ok;
+  }
+
+  // Validates and skips one value of any type.
+  [[nodiscard]] step skip_value(size_t depth = 0) noexcept {
+    skip_ws();
+    if (p_ == end_) return step::rejected;
+    std::string_view text;
+    bool flag = false;
+    switch (*p_) {
+      case '"':
+        return string(text, flag);
+      case 't':
+        return literal("true");
+      case 'f':
+        return literal("false");
+      case 'n':
+        return literal("null");
+      case '{':
+      case '[': {
+        if (depth >= MAX_SKIP_DEPTH) return step::unsupported;
+        const bool object = *p_ == '{';
+        const char close = object ? '}' : ']';
+        ++p_;
+        if (consume(close)) return step::ok;
+        do {
+          if (object) {
+            skip_ws();
+            if (auto s = string(text, flag); s != step::ok) return s;
+            if (!consume(':')) return step::rejected;
+          }
+          if (auto s = skip_value(depth + 1); s != step::ok) return s;
+        } while (consume(','));
+        return consume(close) ? step::ok : step::rejected;
+      }
+      default:
+        return number(text, flag);
+    }
+  }
+
+ private:
+  static constexpr bool is_digit(char c) noexcept { return c >= '0' && c <= '9'; }
+
+  // Well-formed UTF-8 per RFC 3629 (no overlongs, surrogates or code points
+  // above U+10FFFF) — the same ranges nlohmann's lexer accepts.
+  [[nodiscard]] bool utf8_sequence() noexcept {
+    const auto lead = static_cast<unsigned char>(*p_);
+    size_t continuation = 0;
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      continuation = 1;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      continuation = 2;
+      if (lead == 0xE0) lo = 0xA0;
+      if (lead == 0xED) hi = 0x9F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      continuation = 3;
+      if (lead == 0xF0) lo = 0x90;
+      if (lead == 0xF4) hi = 0x8F;
+    } else {
+      return false;
+    }
+    if (remaining() <= continuation) return false;
+    ++p_;
+    for (size_t i = 0; i < continuation; ++i, ++p_) {
+      const auto c = static_cast<unsigned char>(*p_);
+      if (c < lo || c > hi) return false;
+      lo = 0x80;
+      hi = 0xBF;
+    }
+    return true;
+  }
+
+  const char* p_;
+  const char* const end_;
+};
+
+// The value shapes the ACTION fields can take.
+enum class value_kind { absent, null, string, integer, other_number, boolean, other };
+
+struct scanned_value {
+  value_kind kind{value_kind::absent};
+  std::string_view text;  // string contents or number literal
+  bool escaped{false};
+};
+
+[[nodiscard]] step scan_value(scanner& in, scanned_value& v) noexcept {
+  in.skip_ws();
+  if (in.at_end()) return step::rejected;
+  switch (in.peek()) {
+    case '"':
+      v.kind = value_kind::string;
+      return in.string(v.text, v.escaped);
+    case 'n':
+      v.kind = value_kind::null;
+      return in.literal("null");
+    case 't':
+      v.kind = value_kind::boolean;
+      return in.literal("true");
+    case 'f':
+      v.kind = value_kind::boolean;
+      return in.literal("false");
+    case '{':
+    case '[':
+      v.kind = value_kind::other;
+      return in.skip_value();
+    default: {
+      bool integral = false;
+      const step s = in.number(v.text, integral);
+      v.kind = integral ? value_kind::integer : value_kind::other_number;
+      return s;
+    }
+  }
+}
+
+// Converts an integral literal the way nlohmann stores and then reads it as
+// int64_t: non-negative literals are parsed as uint64_t and cast (so values
+// above INT64_MAX wrap), negative ones as int64_t.  Literals that overflow
+// either become floats in nlohmann — left to the DOM path.
+[[nodiscard]] step to_int64(std::string_view literal, int64_t& out) noexcept {
+  const bool negative = !literal.empty() && literal.front() == '-';
+  if (negative) literal.remove_prefix(1);
+  uint64_t magnitude = 0;
+  for (char c : literal) {
+    const auto digit = static_cast<uint64_t>(c - '0');
+    if (magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10) return step::unsupported;
+    magnitude = magnitude * 10 + digit;
+  }
+  if (negative) {
+    constexpr uint64_t MIN_MAGNITUDE = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1;
+    if (magnitude > MIN_MAGNITUDE) return step::unsupported;
+    out = magnitude == MIN_MAGNITUDE ? std::numeric_limits<int64_t>::min() : -static_cast<int64_t>(magnitude);
+  } else {
+    out = static_cast<int64_t>(magnitude);
+  }
+  return step::ok;
+}
+
+[[nodiscard]] fast_parse_status to_status(step s) noexcept {
+  return s == step::rejected ? fast_parse_status::rejected : fast_parse_status::unsupported;
+}
+
+// For failures before the message type is known (syntax errors).
+[[nodiscard]] fast_parse_status to_envelope_status(step s) noexcept {
+  return s == step::rejected ? fast_parse_status::malformed : fast_parse_status::unsupported;
+}
+
+// Scans the members of an object whose '{' has been consumed, handing each
+// key and scanner to `on_member`.  A repeated key is `unsupported`
+// (nlohmann keeps the last one; the fields here are taken as they stream by).
+template <size_t N, typename OnMember>
+[[nodiscard]] step scan_object(scanner& in, const std::string_view (&keys)[N], OnMember&& on_member) noexcept {
+  bool seen[N] = {};
+  if (in.consume('}')) return step::ok;
+  do {
+    in.skip_ws();
+    std::string_view key;
+    bool escaped = false;
+    if (auto s = in.string(key, escaped); s != step::ok) return s;
+    // An escaped key might decode to one of ours.
+    if (escaped) return step::unsupported;
+    if (!in.consume(':')) return step::rejected;
+    size_t index = N;
+    for (size_t i = 0; i < N; ++i) {
+      if (key == keys[i]) {
+        index = i;
+        break;
+      }
+    }
+    if (index == N) {
+      if (auto s = in.skip_value(); s != step::ok) return s;
+      continue;
+    }
+    if (seen[index]) return step::unsupported;
+    seen[index] = true;
+    if (auto s = on_member(index, in); s != step::ok) return s;
+  } while (in.consume(','));
+  return in.consume('}') ? step::ok : step::rejected;
+}
+
+struct action_payload {
+  scanned_value session_id;
+  scanned_value action_type;
+  scanned_value sequence_number;
+  scanned_value amount;
+};
+
+constexpr std::string_view ENVELOPE_KEYS[] = {"message_type", "protocol_version", "payload"};
+constexpr std::string_view PAYLOAD_KEYS[] = {"session_id", "action_type", "sequence_number", "amount"};
+
+[[nodiscard]] step scan_payload(scanner& in, action_payload& payload) noexcept {
+  return scan_object(in, PAYLOAD_KEYS, [&payload](size_t index, scanner& s) noexcept {
+    switch (index) {
+      case 0: return scan_value(s, payload.session_id);
+      case 1: return scan_value(s, payload.action_type);
+      case 2: return scan_value(s, payload.sequence_number);
+      default: return scan_value(s, payload.amount);
+    }
+  });
+}
+
+// Yields `rejected` where from_json would throw on the value's type, and
+// `unsupported` for the coercions only the DOM path reproduces.
+[[nodiscard]] step require_string(const scanned_value& v) noexcept {
+  if (v.kind != value_kind::string) return step::rejected;
+  return v.escaped ? step::unsupported : step::ok;
+}
+
+[[nodiscard]] step require_int64(const scanned_value& v, int64_t& out) noexcept {
+  switch (v.kind) {
+    case value_kind::integer:
+      return to_int64(v.text, out);
+    case value_kind::other_number:
+    case value_kind::boolean:
+      return step::unsupported;
+    default:
+      return step::rejected;
+  }
+}
+
+}  // namespace
+
+fast_parse_status parse_action_fast(std::string_view json_str, action_message& out) noexcept {
+  scanner in(json_str);
+
+  // nlohmann skips a leading UTF-8 byte order mark.
+  if (json_str.size() >= 3 && json_str.substr(0, 3) == "\xEF\xBB\xBF") {
+    return fast_parse_status::unsupported;
+  }
+
+  // Any top-level value other than an object has no message_type.
+  if (!in.consume('{')) {
+    return fast_parse_status::malformed;
+  }
+
+  scanned_value message_type;
+  scanned_value protocol_version;
+  bool payload_is_object = false;
+  action_payload payload;
+  const step envelope = scan_object(in, ENVELOPE_KEYS, [&](size_t index, scanner& s) noexcept {
+    switch (index) {
+      case 0: return scan_value(s, message_type);
+      case 1: return scan_value(s, protocol_version);
+      default: {
+        if (s.consume('{')) {
+          payload_is_object = true;
+          return scan_payload(s, payload);
+        }
+        scanned_value ignored;
+        return scan_value(s, ignored);
+      }
+    }
+  });
+  if (envelope != step::ok) {
+    return to_envelope_status(envelope);
+  }
+  in.skip_ws();
+  if (!in.at_end()) {
+    return fast_parse_status::malformed;
+  }
+
+  // extract_message_type_and_json
+  if (message_type.kind != value_kind::string) return fast_parse_status::malformed;
+  if (message_type.escaped) return fast_parse_status::unsupported;
+  if (message_type.text != message_types::ACTION) {
+    return message_type.text.size() > MAX_MESSAGE_TYPE_LENGTH ? fast_parse_status::malformed
+                                                              : fast_parse_status::not_action;
+  }
+
+  // parse_from_envelope: from_json(message_envelope), version check, then
+  // from_json(action_message) on an object payload.
+  if (auto s = require_string(protocol_version); s != step::ok) return to_status(s);
+  if (!payload_is_object) return fast_parse_status::rejected;
+  if (protocol_version.text != PROTOCOL_VERSION) return fast_parse_status::rejected;
+
+  if (auto s = require_string(payload.session_id); s != step::ok) return to_status(s);
+  if (auto s = require_string(payload.action_type); s != step::ok) return to_status(s);
+  int64_t sequence_number = 0;
+  if (auto s = require_int64(payload.sequence_number, sequence_number); s != step::ok) return to_status(s);
+  std::optional<int64_t> amount;
+  if (payload.amount.kind != value_kind::absent && payload.amount.kind != value_kind::null) {
+    if (payload.amount.kind != value_kind::integer) {
+      // Float amounts are converted from dollars; other types throw.
+      return payload.amount.kind == value_kind::other_number ? fast_parse_status::unsupported
+                                                             : fast_parse_status::rejected;
+    }
+    int64_t value = 0;
+    if (auto s = to_int64(payload.amount.text, value); s != step::ok) return to_status(s);
+    amount = value;
+  }
+
+  // validate_action
+  const std::string_view session_id = payload.session_id.text;
+  if (!detail::validate_session_id_format(session_id)) return fast_parse_status::rejected;
+  if (sequence_number < 0) return fast_parse_status::rejected;
+  const action_kind kind = lookup_action_kind(payload.action_type.text);
+  if (kind == action_kind::unknown) return fast_parse_status::rejected;
+  if (amount && (*amount <= 0 || *amount > MAX_AMOUNT)) return fast_parse_status::rejected;
+  if (action_requires_amount(kind) != amount.has_value()) return fast_parse_status::rejected;
+
+  try {
+    out.session_id.assign(session_id);
+    out.action_type.assign(payload.action_type.text);
+  } catch (...) {
+    return fast_parse_status::unsupported;
+  }
+  out.sequence_number = sequence_number;
+  out.amount = amount;
+  out.kind = kind;
+  return fast_parse_status::ok;
+}
+
+}  // namespace protocol
+}  // namespace cppsim
@@ -1,7 +1,6 @@
 #include "protocol.hpp"
 
 #include <algorithm>
-#include <cctype>
 #include <string_view>
 #include <unordered_set>
 
@@ -9,21 +8,13 @@ namespace cppsim {
 namespace protocol {
 namespace validation {
 
-bool is_valid_message_type(const std::string& message_type,
-                          const std::vector<std::string>& allowed_types) noexcept {
-    if (message_type.empty()) {
+bool is_valid_message_type(std::string_view message_type,
+                          std::initializer_list<message_kind> allowed_types) noexcept {
+    const message_kind kind = lookup_message_kind(message_type);
+    if (kind == message_kind::unknown) {
         return false;
     }
-    
-    // Check for control characters and ensure it's alphanumeric with underscores
-    for (char c : message_type) {
-        if (!isalnum(static_cast<unsigned char>(c)) && c != '_') {
-            return false;
-        }
-    }
-    
-    // Check against allowed types
-    return std::find(allowed_types.begin(), allowed_types.end(), message_type) != allowed_types.end();
+    return std::find(allowed_types.begin(), allowed_types.end(), kind) != allowed_types.end();
 }
 
 bool is_valid_protocol_version(const std::string& version) noexcept {
@@ -56,11 +47,7 @@ bool is_valid_session_id(const std::string& session_id) noexcept {
 }
 
 bool is_valid_action_type(const std::string& action_type) noexcept {
-    static const std::unordered_set<std::string_view> valid_actions = {
-        "FOLD", "CHECK", "CALL", "RAISE", "ALL_IN"
-    };
-    
-    return valid_actions.count(action_type) > 0;
+    return lookup_action_kind(action_type) != action_kind::unknown;
 }
 
 bool is_valid_amount(int64_t amount,
@@ -0,0 +1,582 @@
+#include "protocol.hpp"
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cppsim {
+namespace protocol {
+
+namespace {
+
+// Writes exactly what to_json() + nlohmann::json::dump() would: no spaces,
+// object keys in std::map (byte-wise sorted) order, strings escaped the way
+// dump() escapes them with ensure_ascii = false.
+class json_writer {
+ public:
+  explicit json_writer(std::string& out) noexcept : out_(out) {}
+
+  // Sizes are only needed by the binary formats.
+  void begin_object(size_t /*entries*/) {
+    separator();
+    out_ += '{';
+    first_ = true;
+  }
+
+  void end_object() {
+    out_ += '}';
+    first_ = false;
+  }
+
+  void begin_array(size_t /*elements*/) {
+    separator();
+    out_ += '[';
+    first_ = true;
+  }
+
+  void end_array() {
+    out_ += ']';
+    first_ = false;
+  }
+
+  // `name` must not need escaping (all protocol keys are plain ASCII).
+  void key(std::string_view name) {
+    separator();
+    out_ += '"';
+    out_.append(name);
+    out_ += "\":";
+    first_ = true;  // The value that follows takes no comma.
+  }
+
+  void value(std::string_view s) {
+    separator();
+    string(s);
+  }
+
+  void value(int64_t v) {
+    separator();
+    char buf[24];
+    const auto result = std::to_chars(buf, buf + sizeof(buf), v);
+    out_.append(buf, result.ptr);
+  }
+
+  void value(int v) { value(int64_t{v}); }
+
+  void value(bool v) {
+    separator();
+    out_.append(v ? "true" : "false");
+  }
+
+  void value(const std::vector<std::string>& values) {
+    begin_array(values.size());
+    for (const auto& v : values) value(v);
+    end_array();
+  }
+
+  // A complete value already encoded in this format.
+  void raw(std::string_view encoded) {
+    separator();
+    out_.append(encoded);
+  }
+
+ private:
+  void separator() {
+    if (!first_) out_ += ',';
+    first_ = false;
+  }
+
+  void string(std::string_view s) {
+    static constexpr char hex[] = "0123456789abcdef";
+    out_ += '"';
+    size_t i = 0;
+    while (i < s.size()) {
+      const auto c = static_cast<unsigned char>(s[i]);
+      if (c >= 0x80) {
+        const size_t len = utf8_sequence_length(s.substr(i));
+        if (len == 0) {
+          // dump() throws type_error 316 here; let it produce the identical
+          // exception instead of imitating its message.
+          (void)nlohmann::json(std::string(s)).dump();
+          // Should dump() ever accept what the validator rejects, still never
+          // loop on a zero-length step.
+          throw nlohmann::json::type_error::create(
+              316, "invalid UTF-8 byte at index " + std::to_string(i), nullptr);
+        }
+        out_.append(s.data() + i, len);
+        i += len;
+        continue;
+      }
+      switch (c) {
+        case '"': out_.append("\\\""); break;
+        case '\\': out_.append("\\\\"); break;
+        case '\b': out_.append("\\b"); break;
+        case '\f': out_.append("\\f"); break;
+        case '\n': out_.append("\\n"); break;
+        case '\r': out_.append("\\r"); break;
+        case '\t': out_.append("\\t"); break;
+        default:
+          if (c < 0x20) {
+            const char escape[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+            out_.append(escape, sizeof(escape));
+          } else {
+            out_ += static_cast<char>(c);
+          }
+      }
+      ++i;
+    }
+    out_ += '"';
+  }
+
+  // Length of the well-formed UTF-8 sequence (RFC 3629: no overlongs,
+  // surrogates or code points past U+10FFFF) starting `s`, or 0.
+  [[nodiscard]] static size_t utf8_sequence_length(std::string_view s) noexcept {
+    const auto b0 = static_cast<unsigned char>(s[0]);
+    size_t len = 0;
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xBF;
+    if (b0 >= 0xC2 && b0 <= 0xDF) {
+      len = 2;
+    } else if (b0 >= 0xE0 && b0 <= 0xEF) {
+      len = 3;
+      if (b0 == 0xE0) lo = 0xA0;
+      if (b0 == 0xED) hi = 0x9F;
+    } else if (b0 >= 0xF0 && b0 <= 0xF4) {
+      len = 4;
+      if (b0 == 0xF0) lo = 0x90;
+      if (b0 == 0xF4) hi = 0x8F;
+    } else {
+      return 0;
+    }
+    if (s.size() < len) return 0;
+    const auto b1 = static_cast<unsigned char>(s[1]);
+    if (b1 < lo || b1 > hi) return 0;
+    for (size_t k = 2; k < len; ++k) {
+      const auto b = static_cast<unsigned char>(s[k]);
+      if (b < 0x80 || b > 0xBF) return 0;
+    }
+    return len;
+  }
+
+  std::string& out_;
+  bool first_{true};
+};
+
+enum class binary_format { cbor, msgpack };
+
+// Writes exactly what nlohmann::json::to_cbor() / to_msgpack() write for the
+// to_json() tree: the same (sorted) key order and the same smallest-width
+// integer, string, array and map headers.  Like those, it does not validate
+// UTF-8.
+template <binary_format Format>
+class binary_writer {
+ public:
+  explicit binary_writer(std::string& out) noexcept : out_(out) {}
+
+  void begin_object(size_t entries) {
+    if constexpr (Format == binary_format::cbor) {
+      cbor_head(5, entries);
+    } else {
+      msgpack_head(entries, 0x80, 15, 0xDE);
+    }
+  }
+  void end_object() {}
+
+  void begin_array(size_t elements) {
+    if constexpr (Format == binary_format::cbor) {
+      cbor_head(4, elements);
+    } else {
+      msgpack_head(elements, 0x90, 15, 0xDC);
+    }
+  }
+  void end_array() {}
+
+  void key(std::string_view name) { value(name); }
+
+  void value(std::string_view s) {
+    if constexpr (Format == binary_format::cbor) {
+      cbor_head(3, s.size());
+    } else if (s.size() <= 31) {
+      byte(0xA0 | s.size());
+    } else if (s.size() <= 0xFF) {
+      byte(0xD9);
+      byte(s.size());
+    } else {
+      msgpack_head(s.size(), 0, 0, 0xDA);
+    }
+    out_.append(s);
+  }
+
+  void value(int64_t v) {
+    if constexpr (Format == binary_format::cbor) {
+      if (v >= 0) {
+        cbor_head(0, static_cast<uint64_t>(v));
+      } else {
+        cbor_head(1, static_cast<uint64_t>(-1 - v));
+      }
+    } else if (v >= 0) {
+      const auto u = static_cast<uint64_t>(v);
+      if (u < 0x80) {
+        byte(u);
+      } else if (u <= 0xFF) {
+        byte(0xCC);
+        byte(u);
+      } else if (u <= 0xFFFF) {
+        byte(0xCD);
+        big_endian(u, 2);
+      } else if (u <= 0xFFFFFFFF) {
+        byte(0xCE);
+        big_endian(u, 4);
+      } else {
+        byte(0xCF);
+        big_endian(u, 8);
+      }
+    } else {
+      const auto bits = static_cast<uint64_t>(v);  // Two's complement.
+      if (v >= -32) {
+        byte(bits & 0xFF);
+      } else if (v >= INT8_MIN) {
+        byte(0xD0);
+        byte(bits & 0xFF);
+      } else if (v >= INT16_MIN) {
+        byte(0xD1);
+        big_endian(bits, 2);
+      } else if (v >= INT32_MIN) {
+        byte(0xD2);
+        big_endian(bits, 4);
+      } else {
+        byte(0xD3);
+        big_endian(bits, 8);
+      }
+    }
+  }
+
+  void value(int v) { value(int64_t{v}); }
+
+  void value(bool v) {
+    if constexpr (Format == binary_format::cbor) {
+      byte(v ? 0xF5 : 0xF4);
+    } else {
+      byte(v ? 0xC3 : 0xC2);
+    }
+  }
+
+  void value(const std::vector<std::string>& values) {
+    begin_array(values.size());
+    for (const auto& v : values) value(v);
+  }
+
+  void raw(std::string_view encoded) { out_.append(encoded); }
+
+ private:
+  void byte(uint64_t b) { out_ += static_cast<char>(static_cast<unsigned char>(b)); }
+
+  void big_endian(uint64_t v, int bytes) {
+    for (int shift = 8 * (bytes - 1); shift >= 0; shift -= 8) {
+      byte((v >> shift) & 0xFF);
+    }
+  }
+
+  // Major type plus argument in the shortest form (RFC 8949 §3).
+  void cbor_head(uint64_t major, uint64_t n) {
+    const uint64_t type = major << 5;
+    if (n <= 23) {
+      byte(type | n);
+    } else if (n <= 0xFF) {
+      byte(type | 24);
+      byte(n);
+    } else if (n <= 0xFFFF) {
+      byte(type | 25);
+      big_endian(n, 2);
+    } else if (n <= 0xFFFFFFFF) {
+      byte(type | 26);
+      big_endian(n, 4);
+    } else {
+      byte(type | 27);
+      big_endian(n, 8);
+    }
+  }
+
+  // fix-form up to `fix_max`, else the 16-bit form and then the 32-bit one
+  // (`wide`, `wide + 1`).
+  void msgpack_head(size_t n, uint64_t fix, size_t fix_max, uint64_t wide) {
+    if (n <= fix_max) {
+      byte(fix | n);
+    } else if (n <= 0xFFFF) {
+      byte(wide);
+      big_endian(n, 2);
+    } else {
+      byte(wide + 1);
+      big_endian(n, 4);
+    }
+  }
+
+  std::string& out_;
+};
+
+// Payload bodies: keys in to_json()'s (sorted) order.
+
+template <typename Writer>
+void write_stacks(Writer& w, const std::vector<player_stack>& stacks) {
+  w.begin_array(stacks.size());
+  for (const auto& p : stacks) {
+    w.begin_object(2);
+    w.key("seat");
+    w.value(p.seat);
+    w.key("stack");
+    w.value(p.stack);
+    w.end_object();
+  }
+  w.end_array();
+}
+
+template <typename Writer>
+void write_payload(Writer& w, const state_update_message& msg) {
+  w.begin_object(5 + size_t{msg.acting_seat.has_value()} + size_t{msg.community_cards.has_value()} +
+                 size_t{msg.hole_cards.has_value()} + size_t{msg.state_sequence.has_value()});
+  if (msg.acting_seat) {
+    w.key("acting_seat");
+    w.value(*msg.acting_seat);
+  }
+  if (msg.community_cards) {
+    w.key("community_cards");
+    w.value(*msg.community_cards);
+  }
+  w.key("current_bet");
+  w.value(msg.current_bet);
+  w.key("game_phase");
+  w.value(msg.game_phase);
+  if (msg.hole_cards) {
+    w.key("hole_cards");
+    w.value(*msg.hole_cards);
+  }
+  w.key("player_stacks");
+  write_stacks(w, msg.player_stacks);
+  w.key("pot_size");
+  w.value(msg.pot_size);
+  if (msg.state_sequence) {
+    w.key("state_sequence");
+    w.value(*msg.state_sequence);
+  }
+  w.key("valid_actions");
+  w.value(msg.valid_actions);
+  w.end_object();
+}
+
+template <typename Writer>
+void write_payload(Writer& w, const state_delta_message& msg) {
+  w.begin_object(2 + size_t{msg.acting_seat.has_value()} + size_t{!msg.cleared.empty()} +
+                 size_t{msg.community_cards.has_value()} + size_t{msg.current_bet.has_value()} +
+                 size_t{msg.game_phase.has_value()} + size_t{msg.hole_cards.has_value()} +
+                 size_t{!msg.player_stacks.empty()} + size_t{msg.pot_size.has_value()} +
+                 size_t{!msg.removed_seats.empty()} + size_t{msg.valid_actions.has_value()});
+  if (msg.acting_seat) {
+    w.key("acting_seat");
+    w.value(*msg.acting_seat);
+  }
+  w.key("base_sequence");
+  w.value(msg.base_sequence);
+  if (!msg.cleared.empty()) {
+    w.key("cleared");
+    w.value(msg.cleared);
+  }
+  if (msg.community_cards) {
+    w.key("community_cards");
+    w.value(*msg.community_cards);
+  }
+  if (msg.current_bet) {
+    w.key("current_bet");
+    w.value(*msg.current_bet);
+  }
+  if (msg.game_phase) {
+    w.key("game_phase");
+    w.value(*msg.game_phase);
+  }
+  if (msg.hole_cards) {
+    w.key("hole_cards");
+    w.value(*msg.hole_cards);
+  }
+  if (!msg.player_stacks.empty()) {
+    w.key("player_stacks");
+    write_stacks(w, msg.player_stacks);
+  }
+  if (msg.pot_size) {
+    w.key("pot_size");
+    w.value(*msg.pot_size);
+  }
+  if (!msg.removed_seats.empty()) {
+    w.key("removed_seats");
+    w.begin_array(msg.removed_seats.size());
+    for (const int seat : msg.removed_seats) w.value(seat);
+    w.end_array();
+  }
+  w.key("state_sequence");
+  w.value(msg.state_sequence);
+  if (msg.valid_actions) {
+    w.key("valid_actions");
+    w.value(*msg.valid_actions);
+  }
+  w.end_object();
+}
+
+template <typename Writer>
+void write_payload(Writer& w, const error_message& msg) {
+  w.begin_object(2 + size_t{msg.session_id.has_value()});
+  w.key("error_code");
+  w.value(msg.error_code);
+  w.key("message");
+  w.value(msg.message);
+  if (msg.session_id) {
+    w.key("session_id");
+    w.value(*msg.session_id);
+  }
+  w.end_object();
+}
+
+template <typename Writer>
+void write_payload(Writer& w, const handshake_response& msg) {
+  w.begin_object(3 + size_t{msg.encoding.has_value()});
+  if (msg.encoding) {
+    w.key("encoding");
+    w.value(*msg.encoding);
+  }
+  w.key("seat_number");
+  w.value(msg.seat_number);
+  w.key("session_id");
+  w.value(msg.session_id);
+  w.key("starting_stack");
+  w.value(msg.starting_stack);
+  w.end_object();
+}
+
+template <typename Writer>
+void write_payload(Writer& w, const reload_response_message& msg) {
+  w.begin_object(2);
+  w.key("granted");
+  w.value(msg.granted);
+  w.key("new_stack");
+  w.value(msg.new_stack);
+  w.end_object();
+}
+
+// Outbound BATCH body: messages already serialized in the writer's format.
+struct batch_payload {
+  const std::vector<std::string>& messages;
+};
+
+template <typename Writer>
+void write_payload(Writer& w, const batch_payload& msg) {
+  w.begin_object(1);
+  w.key("messages");
+  w.begin_array(msg.messages.size());
+  for (const auto& m : msg.messages) w.raw(m);
+  w.end_array();
+  w.end_object();
+}
+
+// {"message_type":...,"payload":<body>,"protocol_version":...}
+template <typename Writer, typename Message>
+void write_envelope(std::string& out, const char* message_type, const Message& msg) {
+  Writer w(out);
+  w.begin_object(3);
+  w.key("message_type");
+  w.value(std::string_view(message_type));
+  w.key("payload");
+  write_payload(w, msg);
+  w.key("protocol_version");
+  w.value(std::string_view(PROTOCOL_VERSION));
+  w.end_object();
+}
+
+template <typename Message>
+void write_message(std::string& out, const char* message_type, const Message& msg, wire_encoding encoding) {
+  switch (encoding) {
+    case wire_encoding::cbor:
+      write_envelope<binary_writer<binary_format::cbor>>(out, message_type, msg);
+      return;
+    case wire_encoding::msgpack:
+      write_envelope<binary_writer<binary_format::msgpack>>(out, message_type, msg);
+      return;
+    case wire_encoding::json:
+      break;
+  }
+  write_envelope<json_writer>(out, message_type, msg);
+}
+
+template <typename Message>
+std::string serialize_with(const char* message_type, const Message& msg, wire_encoding encoding, size_t reserve) {
+  std::string out;
+  out.reserve(reserve);
+  write_message(out, message_type, msg, encoding);
+  return out;
+}
+
+// Envelope keys, punctuation and protocol version.
+constexpr size_t ENVELOPE_OVERHEAD = 64;
+
+}  // namespace
+
+void write_state_update(std::string& out, const state_update_message& msg, wire_encoding encoding) {
+  write_message(out, message_types::STATE_UPDATE, msg, encoding);
+}
+
+void write_error(std::string& out, const error_message& msg, wire_encoding encoding) {
+  write_message(out, message_types::ERROR, msg, encoding);
+}
+
+void write_handshake_response(std::string& out, const handshake_response& msg) {
+  write_message(out, message_types::HANDSHAKE_RESPONSE, msg, wire_encoding::json);
+}
+
+void write_reload_response(std::string& out, const reload_response_message& msg, wire_encoding encoding) {
+  write_message(out, message_types::RELOAD_RESPONSE, msg, encoding);
+}
+
+std::string serialize_state_update(const state_update_message& msg, wire_encoding encoding) {
+  // ~32 bytes per stack entry and card; exact sizing is not worth a pass.
+  const size_t items = msg.player_stacks.size() + msg.valid_actions.size() +
+                       (msg.community_cards ? msg.community_cards->size() : 0) +
+                       (msg.hole_cards ? msg.hole_cards->size() : 0);
+  return serialize_with(message_types::STATE_UPDATE, msg, encoding, ENVELOPE_OVERHEAD + 128 + 32 * items);
+}
+
+void write_state_delta(std::string& out, const state_delta_message& msg, wire_encoding encoding) {
+  write_message(out, message_types::STATE_DELTA, msg, encoding);
+}
+
+std::string serialize_state_delta(const state_delta_message& msg, wire_encoding encoding) {
+  const size_t items = msg.player_stacks.size() + msg.removed_seats.size() + msg.cleared.size() +
+                       (msg.valid_actions ? msg.valid_actions->size() : 0) +
+                       (msg.community_cards ? msg.community_cards->size() : 0) +
+                       (msg.hole_cards ? msg.hole_cards->size() : 0);
+  return serialize_with(message_types::STATE_DELTA, msg, encoding, ENVELOPE_OVERHEAD + 64 + 32 * items);
+}
+
+void write_batch(std::string& out, const std::vector<std::string>& messages, wire_encoding encoding) {
+  write_message(out, message_types::BATCH, batch_payload{messages}, encoding);
+}
+
+std::string serialize_batch(const std::vector<std::string>& messages, wire_encoding encoding) {
+  size_t bytes = ENVELOPE_OVERHEAD + 16;
+  for (const auto& m : messages) bytes += m.size() + 1;
+  return serialize_with(message_types::BATCH, batch_payload{messages}, encoding, bytes);
+}
+
+std::string serialize_error(const error_message& msg, wire_encoding encoding) {
+  return serialize_with(message_types::ERROR, msg, encoding,
+                        ENVELOPE_OVERHEAD + 64 + msg.error_code.size() + msg.message.size());
+}
+
+std::string serialize_handshake_response(const handshake_response& msg) {
+  return serialize_with(message_types::HANDSHAKE_RESPONSE, msg, wire_encoding::json,
+                        ENVELOPE_OVERHEAD + 112 + msg.session_id.size());
+}
+
+std::string serialize_reload_response(const reload_response_message& msg, wire_encoding encoding) {
+  return serialize_with(message_types::RELOAD_RESPONSE, msg, encoding, ENVELOPE_OVERHEAD + 48);
+}
+
+}  // namespace protocol
+}  // namespace cppsim
@@ -0,0 +1,402 @@
+#include "async_logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+#include "log_record.hpp"
+
+namespace cppsim {
+namespace server {
+
+namespace {
+
+constexpr size_t RECORD_HEADER_SIZE = 16;
+constexpr size_t RECORD_TEXT_SIZE = async_logger::LOG_RECORD_SIZE - RECORD_HEADER_SIZE;
+constexpr std::string_view TRUNCATION_MARK = "...";
+
+// One ring slot.  The first slot of an entry carries the timestamp, level,
+// kind and slot count; continuation slots only carry bytes.
+struct log_slot {
+  int64_t timestamp_ns;
+  uint32_t length;  // Bytes in this slot.
+  uint8_t level;
+  uint8_t parts;    // Slots in the entry (first slot only).
+  log_entry_kind kind;  // First slot only.
+  uint8_t reserved;
+  char text[RECORD_TEXT_SIZE];
+};
+static_assert(sizeof(log_slot) == async_logger::LOG_RECORD_SIZE, "log_slot must fill one slot exactly");
+// Records are never cut, so the largest must fit in one entry.
+static_assert(LOG_RECORD_MAX_SIZE <= RECORD_TEXT_SIZE * async_logger::MAX_RECORDS_PER_LINE,
+              "a structured record must fit MAX_RECORDS_PER_LINE slots");
+
+std::atomic<uint64_t> next_logger_id{1};
+
+int64_t now_ns() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t round_up_pow2(size_t n) noexcept {
+  size_t p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+}  // namespace
+
+// A line drained from a ring, its text stored in the flusher's arena.
+struct pending_line {
+  int64_t timestamp_ns;
+  log_level level;
+  log_entry_kind kind;
+  size_t offset;
+  size_t length;
+};
+
+// Single-producer / single-consumer ring of log_slots.  The owning thread
+// pushes; the flusher drains.
+class log_ring final {
+ public:
+  explicit log_ring(size_t records)
+      : mask_(round_up_pow2(std::max(records, async_logger::MAX_RECORDS_PER_LINE)) - 1),
+        records_(std::make_unique<log_slot[]>(mask_ + 1)) {}
+
+  // Producer.  Returns false, writing nothing, when the line does not fit;
+  // otherwise `half_full` says whether the flusher should be woken early.
+  [[nodiscard]] bool try_push(log_level level, log_entry_kind kind, int64_t timestamp_ns, std::string_view msg,
+                              bool& half_full) noexcept {
+    constexpr size_t MAX_TEXT = RECORD_TEXT_SIZE * async_logger::MAX_RECORDS_PER_LINE;
+    const bool truncated = msg.size() > MAX_TEXT;
+    if (truncated) msg = msg.substr(0, MAX_TEXT - TRUNCATION_MARK.size());
+    const size_t total = msg.size() + (truncated ? TRUNCATION_MARK.size() : 0);
+    const size_t parts = std::max<size_t>(1, (total + RECORD_TEXT_SIZE - 1) / RECORD_TEXT_SIZE);
+
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    const size_t capacity = mask_ + 1;
+    if (capacity - (head - cached_tail_) < parts) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (capacity - (head - cached_tail_) < parts) return false;
+    }
+
+    size_t copied = 0;
+    for (size_t i = 0; i < parts; ++i) {
+      log_slot& r = records_[(head + i) & mask_];
+      size_t n = std::min(RECORD_TEXT_SIZE, msg.size() - std::min(copied, msg.size()));
+      std::memcpy(r.text, msg.data() + copied, n);
+      copied += n;
+      if (truncated && i + 1 == parts) {
+        std::memcpy(r.text + n, TRUNCATION_MARK.data(), TRUNCATION_MARK.size());
+        n += TRUNCATION_MARK.size();
+      }
+      r.length = static_cast<uint32_t>(n);
+      r.parts = static_cast<uint8_t>(i == 0 ? parts : 0);
+    }
+    log_slot& first = records_[head & mask_];
+    first.timestamp_ns = timestamp_ns;
+    first.level = static_cast<uint8_t>(level);
+    first.kind = kind;
+    head_.store(head + parts, std::memory_order_release);
+
+    half_full = 2 * (head + parts - cached_tail_) >= capacity;
+    if (half_full) {
+      // The cached tail may be stale; only wake the flusher if it really is.
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      half_full = 2 * (head + parts - cached_tail_) >= capacity;
+    }
+    return true;
+  }
+
+  // Consumer.  Appends every published line to `lines` / `arena`.
+  void drain_into(std::string& arena, std::vector<pending_line>& lines) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    while (tail < head) {
+      const log_slot& first = records_[tail & mask_];
+      const size_t parts = first.parts;
+      pending_line line{first.timestamp_ns, static_cast<log_level>(first.level), first.kind, arena.size(), 0};
+      for (size_t i = 0; i < parts; ++i) {
+        const log_slot& r = records_[(tail + i) & mask_];
+        arena.append(r.text, r.length);
+        line.length += r.length;
+      }
+      lines.push_back(line);
+      tail += parts;
+    }
+    tail_.store(tail, std::memory_order_release);
+  }
+
+  [[nodiscard]] bool empty() const noexcept {
+    return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+  }
+
+  // Set when the owning thread exits or moves to another logger; the
+  // flusher drops the ring once it has drained it.
+  std::atomic<bool> retired{false};
+
+ private:
+  const size_t mask_;
+  std::unique_ptr<log_slot[]> records_;
+  alignas(64) std::atomic<uint64_t> head_{0};
+  uint64_t cached_tail_{0};  // Producer's last view of tail_.
+  alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
+namespace {
+
+// The calling thread's ring, for the logger it last logged through.
+struct thread_ring_cache {
+  uint64_t logger_id = 0;
+  std::shared_ptr<log_ring> ring;
+
+  ~thread_ring_cache() {
+    if (ring) ring->retired.store(true, std::memory_order_release);
+  }
+};
+
+thread_local thread_ring_cache t_ring;
+
+}  // namespace
+
+async_logger::async_logger(const async_log_options& options)
+    : options_(options), id_(next_logger_id.fetch_add(1, std::memory_order_relaxed)) {
+  if (!options_.binary_path.empty()) {
+    binary_ = std::make_unique<binary_log_writer>(options_.binary_path, options_.binary_file_max_bytes,
+                                                  options_.binary_files_kept);
+  }
+  flusher_ = std::thread([this] { run(); });
+}
+
+async_logger::~async_logger() noexcept {
+  stop();
+}
+
+log_ring* async_logger::ring_for_this_thread() noexcept {
+  if (t_ring.logger_id == id_) {
+    return t_ring.ring.get();
+  }
+  try {
+    auto ring = std::make_shared<log_ring>(options_.ring_records);
+    {
+      std::lock_guard<std::mutex> lock(rings_mutex_);
+      rings_.push_back(ring);
+    }
+    if (t_ring.ring) t_ring.ring->retired.store(true, std::memory_order_release);
+    t_ring.logger_id = id_;
+    t_ring.ring = std::move(ring);
+    return t_ring.ring.get();
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+bool async_logger::log(log_level level, std::string_view msg) noexcept {
+  return push(level, log_entry_kind::text, msg);
+}
+
+bool async_logger::log_record(log_level level, std::string_view record) noexcept {
+  return push(level, log_entry_kind::record, record);
+}
+
+bool async_logger::push(log_level level, log_entry_kind kind, std::string_view bytes) noexcept {
+  if (!running_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  log_ring* ring = ring_for_this_thread();
+  if (!ring) {
+    return false;
+  }
+
+  const int64_t now = now_ns();
+  bool half_full = false;
+  while (!ring->try_push(level, kind, now, bytes, half_full)) {
+    wake_flusher();
+    if (options_.overflow == log_overflow_policy::drop) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    if (!running_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds{50});
+  }
+  if (half_full) {
+    wake_flusher();
+  }
+  return true;
+}
+
+void async_logger::wake_flusher() noexcept {
+  if (wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+    return;  // Already on its way.
+  }
+  try {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_requested_ = true;
+  } catch (...) {
+    // Lock failure — the flusher still runs on its interval.
+  }
+  wake_.notify_one();
+}
+
+void async_logger::flush() noexcept {
+  try {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    const uint64_t target = ++flush_requested_;
+    wake_.notify_one();
+    flushed_.wait(lock, [this, target] { return flush_completed_ >= target || flusher_exited_; });
+  } catch (...) {
+    // Lock failure — nothing more we can do for the caller.
+  }
+}
+
+void async_logger::stop() noexcept {
+  try {
+    std::call_once(stop_once_, [this] {
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        running_.store(false, std::memory_order_release);
+      }
+      wake_.notify_all();
+      if (flusher_.joinable()) {
+        flusher_.join();
+      }
+      // Lines pushed while the flusher made its final pass.
+      drain_and_write();
+    });
+  } catch (...) {
+    // join() or a final write failed; the lines still queued are lost.
+  }
+}
+
+void async_logger::run() noexcept {
+  std::unique_lock<std::mutex> lock(wake_mutex_);
+  for (;;) {
+    wake_.wait_for(lock, options_.flush_interval, [this] {
+      return wake_requested_ || flush_requested_ != flush_completed_ ||
+             !running_.load(std::memory_order_acquire);
+    });
+    wake_requested_ = false;
+    wake_pending_.store(false, std::memory_order_release);
+    const uint64_t flush_target = flush_requested_;
+    const bool stopping = !running_.load(std::memory_order_acquire);
+
+    lock.unlock();
+    try {
+      drain_and_write();
+    } catch (...) {
+      // Allocation failure while formatting: these lines are lost, the next
+      // pass starts afresh.
+    }
+    lock.lock();
+
+    flush_completed_ = flush_target;
+    if (stopping) {
+      flusher_exited_ = true;
+      flushed_.notify_all();
+      return;
+    }
+    flushed_.notify_all();
+  }
+}
+
+void async_logger::drain_and_write() {
+  arena_.clear();
+  lines_.clear();
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    for (auto it = rings_.begin(); it != rings_.end();) {
+      // Read retired first: a ring retired before the drain is empty after it.
+      const bool retired = (*it)->retired.load(std::memory_order_acquire);
+      (*it)->drain_into(arena_, lines_);
+      it = retired ? rings_.erase(it) : it + 1;
+    }
+  }
+
+  // Each ring is in order; interleave the threads by time.
+  std::stable_sort(lines_.begin(), lines_.end(), [](const pending_line& a, const pending_line& b) {
+    return a.timestamp_ns < b.timestamp_ns;
+  });
+
+  info_out_.clear();
+  error_out_.clear();
+  for (const auto& line : lines_) {
+    const std::string_view payload = std::string_view(arena_).substr(line.offset, line.length);
+    if (binary_) {
+      binary_->append(line.timestamp_ns, line.level, line.kind, payload);
+      // Errors are rare and wanted on the console as well.
+      if (line.level != log_level::error) continue;
+    }
+    std::string& out = line.level == log_level::error ? error_out_ : info_out_;
+    append_prefix(out, line.timestamp_ns, line.level);
+    if (line.kind == log_entry_kind::record) {
+      if (!format_log_record(payload, out)) {
+        out += "[Logger] Malformed log record";
+      }
+    } else {
+      out.append(payload);
+    }
+    out += '\n';
+  }
+
+  const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped != dropped_reported_) {
+    const int64_t now = now_ns();
+    const std::string report =
+        "[Logger] Dropped " + std::to_string(dropped - dropped_reported_) + " log lines (ring full)";
+    append_prefix(error_out_, now, log_level::error);
+    error_out_ += report;
+    error_out_ += '\n';
+    if (binary_) {
+      binary_->append(now, log_level::error, log_entry_kind::text, report);
+    }
+    dropped_reported_ = dropped;
+  }
+
+  if (binary_ && !binary_->flush() && !binary_failed_) {
+    // Reported once; the writer retries with a fresh file on every pass.
+    binary_failed_ = true;
+    const int64_t now = now_ns();
+    append_prefix(error_out_, now, log_level::error);
+    error_out_ += "[Logger] Failed to write binary log " + binary_->path() + "\n";
+  }
+
+  for (auto [stream, out] : {std::pair{options_.info_stream, &info_out_}, std::pair{options_.error_stream, &error_out_}}) {
+    if (!out->empty() && stream) {
+      std::fwrite(out->data(), 1, out->size(), stream);
+      std::fflush(stream);
+    }
+  }
+}
+
+void async_logger::append_prefix(std::string& out, int64_t timestamp_ns, log_level level) {
+  constexpr int64_t NS_PER_SECOND = 1'000'000'000;
+  constexpr int64_t NS_PER_MS = 1'000'000;
+  const int64_t second = timestamp_ns / NS_PER_SECOND;
+  if (second != cached_second_) {
+    // Lines come in batches from the same second or so: run gmtime and
+    // strftime once per second rather than once per line.
+    const auto t = static_cast<std::time_t>(second);
+    std::tm tm_buf{};
+#ifdef _WIN32
+    gmtime_s(&tm_buf, &t);
+#else
+    gmtime_r(&t, &tm_buf);
+#endif
+    if (std::strftime(cached_timestamp_, sizeof(cached_timestamp_), "%Y-%m-%d %H:%M:%S", &tm_buf) == 0) {
+      std::snprintf(cached_timestamp_, sizeof(cached_timestamp_), "ts-err");
+    }
+    cached_second_ = second;
+  }
+  char ms[8];
+  std::snprintf(ms, sizeof(ms), ".%03d ", static_cast<int>((timestamp_ns % NS_PER_SECOND) / NS_PER_MS));
+  out.append(cached_timestamp_);
+  out.append(ms);
+  out.append(log_level_to_string(level));
+  out += ' ';
+}
+
+}  // namespace server
+}  // namespace cppsim
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "binary_log.hpp"
+#include "log_record.hpp"
+#include "logger.hpp"
+
+namespace cppsim {
+namespace server {
+
+class log_ring;
+struct pending_line;
+
+// Asynchronous line logger.
+//
+// Each thread that logs gets its own single-producer ring of fixed-size
+// records (LOG_RECORD_SIZE bytes; longer lines span consecutive records), so
+// producers never contend with each other: log() is a timestamp read, a copy
+// and one release store.  A background thread drains every ring each
+// `flush_interval` — or as soon as one is half full — orders the lines by
+// timestamp, formats them and writes each stream with a single fwrite.
+//
+// With a binary_path the flusher writes entries — structured records still
+// unformatted — to a binary log instead of info_stream.
+//
+// When a ring is full the overflow policy either drops the line (counted,
+// and reported by the flusher as one line) or makes the producer wait for
+// the flusher.
+class async_logger final {
+ public:
+  static constexpr size_t LOG_RECORD_SIZE = 256;
+  // Longest line kept, in records; the rest is cut and marked with "...".
+  static constexpr size_t MAX_RECORDS_PER_LINE = 16;
+
+  explicit async_logger(const async_log_options& options);
+  // Stops, writing everything still queued.
+  ~async_logger() noexcept;
+
+  async_logger(const async_logger&) = delete;
+  async_logger& operator=(const async_logger&) = delete;
+
+  // Queues one line.  Returns false if the logger did not take it — it is
+  // stopped, or the thread's ring could not be allocated — so the caller can
+  // write it some other way.  A line dropped by the overflow policy counts
+  // as taken.
+  bool log(log_level level, std::string_view msg) noexcept;
+  // Queues an encoded structured record (log_record.hpp); the flusher
+  // formats it.  Same return value as log().
+  bool log_record(log_level level, std::string_view record) noexcept;
+
+  // Returns once every line queued before the call has been written.
+  void flush() noexcept;
+
+  // Writes everything queued and joins the background thread.  Idempotent.
+  void stop() noexcept;
+
+  [[nodiscard]] uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  // The calling thread's ring for this logger, registered on first use.
+  log_ring* ring_for_this_thread() noexcept;
+  bool push(log_level level, log_entry_kind kind, std::string_view bytes) noexcept;
+  void run() noexcept;
+  // Drains all rings and writes the lines.  Flusher thread (or stop()) only.
+  void drain_and_write();
+  void append_prefix(std::string& out, int64_t timestamp_ns, log_level level);
+  void wake_flusher() noexcept;
+
+  const async_log_options options_;
+  const uint64_t id_;  // Tells this logger's rings apart in the thread cache.
+
+  std::mutex rings_mutex_;
+  std::vector<std::shared_ptr<log_ring>> rings_;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  std::condition_variable flushed_;
+  bool wake_requested_{false};  // Guarded by wake_mutex_.
+  uint64_t flush_requested_{0};  // Guarded by wake_mutex_.
+  uint64_t flush_completed_{0};  // Guarded by wake_mutex_.
+  bool flusher_exited_{false};   // Guarded by wake_mutex_.
+  std::atomic<bool> wake_pending_{false};  // Coalesces producer wake-ups.
+  std::once_flag stop_once_;
+
+  std::atomic<bool> running_{true};
+  std::atomic<uint64_t> dropped_{0};
+  uint64_t dropped_reported_{0};  // Flusher-only.
+
+  // Flusher-only scratch, reused across passes.
+  std::string arena_;
+  std::vector<pending_line> lines_;
+  std::string info_out_;
+  std::string error_out_;
+  std::unique_ptr<binary_log_writer> binary_;  // Null unless binary_path is set.
+  bool binary_failed_{false};                  // A write error has been reported.
+  int64_t cached_second_{-1};
+  char cached_timestamp_[32]{};
+
+  std::thread flusher_;
+};
+
+}  // namespace server
+}  // namespace cppsim
@@ -0,0 +1,298 @@
+#include "binary_log.hpp"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <utility>
+
+namespace cppsim {
+namespace server {
+
+namespace {
+
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr uint8_t RECORD_FLAG = 0x80;
+constexpr int64_t NS_PER_SECOND = 1'000'000'000;
+constexpr int64_t NS_PER_MS = 1'000'000;
+
+template <typename T>
+void append_raw(std::string& out, T value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  out.append(bytes, sizeof(T));
+}
+
+void append_varint(std::string& out, uint64_t value) {
+  while (value >= 0x80) {
+    out += static_cast<char>((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+uint64_t zigzag(int64_t value) noexcept {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) noexcept {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+std::string rotated_path(const std::string& path, size_t index) {
+  return path + "." + std::to_string(index);
+}
+
+}  // namespace
+
+binary_log_writer::binary_log_writer(std::string path, uint64_t max_file_bytes, size_t files_kept)
+    : path_(std::move(path)), max_file_bytes_(max_file_bytes), files_kept_(files_kept) {
+  std::error_code ec;
+  const auto parent = std::filesystem::path(path_).parent_path();
+  if (!parent.empty()) {
+    std::filesystem::create_directories(parent, ec);
+  }
+  if (std::filesystem::exists(path_, ec)) {
+    rotate();
+  }
+}
+
+binary_log_writer::~binary_log_writer() noexcept {
+  flush();
+  if (file_) {
+    std::fclose(file_);
+  }
+}
+
+void binary_log_writer::append(int64_t timestamp_ns, log_level level, log_entry_kind kind,
+                               std::string_view payload) {
+  if (buffer_.empty()) {
+    buffer_base_ns_ = last_timestamp_ns_;
+  }
+  append_varint(buffer_, zigzag(timestamp_ns - last_timestamp_ns_));
+  buffer_ += static_cast<char>(static_cast<uint8_t>(level) | (kind == log_entry_kind::record ? RECORD_FLAG : 0));
+  append_varint(buffer_, payload.size());
+  buffer_.append(payload);
+  last_timestamp_ns_ = timestamp_ns;
+}
+
+bool binary_log_writer::flush() noexcept {
+  if (buffer_.empty()) {
+    return true;
+  }
+  if (file_ && file_bytes_ > BINARY_LOG_HEADER_SIZE && file_bytes_ + buffer_.size() > max_file_bytes_) {
+    std::fclose(file_);
+    file_ = nullptr;
+    rotate();
+  }
+  // A new file's deltas start from its header's base timestamp, which must
+  // be the timestamp the buffered deltas are relative to.
+  bool ok = file_ || open_file(buffer_base_ns_);
+  if (ok) {
+    ok = std::fwrite(buffer_.data(), 1, buffer_.size(), file_) == buffer_.size() && std::fflush(file_) == 0;
+    file_bytes_ += buffer_.size();
+  }
+  if (!ok && file_) {
+    // The file may now end mid-entry; later entries would not decode.
+    std::fclose(file_);
+    file_ = nullptr;
+    rotate();
+  }
+  buffer_.clear();
+  return ok;
+}
+
+bool binary_log_writer::open_file(int64_t base_timestamp_ns) noexcept {
+  file_ = std::fopen(path_.c_str(), "wb");
+  if (!file_) {
+    return false;
+  }
+  char header[BINARY_LOG_HEADER_SIZE];
+  std::memcpy(header, BINARY_LOG_MAGIC.data(), BINARY_LOG_MAGIC.size());
+  std::memcpy(header + 4, &BINARY_LOG_VERSION, sizeof(BINARY_LOG_VERSION));
+  std::memset(header + 6, 0, 2);
+  std::memcpy(header + 8, &BYTE_ORDER_MARK, sizeof(BYTE_ORDER_MARK));
+  std::memcpy(header + 12, &base_timestamp_ns, sizeof(base_timestamp_ns));
+  file_bytes_ = BINARY_LOG_HEADER_SIZE;
+  return std::fwrite(header, 1, sizeof(header), file_) == sizeof(header);
+}
+
+void binary_log_writer::rotate() noexcept {
+  try {
+    std::error_code ec;
+    if (files_kept_ == 0) {
+      std::filesystem::remove(path_, ec);
+      return;
+    }
+    std::filesystem::remove(rotated_path(path_, files_kept_), ec);
+    for (size_t i = files_kept_; i > 1; --i) {
+      std::filesystem::rename(rotated_path(path_, i - 1), rotated_path(path_, i), ec);
+    }
+    std::filesystem::rename(path_, rotated_path(path_, 1), ec);
+  } catch (...) {
+    // Allocation failure building a path: the next open overwrites the file.
+  }
+}
+
+binary_log_reader::binary_log_reader(const std::string& path) {
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (!file) {
+    fail(path + ": " + std::strerror(errno));
+    return;
+  }
+  char buf[64 * 1024];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) {
+    data_.append(buf, n);
+  }
+  const bool read_error = std::ferror(file) != 0;
+  std::fclose(file);
+  if (read_error) {
+    fail(path + ": read error");
+    return;
+  }
+
+  uint16_t version = 0;
+  uint32_t mark = 0;
+  if (data_.size() < BINARY_LOG_HEADER_SIZE || std::string_view(data_).substr(0, 4) != BINARY_LOG_MAGIC) {
+    fail(path + ": not a binary log");
+    return;
+  }
+  std::memcpy(&version, data_.data() + 4, sizeof(version));
+  std::memcpy(&mark, data_.data() + 8, sizeof(mark));
+  if (mark != BYTE_ORDER_MARK) {
+    fail(path + ": written on a host with a different byte order");
+    return;
+  }
+  if (version != BINARY_LOG_VERSION) {
+    fail(path + ": unsupported version " + std::to_string(version));
+    return;
+  }
+  std::memcpy(&last_timestamp_ns_, data_.data() + 12, sizeof(last_timestamp_ns_));
+  pos_ = BINARY_LOG_HEADER_SIZE;
+}
+
+bool binary_log_reader::next(binary_log_entry& entry) {
+  if (!error_.empty() || pos_ >= data_.size()) {
+    return false;
+  }
+  const auto read_varint = [this](uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && pos_ < data_.size(); shift += 7) {
+      const auto byte = static_cast<uint8_t>(data_[pos_++]);
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) return true;
+    }
+    return false;
+  };
+
+  const size_t entry_start = pos_;
+  uint64_t delta = 0;
+  uint64_t length = 0;
+  if (!read_varint(delta) || pos_ >= data_.size()) {
+    return fail("truncated entry at offset " + std::to_string(entry_start));
+  }
+  const auto flags = static_cast<uint8_t>(data_[pos_++]);
+  const auto level = static_cast<uint8_t>(flags & ~RECORD_FLAG);
+  if (level > static_cast<uint8_t>(log_level::error)) {
+    return fail("bad level at offset " + std::to_string(entry_start));
+  }
+  if (!read_varint(length) || data_.size() - pos_ < length) {
+    return fail("truncated entry at offset " + std::to_string(entry_start));
+  }
+
+  last_timestamp_ns_ += unzigzag(delta);
+  entry.timestamp_ns = last_timestamp_ns_;
+  entry.level = static_cast<log_level>(level);
+  entry.kind = (flags & RECORD_FLAG) ? log_entry_kind::record : log_entry_kind::text;
+  entry.payload = std::string_view(data_).substr(pos_, length);
+  pos_ += length;
+  return true;
+}
+
+bool binary_log_reader::fail(std::string message) {
+  error_ = std::move(message);
+  return false;
+}
+
+bool log_entry_filter::matches(const binary_log_entry& entry) const noexcept {
+  if (entry.level < min_level || entry.timestamp_ns < since_ns || entry.timestamp_ns >= until_ns) {
+    return false;
+  }
+  if (session == INVALID_SESSION_HANDLE) {
+    return true;
+  }
+  if (entry.kind == log_entry_kind::record) {
+    return log_record_mentions_session(entry.payload, session);
+  }
+  const auto id = format_session_id_chars(session);
+  return entry.payload.find(std::string_view(id.data(), id.size())) != std::string_view::npos;
+}
+
+void append_log_entry_text(const binary_log_entry& entry, std::string& out) {
+  const int64_t second = entry.timestamp_ns / NS_PER_SECOND;
+  const auto t = static_cast<std::time_t>(second);
+  std::tm tm_buf{};
+#ifdef _WIN32
+  gmtime_s(&tm_buf, &t);
+#else
+  gmtime_r(&t, &tm_buf);
+#endif
+  char timestamp[40];
+  size_t len = std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_buf);
+  std::snprintf(timestamp + len, sizeof(timestamp) - len, ".%03d ",
+                static_cast<int>((entry.timestamp_ns % NS_PER_SECOND) / NS_PER_MS));
+  out.append(timestamp);
+  out.append(log_level_to_string(entry.level));
+  out += ' ';
+  if (entry.kind == log_entry_kind::record) {
+    if (!format_log_record(entry.payload, out)) {
+      out.append("[Logger] Malformed log record");
+    }
+  } else {
+    out.append(entry.payload);
+  }
+  out += '\n';
+}
+
+std::optional<int64_t> parse_log_time(std::string_view text) noexcept {
+  int64_t seconds = 0;
+  const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), seconds);
+  if (ec == std::errc() && end == text.data() + text.size()) {
+    if (seconds > std::numeric_limits<int64_t>::max() / NS_PER_SECOND || seconds < 0) return std::nullopt;
+    return seconds * NS_PER_SECOND;
+  }
+
+  // "YYYY-mm-ddTHH:MM:SS" is 19 characters; ".mmm" may follow.
+  if (text.size() != 19 && text.size() != 23) return std::nullopt;
+  const auto field = [text](size_t pos, size_t len, int& out) {
+    const auto r = std::from_chars(text.data() + pos, text.data() + pos + len, out);
+    return r.ec == std::errc() && r.ptr == text.data() + pos + len;
+  };
+  std::tm tm_buf{};
+  int ms = 0;
+  if (text[4] != '-' || text[7] != '-' || (text[10] != 'T' && text[10] != ' ') || text[13] != ':' ||
+      text[16] != ':' || !field(0, 4, tm_buf.tm_year) || !field(5, 2, tm_buf.tm_mon) ||
+      !field(8, 2, tm_buf.tm_mday) || !field(11, 2, tm_buf.tm_hour) || !field(14, 2, tm_buf.tm_min) ||
+      !field(17, 2, tm_buf.tm_sec)) {
+    return std::nullopt;
+  }
+  if (text.size() == 23 && (text[19] != '.' || !field(20, 3, ms))) return std::nullopt;
+  if (tm_buf.tm_mon < 1 || tm_buf.tm_mon > 12 || tm_buf.tm_mday < 1 || tm_buf.tm_mday > 31 ||
+      tm_buf.tm_hour > 23 || tm_buf.tm_min > 59 || tm_buf.tm_sec > 60) {
+    return std::nullopt;
+  }
+  tm_buf.tm_year -= 1900;
+  tm_buf.tm_mon -= 1;
+#ifdef _WIN32
+  const std::time_t t = _mkgmtime(&tm_buf);
+#else
+  const std::time_t t = timegm(&tm_buf);
+#endif
+  if (t == static_cast<std::time_t>(-1)) return std::nullopt;
+  return static_cast<int64_t>(t) * NS_PER_SECOND + ms * NS_PER_MS;
+}
+
+}  // namespace server
+}  // namespace cppsim
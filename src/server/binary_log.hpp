@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "log_record.hpp"
+#include "logger.hpp"
+#include "session_handle.hpp"
+
+namespace cppsim {
+namespace server {
+
+// Binary on-disk log (".plog"), written by the async logger when
+// async_log_options::binary_path is set and read back by poker_logdump.
+//
+// A file is a header — "PLOG", u16 version, u16 reserved, a u32 byte-order
+// mark and the i64 base timestamp — followed by entries:
+//
+//   varint  zigzag(timestamp_ns - previous entry's timestamp_ns)
+//   u8      level, | 0x80 if the payload is a structured record
+//   varint  payload length
+//   bytes   payload: a log_record.hpp record (template ID + arguments) or
+//           the text of a plain line
+//
+// Integers inside records and the header are in the writer's byte order; a
+// reader on a host with the other order rejects the file.  When a file
+// would grow past the size limit it is renamed to "<path>.1" (shifting
+// older ones up to "<path>.<files_kept>") and a fresh one is started.
+
+inline constexpr std::string_view BINARY_LOG_MAGIC = "PLOG";
+inline constexpr uint16_t BINARY_LOG_VERSION = 1;
+inline constexpr size_t BINARY_LOG_HEADER_SIZE = 20;
+
+struct binary_log_entry {
+  int64_t timestamp_ns = 0;
+  log_level level = log_level::info;
+  log_entry_kind kind = log_entry_kind::text;
+  std::string_view payload;  // Valid until the reader's next call.
+};
+
+class binary_log_writer final {
+ public:
+  // Creates the parent directory and rotates an existing file at `path` out
+  // of the way before starting.
+  binary_log_writer(std::string path, uint64_t max_file_bytes, size_t files_kept);
+  ~binary_log_writer() noexcept;
+
+  binary_log_writer(const binary_log_writer&) = delete;
+  binary_log_writer& operator=(const binary_log_writer&) = delete;
+
+  // Buffers one entry.  Can throw std::bad_alloc.
+  void append(int64_t timestamp_ns, log_level level, log_entry_kind kind, std::string_view payload);
+
+  // Writes the buffered entries, rotating first if they would take the file
+  // past the size limit.  Returns false on an I/O error; the entries are
+  // lost, and the next flush tries a fresh file.
+  bool flush() noexcept;
+
+  [[nodiscard]] const std::string& path() const noexcept { return path_; }
+
+ private:
+  bool open_file(int64_t base_timestamp_ns) noexcept;
+  void rotate() noexcept;
+
+  const std::string path_;
+  const uint64_t max_file_bytes_;
+  const size_t files_kept_;
+
+  std::FILE* file_ = nullptr;
+  uint64_t file_bytes_ = 0;
+  std::string buffer_;
+  int64_t last_timestamp_ns_ = 0;    // Of the last appended entry.
+  int64_t buffer_base_ns_ = 0;       // last_timestamp_ns_ when buffer_ was empty.
+};
+
+class binary_log_reader final {
+ public:
+  // Reads the whole file; check error() before iterating.
+  explicit binary_log_reader(const std::string& path);
+
+  // The next entry, or false at the end of the file or on a corrupt entry
+  // (then error() says so).
+  bool next(binary_log_entry& entry);
+
+  // Empty unless the file could not be read or is corrupt.
+  [[nodiscard]] const std::string& error() const noexcept { return error_; }
+
+ private:
+  bool fail(std::string message);
+
+  std::string data_;
+  size_t pos_ = 0;
+  int64_t last_timestamp_ns_ = 0;
+  std::string error_;
+};
+
+// Which entries poker_logdump prints.
+struct log_entry_filter {
+  session_handle session = INVALID_SESSION_HANDLE;  // INVALID: any session.
+  int64_t since_ns = std::numeric_limits<int64_t>::min();
+  int64_t until_ns = std::numeric_limits<int64_t>::max();  // Exclusive.
+  log_level min_level = log_level::debug;
+
+  [[nodiscard]] bool matches(const binary_log_entry& entry) const noexcept;
+};
+
+// Appends "YYYY-mm-dd HH:MM:SS.mmm [LEVEL] text\n", the text logger's format.
+void append_log_entry_text(const binary_log_entry& entry, std::string& out);
+
+// "YYYY-mm-ddTHH:MM:SS[.mmm]" (UTC) or whole seconds since the epoch.
+[[nodiscard]] std::optional<int64_t> parse_log_time(std::string_view text) noexcept;
+
+}  // namespace server
+}  // namespace cppsim
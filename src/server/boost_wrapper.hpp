@@ -30,6 +30,7 @@
 // Common Boost.Asio and Beast includes
 #include <boost/asio.hpp>
 #include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
 #include <boost/beast/websocket.hpp>
 
 #if defined(_MSC_VER)
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace cppsim {
+namespace server {
+
+// Bounded lock-free multi-producer / single-consumer FIFO.
+//
+// Producers on any thread call try_push(); exactly one consumer at a time
+// (the session strand) calls try_pop() / empty().  The ring is a power of two
+// at least `limit` cells long, and admission is bounded separately by `limit`
+// so callers get exact backpressure (try_push() fails once `limit` items are
+// queued) without the ring ever filling up.
+//
+// Each cell carries a sequence number (Vyukov's bounded queue): a producer
+// claims a cell by CAS on tail_, writes the value, then publishes it by
+// bumping the cell's sequence; the consumer only reads cells whose sequence
+// says they are published, so no producer ever blocks another or the consumer.
+template <typename T>
+class bounded_mpsc_queue final {
+  static_assert(std::is_nothrow_move_assignable_v<T> && std::is_nothrow_default_constructible_v<T>,
+                "bounded_mpsc_queue requires nothrow default construction and move assignment");
+
+ public:
+  explicit bounded_mpsc_queue(size_t limit)
+      : limit_(limit == 0 ? 1 : limit),
+        mask_(round_up_pow2(limit_) - 1),
+        cells_(std::make_unique<cell[]>(mask_ + 1)) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  bounded_mpsc_queue(const bounded_mpsc_queue&) = delete;
+  bounded_mpsc_queue& operator=(const bounded_mpsc_queue&) = delete;
+  bounded_mpsc_queue(bounded_mpsc_queue&&) = delete;
+  bounded_mpsc_queue& operator=(bounded_mpsc_queue&&) = delete;
+
+  // Returns false without consuming `value` when `limit` items are queued.
+  [[nodiscard]] bool try_push(T&& value) noexcept {
+    // Reserve admission first; the ring is at least `limit` long, so a
+    // reserved producer always finds a free cell below.
+    if (size_.fetch_add(1, std::memory_order_acq_rel) >= limit_) {
+      size_.fetch_sub(1, std::memory_order_acq_rel);
+      return false;
+    }
+
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    cell* c = nullptr;
+    for (;;) {
+      c = &cells_[pos & mask_];
+      size_t seq = c->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else {
+        // Another producer claimed this cell (or the consumer has not yet
+        // released it) — reload and retry.
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    c->value = std::move(value);
+    c->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only.  Returns false if no published item is available.
+  [[nodiscard]] bool try_pop(T& out) noexcept {
+    cell* c = &cells_[head_ & mask_];
+    size_t seq = c->sequence.load(std::memory_order_acquire);
+    if (seq != head_ + 1) {
+      return false;
+    }
+    out = std::move(c->value);
+    c->value = T();
+    c->sequence.store(head_ + mask_ + 1, std::memory_order_release);
+    ++head_;
+    size_.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+  }
+
+  // Consumer only.  A producer that has reserved but not yet published a
+  // cell is not visible here; callers re-check after clearing their
+  // "writer active" flag to close that window.
+  [[nodiscard]] bool empty() const noexcept {
+    const cell* c = &cells_[head_ & mask_];
+    return c->sequence.load(std::memory_order_acquire) != head_ + 1;
+  }
+
+  // Approximate (reservations included); safe from any thread.
+  [[nodiscard]] size_t size() const noexcept { return size_.load(std::memory_order_acquire); }
+
+  [[nodiscard]] size_t limit() const noexcept { return limit_; }
+
+ private:
+  static size_t round_up_pow2(size_t n) noexcept {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+  struct cell {
+    std::atomic<size_t> sequence{0};
+    T value{};
+  };
+
+  // Keep producer- and consumer-owned indices on separate cache lines.
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  const size_t limit_;
+  const size_t mask_;
+  std::unique_ptr<cell[]> cells_;
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> size_{0};
+  alignas(CACHE_LINE_SIZE) size_t head_{0};
+};
+
+}  // namespace server
+}  // namespace cppsim
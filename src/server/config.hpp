@@ -18,14 +18,28 @@ struct config {
     
     static constexpr size_t MAX_MESSAGE_SIZE = 64 * 1024;
     static constexpr size_t MAX_WRITE_QUEUE_SIZE = 100;
+    // A session's read buffer is shrunk back after any message that grew it
+    // past this, so idle sessions don't keep MAX_MESSAGE_SIZE allocations.
+    static constexpr size_t MAX_IDLE_READ_BUFFER_SIZE = 4 * 1024;
     
     static constexpr unsigned short DEFAULT_PORT = 8080;
     static constexpr unsigned short DEFAULT_TEST_PORT = 18080;
     
     static constexpr size_t MAX_MESSAGES_PER_WINDOW = 10;
     static constexpr auto RATE_LIMIT_WINDOW = std::chrono::seconds{1};
+    // Per-message-type rate-limit cost, in units of one message against
+    // MAX_MESSAGES_PER_WINDOW.  Reloads touch the bankroll, so they cost more.
+    static constexpr uint32_t RATE_COST_HANDSHAKE = 1;
+    static constexpr uint32_t RATE_COST_ACTION = 1;
+    static constexpr uint32_t RATE_COST_RELOAD_REQUEST = 2;
+    static constexpr uint32_t RATE_COST_DISCONNECT = 1;
+    static constexpr uint32_t RATE_COST_STATE_ACK = 1;
     
+    // Server-wide, shared by all acceptor shards when sharded.
     static constexpr size_t MAX_CONNECTIONS = 1000;
+    // connection_manager spreads sessions over this many independently
+    // locked hash shards (rounded up to a power of two).
+    static constexpr size_t SESSION_REGISTRY_SHARDS = 64;
     // Reference the protocol constant directly — single source of truth.
     static constexpr size_t MAX_SESSION_ID_LENGTH = protocol::MAX_SESSION_ID_LENGTH;
     static constexpr auto MAX_BACKOFF = std::chrono::seconds{30};
@@ -42,6 +56,64 @@ struct config {
     static constexpr auto WS_READ_TIMEOUT = std::chrono::hours{24};
 
     static constexpr int64_t MAX_SEQUENCE_GAP = 10000;
+
+    // Number of threads running the shared io_context.  0 means "one per
+    // hardware thread".  Sessions and the acceptor are bound to strands, so
+    // per-connection handler ordering is unchanged regardless of the count.
+    static constexpr size_t IO_THREADS = 0;
+    static constexpr size_t MAX_IO_THREADS = 256;
+
+    // Shared-nothing mode: instead of one io_context on IO_THREADS threads,
+    // run one io_context + SO_REUSEPORT acceptor + connection_manager per
+    // thread and let the kernel balance new connections between them.
+    static constexpr bool SHARDED_ACCEPTORS = false;
+
+    // When enabled, a session drains every message queued at flush time and
+    // writes them back-to-back from the write completion handler, instead of
+    // one message per strand round trip.
+    static constexpr bool WRITE_COALESCING = true;
+
+    // Handshake/idle deadlines live on a per-server hashed timer wheel
+    // instead of one steady_timer per session.  Deadlines fire up to one tick
+    // late; TICK * SLOTS is one revolution (longer timeouts just wait out
+    // extra revolutions).
+    static constexpr auto TIMER_WHEEL_TICK = std::chrono::milliseconds{100};
+    static constexpr size_t TIMER_WHEEL_SLOTS = 512;
+
+    // Malformed-frame and protocol-error logs are sampled process-wide: per
+    // window, the first BURST are logged, then one in SAMPLE_EVERY.  Counters
+    // stay exact; only log lines and error records are dropped.
+    static constexpr size_t MALFORMED_LOG_BURST = 20;
+    static constexpr uint64_t MALFORMED_LOG_SAMPLE_EVERY = 100;
+    static constexpr auto MALFORMED_LOG_WINDOW = std::chrono::seconds{1};
+
+    // STATE_UPDATE delta encoding.  Once a client acknowledges a state
+    // (STATE_ACK), later updates go out as STATE_DELTA against it; every
+    // KEYFRAME_INTERVAL-th update is a full keyframe regardless.  At most
+    // MAX_PENDING unacknowledged states are remembered as ack candidates.
+    static constexpr uint32_t STATE_KEYFRAME_INTERVAL = 32;
+    static constexpr size_t STATE_DELTA_MAX_PENDING = 16;
+
+    // Asynchronous logging.  Each logging thread gets a ring of
+    // LOG_RING_RECORDS 256-byte records; a background thread drains the rings
+    // every LOG_FLUSH_INTERVAL, or sooner once one is half full.  When a ring
+    // is full the line is dropped and counted, unless LOG_BLOCK_WHEN_FULL.
+    static constexpr size_t LOG_RING_RECORDS = 1024;
+    static constexpr auto LOG_FLUSH_INTERVAL = std::chrono::milliseconds{50};
+    static constexpr bool LOG_BLOCK_WHEN_FULL = false;
+
+    // Binary log files ("log_file" in the runtime config): a file is rotated
+    // once it would exceed LOG_FILE_MAX_BYTES, keeping LOG_FILES_KEPT old ones.
+    static constexpr uint64_t LOG_FILE_MAX_BYTES = 64ull * 1024 * 1024;
+    static constexpr size_t LOG_FILES_KEPT = 8;
+
+    // OpenMetrics scrape endpoint ("metrics_port" / "metrics_address" in the
+    // runtime config).  Port 0 leaves it off; it binds to loopback unless an
+    // address is given.  A scraper gets METRICS_REQUEST_TIMEOUT to send its
+    // request and read the reply.
+    static constexpr uint16_t METRICS_PORT = 0;
+    static constexpr const char* METRICS_ADDRESS = "127.0.0.1";
+    static constexpr auto METRICS_REQUEST_TIMEOUT = std::chrono::seconds{5};
 };
 
 } // namespace server
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace cppsim {
+namespace server {
+
+// Server-wide connection budget shared by every connection_manager.
+//
+// In sharded mode each io thread has its own connection_manager, but
+// max_connections still caps the server as a whole: every shard reserves
+// from this one counter with a CAS, so the limit is never exceeded — not
+// even transiently — and a busy shard can use capacity an idle one leaves
+// free.  The counter is only touched on connect and disconnect.
+class connection_limit final {
+ public:
+  explicit connection_limit(size_t capacity) noexcept : capacity_(capacity) {}
+
+  connection_limit(const connection_limit&) = delete;
+  connection_limit& operator=(const connection_limit&) = delete;
+
+  // Reserves one connection; false if the server is full.
+  [[nodiscard]] bool try_acquire() noexcept {
+    size_t count = count_.load(std::memory_order_relaxed);
+    do {
+      if (count >= capacity_) {
+        return false;
+      }
+    } while (!count_.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel,
+                                           std::memory_order_relaxed));
+    return true;
+  }
+
+  void release(size_t n = 1) noexcept { count_.fetch_sub(n, std::memory_order_acq_rel); }
+
+  [[nodiscard]] size_t size() const noexcept { return count_.load(std::memory_order_acquire); }
+  [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+
+ private:
+  const size_t capacity_;
+  // On its own cache line, away from whatever the owner allocates next to it.
+  alignas(64) std::atomic<size_t> count_{0};
+};
+
+}  // namespace server
+}  // namespace cppsim
@@ -4,16 +4,15 @@
 #include <array>
 #include <atomic>
 #include <chrono>
-#include <cstdio>
 #include <memory>
-#include <mutex>
+#include <optional>
 #include <random>
 #include <string_view>
 #include <utility>
 
 #include "config.hpp"
+#include "log_record.hpp"
 #include "logger.hpp"
-#include "sanitize.hpp"
 #include "websocket_session.hpp"
 
 namespace {
@@ -28,196 +27,141 @@ constexpr int MAX_SESSION_ID_RETRIES = 3;
 namespace cppsim {
 namespace server {
 
-std::string connection_manager::register_session(
+session_handle connection_manager::register_session(
     std::shared_ptr<websocket_session> session) {
   if (!session) {
     log_error("[ConnectionManager] Cannot register null session");
-    return std::string();
+    return INVALID_SESSION_HANDLE;
+  }
+  static_assert(SESSION_ID_LENGTH <= config::MAX_SESSION_ID_LENGTH,
+                "Formatted session IDs must fit the protocol limit");
+
+  // Reserve a slot in the server-wide budget first; it is held until the
+  // session is unregistered, or handed back if registering fails.
+  if (!limit_->try_acquire()) {
+    log<log_id::max_connections>(limit_->capacity());
+    return INVALID_SESSION_HANDLE;
   }
-  
-  for (int attempt = 0; attempt < MAX_SESSION_ID_RETRIES; ++attempt) {
-    std::string session_id = generate_session_id();
-
-    if (session_id.empty()) {
-      log_error("[ConnectionManager] Failed to generate session ID");
-      return std::string();
-    }
-
-    if (session_id.size() > config::MAX_SESSION_ID_LENGTH) {
-      log_error("[ConnectionManager] Generated session ID exceeds maximum length");
-      return std::string();
-    }
 
-    // emplace_result distinguishes the three outcomes so logging can happen
-    // outside the lock, reducing sessions_mutex_ hold time on the hot path.
-    enum class emplace_result { success, max_connections, collision };
-    auto result = emplace_result::success;
-    size_t count = 0;
-    {
-      std::lock_guard<std::mutex> lock(sessions_mutex_);
-      if (sessions_.size() >= config::MAX_CONNECTIONS) {
-        result = emplace_result::max_connections;
-      } else {
-        // session is moved via try_emplace — on collision the forwarded arg is
-        // untouched (C++17 guarantee), so the local parameter remains valid for
-        // retry.  On success, ownership transfers into the map without an extra
-        // atomic refcount increment/decrement pair.
-        auto [it, inserted] = sessions_.try_emplace(session_id, std::move(session));
-        if (!inserted) {
-          result = emplace_result::collision;
-        } else {
-          count = sessions_.size();
-        }
-      }
+  for (int attempt = 0; attempt < MAX_SESSION_ID_RETRIES; ++attempt) {
+    const session_handle handle = generate_session_handle();
+
+    // The registry has room for the whole budget, so only a collision can
+    // fail here.  Logging happens after the shard lock is released.
+    // `session` is only moved from on success, so it remains valid for a
+    // retry after a collision.
+    using insert_result = decltype(sessions_)::insert_result;
+    insert_result result = insert_result::full;
+    try {
+      result = sessions_.try_insert(handle, std::move(session));
+    } catch (...) {
+      limit_->release();
+      throw;
     }
-
     switch (result) {
-      case emplace_result::max_connections:
-        log_error("[ConnectionManager] Maximum connections reached (" +
-            std::to_string(config::MAX_CONNECTIONS) + ")");
-        return std::string();
-      case emplace_result::collision:
-        log_error("[ConnectionManager] Session ID collision (attempt " +
-            std::to_string(attempt + 1) + "), retrying: " + cppsim::server::sanitize_session_id(session_id));
+      case insert_result::full:
+        limit_->release();
+        log<log_id::max_connections>(sessions_.capacity());
+        return INVALID_SESSION_HANDLE;
+      case insert_result::collision:
+        log<log_id::session_id_collision>(attempt + 1, log_session{handle});
         continue;
-      case emplace_result::success:
+      case insert_result::inserted:
         break;
       default:
-        log_error("[ConnectionManager] Unexpected emplace result");
-        return std::string();
+        limit_->release();
+        log_error("[ConnectionManager] Unexpected insert result");
+        return INVALID_SESSION_HANDLE;
     }
 
-    log_message("[ConnectionManager] Registered session: " + cppsim::server::sanitize_session_id(session_id) + " (total: " + std::to_string(count) + ")");
+    log<log_id::session_registered>(log_session{handle}, limit_->size());
 
-    return session_id;
+    return handle;
   }
 
+  limit_->release();
   log_error("[ConnectionManager] Session ID collision after all retries");
-  return std::string();
+  return INVALID_SESSION_HANDLE;
 }
 
-void connection_manager::unregister_session(std::string_view session_id) noexcept {
-  if (session_id.empty()) {
+void connection_manager::unregister_session(session_handle handle) noexcept {
+  if (handle == INVALID_SESSION_HANDLE || !sessions_.erase(handle)) {
     return;
   }
-  size_t count;
-  bool found = false;
-  {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    auto it = sessions_.find(session_id);
-    if (it != sessions_.end()) {
-      sessions_.erase(it);
-      found = true;
-    }
-    count = sessions_.size();
-  }
-  if (found) {
-    // Log message construction is wrapped in try/catch because this function
-    // is noexcept — an allocation failure in string concatenation would
-    // otherwise call std::terminate.
-    try {
-      log_message("[ConnectionManager] Unregistered session: " + cppsim::server::sanitize_session_id(session_id) + " (remaining: " +
-                  std::to_string(count) + ")");
-    } catch (...) {
-      // Allocation failure — session was still unregistered successfully.
-    }
+  limit_->release();
+  log<log_id::session_unregistered>(log_session{handle}, limit_->size());
+}
+
+void connection_manager::unregister_session(std::string_view session_id) noexcept {
+  unregister_session(parse_session_id(session_id));
+}
+
+std::shared_ptr<websocket_session> connection_manager::get_session(
+    session_handle handle) const noexcept {
+  if (handle == INVALID_SESSION_HANDLE) {
+    return nullptr;
   }
+  return sessions_.find(handle);
 }
 
 std::shared_ptr<websocket_session> connection_manager::get_session(
     std::string_view session_id) const noexcept {
-  std::lock_guard<std::mutex> lock(sessions_mutex_);
-  auto it = sessions_.find(session_id);
-  if (it != sessions_.end()) {
-    return it->second;
-  }
-  return nullptr;
+  return get_session(parse_session_id(session_id));
 }
 
 std::vector<std::string> connection_manager::active_session_ids() const {
-  std::lock_guard<std::mutex> lock(sessions_mutex_);
+  const auto handles = sessions_.keys();
   std::vector<std::string> ids;
-  ids.reserve(sessions_.size());
-  for (const auto& pair : sessions_) {
-    ids.push_back(pair.first);
+  ids.reserve(handles.size());
+  for (session_handle handle : handles) {
+    ids.push_back(format_session_id(handle));
   }
   return ids;
 }
 
 size_t connection_manager::session_count() const noexcept {
-  std::lock_guard<std::mutex> lock(sessions_mutex_);
   return sessions_.size();
 }
 
-std::string connection_manager::generate_session_id() noexcept {
-  try {
-    // Combine a monotonic counter with thread-local PRNG to produce session
-    // IDs that are both unique and unpredictable.
-    static std::atomic<uint64_t> counter{0};
-    uint64_t id = counter.fetch_add(1, std::memory_order_relaxed);
-
-    // Thread-local mt19937 seeded once per thread from random_device.
-    // Uses seed_seq with multiple rd() calls to properly initialize the
-    // full 624-word state (a single 32-bit seed leaves most state
-    // deterministic, reducing effective entropy of session IDs).
-    thread_local std::mt19937 rng([] {
+session_handle connection_manager::generate_session_handle() noexcept {
+  // Combine a monotonic counter with thread-local PRNG to produce handles
+  // that are both unique and unpredictable.
+  static std::atomic<uint64_t> counter{0};
+
+  // Thread-local mt19937 seeded once per thread from random_device.
+  // Uses seed_seq with multiple rd() calls to properly initialize the
+  // full 624-word state (a single 32-bit seed leaves most state
+  // deterministic, reducing effective entropy of session IDs).  If seeding
+  // throws, fall back to the counter alone (less secure but still unique).
+  thread_local std::optional<std::mt19937> rng = []() -> std::optional<std::mt19937> {
+    try {
       std::random_device rd;
       std::array<uint32_t, std::mt19937::state_size> seeds;
       std::generate(seeds.begin(), seeds.end(), std::ref(rd));
       std::seed_seq seq(seeds.begin(), seeds.end());
       return std::mt19937(seq);
-    }());
-    uint32_t rnd = static_cast<uint32_t>(rng());
-
-    // Format: "sess_" + 16 hex chars (mixing counter + randomness).
-    uint64_t mixed = (id << 32) ^ rnd;
-    char buf[22]; // "sess_" (5) + 16 hex chars + NUL = 22 bytes
-    constexpr char hex[] = "0123456789abcdef";
-    buf[0] = 's'; buf[1] = 'e'; buf[2] = 's'; buf[3] = 's'; buf[4] = '_';
-    for (int i = 0; i < 16; ++i) {
-      buf[5 + i] = hex[(mixed >> (60 - 4 * i)) & 0xF];
-    }
-    buf[21] = '\0';
-    return std::string(buf, 21);
-  } catch (...) {
-    // Fallback: counter-only (less secure but still unique)
-    try {
-      static std::atomic<uint64_t> fallback_counter{0};
-      uint64_t id = fallback_counter.fetch_add(1, std::memory_order_relaxed);
-      return "sess_" + std::to_string(id);
     } catch (...) {
-      log_error("[ConnectionManager] Failed to generate session ID");
-      return std::string();
+      return std::nullopt;
     }
+  }();
+
+  session_handle handle = INVALID_SESSION_HANDLE;
+  while (handle == INVALID_SESSION_HANDLE) {
+    const uint64_t id = counter.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t rnd = rng ? (*rng)() : 0;
+    handle = (id << 32) ^ rnd;
   }
+  return handle;
 }
 
 void connection_manager::stop_all() noexcept {
-  decltype(sessions_) sessions_to_stop;
-  {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    sessions_to_stop.swap(sessions_);
-    // swap is O(1) — moves the entire red-black tree root instead of
-    // iterating and moving each element individually.
-  }
-
-  const size_t count = sessions_to_stop.size();
-  for (auto& [id, session] : sessions_to_stop) {
-    (void)id;
+  // Each shard is swapped out under its own lock; sessions are closed after
+  // the lock is released, since close() re-enters unregister_session().
+  const size_t count = sessions_.drain([](session_handle, const std::shared_ptr<websocket_session>& session) {
     session->close();
-  }
-
-  try {
-    // Use snprintf to avoid allocations in noexcept function
-    char buffer[128];
-    int len = std::snprintf(buffer, sizeof(buffer), 
-                             "[ConnectionManager] Stopped %zu session(s).", count);
-    if (len > 0 && len < static_cast<int>(sizeof(buffer))) {
-      log_message(std::string_view(buffer, static_cast<size_t>(len)));
-    }
-  } catch (...) {
-    // Allocation failure — sessions were still stopped successfully.
-  }
+  });
+  limit_->release(count);
+  log<log_id::sessions_stopped>(count);
 }
 
 }  // namespace server
@@ -1,11 +1,17 @@
 #pragma once
 
-#include <map>
+#include <cstddef>
 #include <memory>
-#include <mutex>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "config.hpp"
+#include "connection_limit.hpp"
+#include "session_handle.hpp"
+#include "session_registry.hpp"
+
 namespace cppsim {
 namespace server {
 
@@ -13,13 +19,28 @@ class websocket_session;
 
 // Thread safety:
 //   All public methods are safe to call from any thread.
-//   - Mutex-protected: register_session, unregister_session, get_session,
-//     active_session_ids, session_count, empty, stop_all.
+//   - Sessions live in a session_registry: register_session,
+//     unregister_session and get_session lock only the shard that owns the
+//     ID; session_count is a single atomic load.
+//   - max_connections is enforced exactly, even under concurrent registers,
+//     and across every connection_manager sharing the same connection_limit.
+//   - Sessions are keyed by their 64-bit session_handle.  The string_view
+//     overloads parse a client-supplied "sess_..." ID at the protocol edge.
 //   - Sessions are shared_ptr; callers must synchronize access to the
 //     session object itself (websocket_session handles its own thread safety).
+//
+// When the server runs sharded (one io_context + acceptor per core), each
+// shard owns its own connection_manager and they all share one
+// connection_limit, so max_connections stays a server-wide cap.
 class connection_manager final {
  public:
-  connection_manager() noexcept = default;
+  // Can throw std::bad_alloc.
+  explicit connection_manager(size_t max_connections = config::MAX_CONNECTIONS,
+                              size_t shards = config::SESSION_REGISTRY_SHARDS)
+      : connection_manager(std::make_shared<connection_limit>(max_connections), shards) {}
+  explicit connection_manager(std::shared_ptr<connection_limit> limit,
+                              size_t shards = config::SESSION_REGISTRY_SHARDS)
+      : limit_(std::move(limit)), sessions_(limit_->capacity(), shards) {}
   ~connection_manager() noexcept = default;
 
   connection_manager(const connection_manager&) = delete;
@@ -27,26 +48,32 @@ class connection_manager final {
   connection_manager(connection_manager&&) = delete;
   connection_manager& operator=(connection_manager&&) = delete;
 
-  // Returns empty string on failure (null session, max connections reached,
-  // or session ID collision after all retries).
-  [[nodiscard]] std::string register_session(std::shared_ptr<websocket_session> session);
+  // Returns INVALID_SESSION_HANDLE on failure (null session, max connections
+  // reached, or handle collision after all retries).
+  [[nodiscard]] session_handle register_session(std::shared_ptr<websocket_session> session);
 
+  void unregister_session(session_handle handle) noexcept;
   void unregister_session(std::string_view session_id) noexcept;
 
+  [[nodiscard]] std::shared_ptr<websocket_session> get_session(session_handle handle) const noexcept;
   [[nodiscard]] std::shared_ptr<websocket_session> get_session(std::string_view session_id) const noexcept;
 
   // Note: Can throw std::bad_alloc on memory exhaustion.
   [[nodiscard]] std::vector<std::string> active_session_ids() const;
 
+  // Sessions in this manager; the server-wide count is in limit().
   [[nodiscard]] size_t session_count() const noexcept;
 
+  [[nodiscard]] size_t max_connections() const noexcept { return limit_->capacity(); }
+  [[nodiscard]] const connection_limit& limit() const noexcept { return *limit_; }
+
   void stop_all() noexcept;
 
  private:
-  [[nodiscard]] static std::string generate_session_id() noexcept;
+  [[nodiscard]] static session_handle generate_session_handle() noexcept;
 
-  mutable std::mutex sessions_mutex_;
-  std::map<std::string, std::shared_ptr<websocket_session>, std::less<>> sessions_;
+  std::shared_ptr<connection_limit> limit_;
+  session_registry<session_handle, std::shared_ptr<websocket_session>> sessions_;
 };
 
 }  // namespace server
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "boost_wrapper.hpp"
+
+namespace cppsim {
+namespace server {
+
+namespace detail {
+
+// Small per-thread cache of recently freed handler blocks.  A session's
+// read/write/timer loop allocates the same few handler sizes over and over;
+// after warm-up every allocation is served from here instead of malloc.
+// Blocks may be freed on a different thread than they were allocated on —
+// they simply land in that thread's cache.
+class handler_block_cache final {
+ public:
+  static constexpr size_t SLOTS = 16;
+  static constexpr size_t GRANULE = 64;
+  static constexpr size_t MAX_CACHED_SIZE = 4096;
+
+  handler_block_cache() noexcept = default;
+  ~handler_block_cache() noexcept {
+    for (auto& entry : slots_) {
+      ::operator delete(entry.block);
+    }
+  }
+
+  handler_block_cache(const handler_block_cache&) = delete;
+  handler_block_cache& operator=(const handler_block_cache&) = delete;
+  handler_block_cache(handler_block_cache&&) = delete;
+  handler_block_cache& operator=(handler_block_cache&&) = delete;
+
+  [[nodiscard]] static handler_block_cache& local() noexcept {
+    thread_local handler_block_cache cache;
+    return cache;
+  }
+
+  // Can throw std::bad_alloc.
+  [[nodiscard]] void* allocate(size_t bytes) {
+    const size_t rounded = round_up(bytes);
+    if (rounded <= MAX_CACHED_SIZE) {
+      for (auto& entry : slots_) {
+        if (entry.block != nullptr && entry.size == rounded) {
+          return std::exchange(entry.block, nullptr);
+        }
+      }
+    }
+    return ::operator new(rounded);
+  }
+
+  void deallocate(void* block, size_t bytes) noexcept {
+    const size_t rounded = round_up(bytes);
+    if (rounded <= MAX_CACHED_SIZE) {
+      for (auto& entry : slots_) {
+        if (entry.block == nullptr) {
+          entry.block = block;
+          entry.size = rounded;
+          return;
+        }
+      }
+    }
+    ::operator delete(block);
+  }
+
+ private:
+  static constexpr size_t round_up(size_t bytes) noexcept {
+    return bytes == 0 ? GRANULE : (bytes + GRANULE - 1) / GRANULE * GRANULE;
+  }
+
+  struct cached_block {
+    void* block{nullptr};
+    size_t size{0};
+  };
+  std::array<cached_block, SLOTS> slots_{};
+};
+
+}  // namespace detail
+
+// Standard allocator backed by the calling thread's handler_block_cache.
+// Stateless, so every instance compares equal and memory allocated through
+// one may be released through any other.
+template <typename T>
+class recycling_allocator {
+ public:
+  using value_type = T;
+
+  recycling_allocator() noexcept = default;
+  template <typename U>
+  recycling_allocator(const recycling_allocator<U>&) noexcept {}
+
+  [[nodiscard]] T* allocate(size_t n) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "recycling_allocator does not support over-aligned types");
+    if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return static_cast<T*>(detail::handler_block_cache::local().allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    detail::handler_block_cache::local().deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const recycling_allocator<U>&) const noexcept { return true; }
+  template <typename U>
+  bool operator!=(const recycling_allocator<U>&) const noexcept { return false; }
+};
+
+// Completion handler wrapper that advertises recycling_allocator through
+// asio's associated_allocator, so asio and Beast allocate the operation
+// state for this handler from the per-thread cache.  The wrapped handler's
+// associated executor is forwarded unchanged.
+template <typename Handler>
+class recycling_handler {
+ public:
+  using allocator_type = recycling_allocator<void>;
+
+  template <typename H>
+  explicit recycling_handler(H&& handler) : handler_(std::forward<H>(handler)) {}
+
+  [[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_type(); }
+
+  [[nodiscard]] const Handler& inner() const noexcept { return handler_; }
+
+  template <typename... Args>
+  void operator()(Args&&... args) {
+    handler_(std::forward<Args>(args)...);
+  }
+
+ private:
+  Handler handler_;
+};
+
+template <typename Handler>
+[[nodiscard]] recycling_handler<std::decay_t<Handler>> make_recycling_handler(Handler&& handler) {
+  return recycling_handler<std::decay_t<Handler>>(std::forward<Handler>(handler));
+}
+
+}  // namespace server
+}  // namespace cppsim
+
+namespace boost {
+namespace asio {
+
+template <typename Handler, typename Executor>
+struct associated_executor<cppsim::server::recycling_handler<Handler>, Executor> {
+  using type = typename associated_executor<Handler, Executor>::type;
+
+  static type get(const cppsim::server::recycling_handler<Handler>& h,
+                  const Executor& ex = Executor()) noexcept {
+    return associated_executor<Handler, Executor>::get(h.inner(), ex);
+  }
+};
+
+}  // namespace asio
+}  // namespace boost
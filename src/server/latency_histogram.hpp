@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace cppsim {
+namespace server {
+
+// Log-linear (HDR-style) bucketing of microsecond latencies.  Values below
+// 64 us get a bucket each; above that every power-of-two range is split into
+// 64 equal sub-buckets, so a bucket is never wider than 1/64 (~1.6%) of the
+// values in it.  1728 buckets reach 2^32 us (~71 minutes); anything larger
+// lands in the last one.
+namespace histogram_layout {
+
+inline constexpr unsigned SUB_BUCKET_BITS = 6;
+inline constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+inline constexpr unsigned VALUE_BITS = 32;
+inline constexpr uint64_t MAX_VALUE = (uint64_t{1} << VALUE_BITS) - 1;
+inline constexpr size_t BUCKETS = (VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+inline unsigned highest_bit(uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+  unsigned bit = 0;
+  while (value >>= 1) ++bit;
+  return bit;
+#endif
+}
+
+inline size_t bucket_index(uint64_t value) noexcept {
+  if (value > MAX_VALUE) value = MAX_VALUE;
+  if (value < SUB_BUCKETS) return value;
+  const unsigned shift = highest_bit(value) - SUB_BUCKET_BITS;
+  return (shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+}
+
+// The largest value that maps to `index`.
+inline uint64_t bucket_highest(size_t index) noexcept {
+  if (index < SUB_BUCKETS) return index;
+  const auto shift = static_cast<unsigned>(index / SUB_BUCKETS - 1);
+  const uint64_t lowest = (index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+  return lowest + (uint64_t{1} << shift) - 1;
+}
+
+}  // namespace histogram_layout
+
+// Plain bucket counts copied out of one or more latency_histograms.
+struct histogram_snapshot {
+  std::array<uint64_t, histogram_layout::BUCKETS> counts{};
+  uint64_t total = 0;
+
+  void merge(const histogram_snapshot& other) noexcept {
+    for (size_t i = 0; i < counts.size(); ++i) counts[i] += other.counts[i];
+    total += other.total;
+  }
+
+  // The smallest bucket bound that at least `percentile`% of the values are
+  // at or below; 0 when empty.
+  [[nodiscard]] uint64_t value_at_percentile(double percentile) const noexcept {
+    if (total == 0) return 0;
+    auto rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total)));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+      seen += counts[i];
+      if (seen >= rank) return histogram_layout::bucket_highest(i);
+    }
+    return histogram_layout::MAX_VALUE;
+  }
+};
+
+// Fixed-size latency histogram that any number of threads can record into:
+// record() is one relaxed atomic increment, with no lock and no allocation.
+// Snapshots taken while others record may be off by the in-flight values.
+class latency_histogram final {
+ public:
+  latency_histogram() noexcept { clear(); }
+
+  latency_histogram(const latency_histogram&) = delete;
+  latency_histogram& operator=(const latency_histogram&) = delete;
+
+  void record(uint64_t value_us) noexcept {
+    buckets_[histogram_layout::bucket_index(value_us)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Adds this histogram's counts to `out`; call on several to merge them.
+  void add_to(histogram_snapshot& out) const noexcept {
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      const uint64_t n = buckets_[i].load(std::memory_order_relaxed);
+      out.counts[i] += n;
+      out.total += n;
+    }
+  }
+
+  void clear() noexcept {
+    for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, histogram_layout::BUCKETS> buckets_;
+};
+
+}  // namespace server
+}  // namespace cppsim
@@ -0,0 +1,161 @@
+#include "log_record.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace cppsim {
+namespace server {
+
+namespace {
+
+constexpr std::string_view TRUNCATION_MARK = "...";
+constexpr std::string_view UNAUTHENTICATED = "(unauthenticated)";
+
+template <typename T>
+void append_number(std::string& out, T value) {
+  char buf[24];
+  const auto result = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, result.ptr);
+}
+
+}  // namespace
+
+log_record_builder::log_record_builder(log_id id) noexcept : buf_{}, size_(LOG_RECORD_HEADER_SIZE) {
+  const auto raw = static_cast<uint16_t>(id);
+  std::memcpy(buf_.data(), &raw, sizeof(raw));
+  buf_[2] = 0;
+}
+
+void log_record_builder::add_fixed(log_arg_type type, uint64_t bits) noexcept {
+  buf_[size_++] = static_cast<char>(type);
+  std::memcpy(buf_.data() + size_, &bits, sizeof(bits));
+  size_ += sizeof(bits);
+  ++buf_[2];
+}
+
+void log_record_builder::add_int(int64_t value) noexcept {
+  add_fixed(log_arg_type::int64, static_cast<uint64_t>(value));
+}
+
+void log_record_builder::add_uint(uint64_t value) noexcept {
+  add_fixed(log_arg_type::uint64, value);
+}
+
+void log_record_builder::add_session(session_handle handle) noexcept {
+  add_fixed(log_arg_type::session, handle);
+}
+
+void log_record_builder::add_string(std::string_view value, size_t max_length) noexcept {
+  max_length = std::min(max_length, LOG_STRING_ARG_MAX);
+  const bool truncated = value.size() > max_length;
+  if (truncated) value = value.substr(0, max_length);
+  buf_[size_++] = static_cast<char>(truncated ? log_arg_type::truncated_string : log_arg_type::string);
+  buf_[size_++] = static_cast<char>(value.size());
+  std::memcpy(buf_.data() + size_, value.data(), value.size());
+  size_ += value.size();
+  ++buf_[2];
+}
+
+namespace {
+
+struct decoded_arg {
+  log_arg_type type;
+  uint64_t bits;          // Integers and session handles.
+  std::string_view text;  // Strings.
+};
+
+// Calls on_arg(const decoded_arg&) for each argument of `record`, in order.
+// Returns nullptr if the record is malformed, else its template.
+template <typename OnArg>
+const log_template* for_each_log_arg(std::string_view record, OnArg&& on_arg) {
+  if (record.size() < LOG_RECORD_HEADER_SIZE) return nullptr;
+  uint16_t raw_id = 0;
+  std::memcpy(&raw_id, record.data(), sizeof(raw_id));
+  const log_template* tmpl = find_log_template(raw_id);
+  if (!tmpl) return nullptr;
+  const auto arg_count = static_cast<uint8_t>(record[2]);
+  if (arg_count != detail::count_log_placeholders(tmpl->format)) return nullptr;
+
+  size_t pos = LOG_RECORD_HEADER_SIZE;
+  for (size_t arg = 0; arg < arg_count; ++arg) {
+    if (pos >= record.size()) return nullptr;
+    decoded_arg decoded{static_cast<log_arg_type>(record[pos++]), 0, {}};
+    switch (decoded.type) {
+      case log_arg_type::int64:
+      case log_arg_type::uint64:
+      case log_arg_type::session:
+        if (record.size() - pos < sizeof(decoded.bits)) return nullptr;
+        std::memcpy(&decoded.bits, record.data() + pos, sizeof(decoded.bits));
+        pos += sizeof(decoded.bits);
+        break;
+      case log_arg_type::string:
+      case log_arg_type::truncated_string: {
+        if (pos >= record.size()) return nullptr;
+        const auto length = static_cast<uint8_t>(record[pos++]);
+        if (record.size() - pos < length) return nullptr;
+        decoded.text = record.substr(pos, length);
+        pos += length;
+        break;
+      }
+      default:
+        return nullptr;
+    }
+    on_arg(decoded);
+  }
+  return pos == record.size() ? tmpl : nullptr;
+}
+
+void append_arg(std::string& out, const decoded_arg& arg) {
+  switch (arg.type) {
+    case log_arg_type::int64:
+      append_number(out, static_cast<int64_t>(arg.bits));
+      break;
+    case log_arg_type::uint64:
+      append_number(out, arg.bits);
+      break;
+    case log_arg_type::session:
+      if (arg.bits == INVALID_SESSION_HANDLE) {
+        out.append(UNAUTHENTICATED);
+      } else {
+        const auto chars = format_session_id_chars(arg.bits);
+        out.append(chars.data(), chars.size());
+      }
+      break;
+    case log_arg_type::truncated_string:
+      out.append(arg.text);
+      out.append(TRUNCATION_MARK);
+      break;
+    default:
+      out.append(arg.text);
+      break;
+  }
+}
+
+}  // namespace
+
+bool format_log_record(std::string_view record, std::string& out) {
+  // Validate first so that a malformed record appends nothing.
+  const log_template* tmpl = for_each_log_arg(record, [](const decoded_arg&) {});
+  if (!tmpl) return false;
+  std::string_view format = tmpl->format;
+  for_each_log_arg(record, [&](const decoded_arg& arg) {
+    const size_t placeholder = format.find("{}");
+    out.append(format.substr(0, placeholder));
+    format.remove_prefix(placeholder + 2);
+    append_arg(out, arg);
+  });
+  out.append(format);
+  return true;
+}
+
+bool log_record_mentions_session(std::string_view record, session_handle handle) noexcept {
+  bool found = false;
+  const log_template* tmpl = for_each_log_arg(record, [&](const decoded_arg& arg) {
+    found = found || (arg.type == log_arg_type::session && arg.bits == handle);
+  });
+  return tmpl && found;
+}
+
+}  // namespace server
+}  // namespace cppsim
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "logger.hpp"
+#include "session_handle.hpp"
+
+namespace cppsim {
+namespace server {
+
+// Structured log lines.
+//
+// log<log_id::X>(args...) does not build the line: it records the template
+// ID and the arguments — integers, session handles and short strings — in
+// a small binary record on the stack and hands that to the sink.  The text
+// is produced only where the record is written out (by the async logger's
+// flusher, or right away on the synchronous path).  Lines below
+// LOG_MIN_LEVEL compile to nothing.
+//
+// Record layout: u16 template ID, u8 argument count, then per argument a
+// type byte followed by 8 bytes (integers and session handles, native byte
+// order) or a u8 length and that many bytes (strings).
+
+enum class log_id : uint16_t {
+  session_init_failed,
+  accept_failed,
+  accept_exception,
+  client_disconnected,
+  read_error,
+  suspicious_activity,
+  handler_exception,
+  handler_unknown_exception,
+  rate_limited,
+  incompatible_version,
+  client_name,
+  handshake_send_failed,
+  handshake_succeeded,
+  unknown_message_type,
+  action_validated,
+  sequence_not_increasing,
+  sequence_gap,
+  reload_parse_failed,
+  reload_validated,
+  reload_send_failed,
+  disconnect_parse_failed,
+  disconnect_validated,
+  keyframe_serialize_failed,
+  keyframe_send_failed,
+  state_resync,
+  batch_send_failed,
+  batch_serialize_failed,
+  state_update_failed,
+  write_queue_full,
+  write_exception,
+  write_error,
+  write_queue_dropped,
+  on_write_exception,
+  idle_timeout,
+  close_exception,
+  session_id_too_long,
+  session_id_mismatch,
+  protocol_error_send_failed,
+  tcp_close_error,
+  close_error,
+  do_close_exception,
+  message_burst,
+  malformed_frame,
+  malformed_frame_sampled,
+  max_connections,
+  session_id_collision,
+  session_registered,
+  session_unregistered,
+  sessions_stopped,
+  batch_too_large,
+};
+
+struct log_template {
+  log_id id;
+  log_level level;
+  std::string_view format;  // "{}" marks each argument.
+};
+
+// Indexed by log_id; append new templates at the end of both lists.
+inline constexpr log_template LOG_TEMPLATES[] = {
+    {log_id::session_init_failed, log_level::error, "[WebSocketSession] run() initialization error: {}"},
+    {log_id::accept_failed, log_level::error, "[WebSocketSession] Accept failed: {}"},
+    {log_id::accept_exception, log_level::error, "[WebSocketSession] Exception in on_accept: {}"},
+    {log_id::client_disconnected, log_level::info, "[WebSocketSession] Client disconnected: {}"},
+    {log_id::read_error, log_level::error, "[WebSocketSession] Read error for {}: {}"},
+    {log_id::suspicious_activity, log_level::error, "[WebSocketSession] Suspicious activity detected — closing session {}"},
+    {log_id::handler_exception, log_level::error, "[WebSocketSession] Unhandled exception in message handler: {}"},
+    {log_id::handler_unknown_exception, log_level::error,
+     "[WebSocketSession] Unknown exception in message handler for session {}"},
+    {log_id::rate_limited, log_level::error,
+     "[WebSocketSession] Rate limit exceeded (max {} messages per window) for session {}"},
+    {log_id::incompatible_version, log_level::error, "[WebSocketSession] Handshake error: Incompatible version {}"},
+    {log_id::client_name, log_level::info, "[WebSocketSession] Client Name: {}"},
+    {log_id::handshake_send_failed, log_level::error,
+     "[WebSocketSession] Failed to send handshake response for session: {}"},
+    {log_id::handshake_succeeded, log_level::info, "[WebSocketSession] Handshake successful for session: {}"},
+    {log_id::unknown_message_type, log_level::error, "[WebSocketSession] Unknown message type '{}' from {}"},
+    {log_id::action_validated, log_level::debug, "[WebSocketSession] Validated ACTION from {}: type={} seq={}"},
+    {log_id::sequence_not_increasing, log_level::error, "[WebSocketSession] Invalid sequence number {} (expected > {})"},
+    {log_id::sequence_gap, log_level::error,
+     "[WebSocketSession] Sequence number too far ahead: {} (gap: {}, max allowed: {})"},
+    {log_id::reload_parse_failed, log_level::error, "[WebSocketSession] Failed to parse RELOAD_REQUEST from {}"},
+    {log_id::reload_validated, log_level::debug, "[WebSocketSession] Validated RELOAD_REQUEST from {}"},
+    {log_id::reload_send_failed, log_level::error, "[WebSocketSession] Failed to send RELOAD_RESPONSE to {}"},
+    {log_id::disconnect_parse_failed, log_level::error, "[WebSocketSession] Failed to parse DISCONNECT from {}"},
+    {log_id::disconnect_validated, log_level::info, "[WebSocketSession] Validated DISCONNECT from {}"},
+    {log_id::keyframe_serialize_failed, log_level::error, "[WebSocketSession] Failed to serialize keyframe: {}"},
+    {log_id::keyframe_send_failed, log_level::error, "[WebSocketSession] Failed to send keyframe to {}"},
+    {log_id::state_resync, log_level::info, "[WebSocketSession] State resync for {} (acked {}, {})"},
+    {log_id::batch_send_failed, log_level::error, "[WebSocketSession] Failed to send BATCH replies to {}"},
+    {log_id::batch_serialize_failed, log_level::error, "[WebSocketSession] Failed to serialize BATCH replies: {}"},
+    {log_id::state_update_failed, log_level::error, "[WebSocketSession] Failed to send state update: {}"},
+    {log_id::write_queue_full, log_level::error,
+     "[WebSocketSession] Write queue full for session {}, dropping message"},
+    {log_id::write_exception, log_level::error,
+     "[WebSocketSession] Exception in do_write (allocation failure) - closing session {}"},
+    {log_id::write_error, log_level::error, "[WebSocketSession] Write error for {}: {}"},
+    {log_id::write_queue_dropped, log_level::error, "[WebSocketSession] Dropped {} queued message(s) on write error"},
+    {log_id::on_write_exception, log_level::error, "[WebSocketSession] Exception in on_write: {}"},
+    {log_id::idle_timeout, log_level::error, "[WebSocketSession] Idle timeout for session {}"},
+    {log_id::close_exception, log_level::error, "[WebSocketSession] Exception in close(): {}"},
+    {log_id::session_id_too_long, log_level::error, "[WebSocketSession] Session ID too long: {} > {}"},
+    {log_id::session_id_mismatch, log_level::error, "[WebSocketSession] Session ID mismatch: expected {}, got {}"},
+    {log_id::protocol_error_send_failed, log_level::error,
+     "[WebSocketSession] Failed to send protocol error for session {}"},
+    {log_id::tcp_close_error, log_level::error, "[WebSocketSession] TCP close error: {}"},
+    {log_id::close_error, log_level::error, "[WebSocketSession] Close error: {}"},
+    {log_id::do_close_exception, log_level::error, "[WebSocketSession] Exception in do_close: {}"},
+    {log_id::message_burst, log_level::error, "[WebSocketSession] Rapid message burst detected: {} messages in < 1s"},
+    {log_id::malformed_frame, log_level::error, "[WebSocketSession] Malformed frame from {}: {}"},
+    {log_id::malformed_frame_sampled, log_level::error,
+     "[WebSocketSession] Malformed frame from {}: {} ({} similar suppressed)"},
+    {log_id::max_connections, log_level::error, "[ConnectionManager] Maximum connections reached ({})"},
+    {log_id::session_id_collision, log_level::error, "[ConnectionManager] Session ID collision (attempt {}), retrying: {}"},
+    {log_id::session_registered, log_level::info, "[ConnectionManager] Registered session: {} (total: {})"},
+    {log_id::session_unregistered, log_level::info, "[ConnectionManager] Unregistered session: {} (remaining: {})"},
+    {log_id::sessions_stopped, log_level::info, "[ConnectionManager] Stopped {} session(s)."},
+    {log_id::batch_too_large, log_level::info,
+     "[WebSocketSession] Rejected BATCH costing {} units (burst is {}) from {}"},
+};
+
+inline constexpr size_t LOG_TEMPLATE_COUNT = std::size(LOG_TEMPLATES);
+
+namespace detail {
+
+constexpr bool log_templates_in_id_order() noexcept {
+  for (size_t i = 0; i < LOG_TEMPLATE_COUNT; ++i) {
+    if (static_cast<size_t>(LOG_TEMPLATES[i].id) != i) return false;
+  }
+  return true;
+}
+
+constexpr size_t count_log_placeholders(std::string_view format) noexcept {
+  size_t n = 0;
+  for (size_t i = 0; i + 1 < format.size(); ++i) {
+    if (format[i] == '{' && format[i + 1] == '}') {
+      ++n;
+      ++i;
+    }
+  }
+  return n;
+}
+
+}  // namespace detail
+
+static_assert(detail::log_templates_in_id_order(), "LOG_TEMPLATES must list templates in log_id order");
+
+// The template for a raw ID read back from a record, or nullptr.
+[[nodiscard]] constexpr const log_template* find_log_template(uint16_t id) noexcept {
+  return id < LOG_TEMPLATE_COUNT ? &LOG_TEMPLATES[id] : nullptr;
+}
+
+// A session handle argument: formatted as its "sess_..." ID, or
+// "(unauthenticated)" for INVALID_SESSION_HANDLE.
+struct log_session {
+  session_handle handle;
+};
+
+// A client-supplied string argument, cut to `max_length` like trunc_field().
+struct log_field {
+  std::string_view text;
+  size_t max_length;
+};
+
+// What a log entry holds: a finished text line, or an encoded record.
+enum class log_entry_kind : uint8_t { text, record };
+
+enum class log_arg_type : uint8_t { int64, uint64, session, string, truncated_string };
+
+// Longer string arguments are cut and shown with a trailing "...".
+inline constexpr size_t LOG_STRING_ARG_MAX = 128;
+inline constexpr size_t LOG_RECORD_MAX_ARGS = 8;
+inline constexpr size_t LOG_RECORD_HEADER_SIZE = 3;
+inline constexpr size_t LOG_RECORD_MAX_SIZE = LOG_RECORD_HEADER_SIZE + LOG_RECORD_MAX_ARGS * (2 + LOG_STRING_ARG_MAX);
+
+// Encodes one record into a fixed buffer; never allocates.
+class log_record_builder final {
+ public:
+  explicit log_record_builder(log_id id) noexcept;
+
+  void add_int(int64_t value) noexcept;
+  void add_uint(uint64_t value) noexcept;
+  void add_session(session_handle handle) noexcept;
+  // Cut to `max_length` (at most LOG_STRING_ARG_MAX) and marked as such.
+  void add_string(std::string_view value, size_t max_length = LOG_STRING_ARG_MAX) noexcept;
+
+  [[nodiscard]] std::string_view view() const noexcept { return {buf_.data(), size_}; }
+
+ private:
+  void add_fixed(log_arg_type type, uint64_t bits) noexcept;
+
+  std::array<char, LOG_RECORD_MAX_SIZE> buf_;
+  size_t size_;
+};
+
+template <typename T>
+void add_log_arg(log_record_builder& record, const T& value) noexcept {
+  if constexpr (std::is_same_v<T, log_session>) {
+    record.add_session(value.handle);
+  } else if constexpr (std::is_same_v<T, log_field>) {
+    record.add_string(value.text, value.max_length);
+  } else if constexpr (std::is_same_v<T, bool>) {
+    record.add_string(value ? "true" : "false");
+  } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+    record.add_int(value);
+  } else if constexpr (std::is_integral_v<T>) {
+    record.add_uint(value);
+  } else {
+    static_assert(std::is_convertible_v<const T&, std::string_view>,
+                  "log arguments are integers, log_session or string-like");
+    record.add_string(std::string_view(value));
+  }
+}
+
+// Appends the formatted text of `record` to `out`.  Returns false, and
+// appends nothing, if the record is malformed.  Can throw std::bad_alloc.
+bool format_log_record(std::string_view record, std::string& out);
+
+// Whether `record` is well formed and has `handle` as a session argument.
+[[nodiscard]] bool log_record_mentions_session(std::string_view record, session_handle handle) noexcept;
+
+// Hands an encoded record to the active sink.
+void write_log_record(log_level level, std::string_view record) noexcept;
+
+template <log_id Id, typename... Args>
+void log(const Args&... args) noexcept {
+  constexpr log_template tmpl = LOG_TEMPLATES[static_cast<size_t>(Id)];
+  static_assert(detail::count_log_placeholders(tmpl.format) == sizeof...(Args),
+                "argument count does not match the log template");
+  static_assert(sizeof...(Args) <= LOG_RECORD_MAX_ARGS, "too many log arguments");
+  if constexpr (tmpl.level >= LOG_MIN_LEVEL) {
+    log_record_builder record(Id);
+    (add_log_arg(record, args), ...);
+    write_log_record(tmpl.level, record.view());
+  }
+}
+
+}  // namespace server
+}  // namespace cppsim
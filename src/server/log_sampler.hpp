@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace cppsim {
+namespace server {
+
+// Bounds how many events of one kind reach the log.  Within each window the
+// first `burst` events are admitted, then only every `sample_every`-th; the
+// rest are counted and the count is handed to the next admitted event so the
+// log line can say how many were dropped.
+//
+// Thread-safe and lock-free: any io thread may call admit().  The window
+// reset races benignly — at worst a few events are sampled against the
+// wrong window.
+class log_sampler final {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  log_sampler(size_t burst, uint64_t sample_every, clock::duration window) noexcept
+      : burst_(burst), sample_every_(std::max<uint64_t>(sample_every, 1)), window_(window.count()) {}
+
+  log_sampler(const log_sampler&) = delete;
+  log_sampler& operator=(const log_sampler&) = delete;
+
+  // Records one event at `now`.  Returns true if it should be logged; then
+  // `suppressed` is the number of events dropped since the last admitted one.
+  [[nodiscard]] bool admit(clock::time_point now, uint64_t& suppressed) noexcept {
+    const clock::rep t = now.time_since_epoch().count();
+    clock::rep start = window_start_.load(std::memory_order_relaxed);
+    if (t - start >= window_ && window_start_.compare_exchange_strong(start, t, std::memory_order_relaxed)) {
+      seen_.store(0, std::memory_order_relaxed);
+    }
+
+    const uint64_t n = seen_.fetch_add(1, std::memory_order_relaxed);
+    if (n < burst_ || (n - burst_) % sample_every_ == sample_every_ - 1) {
+      suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+      return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // Events dropped and not yet reported by an admitted one.
+  [[nodiscard]] uint64_t pending_suppressed() const noexcept {
+    return suppressed_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const uint64_t burst_;
+  const uint64_t sample_every_;
+  const clock::rep window_;
+  std::atomic<clock::rep> window_start_{0};
+  std::atomic<uint64_t> seen_{0};
+  std::atomic<uint64_t> suppressed_{0};
+};
+
+}  // namespace server
+}  // namespace cppsim
@@ -0,0 +1,96 @@
+// poker_logdump: decode binary server logs (binary_log.hpp) to text.
+//
+//   poker_logdump [--session ID] [--since TIME] [--until TIME] [--level LEVEL] FILE...
+//
+// Files are decoded in the order given — pass rotated files oldest first
+// ("server.plog.2 server.plog.1 server.plog").  TIME is seconds since the
+// epoch or "YYYY-mm-ddTHH:MM:SS[.mmm]" in UTC; --until is exclusive.
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binary_log.hpp"
+#include "session_handle.hpp"
+
+namespace {
+
+constexpr int EXIT_USAGE = 2;
+
+int usage(const char* reason) {
+  if (reason) std::cerr << "poker_logdump: " << reason << "\n";
+  std::cerr << "Usage: poker_logdump [--session sess_...] [--since TIME] [--until TIME]\n"
+               "                     [--level debug|info|error] FILE...\n"
+               "TIME is seconds since the epoch or YYYY-mm-ddTHH:MM:SS[.mmm] (UTC).\n";
+  return EXIT_USAGE;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  using namespace cppsim::server;
+
+  log_entry_filter filter;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      usage(nullptr);
+      return EXIT_SUCCESS;
+    }
+    if (arg == "--session" || arg == "--since" || arg == "--until" || arg == "--level") {
+      if (i + 1 >= argc) return usage("missing value");
+      const std::string_view value = argv[++i];
+      if (arg == "--session") {
+        filter.session = parse_session_id(value);
+        if (filter.session == INVALID_SESSION_HANDLE) return usage("bad session ID");
+      } else if (arg == "--level") {
+        if (value == "debug") {
+          filter.min_level = log_level::debug;
+        } else if (value == "info") {
+          filter.min_level = log_level::info;
+        } else if (value == "error") {
+          filter.min_level = log_level::error;
+        } else {
+          return usage("bad level");
+        }
+      } else {
+        const auto time = parse_log_time(value);
+        if (!time) return usage("bad time");
+        (arg == "--since" ? filter.since_ns : filter.until_ns) = *time;
+      }
+    } else if (!arg.empty() && arg[0] == '-') {
+      return usage("unknown option");
+    } else {
+      files.emplace_back(arg);
+    }
+  }
+  if (files.empty()) return usage("no input files");
+
+  int status = EXIT_SUCCESS;
+  std::string out;
+  for (const auto& file : files) {
+    binary_log_reader reader(file);
+    binary_log_entry entry;
+    while (reader.next(entry)) {
+      if (!filter.matches(entry)) continue;
+      append_log_entry_text(entry, out);
+      if (out.size() >= 64 * 1024) {
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        out.clear();
+      }
+    }
+    if (!reader.error().empty()) {
+      std::fwrite(out.data(), 1, out.size(), stdout);
+      out.clear();
+      std::fflush(stdout);
+      std::cerr << "poker_logdump: " << reader.error() << "\n";
+      status = EXIT_FAILURE;
+    }
+  }
+  std::fwrite(out.data(), 1, out.size(), stdout);
+  return status;
+}
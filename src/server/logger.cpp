@@ -1,8 +1,12 @@
 #include "logger.hpp"
+#include "async_logger.hpp"
+#include "log_record.hpp"
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cstdio>
+#include <cstdlib>
 #include <ctime>
 #include <iostream>
 #include <mutex>
@@ -14,6 +18,11 @@ namespace server {
 namespace {
     std::mutex log_mutex;
 
+    // Never deleted once started: a thread may still be inside log() on a
+    // logger that stop_async_logging() has just swapped out.
+    std::atomic<async_logger*> active_logger{nullptr};
+    std::atomic<uint64_t> dropped_by_stopped_loggers{0};
+
     constexpr size_t TIMESTAMP_BUFFER_SIZE = 32;
     constexpr size_t MS_PRECISION = 3;
 
@@ -42,24 +51,84 @@ namespace {
       }
       return buf;
     }
+
+    void write_line(log_level level, std::string_view msg) noexcept {
+      try {
+        auto timestamp = get_timestamp();
+        std::lock_guard<std::mutex> lock(log_mutex);
+        std::ostream& stream = (level == log_level::error) ? std::cerr : std::cout;
+        stream << timestamp.data() << " " << log_level_to_string(level) << " " << msg << '\n';
+        stream.flush();
+      } catch (...) {
+        // Best-effort fallback — fprintf to stderr is atomic on POSIX,
+        // no additional synchronization needed.
+        constexpr size_t MAX_FALLBACK_MSG_SIZE = 1024;
+        std::fprintf(stderr, "[FALLBACK] %s %.*s\n",
+                     log_level_to_string(level),
+                     static_cast<int>(std::min(msg.size(), MAX_FALLBACK_MSG_SIZE)),
+                     msg.data());
+      }
+    }
 }
 
 void log(log_level level, std::string_view msg) noexcept {
+    if (level < LOG_MIN_LEVEL) {
+      return;
+    }
+    if (async_logger* logger = active_logger.load(std::memory_order_acquire)) {
+      if (logger->log(level, msg)) {
+        return;
+      }
+    }
+    write_line(level, msg);
+}
+
+void write_log_record(log_level level, std::string_view record) noexcept {
+    if (async_logger* logger = active_logger.load(std::memory_order_acquire)) {
+      if (logger->log_record(level, record)) {
+        return;
+      }
+    }
     try {
-      auto timestamp = get_timestamp();
-      std::lock_guard<std::mutex> lock(log_mutex);
-      std::ostream& stream = (level == log_level::error) ? std::cerr : std::cout;
-      stream << timestamp.data() << " " << log_level_to_string(level) << " " << msg << '\n';
-      stream.flush();
+      std::string line;
+      if (!format_log_record(record, line)) {
+        line = "[Logger] Malformed log record";
+      }
+      write_line(level, line);
     } catch (...) {
-      // Best-effort fallback — fprintf to stderr is atomic on POSIX,
-      // no additional synchronization needed.
-      constexpr size_t MAX_FALLBACK_MSG_SIZE = 1024;
-      std::fprintf(stderr, "[FALLBACK] %s %.*s\n",
-                   log_level_to_string(level),
-                   static_cast<int>(std::min(msg.size(), MAX_FALLBACK_MSG_SIZE)),
-                   msg.data());
+      write_line(log_level::error, "[Logger] Failed to format log record");
+    }
+}
+
+void start_async_logging(const async_log_options& options) {
+    auto* logger = new async_logger(options);
+    if (async_logger* previous = active_logger.exchange(logger, std::memory_order_acq_rel)) {
+      previous->stop();
+      dropped_by_stopped_loggers.fetch_add(previous->dropped(), std::memory_order_relaxed);
+    }
+    static const bool registered = std::atexit([] { stop_async_logging(); }) == 0;
+    (void)registered;
+}
+
+void stop_async_logging() noexcept {
+    if (async_logger* logger = active_logger.exchange(nullptr, std::memory_order_acq_rel)) {
+      logger->stop();
+      dropped_by_stopped_loggers.fetch_add(logger->dropped(), std::memory_order_relaxed);
+    }
+}
+
+void flush_logs() noexcept {
+    if (async_logger* logger = active_logger.load(std::memory_order_acquire)) {
+      logger->flush();
+    }
+}
+
+uint64_t dropped_log_records() noexcept {
+    uint64_t dropped = dropped_by_stopped_loggers.load(std::memory_order_relaxed);
+    if (async_logger* logger = active_logger.load(std::memory_order_acquire)) {
+      dropped += logger->dropped();
     }
+    return dropped;
 }
 
 void log_message(std::string_view msg) noexcept {
@@ -1,19 +1,78 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
 #include <string_view>
 
+#include "config.hpp"
+
 namespace cppsim {
 namespace server {
 
-enum class log_level { info, error };
+enum class log_level : uint8_t { debug, info, error };
 
 [[nodiscard]] constexpr const char* log_level_to_string(log_level level) noexcept {
-  return level == log_level::error ? "[ERROR]" : "[INFO]";
+  switch (level) {
+    case log_level::debug:
+      return "[DEBUG]";
+    case log_level::error:
+      return "[ERROR]";
+    default:
+      return "[INFO]";
+  }
 }
 
+// Lowest level compiled in; set with -DCPPSIM_LOG_MIN_LEVEL=DEBUG|INFO|ERROR
+// at configure time.  Structured lines below it (log<log_id::...>()) compile
+// to nothing; plain log() calls below it return immediately.
+#define CPPSIM_LOG_LEVEL_DEBUG 0
+#define CPPSIM_LOG_LEVEL_INFO 1
+#define CPPSIM_LOG_LEVEL_ERROR 2
+#ifndef CPPSIM_LOG_MIN_LEVEL
+#define CPPSIM_LOG_MIN_LEVEL CPPSIM_LOG_LEVEL_INFO
+#endif
+inline constexpr log_level LOG_MIN_LEVEL = static_cast<log_level>(CPPSIM_LOG_MIN_LEVEL);
+
+// What a thread does when its log ring is full.
+enum class log_overflow_policy {
+  drop,   // Discard the line and count it (dropped_log_records()).
+  block,  // Wait for the flusher to make room.
+};
+
+struct async_log_options {
+  size_t ring_records = config::LOG_RING_RECORDS;
+  log_overflow_policy overflow =
+      config::LOG_BLOCK_WHEN_FULL ? log_overflow_policy::block : log_overflow_policy::drop;
+  std::chrono::milliseconds flush_interval = config::LOG_FLUSH_INTERVAL;
+  std::FILE* info_stream = stdout;
+  std::FILE* error_stream = stderr;
+  // When set, lines go to this binary log (binary_log.hpp) instead of
+  // info_stream; error lines are still written to error_stream as text.
+  std::string binary_path;
+  uint64_t binary_file_max_bytes = config::LOG_FILE_MAX_BYTES;
+  size_t binary_files_kept = config::LOG_FILES_KEPT;
+};
+
 void log_message(std::string_view msg) noexcept;
 void log_error(std::string_view msg) noexcept;
 void log(log_level level, std::string_view msg) noexcept;
 
+// Until start_async_logging(), and again after stop_async_logging(), log()
+// formats and writes each line synchronously on the calling thread.  In
+// between, lines go through an async_logger: the caller only copies the
+// line into its thread's ring and a background thread writes them.
+void start_async_logging(const async_log_options& options = {});
+// Writes everything still queued and stops the background thread.  Also
+// runs at exit.  Lines logged concurrently with the stop may be lost, so
+// call it once the threads that log have been joined.
+void stop_async_logging() noexcept;
+// Returns once every line logged before the call has been written.
+void flush_logs() noexcept;
+// Lines discarded under log_overflow_policy::drop since start-up.
+[[nodiscard]] uint64_t dropped_log_records() noexcept;
+
 }
 }
@@ -1,23 +1,73 @@
+#include <algorithm>
 #include <csignal>
 #include <cstdlib>
 #include <thread>
-#include <atomic>
+#include <memory>
+#include <vector>
 
 #include "boost_wrapper.hpp"
 #include "config.hpp"
+#include "log_sampler.hpp"
 #include "logger.hpp"
 #include "protocol.hpp"
 #include "websocket_server.hpp"
 #include "runtime_config_manager.hpp"
 #include "metrics_collector.hpp"
+#include "metrics_http_server.hpp"
 #include <filesystem>
 
+namespace {
+
+// Resolve the configured io thread count (0 = one per hardware thread).
+size_t resolve_io_threads(size_t configured) noexcept {
+  if (configured > 0) {
+    return configured;
+  }
+  // hardware_concurrency() may return 0 when the value is not computable.
+  return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Run the io_context until it is stopped.  Handlers are expected to catch
+// their own exceptions, but one escaping io_context::run() must not take a
+// worker thread (and with it std::terminate) down — log and resume.
+void run_io_context(boost::asio::io_context& ioc) noexcept {
+  for (;;) {
+    try {
+      ioc.run();
+      return;
+    } catch (const std::exception& e) {
+      cppsim::server::log_error(std::string("[Main] Exception escaped io handler: ") + e.what());
+    } catch (...) {
+      cppsim::server::log_error("[Main] Unknown exception escaped io handler");
+    }
+  }
+}
+
+}  // namespace
+
 int main() {
   try {
-    // Set up error logging
-    cppsim::protocol::set_error_logger([](std::string_view msg) {
+    // From here on log lines are written by a background thread; whatever is
+    // still queued at exit is written by stop_async_logging().
+    cppsim::server::start_async_logging();
+
+    // Set up error logging.  Sampled: a flood of bad frames must not turn
+    // into a flood of log lines and locked error records.
+    const auto suppressed_errors =
+        cppsim::server::metrics_collector::register_counter("errors.protocol_error_suppressed");
+    cppsim::protocol::set_error_logger([suppressed_errors](std::string_view msg) {
+      using cppsim::server::config;
+      static cppsim::server::log_sampler sampler(config::MALFORMED_LOG_BURST, config::MALFORMED_LOG_SAMPLE_EVERY,
+                                                 config::MALFORMED_LOG_WINDOW);
+      uint64_t suppressed = 0;
+      if (!sampler.admit(std::chrono::steady_clock::now(), suppressed)) {
+        return;
+      }
       cppsim::server::log_error(msg);
       cppsim::server::metrics_collector::record_error("protocol_error", std::string(msg));
+      if (suppressed != 0) {
+        suppressed_errors.add(static_cast<int64_t>(suppressed));
+      }
     });
     
     // Initialize metrics collection
@@ -45,63 +95,107 @@ int main() {
     cppsim::server::log_message("  - Max message size: " + std::to_string(config.get_max_message_size()));
     cppsim::server::log_message("  - Security enabled: " + std::string(config.is_security_enabled() ? "true" : "false"));
     cppsim::server::log_message("  - Metrics enabled: " + std::string(config.is_metrics_enabled() ? "true" : "false"));
-    
-    boost::asio::io_context ioc;
-    std::atomic<bool> running{true};
 
-    // Create server with configuration-based port
-    auto server = std::make_shared<cppsim::server::websocket_server>(ioc, cppsim::server::config::DEFAULT_PORT);
+    // The log file comes from the config, so start-up logs as text up to here.
+    if (const std::string& log_file = config.get_log_file(); !log_file.empty()) {
+      cppsim::server::log_message("  - Log file: " + log_file + " (binary; read with poker_logdump)");
+      cppsim::server::async_log_options log_options;
+      log_options.binary_path = log_file;
+      cppsim::server::start_async_logging(log_options);
+    }
 
-    boost::asio::signal_set signals(ioc, SIGINT, SIGTERM);
-    signals.async_wait([&running, &ioc](boost::beast::error_code const&, int) {
+    const size_t io_threads = resolve_io_threads(config.get_io_threads());
+    bool sharded = config.is_sharded_acceptors_enabled();
+    if (sharded && !cppsim::server::websocket_server::reuse_port_supported()) {
+      cppsim::server::log_error("[Main] SO_REUSEPORT not supported on this platform, using a shared io_context");
+      sharded = false;
+    }
+    cppsim::server::log_message("  - I/O threads: " + std::to_string(io_threads) +
+                                (sharded ? " (sharded acceptors)" : " (shared io_context)"));
+
+    // Shared mode: one io_context run by every io thread.  Per-session
+    // ordering is guaranteed by the strands the acceptor and sessions are
+    // bound to.
+    // Sharded mode: one io_context per io thread, each with its own
+    // SO_REUSEPORT acceptor and connection_manager shard, so no session ever
+    // touches another thread's scheduler or registry.
+    // The concurrency hint lets asio skip scheduler locking when an
+    // io_context is only run by a single thread.
+    const size_t shard_count = sharded ? io_threads : 1;
+    const size_t threads_per_shard = sharded ? 1 : io_threads;
+    // Every shard reserves from one server-wide connection budget.
+    const auto connection_budget = std::make_shared<cppsim::server::connection_limit>(
+        static_cast<size_t>(config.get_max_connections()));
+
+    std::vector<std::unique_ptr<boost::asio::io_context>> iocs;
+    std::vector<std::shared_ptr<cppsim::server::websocket_server>> servers;
+    iocs.reserve(shard_count);
+    servers.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+      iocs.push_back(std::make_unique<boost::asio::io_context>(static_cast<int>(threads_per_shard)));
+      servers.push_back(std::make_shared<cppsim::server::websocket_server>(
+          *iocs.back(), cppsim::server::config::DEFAULT_PORT, cppsim::server::config::HANDSHAKE_TIMEOUT,
+          sharded, connection_budget));
+    }
+
+    boost::asio::signal_set signals(*iocs.front(), SIGINT, SIGTERM);
+    signals.async_wait([&iocs](boost::beast::error_code const&, int) {
       cppsim::server::log_message("[Main] Shutting down server...");
       
-      // Signal metrics thread to stop
-      running = false;
-      
       // Record shutdown metrics
       auto uptime = std::chrono::duration_cast<std::chrono::seconds>(
           std::chrono::steady_clock::now() - cppsim::server::metrics_collector::instance().get_start_time()).count();
       cppsim::server::metrics_collector::record_event("server_shutdown");
       cppsim::server::metrics_collector::set_gauge("server_uptime_seconds", static_cast<double>(uptime));
       
-      ioc.stop();
+      for (auto& ioc : iocs) {
+        ioc->stop();
+      }
     });
 
     cppsim::server::log_message("[Main] Server running. Press Ctrl+C to stop.");
     
-    // Start metrics collection thread if enabled
-    std::thread metrics_thread;
-    if (config.is_metrics_enabled()) {
-      metrics_thread = std::thread([&running]() {
-        while (running) {
-          // Sleep in short increments so the thread exits promptly when
-          // `running` becomes false during shutdown.
-          for (int i = 0; i < 30 && running; ++i) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-          }
-          if (!running) break;
-          try {
-            std::string metrics = cppsim::server::metrics_collector::export_metrics();
-            cppsim::server::log_message("[Metrics] Exported " + std::to_string(metrics.size()) + " bytes of metrics");
-          } catch (const std::exception& e) {
-            cppsim::server::log_error(std::string("[Metrics] Export failed: ") + e.what());
-          }
-        }
-      });
+    // Serve /metrics from its own thread, so scrapes never run on an io thread.
+    std::unique_ptr<cppsim::server::metrics_http_server> metrics_server;
+    if (config.is_metrics_enabled() && config.get_metrics_port() != 0) {
+      using cppsim::server::metrics_collector;
+      const auto dropped_log_gauge = metrics_collector::register_gauge("logger.dropped_records");
+      const auto uptime_gauge = metrics_collector::register_gauge("server_uptime_seconds");
+      metrics_server = std::make_unique<cppsim::server::metrics_http_server>(
+          config.get_metrics_address(), config.get_metrics_port(), [dropped_log_gauge, uptime_gauge] {
+            dropped_log_gauge.set(static_cast<double>(cppsim::server::dropped_log_records()));
+            uptime_gauge.set(std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                           metrics_collector::get_start_time())
+                                 .count());
+          });
+      metrics_server->start();
+      cppsim::server::log_message("[Main] Metrics at http://" + config.get_metrics_address() + ":" +
+                                  std::to_string(metrics_server->port()) + "/metrics");
     }
     
-    server->run();
-    ioc.run();
-
-    // Join metrics thread before destroying shared state (the `running` flag,
-    // metrics_collector singleton, etc.).  A detached thread could outlive
-    // main() and touch destroyed objects during shutdown.
-    if (metrics_thread.joinable()) {
-      metrics_thread.join();
+    for (auto& server : servers) {
+      server->run();
+    }
+
+    // The main thread runs the first shard; spawn the remaining workers.
+    std::vector<std::thread> io_workers;
+    io_workers.reserve(shard_count * threads_per_shard - 1);
+    for (size_t shard = 0; shard < shard_count; ++shard) {
+      for (size_t t = (shard == 0 ? 1 : 0); t < threads_per_shard; ++t) {
+        io_workers.emplace_back([ioc = iocs[shard].get()]() { run_io_context(*ioc); });
+      }
+    }
+    run_io_context(*iocs.front());
+    for (auto& worker : io_workers) {
+      worker.join();
+    }
+
+    if (metrics_server) {
+      metrics_server->stop();
     }
 
     cppsim::server::log_message("[Main] Server stopped.");
+    cppsim::server::stop_async_logging();
     return EXIT_SUCCESS;
 
   } catch (const std::exception& e) {
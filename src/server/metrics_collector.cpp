@@ -1,65 +1,152 @@
-#include <cmath>
+#include <algorithm>
 #include <limits>
 
 #include "metrics_collector.hpp"
+#include "openmetrics.hpp"
 
 namespace cppsim {
 namespace server {
 
-metrics_collector::metrics_collector() : start_time_(std::chrono::steady_clock::now()) {}
-metrics_collector::~metrics_collector() = default;
+namespace detail {
+
+size_t assign_metric_stripe() noexcept {
+    static std::atomic<size_t> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed) % METRIC_STRIPES;
+}
+
+} // namespace detail
+
+namespace {
+
+int64_t sum_stripes(const detail::counter_cell& cell) noexcept {
+    int64_t total = 0;
+    for (const auto& stripe : cell.stripes) {
+        total += stripe.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
 
-// Helper function to calculate percentile
-// Precondition: samples must already be sorted in ascending order.
-double metrics_collector::calculate_percentile(const std::vector<int64_t>& sorted_samples, int percentile) {
-    if (sorted_samples.empty()) return 0.0;
+// Histogram "le" bounds for timings.  A fine bucket straddling a bound is
+// counted in the next one up, so a count can lag by under 1.6% of the bound.
+struct openmetrics_bound {
+    uint64_t micros;
+    std::string_view label;  // In seconds.
+};
+constexpr openmetrics_bound OPENMETRICS_BOUNDS[] = {
+    {100, "0.0001"}, {250, "0.00025"}, {500, "0.0005"},
+    {1000, "0.001"}, {2500, "0.0025"}, {5000, "0.005"},
+    {10000, "0.01"}, {25000, "0.025"}, {50000, "0.05"},
+    {100000, "0.1"}, {250000, "0.25"}, {500000, "0.5"},
+    {1000000, "1"}, {2500000, "2.5"}, {5000000, "5"}, {10000000, "10"},
+};
+
+// Pointers to the metrics in `map` that are exported, sorted by name.  Keys
+// and cells stay put once inserted, so they can be read after unlocking.
+template <typename Cell>
+std::vector<std::pair<const std::string*, const Cell*>> listed_metrics(
+    const std::unordered_map<std::string, Cell>& map, std::mutex& mutex) {
+    std::vector<std::pair<const std::string*, const Cell*>> listed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        listed.reserve(map.size());
+        for (const auto& [name, cell] : map) {
+            if (cell.listed.load(std::memory_order_relaxed)) {
+                listed.emplace_back(&name, &cell);
+            }
+        }
+    }
+    std::sort(listed.begin(), listed.end(), [](const auto& a, const auto& b) { return *a.first < *b.first; });
+    return listed;
+}
 
-    double index = (percentile / 100.0) * static_cast<double>(sorted_samples.size() - 1);
-    size_t lower_idx = static_cast<size_t>(std::floor(index));
-    size_t upper_idx = static_cast<size_t>(std::ceil(index));
+template <typename Cell>
+Cell& mark_registered(Cell& cell) noexcept {
+    cell.registered = true;
+    cell.listed.store(true, std::memory_order_relaxed);
+    return cell;
+}
+
+} // namespace
+
+int64_t counter_handle::value() const noexcept {
+    return sum_stripes(*cell_);
+}
 
-    if (lower_idx == upper_idx) {
-        return static_cast<double>(sorted_samples[lower_idx]);
+void timing_handle::record(std::chrono::microseconds duration) const noexcept {
+    const int64_t value = std::max<int64_t>(duration.count(), 0);
+    auto& stripe = cell_->stripes[detail::metric_stripe()];
+    stripe.count.fetch_add(1, std::memory_order_relaxed);
+    stripe.sum.fetch_add(value, std::memory_order_relaxed);
+    int64_t seen = stripe.min.load(std::memory_order_relaxed);
+    while (value < seen && !stripe.min.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
     }
+    seen = stripe.max.load(std::memory_order_relaxed);
+    while (value > seen && !stripe.max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+    cell_->histogram.record(static_cast<uint64_t>(value));
+}
+
+metrics_collector::metrics_collector()
+    : errors_total_(&mark_registered(counter_cell_for("errors.total"))),
+      start_time_(std::chrono::steady_clock::now()) {}
+metrics_collector::~metrics_collector() = default;
+
+detail::counter_cell& metrics_collector::counter_cell_for(const std::string& name) {
+    std::lock_guard<std::mutex> lock(counters_mutex_);
+    return counters_.try_emplace(name).first->second;
+}
+
+detail::gauge_cell& metrics_collector::gauge_cell_for(const std::string& name) {
+    std::lock_guard<std::mutex> lock(gauges_mutex_);
+    return gauges_.try_emplace(name).first->second;
+}
 
-    double weight = index - static_cast<double>(lower_idx);
-    return static_cast<double>(sorted_samples[lower_idx]) * (1 - weight) +
-           static_cast<double>(sorted_samples[upper_idx]) * weight;
+detail::timing_cell& metrics_collector::timing_cell_for(const std::string& name) {
+    std::lock_guard<std::mutex> lock(timings_mutex_);
+    return timings_.try_emplace(name).first->second;
+}
+
+counter_handle metrics_collector::register_counter(const std::string& name) {
+    auto& m = instance();
+    std::lock_guard<std::mutex> lock(m.counters_mutex_);
+    return counter_handle(&mark_registered(m.counters_.try_emplace(name).first->second));
+}
+
+gauge_handle metrics_collector::register_gauge(const std::string& name) {
+    auto& m = instance();
+    std::lock_guard<std::mutex> lock(m.gauges_mutex_);
+    return gauge_handle(&mark_registered(m.gauges_.try_emplace(name).first->second));
+}
+
+timing_handle metrics_collector::register_timing(const std::string& name) {
+    auto& m = instance();
+    std::lock_guard<std::mutex> lock(m.timings_mutex_);
+    return timing_handle(&mark_registered(m.timings_.try_emplace(name).first->second));
 }
 
 void metrics_collector::increment_counter(const std::string& name, int64_t value) noexcept {
     try {
-        auto& m = instance();
-        std::lock_guard<std::mutex> lock(m.counters_mutex_);
-        m.counters_[name] += value;
+        auto& cell = instance().counter_cell_for(name);
+        cell.listed.store(true, std::memory_order_relaxed);
+        counter_handle(&cell).add(value);
     } catch (...) {
     }
 }
 
 void metrics_collector::set_gauge(const std::string& name, double value) noexcept {
     try {
-        auto& m = instance();
-        std::lock_guard<std::mutex> lock(m.gauges_mutex_);
-        m.gauges_[name] = value;
+        auto& cell = instance().gauge_cell_for(name);
+        cell.listed.store(true, std::memory_order_relaxed);
+        gauge_handle(&cell).set(value);
     } catch (...) {
     }
 }
 
-void metrics_collector::record_timing(const std::string& name, std::chrono::milliseconds duration) noexcept {
+void metrics_collector::record_timing(const std::string& name, std::chrono::microseconds duration) noexcept {
     try {
-        auto& m = instance();
-        std::lock_guard<std::mutex> lock(m.timings_mutex_);
-        auto& timing_data = m.timings_[name];
-
-        timing_data.count++;
-        timing_data.sum += duration.count();
-        timing_data.min = std::min(timing_data.min, duration.count());
-        timing_data.max = std::max(timing_data.max, duration.count());
-
-        if (timing_data.samples.size() > 1000) {
-            timing_data.samples.pop_front();
-        }
-        timing_data.samples.push_back(duration.count());
+        auto& cell = instance().timing_cell_for(name);
+        cell.listed.store(true, std::memory_order_relaxed);
+        timing_handle(&cell).record(duration);
     } catch (...) {
     }
 }
@@ -85,6 +172,7 @@ void metrics_collector::record_event(const std::string& name, const std::vector<
 void metrics_collector::record_error(const std::string& error_type, const std::string& details) noexcept {
     try {
         auto& m = instance();
+        detail::counter_cell* type_counter = nullptr;
         {
             std::lock_guard<std::mutex> lock(m.errors_mutex_);
 
@@ -97,12 +185,19 @@ void metrics_collector::record_error(const std::string& error_type, const std::s
             if (m.errors_.size() > 500) {
                 m.errors_.pop_front();
             }
+
+            auto it = m.error_counters_.find(error_type);
+            if (it == m.error_counters_.end()) {
+                // counters_mutex_ nests inside errors_mutex_ only here, and
+                // never the other way round.
+                it = m.error_counters_.emplace(error_type, &m.counter_cell_for("errors." + error_type)).first;
+            }
+            type_counter = it->second;
         }
 
-        // Increment counters after releasing errors_mutex_ to avoid holding
-        // two locks simultaneously (counters_mutex_ + errors_mutex_).
-        increment_counter("errors.total");
-        increment_counter("errors." + error_type, 1);
+        m.errors_total_.add();
+        type_counter->listed.store(true, std::memory_order_relaxed);
+        counter_handle(type_counter).add();
     } catch (...) {
     }
 }
@@ -118,8 +213,10 @@ std::string metrics_collector::export_metrics() noexcept {
         json_result["counters"] = nlohmann::json::object();
         {
             std::lock_guard<std::mutex> clk(m.counters_mutex_);
-            for (const auto& [name, value] : m.counters_) {
-                json_result["counters"][name] = value;
+            for (const auto& [name, cell] : m.counters_) {
+                if (cell.listed.load(std::memory_order_relaxed)) {
+                    json_result["counters"][name] = sum_stripes(cell);
+                }
             }
         }
 
@@ -127,8 +224,10 @@ std::string metrics_collector::export_metrics() noexcept {
         json_result["gauges"] = nlohmann::json::object();
         {
             std::lock_guard<std::mutex> glk(m.gauges_mutex_);
-            for (const auto& [name, value] : m.gauges_) {
-                json_result["gauges"][name] = value;
+            for (const auto& [name, cell] : m.gauges_) {
+                if (cell.listed.load(std::memory_order_relaxed)) {
+                    json_result["gauges"][name] = cell.value.load(std::memory_order_relaxed);
+                }
             }
         }
 
@@ -136,24 +235,38 @@ std::string metrics_collector::export_metrics() noexcept {
         json_result["timings"] = nlohmann::json::object();
         {
             std::lock_guard<std::mutex> tlk(m.timings_mutex_);
-            for (const auto& [name, data] : m.timings_) {
+            for (const auto& [name, cell] : m.timings_) {
+                if (!cell.listed.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+                int64_t count = 0;
+                int64_t sum = 0;
+                int64_t min = std::numeric_limits<int64_t>::max();
+                int64_t max = 0;
+                for (const auto& stripe : cell.stripes) {
+                    count += stripe.count.load(std::memory_order_relaxed);
+                    sum += stripe.sum.load(std::memory_order_relaxed);
+                    min = std::min(min, stripe.min.load(std::memory_order_relaxed));
+                    max = std::max(max, stripe.max.load(std::memory_order_relaxed));
+                }
+                histogram_snapshot histogram;
+                cell.histogram.add_to(histogram);
+                // A bucket's upper bound can exceed every value in it.
+                const auto percentile = [&histogram, max](double p) {
+                    return std::min(histogram.value_at_percentile(p), static_cast<uint64_t>(max));
+                };
+
                 nlohmann::json timing_json;
-                timing_json["count"] = data.count;
-                timing_json["sum_ms"] = data.sum;
-                timing_json["min_ms"] = data.min;
-                timing_json["max_ms"] = data.max;
-                timing_json["avg_ms"] = data.count > 0
-                    ? static_cast<double>(data.sum) / static_cast<double>(data.count)
+                timing_json["count"] = count;
+                timing_json["sum_us"] = sum;
+                timing_json["min_us"] = count > 0 ? min : 0;
+                timing_json["avg_us"] = count > 0
+                    ? static_cast<double>(sum) / static_cast<double>(count)
                     : 0.0;
-
-                if (!data.samples.empty()) {
-                    std::vector<int64_t> sorted_samples(data.samples.begin(), data.samples.end());
-                    std::sort(sorted_samples.begin(), sorted_samples.end());
-
-                    timing_json["p50_ms"] = calculate_percentile(sorted_samples, 50);
-                    timing_json["p95_ms"] = calculate_percentile(sorted_samples, 95);
-                    timing_json["p99_ms"] = calculate_percentile(sorted_samples, 99);
-                }
+                timing_json["p50_us"] = percentile(50.0);
+                timing_json["p99_us"] = percentile(99.0);
+                timing_json["p999_us"] = percentile(99.9);
+                timing_json["max_us"] = max;
 
                 json_result["timings"][name] = timing_json;
             }
@@ -215,12 +328,57 @@ std::string metrics_collector::export_metrics() noexcept {
     }
 }
 
+void metrics_collector::append_openmetrics(std::string& out) {
+    auto& m = instance();
+
+    for (const auto& [name, cell] : listed_metrics(m.counters_, m.counters_mutex_)) {
+        const std::string family = openmetrics_counter_family(*name);
+        append_openmetrics_type(out, family, "counter");
+        append_openmetrics_sample(out, family, "_total", sum_stripes(*cell));
+    }
+
+    for (const auto& [name, cell] : listed_metrics(m.gauges_, m.gauges_mutex_)) {
+        const std::string family = openmetrics_family(*name);
+        append_openmetrics_type(out, family, "gauge");
+        append_openmetrics_sample(out, family, "", cell->value.load(std::memory_order_relaxed));
+    }
+
+    for (const auto& [name, cell] : listed_metrics(m.timings_, m.timings_mutex_)) {
+        const std::string family = openmetrics_family(*name, "_seconds");
+        int64_t sum_us = 0;
+        for (const auto& stripe : cell->stripes) {
+            sum_us += stripe.sum.load(std::memory_order_relaxed);
+        }
+        histogram_snapshot histogram;
+        cell->histogram.add_to(histogram);
+
+        append_openmetrics_type(out, family, "histogram");
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+        for (const auto& bound : OPENMETRICS_BOUNDS) {
+            for (; bucket < histogram.counts.size() && histogram_layout::bucket_highest(bucket) <= bound.micros;
+                 ++bucket) {
+                cumulative += histogram.counts[bucket];
+            }
+            out.append(family).append("_bucket{le=\"").append(bound.label).append("\"} ");
+            append_openmetrics_number(out, cumulative);
+            out.append("\n");
+        }
+        // Counts and +Inf come from the same snapshot, so they agree.
+        out.append(family).append("_bucket{le=\"+Inf\"} ");
+        append_openmetrics_number(out, histogram.total);
+        out.append("\n");
+        append_openmetrics_sample(out, family, "_sum", static_cast<double>(sum_us) / 1e6);
+        append_openmetrics_sample(out, family, "_count", histogram.total);
+    }
+}
+
 int64_t metrics_collector::get_counter(const std::string& name) noexcept {
     try {
         auto& m = instance();
         std::lock_guard<std::mutex> lock(m.counters_mutex_);
         auto it = m.counters_.find(name);
-        return it != m.counters_.end() ? it->second : 0;
+        return it != m.counters_.end() ? sum_stripes(it->second) : 0;
     } catch (...) {
         return 0;
     }
@@ -231,7 +389,7 @@ double metrics_collector::get_gauge(const std::string& name) noexcept {
         auto& m = instance();
         std::lock_guard<std::mutex> lock(m.gauges_mutex_);
         auto it = m.gauges_.find(name);
-        return it != m.gauges_.end() ? it->second : 0.0;
+        return it != m.gauges_.end() ? it->second.value.load(std::memory_order_relaxed) : 0.0;
     } catch (...) {
         return 0.0;
     }
@@ -246,17 +404,36 @@ void metrics_collector::reset() noexcept {
         // start_time_.
         std::lock_guard<std::mutex> elk(m.export_mutex_);
 
+        // Metrics are zeroed rather than erased, since handles point at them.
+        // Ones nobody registered drop out of the export until next updated.
         {
             std::lock_guard<std::mutex> clk(m.counters_mutex_);
-            m.counters_.clear();
+            for (auto& [name, cell] : m.counters_) {
+                for (auto& stripe : cell.stripes) {
+                    stripe.value.store(0, std::memory_order_relaxed);
+                }
+                cell.listed.store(cell.registered, std::memory_order_relaxed);
+            }
         }
         {
             std::lock_guard<std::mutex> glk(m.gauges_mutex_);
-            m.gauges_.clear();
+            for (auto& [name, cell] : m.gauges_) {
+                cell.value.store(0.0, std::memory_order_relaxed);
+                cell.listed.store(cell.registered, std::memory_order_relaxed);
+            }
         }
         {
             std::lock_guard<std::mutex> tlk(m.timings_mutex_);
-            m.timings_.clear();
+            for (auto& [name, cell] : m.timings_) {
+                for (auto& stripe : cell.stripes) {
+                    stripe.count.store(0, std::memory_order_relaxed);
+                    stripe.sum.store(0, std::memory_order_relaxed);
+                    stripe.min.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+                    stripe.max.store(0, std::memory_order_relaxed);
+                }
+                cell.histogram.clear();
+                cell.listed.store(cell.registered, std::memory_order_relaxed);
+            }
         }
         {
             std::lock_guard<std::mutex> elkk(m.events_mutex_);
@@ -1,23 +1,132 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <limits>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "latency_histogram.hpp"
+
 namespace cppsim {
 namespace server {
 
+namespace detail {
+
+// Updates land on one of METRIC_STRIPES cache-line-sized slots, picked per
+// thread, and are summed when read; threads only share a line once there
+// are more of them than stripes.
+inline constexpr size_t METRIC_STRIPES = 16;
+
+size_t assign_metric_stripe() noexcept;
+
+inline size_t metric_stripe() noexcept {
+    static thread_local const size_t stripe = assign_metric_stripe();
+    return stripe;
+}
+
+struct alignas(64) counter_stripe {
+    std::atomic<int64_t> value{0};
+};
+
+struct alignas(64) timing_stripe {
+    std::atomic<int64_t> count{0};
+    std::atomic<int64_t> sum{0};
+    std::atomic<int64_t> min{std::numeric_limits<int64_t>::max()};
+    std::atomic<int64_t> max{0};
+};
+
+// Storage behind one named metric.  Never freed or moved, so handles can
+// point straight at it.  `listed` says whether the exports show it:
+// registered metrics always, others once updated since the last reset().
+struct counter_cell {
+    std::array<counter_stripe, METRIC_STRIPES> stripes;
+    std::atomic<bool> listed{false};
+    bool registered = false;
+};
+
+struct gauge_cell {
+    alignas(64) std::atomic<double> value{0.0};
+    std::atomic<bool> listed{false};
+    bool registered = false;
+};
+
+struct timing_cell {
+    std::array<timing_stripe, METRIC_STRIPES> stripes;
+    latency_histogram histogram;  // Shared; a hit bucket is rarely contended.
+    std::atomic<bool> listed{false};
+    bool registered = false;
+};
+
+} // namespace detail
+
+/**
+ * @brief Pre-registered counter; see metrics_collector::register_counter().
+ *
+ * add() is one relaxed atomic add on a per-thread stripe — no lookup, no lock.
+ */
+class counter_handle {
+public:
+    void add(int64_t value = 1) const noexcept {
+        cell_->stripes[detail::metric_stripe()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] int64_t value() const noexcept;
+
+private:
+    friend class metrics_collector;
+    explicit counter_handle(detail::counter_cell* cell) noexcept : cell_(cell) {}
+
+    detail::counter_cell* cell_;
+};
+
+/**
+ * @brief Pre-registered gauge; see metrics_collector::register_gauge().
+ */
+class gauge_handle {
+public:
+    void set(double value) const noexcept { cell_->value.store(value, std::memory_order_relaxed); }
+
+    [[nodiscard]] double value() const noexcept { return cell_->value.load(std::memory_order_relaxed); }
+
+private:
+    friend class metrics_collector;
+    explicit gauge_handle(detail::gauge_cell* cell) noexcept : cell_(cell) {}
+
+    detail::gauge_cell* cell_;
+};
+
+/**
+ * @brief Pre-registered timing; see metrics_collector::register_timing().
+ */
+class timing_handle {
+public:
+    void record(std::chrono::microseconds duration) const noexcept;
+
+private:
+    friend class metrics_collector;
+    explicit timing_handle(detail::timing_cell* cell) noexcept : cell_(cell) {}
+
+    detail::timing_cell* cell_;
+};
+
 /**
  * @brief High-performance metrics collection for poker server
  *
  * Provides thread-safe metrics collection with minimal overhead.
  * Supports counters, gauges, histograms, and timing metrics.
  * Designed to be called frequently without impacting performance.
+ *
+ * Hot paths should register their metrics once and update them through the
+ * returned handles, which never lock; the name-based calls look the metric
+ * up under a mutex on every call.  Both update the same storage.
  */
 class metrics_collector {
 public:
@@ -31,12 +140,33 @@ public:
         return instance;
     }
 
+    /**
+     * @brief Register (or look up) a metric by name, typically at startup.
+     *
+     * The handle stays valid for the life of the process, across reset(),
+     * and the metric is exported even before its first update.
+     * @throws std::bad_alloc
+     */
+    static counter_handle register_counter(const std::string& name);
+    static gauge_handle register_gauge(const std::string& name);
+    static timing_handle register_timing(const std::string& name);
+
     static void increment_counter(const std::string& name, int64_t value = 1) noexcept;
     static void set_gauge(const std::string& name, double value) noexcept;
-    static void record_timing(const std::string& name, std::chrono::milliseconds duration) noexcept;
+    static void record_timing(const std::string& name, std::chrono::microseconds duration) noexcept;
     static void record_event(const std::string& name, const std::vector<std::string>& tags = {}) noexcept;
     static void record_error(const std::string& error_type, const std::string& details = "") noexcept;
     static std::string export_metrics() noexcept;
+
+    /**
+     * @brief Append every exported metric in OpenMetrics text format
+     *
+     * Counters, gauges and timings (as histograms in seconds), without the
+     * closing "# EOF".  The map mutexes are held only while collecting
+     * pointers; values are read lock-free afterwards.
+     * @throws std::bad_alloc
+     */
+    static void append_openmetrics(std::string& out);
     static int64_t get_counter(const std::string& name) noexcept;
     static double get_gauge(const std::string& name) noexcept;
     static void reset() noexcept;
@@ -46,25 +176,20 @@ private:
     metrics_collector();
     ~metrics_collector();
 
-    static double calculate_percentile(const std::vector<int64_t>& sorted_samples, int percentile);
+    detail::counter_cell& counter_cell_for(const std::string& name);
+    detail::gauge_cell& gauge_cell_for(const std::string& name);
+    detail::timing_cell& timing_cell_for(const std::string& name);
 
-    // Counter metrics
-    std::unordered_map<std::string, int64_t> counters_;
+    // Metric storage.  Entries are never erased, and unordered_map never
+    // moves its elements, so handles stay valid; the mutexes guard the maps
+    // themselves, not the values.
+    std::unordered_map<std::string, detail::counter_cell> counters_;
     mutable std::mutex counters_mutex_;
 
-    // Gauge metrics
-    std::unordered_map<std::string, double> gauges_;
+    std::unordered_map<std::string, detail::gauge_cell> gauges_;
     mutable std::mutex gauges_mutex_;
 
-    // Timing metrics
-    struct timing_data {
-        int64_t count{0};
-        int64_t sum{0};
-        int64_t min{std::numeric_limits<int64_t>::max()};
-        int64_t max{0};
-        std::deque<int64_t> samples;
-    };
-    std::unordered_map<std::string, timing_data> timings_;
+    std::unordered_map<std::string, detail::timing_cell> timings_;
     mutable std::mutex timings_mutex_;
 
     // Event metrics
@@ -83,7 +208,11 @@ private:
         std::string details;
     };
     std::deque<error_data> errors_;
+    // "errors.<type>" counters by type, so record_error() does not rebuild
+    // the name.
+    std::unordered_map<std::string, detail::counter_cell*> error_counters_;
     mutable std::mutex errors_mutex_;
+    counter_handle errors_total_;
 
     // Export mutex — also guards start_time_ (read by get_start_time(),
     // written by reset() and the constructor).
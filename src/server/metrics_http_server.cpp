@@ -0,0 +1,176 @@
+#include "metrics_http_server.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "logger.hpp"
+#include "metrics_collector.hpp"
+#include "openmetrics.hpp"
+
+namespace cppsim {
+namespace server {
+
+namespace http = boost::beast::http;
+
+namespace {
+
+void append_session_counter(std::string& out, std::string_view name, uint64_t value) {
+  const std::string family = openmetrics_family(name);
+  append_openmetrics_type(out, family, "counter");
+  append_openmetrics_sample(out, family, "_total", value);
+}
+
+// One scrape: read a request, write the page, close.
+class metrics_connection final : public std::enable_shared_from_this<metrics_connection> {
+ public:
+  metrics_connection(boost::asio::ip::tcp::socket socket, const std::function<void()>& on_scrape,
+                     std::chrono::seconds timeout)
+      : stream_(std::move(socket)), on_scrape_(on_scrape), timeout_(timeout) {}
+
+  void run() {
+    stream_.expires_after(timeout_);
+    http::async_read(stream_, buffer_, request_,
+                     [self = shared_from_this()](boost::beast::error_code ec, std::size_t) { self->on_read(ec); });
+  }
+
+ private:
+  void on_read(boost::beast::error_code ec) {
+    if (ec) {
+      return;  // Timed out, malformed or closed: nothing worth answering.
+    }
+    response_.version(request_.version());
+    response_.keep_alive(false);
+    if (request_.method() != http::verb::get) {
+      response_.result(http::status::method_not_allowed);
+      response_.set(http::field::allow, "GET");
+    } else if (request_.target() != "/metrics") {
+      response_.result(http::status::not_found);
+    } else {
+      try {
+        if (on_scrape_) on_scrape_();
+        response_.body() = render_openmetrics_page();
+        response_.result(http::status::ok);
+        response_.set(http::field::content_type,
+                      boost::beast::string_view(OPENMETRICS_CONTENT_TYPE.data(), OPENMETRICS_CONTENT_TYPE.size()));
+      } catch (const std::exception& e) {
+        log_error(std::string("[Metrics] Failed to render /metrics: ") + e.what());
+        response_.result(http::status::internal_server_error);
+        response_.body().clear();
+      }
+    }
+    response_.prepare_payload();
+    stream_.expires_after(timeout_);
+    http::async_write(stream_, response_, [self = shared_from_this()](boost::beast::error_code, std::size_t) {
+      boost::beast::error_code ignored;
+      self->stream_.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_send, ignored);
+    });
+  }
+
+  boost::beast::tcp_stream stream_;
+  boost::beast::flat_buffer buffer_;
+  http::request<http::empty_body> request_;
+  http::response<http::string_body> response_;
+  const std::function<void()>& on_scrape_;
+  std::chrono::seconds timeout_;
+};
+
+}  // namespace
+
+std::string render_openmetrics_page(const session_metrics_registry& registry) {
+  std::string out;
+  out.reserve(16 * 1024);
+  metrics_collector::append_openmetrics(out);
+
+  const auto sessions = registry.summarize();
+  const std::string live = openmetrics_family("sessions_live");
+  append_openmetrics_type(out, live, "gauge");
+  append_openmetrics_sample(out, live, "", sessions.live_sessions);
+  append_session_counter(out, "session_messages_sent", sessions.messages_sent);
+  append_session_counter(out, "session_messages_received", sessions.messages_received);
+  append_session_counter(out, "session_bytes_sent", sessions.bytes_sent);
+  append_session_counter(out, "session_bytes_received", sessions.bytes_received);
+  append_session_counter(out, "session_errors", sessions.errors);
+  append_session_counter(out, "session_rate_limit_exceeded", sessions.rate_limit_exceeded);
+  append_session_counter(out, "session_malformed_frames", sessions.malformed_frames);
+  append_session_counter(out, "session_batches", sessions.batches);
+  append_session_counter(out, "session_batched_messages", sessions.batched_messages);
+  append_session_counter(out, "session_write_flushes", sessions.flushes);
+  append_session_counter(out, "session_frames_flushed", sessions.frames_flushed);
+
+  out.append("# EOF\n");
+  return out;
+}
+
+metrics_http_server::metrics_http_server(const std::string& address, uint16_t port,
+                                         std::function<void()> on_scrape, std::chrono::seconds request_timeout)
+    : acceptor_(ioc_), retry_timer_(ioc_), on_scrape_(std::move(on_scrape)), request_timeout_(request_timeout) {
+  boost::beast::error_code ec;
+  const auto ip = boost::asio::ip::make_address(address, ec);
+  if (ec) {
+    throw std::runtime_error("[Metrics] Invalid metrics_address '" + address + "': " + ec.message());
+  }
+  const boost::asio::ip::tcp::endpoint endpoint{ip, port};
+  acceptor_.open(endpoint.protocol(), ec);
+  if (!ec) acceptor_.set_option(boost::asio::socket_base::reuse_address(true), ec);
+  if (!ec) acceptor_.bind(endpoint, ec);
+  if (!ec) acceptor_.listen(boost::asio::socket_base::max_listen_connections, ec);
+  if (ec) {
+    throw std::runtime_error("[Metrics] Failed to listen on " + address + ":" + std::to_string(port) + ": " +
+                             ec.message());
+  }
+  port_ = acceptor_.local_endpoint().port();
+}
+
+metrics_http_server::~metrics_http_server() noexcept {
+  stop();
+}
+
+void metrics_http_server::start() {
+  do_accept();
+  thread_ = std::thread([this] {
+    try {
+      ioc_.run();
+    } catch (const std::exception& e) {
+      log_error(std::string("[Metrics] Listener stopped: ") + e.what());
+    }
+  });
+}
+
+void metrics_http_server::stop() noexcept {
+  // Stopping the io_context abandons any scrape in flight; its connection
+  // is destroyed with the context.
+  ioc_.stop();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  boost::beast::error_code ec;
+  acceptor_.close(ec);
+}
+
+void metrics_http_server::do_accept() {
+  acceptor_.async_accept([this](boost::beast::error_code ec, boost::asio::ip::tcp::socket socket) {
+    if (ec == boost::asio::error::operation_aborted) {
+      return;
+    }
+    if (ec) {
+      // Typically out of file descriptors; retrying at once would spin.
+      log_error("[Metrics] Accept failed: " + ec.message());
+      retry_timer_.expires_after(std::chrono::seconds{1});
+      retry_timer_.async_wait([this](boost::beast::error_code wait_ec) {
+        if (!wait_ec) do_accept();
+      });
+      return;
+    }
+    try {
+      std::make_shared<metrics_connection>(std::move(socket), on_scrape_, request_timeout_)->run();
+    } catch (const std::exception& e) {
+      log_error(std::string("[Metrics] Failed to start scrape: ") + e.what());
+    }
+    do_accept();
+  });
+}
+
+}  // namespace server
+}  // namespace cppsim
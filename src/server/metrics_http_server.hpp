@@ -0,0 +1,59 @@
+#pragma once
+
+#include "boost_wrapper.hpp"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "config.hpp"
+#include "session_metrics.hpp"
+
+namespace cppsim {
+namespace server {
+
+// The /metrics page: metrics_collector's metrics and `registry`'s summed
+// session_metrics in OpenMetrics text format, ending in "# EOF".
+// Can throw std::bad_alloc.
+[[nodiscard]] std::string render_openmetrics_page(
+    const session_metrics_registry& registry = session_metrics_registry::instance());
+
+// Admin HTTP listener serving GET /metrics for Prometheus-style scrapers.
+//
+// Runs its own io_context on its own thread, so a slow or stuck scraper
+// never occupies a game io thread; rendering only reads atomics and takes
+// the metric registries' locks long enough to copy pointers.  One request
+// per connection, answered with "Connection: close".
+class metrics_http_server final {
+ public:
+  // Binds `address`:`port` (port 0 picks a free one).  `on_scrape` runs on
+  // the listener thread before each render, to refresh polled gauges.
+  // Throws std::runtime_error if the address cannot be bound.
+  metrics_http_server(const std::string& address, uint16_t port, std::function<void()> on_scrape = {},
+                      std::chrono::seconds request_timeout = config::METRICS_REQUEST_TIMEOUT);
+  metrics_http_server(const metrics_http_server&) = delete;
+  metrics_http_server& operator=(const metrics_http_server&) = delete;
+  ~metrics_http_server() noexcept;
+
+  // Starts the listener thread.
+  void start();
+  // Closes the listener and joins its thread; idempotent.
+  void stop() noexcept;
+
+  [[nodiscard]] uint16_t port() const noexcept { return port_; }
+
+ private:
+  void do_accept();
+
+  boost::asio::io_context ioc_{1};
+  boost::asio::ip::tcp::acceptor acceptor_;
+  boost::asio::steady_timer retry_timer_;  // Backs off after a failed accept.
+  std::function<void()> on_scrape_;
+  std::chrono::seconds request_timeout_;
+  uint16_t port_ = 0;
+  std::thread thread_;
+};
+
+}  // namespace server
+}  // namespace cppsim
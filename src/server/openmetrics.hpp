@@ -0,0 +1,61 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace cppsim {
+namespace server {
+
+// Pieces of the OpenMetrics text format, written straight into a string.
+// Every family is "poker_" + the metric's name with anything outside
+// [A-Za-z0-9_] turned into '_'; counters get the "_total" sample suffix the
+// format requires, and timings are histograms in seconds.
+
+inline constexpr std::string_view OPENMETRICS_CONTENT_TYPE =
+    "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+inline std::string openmetrics_family(std::string_view name, std::string_view unit_suffix = {}) {
+  std::string family = "poker_";
+  family.reserve(family.size() + name.size() + unit_suffix.size());
+  for (const char c : name) {
+    const bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    family += valid ? c : '_';
+  }
+  family.append(unit_suffix);
+  return family;
+}
+
+// As openmetrics_family(), less a trailing "_total", which the counter's
+// sample name adds back ("errors.total" -> poker_errors -> poker_errors_total).
+inline std::string openmetrics_counter_family(std::string_view name) {
+  std::string family = openmetrics_family(name);
+  constexpr std::string_view TOTAL = "_total";
+  if (family.size() > TOTAL.size() + 6 && std::string_view(family).substr(family.size() - TOTAL.size()) == TOTAL) {
+    family.resize(family.size() - TOTAL.size());
+  }
+  return family;
+}
+
+inline void append_openmetrics_type(std::string& out, std::string_view family, std::string_view type) {
+  out.append("# TYPE ").append(family).append(" ").append(type).append("\n");
+}
+
+template <typename T>
+void append_openmetrics_number(std::string& out, T value) {
+  char buf[32];
+  const auto result = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, static_cast<size_t>(result.ptr - buf));
+}
+
+// "<family><suffix> <value>\n"
+template <typename T>
+void append_openmetrics_sample(std::string& out, std::string_view family, std::string_view suffix, T value) {
+  out.append(family).append(suffix).append(" ");
+  append_openmetrics_number(out, value);
+  out.append("\n");
+}
+
+}  // namespace server
+}  // namespace cppsim
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace cppsim {
+namespace server {
+
+// Reference-counted, immutable serialized message.  Serialize once, then hand
+// the same payload to any number of sessions: each queues a pointer, not a
+// copy, and the bytes live until the last session's write completes.
+using shared_payload = std::shared_ptr<const std::string>;
+
+// Can throw std::bad_alloc.
+[[nodiscard]] inline shared_payload make_shared_payload(std::string message) {
+  return std::make_shared<const std::string>(std::move(message));
+}
+
+// One entry in a session's outbound queue: either a string the session owns
+// outright (unicast replies — no extra allocation) or a shared payload
+// (broadcasts).  Either way the bytes stay put until the write completes.
+// `binary` selects a binary WebSocket frame (CBOR / MessagePack sessions)
+// instead of a text one.
+class outbound_message final {
+ public:
+  outbound_message() noexcept = default;
+  explicit outbound_message(std::string owned, bool binary = false) noexcept
+      : owned_(std::move(owned)), binary_(binary) {}
+  explicit outbound_message(shared_payload shared, bool binary = false) noexcept
+      : shared_(std::move(shared)), binary_(binary) {}
+
+  outbound_message(outbound_message&&) noexcept = default;
+  outbound_message& operator=(outbound_message&&) noexcept = default;
+  outbound_message(const outbound_message&) = delete;
+  outbound_message& operator=(const outbound_message&) = delete;
+
+  [[nodiscard]] const std::string& bytes() const noexcept { return shared_ ? *shared_ : owned_; }
+
+  [[nodiscard]] bool is_shared() const noexcept { return shared_ != nullptr; }
+
+  [[nodiscard]] bool is_binary() const noexcept { return binary_; }
+
+ private:
+  std::string owned_;
+  shared_payload shared_;
+  bool binary_{false};
+};
+
+}  // namespace server
+}  // namespace cppsim
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "config.hpp"
+#include "protocol.hpp"
+
+namespace cppsim {
+namespace server {
+
+// Rate-limit cost of each inbound message type, in units of one message.
+// Every frame is charged one unit before it is parsed; once its type is
+// known the remaining (cost - 1) units are charged.
+struct message_cost_table {
+  uint32_t handshake{config::RATE_COST_HANDSHAKE};
+  uint32_t action{config::RATE_COST_ACTION};
+  uint32_t reload_request{config::RATE_COST_RELOAD_REQUEST};
+  uint32_t disconnect{config::RATE_COST_DISCONNECT};
+  uint32_t state_ack{config::RATE_COST_STATE_ACK};
+
+  [[nodiscard]] uint32_t cost_for(protocol::message_kind kind) const noexcept {
+    switch (kind) {
+      case protocol::message_kind::action: return action;
+      case protocol::message_kind::reload_request: return reload_request;
+      case protocol::message_kind::disconnect: return disconnect;
+      case protocol::message_kind::state_ack: return state_ack;
+      case protocol::message_kind::handshake: return handshake;
+      default: return 1;
+    }
+  }
+
+  [[nodiscard]] uint32_t cost_for(std::string_view message_type) const noexcept {
+    return cost_for(protocol::lookup_message_kind(message_type));
+  }
+};
+
+// Generic cell rate algorithm (GCRA) — a token bucket stored as a single
+// "theoretical arrival time".  Allows bursts of up to `max_per_window`
+// units, refilled at `max_per_window` units per `window`.  O(1) time and
+// constant memory per session.
+//
+// Not thread-safe: owned by one session and only touched on its strand.
+class gcra_rate_limiter final {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  gcra_rate_limiter() noexcept { configure(config::MAX_MESSAGES_PER_WINDOW, config::RATE_LIMIT_WINDOW); }
+
+  void configure(size_t max_per_window, clock::duration window) noexcept {
+    max_per_window_ = std::max<size_t>(max_per_window, 1);
+    burst_ = window;
+    emission_interval_ = window / static_cast<clock::rep>(max_per_window_);
+  }
+
+  // Charges `cost` units at `now`.  Returns false — and charges nothing —
+  // if that would exceed the burst allowance.
+  [[nodiscard]] bool try_acquire(uint32_t cost, clock::time_point now) noexcept {
+    if (cost == 0) {
+      return true;
+    }
+    const auto tat = std::max(tat_, now) + emission_interval_ * static_cast<clock::rep>(cost);
+    if (tat - now > burst_) {
+      return false;
+    }
+    tat_ = tat;
+    return true;
+  }
+
+  [[nodiscard]] size_t max_per_window() const noexcept { return max_per_window_; }
+
+ private:
+  size_t max_per_window_{1};
+  clock::duration burst_{};
+  clock::duration emission_interval_{};
+  clock::time_point tat_{};
+};
+
+}  // namespace server
+}  // namespace cppsim
@@ -13,6 +13,86 @@
 namespace cppsim {
 namespace server {
 
+bool config_snapshot::same_values(const config_snapshot& other) const noexcept {
+    const auto& a = rate_limit_costs;
+    const auto& b = other.rate_limit_costs;
+    return max_connections == other.max_connections &&
+           handshake_timeout == other.handshake_timeout &&
+           max_message_size == other.max_message_size &&
+           max_write_queue_size == other.max_write_queue_size &&
+           max_messages_per_window == other.max_messages_per_window &&
+           rate_limit_window == other.rate_limit_window &&
+           a.handshake == b.handshake && a.action == b.action &&
+           a.reload_request == b.reload_request && a.disconnect == b.disconnect &&
+           a.state_ack == b.state_ack &&
+           max_backoff == other.max_backoff &&
+           ws_idle_timeout == other.ws_idle_timeout &&
+           max_amount == other.max_amount &&
+           max_sequence_gap == other.max_sequence_gap &&
+           io_threads == other.io_threads &&
+           sharded_acceptors == other.sharded_acceptors &&
+           write_coalescing == other.write_coalescing &&
+           log_file == other.log_file &&
+           security_enabled == other.security_enabled &&
+           metrics_enabled == other.metrics_enabled &&
+           metrics_port == other.metrics_port &&
+           metrics_address == other.metrics_address;
+}
+
+runtime_config_manager::runtime_config_manager() {
+    // Readers may call snapshot() before any file is loaded.
+    snapshots_.push_back(std::make_unique<const config_snapshot>());
+    current_.store(snapshots_.back().get(), std::memory_order_release);
+}
+
+void runtime_config_manager::publish(config_snapshot next) {
+    const config_snapshot* published = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(config_mutex_);
+        const config_snapshot* current = current_.load(std::memory_order_relaxed);
+        if (next.same_values(*current)) {
+            return;  // Nothing changed — keep readers' cached pointers current.
+        }
+        next.version = current->version + 1;
+        snapshots_.reserve(snapshots_.size() + 1);
+        snapshots_.push_back(std::make_unique<const config_snapshot>(next));
+        published = snapshots_.back().get();
+        current_.store(published, std::memory_order_release);
+    }
+
+    std::vector<change_listener> to_notify;
+    {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        to_notify.reserve(listeners_.size());
+        for (const auto& entry : listeners_) {
+            to_notify.push_back(entry.second);
+        }
+    }
+    for (const auto& listener : to_notify) {
+        try {
+            listener(*published);
+        } catch (const std::exception& e) {
+            log_error(std::string("[RuntimeConfig] Exception in change listener: ") + e.what());
+        } catch (...) {
+            log_error("[RuntimeConfig] Unknown exception in change listener");
+        }
+    }
+}
+
+size_t runtime_config_manager::add_change_listener(change_listener listener) {
+    std::lock_guard<std::mutex> lock(listeners_mutex_);
+    const size_t id = next_listener_id_++;
+    listeners_.emplace_back(id, std::move(listener));
+    return id;
+}
+
+void runtime_config_manager::remove_change_listener(size_t id) noexcept {
+    std::lock_guard<std::mutex> lock(listeners_mutex_);
+    listeners_.erase(std::remove_if(listeners_.begin(), listeners_.end(),
+                                    [id](const auto& entry) { return entry.first == id; }),
+                     listeners_.end());
+}
+
 bool runtime_config_manager::load_from_file(const std::string& path) noexcept {
     try {
         // Parse the file outside the lock — I/O + JSON parsing don't need
@@ -86,12 +166,19 @@ bool runtime_config_manager::load_from_json(const nlohmann::json& config_json) n
         size_t new_max_write_queue_size = config::MAX_WRITE_QUEUE_SIZE;
         size_t new_max_messages_per_window = config::MAX_MESSAGES_PER_WINDOW;
         auto new_rate_limit_window = config::RATE_LIMIT_WINDOW;
+        message_cost_table new_rate_limit_costs{};
         auto new_max_backoff = config::MAX_BACKOFF;
         auto new_ws_idle_timeout = std::chrono::duration_cast<std::chrono::seconds>(config::WS_IDLE_TIMEOUT);
         int64_t new_max_amount = protocol::MAX_AMOUNT;
         int64_t new_max_sequence_gap = config::MAX_SEQUENCE_GAP;
+        size_t new_io_threads = config::IO_THREADS;
+        bool new_sharded_acceptors = config::SHARDED_ACCEPTORS;
+        bool new_write_coalescing = config::WRITE_COALESCING;
+        std::string new_log_file;
         bool new_security_enabled = true;
         bool new_metrics_enabled = true;
+        uint16_t new_metrics_port = config::METRICS_PORT;
+        std::string new_metrics_address = config::METRICS_ADDRESS;
 
         // Load values from JSON with per-field clamping
         if (config_json.contains("max_connections") && config_json["max_connections"].is_number()) {
@@ -142,6 +229,58 @@ bool runtime_config_manager::load_from_json(const nlohmann::json& config_json) n
             }
         }
         
+        if (config_json.contains("rate_limit_costs") && config_json["rate_limit_costs"].is_object()) {
+            const message_cost_table defaults{};
+            for (const auto& [type, value] : config_json["rate_limit_costs"].items()) {
+                uint32_t* cost = nullptr;
+                uint32_t fallback = 1;
+                switch (protocol::lookup_message_kind(type)) {
+                    case protocol::message_kind::handshake:
+                        cost = &new_rate_limit_costs.handshake;
+                        fallback = defaults.handshake;
+                        break;
+                    case protocol::message_kind::action:
+                        cost = &new_rate_limit_costs.action;
+                        fallback = defaults.action;
+                        break;
+                    case protocol::message_kind::reload_request:
+                        cost = &new_rate_limit_costs.reload_request;
+                        fallback = defaults.reload_request;
+                        break;
+                    case protocol::message_kind::disconnect:
+                        cost = &new_rate_limit_costs.disconnect;
+                        fallback = defaults.disconnect;
+                        break;
+                    case protocol::message_kind::state_ack:
+                        cost = &new_rate_limit_costs.state_ack;
+                        fallback = defaults.state_ack;
+                        break;
+                    default:
+                        break;
+                }
+                if (!cost) {
+                    log_error("[RuntimeConfig] Unknown message type in rate_limit_costs: " + type.substr(0, 32));
+                    continue;
+                }
+                // A message must be affordable within one full window.
+                int64_t v = value.is_number_integer() ? value.get<int64_t>() : 0;
+                if (v < 1 || v > static_cast<int64_t>(new_max_messages_per_window)) {
+                    log_error("[RuntimeConfig] Invalid rate_limit_costs." + type + ", using default");
+                    *cost = fallback;
+                } else {
+                    *cost = static_cast<uint32_t>(v);
+                }
+            }
+        }
+        // Defaults and fallbacks too: with a tiny window even the default
+        // RELOAD_REQUEST cost could never be afforded.
+        const auto max_cost = static_cast<uint32_t>(new_max_messages_per_window);
+        for (uint32_t* cost : {&new_rate_limit_costs.handshake, &new_rate_limit_costs.action,
+                               &new_rate_limit_costs.reload_request, &new_rate_limit_costs.disconnect,
+                               &new_rate_limit_costs.state_ack}) {
+            *cost = std::min(*cost, max_cost);
+        }
+        
         if (config_json.contains("max_backoff") && config_json["max_backoff"].is_number()) {
             new_max_backoff = std::chrono::seconds(config_json["max_backoff"].get<int64_t>());
             if (new_max_backoff < std::chrono::seconds(1) || new_max_backoff > std::chrono::seconds(300)) {
@@ -178,6 +317,28 @@ bool runtime_config_manager::load_from_json(const nlohmann::json& config_json) n
             }
         }
         
+        if (config_json.contains("io_threads") && config_json["io_threads"].is_number_integer()) {
+            int64_t io_threads = config_json["io_threads"].get<int64_t>();
+            if (io_threads < 0 || io_threads > static_cast<int64_t>(config::MAX_IO_THREADS)) {
+                log_error("[RuntimeConfig] Invalid io_threads, using default");
+                new_io_threads = config::IO_THREADS;
+            } else {
+                new_io_threads = static_cast<size_t>(io_threads);
+            }
+        }
+        
+        if (config_json.contains("sharded_acceptors") && config_json["sharded_acceptors"].is_boolean()) {
+            new_sharded_acceptors = config_json["sharded_acceptors"].get<bool>();
+        }
+        
+        if (config_json.contains("write_coalescing") && config_json["write_coalescing"].is_boolean()) {
+            new_write_coalescing = config_json["write_coalescing"].get<bool>();
+        }
+        
+        if (config_json.contains("log_file") && config_json["log_file"].is_string()) {
+            new_log_file = config_json["log_file"].get<std::string>();
+        }
+        
         if (config_json.contains("security_enabled") && config_json["security_enabled"].is_boolean()) {
             new_security_enabled = config_json["security_enabled"].get<bool>();
         }
@@ -186,28 +347,46 @@ bool runtime_config_manager::load_from_json(const nlohmann::json& config_json) n
             new_metrics_enabled = config_json["metrics_enabled"].get<bool>();
         }
         
+        if (config_json.contains("metrics_port") && config_json["metrics_port"].is_number_integer()) {
+            int64_t metrics_port = config_json["metrics_port"].get<int64_t>();
+            if (metrics_port < 0 || metrics_port > 65535) {
+                log_error("[RuntimeConfig] Invalid metrics_port, using default");
+            } else {
+                new_metrics_port = static_cast<uint16_t>(metrics_port);
+            }
+        }
+        
+        if (config_json.contains("metrics_address") && config_json["metrics_address"].is_string()) {
+            new_metrics_address = config_json["metrics_address"].get<std::string>();
+        }
+        
         // Validate cross-field invariants before committing
         if (new_max_write_queue_size < new_max_messages_per_window) {
             log_error("[RuntimeConfig] max_write_queue_size must be >= max_messages_per_window");
             return false;
         }
         
-        // Commit the new values under a single lock acquisition
-        {
-            std::lock_guard<std::mutex> lock(config_mutex_);
-            max_connections_ = new_max_connections;
-            handshake_timeout_ = new_handshake_timeout;
-            max_message_size_ = new_max_message_size;
-            max_write_queue_size_ = new_max_write_queue_size;
-            max_messages_per_window_ = new_max_messages_per_window;
-            rate_limit_window_ = new_rate_limit_window;
-            max_backoff_ = new_max_backoff;
-            ws_idle_timeout_ = new_ws_idle_timeout;
-            max_amount_ = new_max_amount;
-            max_sequence_gap_ = new_max_sequence_gap;
-            security_enabled_ = new_security_enabled;
-            metrics_enabled_ = new_metrics_enabled;
-        }
+        config_snapshot next;
+        next.max_connections = new_max_connections;
+        next.handshake_timeout = new_handshake_timeout;
+        next.max_message_size = new_max_message_size;
+        next.max_write_queue_size = new_max_write_queue_size;
+        next.max_messages_per_window = new_max_messages_per_window;
+        next.rate_limit_window = new_rate_limit_window;
+        next.rate_limit_costs = new_rate_limit_costs;
+        next.max_backoff = new_max_backoff;
+        next.ws_idle_timeout = new_ws_idle_timeout;
+        next.max_amount = new_max_amount;
+        next.max_sequence_gap = new_max_sequence_gap;
+        next.io_threads = new_io_threads;
+        next.sharded_acceptors = new_sharded_acceptors;
+        next.write_coalescing = new_write_coalescing;
+        next.log_file = std::move(new_log_file);
+        next.security_enabled = new_security_enabled;
+        next.metrics_enabled = new_metrics_enabled;
+        next.metrics_port = new_metrics_port;
+        next.metrics_address = std::move(new_metrics_address);
+        publish(std::move(next));
         
         return true;
         
@@ -222,23 +401,34 @@ bool runtime_config_manager::load_from_json(const nlohmann::json& config_json) n
 
 std::string runtime_config_manager::export_to_json() const noexcept {
     try {
+        const config_snapshot& snap = *snapshot();
         nlohmann::json config_json;
-        {
-            std::lock_guard<std::mutex> lock(config_mutex_);
-            config_json["max_connections"] = max_connections_;
-            config_json["handshake_timeout"] = handshake_timeout_.count();
-            config_json["max_message_size"] = max_message_size_;
-            config_json["max_write_queue_size"] = max_write_queue_size_;
-            config_json["max_messages_per_window"] = max_messages_per_window_;
-            config_json["rate_limit_window"] = rate_limit_window_.count();
-            config_json["max_backoff"] = max_backoff_.count();
-            config_json["ws_idle_timeout"] = ws_idle_timeout_.count();
-            config_json["max_amount"] = max_amount_;
-            config_json["max_sequence_gap"] = max_sequence_gap_;
-            config_json["security_enabled"] = security_enabled_;
-            config_json["metrics_enabled"] = metrics_enabled_;
-            config_json["config_path"] = config_path_;
-        }
+        config_json["max_connections"] = snap.max_connections;
+        config_json["handshake_timeout"] = snap.handshake_timeout.count();
+        config_json["max_message_size"] = snap.max_message_size;
+        config_json["max_write_queue_size"] = snap.max_write_queue_size;
+        config_json["max_messages_per_window"] = snap.max_messages_per_window;
+        config_json["rate_limit_window"] = snap.rate_limit_window.count();
+        config_json["rate_limit_costs"] = {
+            {protocol::message_types::HANDSHAKE, snap.rate_limit_costs.handshake},
+            {protocol::message_types::ACTION, snap.rate_limit_costs.action},
+            {protocol::message_types::RELOAD_REQUEST, snap.rate_limit_costs.reload_request},
+            {protocol::message_types::DISCONNECT, snap.rate_limit_costs.disconnect},
+            {protocol::message_types::STATE_ACK, snap.rate_limit_costs.state_ack}};
+        config_json["max_backoff"] = snap.max_backoff.count();
+        config_json["ws_idle_timeout"] = snap.ws_idle_timeout.count();
+        config_json["max_amount"] = snap.max_amount;
+        config_json["max_sequence_gap"] = snap.max_sequence_gap;
+        config_json["io_threads"] = snap.io_threads;
+        config_json["sharded_acceptors"] = snap.sharded_acceptors;
+        config_json["write_coalescing"] = snap.write_coalescing;
+        config_json["log_file"] = snap.log_file;
+        config_json["security_enabled"] = snap.security_enabled;
+        config_json["metrics_enabled"] = snap.metrics_enabled;
+        config_json["metrics_port"] = snap.metrics_port;
+        config_json["metrics_address"] = snap.metrics_address;
+        config_json["config_version"] = snap.version;
+        config_json["config_path"] = get_config_path();
         config_json["last_reload_time"] = std::chrono::system_clock::to_time_t(
             std::chrono::system_clock::now());
         
@@ -1,17 +1,64 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
+#include "config.hpp"
+#include "protocol.hpp"
+#include "rate_limiter.hpp"
+
 namespace cppsim {
 namespace server {
 
+/**
+ * @brief Immutable set of every runtime configuration value
+ *
+ * Published by runtime_config_manager as a whole; a snapshot is never
+ * modified after publication and never freed while the process runs, so a
+ * `const config_snapshot*` obtained from snapshot() may be cached
+ * indefinitely.  Defaults come from config.hpp.
+ */
+struct config_snapshot {
+    /** @brief Bumped on every published change; 0 is the built-in defaults. */
+    uint64_t version{0};
+
+    int max_connections{static_cast<int>(config::MAX_CONNECTIONS)};
+    std::chrono::seconds handshake_timeout{config::HANDSHAKE_TIMEOUT};
+    size_t max_message_size{config::MAX_MESSAGE_SIZE};
+    size_t max_write_queue_size{config::MAX_WRITE_QUEUE_SIZE};
+    size_t max_messages_per_window{config::MAX_MESSAGES_PER_WINDOW};
+    std::chrono::seconds rate_limit_window{config::RATE_LIMIT_WINDOW};
+    message_cost_table rate_limit_costs{};
+    std::chrono::seconds max_backoff{config::MAX_BACKOFF};
+    std::chrono::seconds ws_idle_timeout{std::chrono::duration_cast<std::chrono::seconds>(config::WS_IDLE_TIMEOUT)};
+    int64_t max_amount{protocol::MAX_AMOUNT};
+    int64_t max_sequence_gap{config::MAX_SEQUENCE_GAP};
+    size_t io_threads{config::IO_THREADS};
+    bool sharded_acceptors{config::SHARDED_ACCEPTORS};
+    bool write_coalescing{config::WRITE_COALESCING};
+    /** @brief Binary log path (binary_log.hpp); empty logs text to stdout/stderr. */
+    std::string log_file{};
+    bool security_enabled{true};
+    bool metrics_enabled{true};
+    /** @brief OpenMetrics endpoint (metrics_http_server.hpp); port 0 is off. */
+    uint16_t metrics_port{config::METRICS_PORT};
+    std::string metrics_address{config::METRICS_ADDRESS};
+
+    /** @brief Field-wise equality, ignoring version. */
+    [[nodiscard]] bool same_values(const config_snapshot& other) const noexcept;
+};
+
 /**
  * @brief Runtime configuration manager for cppsim poker server
  * 
@@ -19,10 +66,16 @@ namespace server {
  * All configuration values have sensible defaults and validation.
  *
  * Thread Safety: All public methods are safe to call from any thread.
- * A single mutex (config_mutex_) protects all config members.
+ * Readers never lock: the current config_snapshot is published through an
+ * atomic pointer, and a (re)load builds a new snapshot and swaps it in.
+ * config_mutex_ serialises writers and guards the reload bookkeeping.
+ * Superseded snapshots are retained (loads that change nothing publish
+ * nothing), which is what makes cached snapshot pointers safe.
  */
 class runtime_config_manager {
 public:
+    using change_listener = std::function<void(const config_snapshot&)>;
+
     runtime_config_manager(const runtime_config_manager&) = delete;
     runtime_config_manager& operator=(const runtime_config_manager&) = delete;
     runtime_config_manager(runtime_config_manager&&) = delete;
@@ -45,68 +98,99 @@ public:
      * @return true if successful, false otherwise
      */
     bool reload() noexcept;
-    
-    // Accessors — each takes config_mutex_ to prevent torn reads during reload.
 
-    [[nodiscard]] int get_max_connections() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return max_connections_;
+    /**
+     * @brief Current configuration, lock-free
+     * @return Never null; valid for the lifetime of the process.  Compare
+     *         against a cached pointer to detect a reload cheaply.
+     */
+    [[nodiscard]] const config_snapshot* snapshot() const noexcept {
+        return current_.load(std::memory_order_acquire);
     }
+
+    /**
+     * @brief Register a callback run after each published config change
+     * @return Id for remove_change_listener().
+     *
+     * Called on the thread that performed the load, outside any lock.  Keep
+     * it cheap; hot-path code should poll snapshot() instead.
+     */
+    size_t add_change_listener(change_listener listener);
+
+    /** @brief Unregister a listener; no-op for unknown ids. */
+    void remove_change_listener(size_t id) noexcept;
+    
+    // Accessors — each is a lock-free read of the current snapshot.
+
+    [[nodiscard]] int get_max_connections() const noexcept { return snapshot()->max_connections; }
     
     [[nodiscard]] std::chrono::seconds get_handshake_timeout() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return handshake_timeout_;
+        return snapshot()->handshake_timeout;
     }
     
-    [[nodiscard]] size_t get_max_message_size() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return max_message_size_;
-    }
+    [[nodiscard]] size_t get_max_message_size() const noexcept { return snapshot()->max_message_size; }
     
-    [[nodiscard]] size_t get_max_write_queue_size() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return max_write_queue_size_;
-    }
+    [[nodiscard]] size_t get_max_write_queue_size() const noexcept { return snapshot()->max_write_queue_size; }
     
     [[nodiscard]] size_t get_max_messages_per_window() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return max_messages_per_window_;
+        return snapshot()->max_messages_per_window;
     }
     
     [[nodiscard]] std::chrono::seconds get_rate_limit_window() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return rate_limit_window_;
+        return snapshot()->rate_limit_window;
     }
     
-    [[nodiscard]] std::chrono::seconds get_max_backoff() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return max_backoff_;
+    /**
+     * @brief Per-message-type rate-limit costs (see message_cost_table)
+     * @return Costs in units of one message against max_messages_per_window.
+     */
+    [[nodiscard]] message_cost_table get_rate_limit_costs() const noexcept {
+        return snapshot()->rate_limit_costs;
     }
     
+    [[nodiscard]] std::chrono::seconds get_max_backoff() const noexcept { return snapshot()->max_backoff; }
+    
     [[nodiscard]] std::chrono::seconds get_ws_idle_timeout() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return ws_idle_timeout_;
+        return snapshot()->ws_idle_timeout;
     }
 
-    [[nodiscard]] int64_t get_max_amount() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return max_amount_;
-    }
+    [[nodiscard]] int64_t get_max_amount() const noexcept { return snapshot()->max_amount; }
     
-    [[nodiscard]] int64_t get_max_sequence_gap() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return max_sequence_gap_;
-    }
+    [[nodiscard]] int64_t get_max_sequence_gap() const noexcept { return snapshot()->max_sequence_gap; }
     
-    [[nodiscard]] bool is_security_enabled() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return security_enabled_;
-    }
+    /**
+     * @brief Configured io_context worker thread count
+     * @return Thread count, or 0 to use one thread per hardware thread.
+     *         Only read at startup — changing it requires a restart.
+     */
+    [[nodiscard]] size_t get_io_threads() const noexcept { return snapshot()->io_threads; }
     
-    [[nodiscard]] bool is_metrics_enabled() const noexcept {
-        std::lock_guard<std::mutex> lock(config_mutex_);
-        return metrics_enabled_;
-    }
+    /**
+     * @brief Whether to run one io_context + SO_REUSEPORT acceptor per thread
+     * @return true for shared-nothing sharding, false for a shared io_context.
+     *         Only read at startup — changing it requires a restart.
+     */
+    [[nodiscard]] bool is_sharded_acceptors_enabled() const noexcept { return snapshot()->sharded_acceptors; }
+    
+    [[nodiscard]] bool is_write_coalescing_enabled() const noexcept { return snapshot()->write_coalescing; }
+    
+    /**
+     * @brief Path of the binary log file, or empty for text logging
+     * @return Only read at startup — changing it requires a restart.
+     */
+    [[nodiscard]] const std::string& get_log_file() const noexcept { return snapshot()->log_file; }
+    
+    [[nodiscard]] bool is_security_enabled() const noexcept { return snapshot()->security_enabled; }
+    
+    [[nodiscard]] bool is_metrics_enabled() const noexcept { return snapshot()->metrics_enabled; }
+    
+    /**
+     * @brief Port and bind address of the /metrics endpoint (0: disabled)
+     * @return Only read at startup — changing them requires a restart.
+     */
+    [[nodiscard]] uint16_t get_metrics_port() const noexcept { return snapshot()->metrics_port; }
+    
+    [[nodiscard]] const std::string& get_metrics_address() const noexcept { return snapshot()->metrics_address; }
     
     [[nodiscard]] std::string get_config_path() const noexcept {
         std::lock_guard<std::mutex> lock(config_mutex_);
@@ -116,27 +200,26 @@ public:
     [[nodiscard]] std::string export_to_json() const noexcept;
 
 private:
-    runtime_config_manager() = default;
+    runtime_config_manager();
     ~runtime_config_manager() = default;
 
     bool load_from_json(const nlohmann::json& config_json) noexcept;
+
+    // Publishes `next` unless it matches the current values; then notifies
+    // listeners.  Can throw std::bad_alloc.
+    void publish(config_snapshot next);
     
+    // Guards config_path_, reload bookkeeping and snapshots_ (writers only).
     mutable std::mutex config_mutex_;
-
-    // Configuration members with defaults — all guarded by config_mutex_.
     std::string config_path_;
-    int max_connections_{1000};
-    std::chrono::seconds handshake_timeout_{std::chrono::seconds{10}};
-    size_t max_message_size_{64 * 1024};
-    size_t max_write_queue_size_{100};
-    size_t max_messages_per_window_{10};
-    std::chrono::seconds rate_limit_window_{std::chrono::seconds{1}};
-    std::chrono::seconds max_backoff_{std::chrono::seconds{30}};
-    std::chrono::seconds ws_idle_timeout_{std::chrono::seconds{24 * 3600}};
-    int64_t max_amount_{1000000000000000LL};
-    int64_t max_sequence_gap_{10000};
-    bool security_enabled_{true};
-    bool metrics_enabled_{true};
+
+    // Every snapshot ever published; current_ points at the last one.
+    std::vector<std::unique_ptr<const config_snapshot>> snapshots_;
+    std::atomic<const config_snapshot*> current_{nullptr};
+
+    std::mutex listeners_mutex_;
+    std::vector<std::pair<size_t, change_listener>> listeners_;
+    size_t next_listener_id_{1};
     
     // Hot-reload support
     std::chrono::steady_clock::time_point last_reload_time_;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace cppsim {
+namespace server {
+
+// Compact identity of a registered session.  Generated once by
+// connection_manager::register_session(); the "sess_" + 16 hex string clients
+// see is just its textual form, produced and parsed only at the protocol edge.
+using session_handle = uint64_t;
+
+// Never issued: marks "not registered" / "not a valid session ID".
+inline constexpr session_handle INVALID_SESSION_HANDLE = 0;
+
+inline constexpr std::string_view SESSION_ID_PREFIX = "sess_";
+inline constexpr size_t SESSION_ID_HEX_DIGITS = 16;
+inline constexpr size_t SESSION_ID_LENGTH = SESSION_ID_PREFIX.size() + SESSION_ID_HEX_DIGITS;
+
+// Fixed-size textual session ID; formatting never allocates.
+using session_id_chars = std::array<char, SESSION_ID_LENGTH>;
+
+[[nodiscard]] constexpr session_id_chars format_session_id_chars(session_handle handle) noexcept {
+  constexpr char hex[] = "0123456789abcdef";
+  session_id_chars out{};
+  for (size_t i = 0; i < SESSION_ID_PREFIX.size(); ++i) {
+    out[i] = SESSION_ID_PREFIX[i];
+  }
+  for (size_t i = 0; i < SESSION_ID_HEX_DIGITS; ++i) {
+    out[SESSION_ID_PREFIX.size() + i] = hex[(handle >> (60 - 4 * i)) & 0xF];
+  }
+  return out;
+}
+
+// Empty for INVALID_SESSION_HANDLE.  Can throw std::bad_alloc.
+[[nodiscard]] inline std::string format_session_id(session_handle handle) {
+  if (handle == INVALID_SESSION_HANDLE) {
+    return std::string();
+  }
+  const auto chars = format_session_id_chars(handle);
+  return std::string(chars.data(), chars.size());
+}
+
+// Inverse of format_session_id: accepts exactly "sess_" + 16 lowercase hex
+// digits and returns INVALID_SESSION_HANDLE for anything else.
+[[nodiscard]] constexpr session_handle parse_session_id(std::string_view id) noexcept {
+  if (id.size() != SESSION_ID_LENGTH || id.substr(0, SESSION_ID_PREFIX.size()) != SESSION_ID_PREFIX) {
+    return INVALID_SESSION_HANDLE;
+  }
+  session_handle handle = 0;
+  for (size_t i = SESSION_ID_PREFIX.size(); i < SESSION_ID_LENGTH; ++i) {
+    const char c = id[i];
+    session_handle digit = 0;
+    if (c >= '0' && c <= '9') {
+      digit = static_cast<session_handle>(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+      digit = static_cast<session_handle>(c - 'a' + 10);
+    } else {
+      return INVALID_SESSION_HANDLE;
+    }
+    handle = (handle << 4) | digit;
+  }
+  return handle;
+}
+
+}  // namespace server
+}  // namespace cppsim
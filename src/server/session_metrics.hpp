@@ -1,9 +1,13 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 
 namespace cppsim {
 namespace server {
@@ -101,6 +105,22 @@ public:
         rate_limit_exceeded_.fetch_add(1, std::memory_order_relaxed);
     }
     
+    /**
+     * @brief Record a frame rejected as malformed
+     */
+    void record_malformed_frame() noexcept {
+        malformed_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Record one BATCH frame
+     * @param messages Number of messages it carried
+     */
+    void record_batch(size_t messages) noexcept {
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        batched_messages_.fetch_add(messages, std::memory_order_relaxed);
+    }
+    
     /**
      * @brief Get total messages sent
      * @return Total number of messages sent
@@ -173,6 +193,30 @@ public:
         return rate_limit_exceeded_.load(std::memory_order_relaxed);
     }
     
+    /**
+     * @brief Get malformed frame count
+     * @return Number of frames rejected as malformed
+     */
+    uint64_t get_malformed_frames() const noexcept {
+        return malformed_frames_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get BATCH frame count
+     * @return Number of BATCH frames handled
+     */
+    uint64_t get_batches() const noexcept {
+        return batches_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get batched message count
+     * @return Total messages carried by BATCH frames
+     */
+    uint64_t get_batched_messages() const noexcept {
+        return batched_messages_.load(std::memory_order_relaxed);
+    }
+    
     /**
      * @brief Increment bytes sent counter
      * @param bytes Number of bytes to increment by
@@ -205,6 +249,62 @@ public:
         return bytes_received_.load(std::memory_order_relaxed);
     }
     
+    /**
+     * @brief Record one write flush
+     * @param frames Number of WebSocket frames written back-to-back in the flush
+     */
+    void record_flush(size_t frames) noexcept {
+        flushes_.fetch_add(1, std::memory_order_relaxed);
+        frames_flushed_.fetch_add(frames, std::memory_order_relaxed);
+        
+        uint64_t current_max = max_frames_per_flush_.load(std::memory_order_relaxed);
+        while (frames > current_max) {
+            if (max_frames_per_flush_.compare_exchange_weak(
+                    current_max,
+                    frames,
+                    std::memory_order_relaxed,
+                    std::memory_order_relaxed)) {
+                break;
+            }
+        }
+    }
+    
+    /**
+     * @brief Get total number of write flushes
+     * @return Number of flushes performed
+     */
+    uint64_t get_flush_count() const noexcept {
+        return flushes_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * @brief Get total frames written across all flushes
+     * @return Number of frames flushed
+     */
+    uint64_t get_frames_flushed() const noexcept {
+        return frames_flushed_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * @brief Get average frames per flush (the write batching ratio)
+     * @return Average frames per flush, or 0 if no flushes
+     */
+    double get_average_frames_per_flush() const noexcept {
+        uint64_t count = flushes_.load(std::memory_order_relaxed);
+        if (count == 0) return 0.0;
+        
+        uint64_t total = frames_flushed_.load(std::memory_order_relaxed);
+        return static_cast<double>(total) / static_cast<double>(count);
+    }
+    
+    /**
+     * @brief Get the largest flush observed
+     * @return Maximum frames written in a single flush
+     */
+    uint64_t get_max_frames_per_flush() const noexcept {
+        return max_frames_per_flush_.load(std::memory_order_relaxed);
+    }
+    
     /**
      * @brief Reset all metrics
      */
@@ -219,8 +319,14 @@ public:
         connection_count_.store(0, std::memory_order_relaxed);
         max_connection_time_.store(0, std::memory_order_relaxed);
         rate_limit_exceeded_.store(0, std::memory_order_relaxed);
+        malformed_frames_.store(0, std::memory_order_relaxed);
+        batches_.store(0, std::memory_order_relaxed);
+        batched_messages_.store(0, std::memory_order_relaxed);
         bytes_sent_.store(0, std::memory_order_relaxed);
         bytes_received_.store(0, std::memory_order_relaxed);
+        flushes_.store(0, std::memory_order_relaxed);
+        frames_flushed_.store(0, std::memory_order_relaxed);
+        max_frames_per_flush_.store(0, std::memory_order_relaxed);
     }
 
 private:
@@ -241,10 +347,136 @@ private:
     
     // Rate limiting
     std::atomic<uint64_t> rate_limit_exceeded_{0};
+    std::atomic<uint64_t> malformed_frames_{0};
+
+    // Pipelining
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> batched_messages_{0};
     
     // Byte counters
     std::atomic<uint64_t> bytes_sent_{0};
     std::atomic<uint64_t> bytes_received_{0};
+    
+    // Write coalescing
+    std::atomic<uint64_t> flushes_{0};
+    std::atomic<uint64_t> frames_flushed_{0};
+    std::atomic<uint64_t> max_frames_per_flush_{0};
+};
+
+/**
+ * @brief Server-wide sums of every session's session_metrics
+ *
+ * Sessions are tracked for their whole life; a retiring session's counts are
+ * folded into its shard's totals under the same lock summarize() takes, so
+ * the sums never go backwards.  Sharded so that a scrape only holds up
+ * sessions starting or ending in the shard it is currently summing.
+ */
+class session_metrics_registry {
+public:
+    struct totals {
+        uint64_t live_sessions{0};
+        uint64_t messages_sent{0};
+        uint64_t messages_received{0};
+        uint64_t bytes_sent{0};
+        uint64_t bytes_received{0};
+        uint64_t errors{0};
+        uint64_t rate_limit_exceeded{0};
+        uint64_t malformed_frames{0};
+        uint64_t batches{0};
+        uint64_t batched_messages{0};
+        uint64_t flushes{0};
+        uint64_t frames_flushed{0};
+
+        void add_totals(const totals& o) noexcept {
+            messages_sent += o.messages_sent;
+            messages_received += o.messages_received;
+            bytes_sent += o.bytes_sent;
+            bytes_received += o.bytes_received;
+            errors += o.errors;
+            rate_limit_exceeded += o.rate_limit_exceeded;
+            malformed_frames += o.malformed_frames;
+            batches += o.batches;
+            batched_messages += o.batched_messages;
+            flushes += o.flushes;
+            frames_flushed += o.frames_flushed;
+        }
+
+        void add(const session_metrics& m) noexcept {
+            messages_sent += m.get_messages_sent();
+            messages_received += m.get_messages_received();
+            bytes_sent += m.get_bytes_sent();
+            bytes_received += m.get_bytes_received();
+            errors += m.get_errors();
+            rate_limit_exceeded += m.get_rate_limit_exceeded_count();
+            malformed_frames += m.get_malformed_frames();
+            batches += m.get_batches();
+            batched_messages += m.get_batched_messages();
+            flushes += m.get_flush_count();
+            frames_flushed += m.get_frames_flushed();
+        }
+    };
+
+    session_metrics_registry() = default;
+    session_metrics_registry(const session_metrics_registry&) = delete;
+    session_metrics_registry& operator=(const session_metrics_registry&) = delete;
+
+    static session_metrics_registry& instance() {
+        static session_metrics_registry registry;
+        return registry;
+    }
+
+    /**
+     * @brief Start including `m` in the sums
+     * @throws std::bad_alloc
+     */
+    void track(const session_metrics& m) {
+        auto& s = shard_for(m);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.live.insert(&m);
+    }
+
+    /**
+     * @brief Fold `m`'s final counts into the totals and stop tracking it
+     */
+    void retire(const session_metrics& m) noexcept {
+        auto& s = shard_for(m);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.live.erase(&m) != 0) {
+            s.retired.add(m);
+        }
+    }
+
+    /**
+     * @brief Sums over live and retired sessions
+     */
+    [[nodiscard]] totals summarize() const noexcept {
+        totals sum;
+        for (const auto& s : shards_) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            sum.add_totals(s.retired);
+            sum.live_sessions += s.live.size();
+            for (const session_metrics* m : s.live) {
+                sum.add(*m);
+            }
+        }
+        return sum;
+    }
+
+private:
+    static constexpr size_t SHARDS = 16;
+
+    struct alignas(64) shard {
+        mutable std::mutex mutex;
+        std::unordered_set<const session_metrics*> live;
+        totals retired;
+    };
+
+    shard& shard_for(const session_metrics& m) noexcept {
+        // Sessions come from a slab; the low bits of their addresses repeat.
+        return shards_[(reinterpret_cast<uintptr_t>(&m) >> 6) % SHARDS];
+    }
+
+    std::array<shard, SHARDS> shards_;
 };
 
 } // namespace server
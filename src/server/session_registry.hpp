@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cppsim {
+namespace server {
+
+// Bounded, sharded hash map used by connection_manager to hold live sessions.
+//
+// Keys are spread over a power-of-two number of shards, each an
+// unordered_map behind its own mutex, so register/unregister/lookup of
+// unrelated sessions rarely contend.  The entry count lives in one atomic:
+// size() never takes a lock, and try_insert() reserves a unit of capacity
+// with a CAS before touching any shard, so `capacity` is never exceeded —
+// not even transiently — however many threads insert at once.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class session_registry final {
+ public:
+  enum class insert_result { inserted, full, collision };
+
+  session_registry(size_t capacity, size_t shards)
+      : capacity_(capacity),
+        shard_bits_(log2_ceil(shards == 0 ? 1 : shards)),
+        shards_(std::make_unique<shard[]>(size_t{1} << shard_bits_)) {}
+
+  session_registry(const session_registry&) = delete;
+  session_registry& operator=(const session_registry&) = delete;
+  session_registry(session_registry&&) = delete;
+  session_registry& operator=(session_registry&&) = delete;
+
+  // `value` is only moved from when the result is `inserted`, so callers can
+  // retry a collision with a fresh key.  Can throw std::bad_alloc (with the
+  // reservation released).
+  [[nodiscard]] insert_result try_insert(const Key& key, Value&& value) {
+    size_t count = count_.load(std::memory_order_relaxed);
+    do {
+      if (count >= capacity_) {
+        return insert_result::full;
+      }
+    } while (!count_.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel,
+                                           std::memory_order_relaxed));
+
+    bool inserted = false;
+    try {
+      shard& s = shard_for(key);
+      std::lock_guard<std::mutex> lock(s.mutex);
+      inserted = s.entries.try_emplace(key, std::move(value)).second;
+    } catch (...) {
+      count_.fetch_sub(1, std::memory_order_acq_rel);
+      throw;
+    }
+    if (!inserted) {
+      count_.fetch_sub(1, std::memory_order_acq_rel);
+      return insert_result::collision;
+    }
+    return insert_result::inserted;
+  }
+
+  // Returns true if `key` was present.  The erased value is destroyed after
+  // the shard lock is released.
+  bool erase(const Key& key) noexcept {
+    Value erased{};
+    {
+      shard& s = shard_for(key);
+      std::lock_guard<std::mutex> lock(s.mutex);
+      auto it = s.entries.find(key);
+      if (it == s.entries.end()) {
+        return false;
+      }
+      erased = std::move(it->second);
+      s.entries.erase(it);
+    }
+    count_.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+  }
+
+  // Returns a default-constructed Value when `key` is absent.
+  [[nodiscard]] Value find(const Key& key) const noexcept {
+    const shard& s = shard_for(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.entries.find(key);
+    return it != s.entries.end() ? it->second : Value{};
+  }
+
+  // Entries present plus inserts in flight; never exceeds capacity().
+  [[nodiscard]] size_t size() const noexcept { return count_.load(std::memory_order_acquire); }
+  [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+  [[nodiscard]] size_t shard_count() const noexcept { return size_t{1} << shard_bits_; }
+
+  // Can throw std::bad_alloc.  Not a point-in-time snapshot: shards are
+  // visited one at a time.
+  [[nodiscard]] std::vector<Key> keys() const {
+    std::vector<Key> out;
+    out.reserve(size());
+    for (size_t i = 0; i < shard_count(); ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      for (const auto& entry : shards_[i].entries) {
+        out.push_back(entry.first);
+      }
+    }
+    return out;
+  }
+
+  // Empties every shard, calling `fn(key, value)` for each removed entry
+  // outside the shard locks.  Returns the number of entries removed.
+  template <typename Fn>
+  size_t drain(Fn&& fn) noexcept {
+    size_t drained = 0;
+    for (size_t i = 0; i < shard_count(); ++i) {
+      map_type taken;
+      {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        taken.swap(shards_[i].entries);
+      }
+      count_.fetch_sub(taken.size(), std::memory_order_acq_rel);
+      drained += taken.size();
+      for (auto& entry : taken) {
+        fn(entry.first, entry.second);
+      }
+    }
+    return drained;
+  }
+
+ private:
+  using map_type = std::unordered_map<Key, Value, Hash>;
+
+  // Cache-line aligned so neighbouring shard locks do not false-share.
+  struct alignas(64) shard {
+    mutable std::mutex mutex;
+    map_type entries;
+  };
+
+  static constexpr unsigned log2_ceil(size_t n) noexcept {
+    unsigned bits = 0;
+    while ((size_t{1} << bits) < n) ++bits;
+    return bits;
+  }
+
+  // Shards take the top bits of a Fibonacci-scrambled hash; the low bits
+  // stay free for the per-shard unordered_map's bucket index.
+  [[nodiscard]] shard& shard_for(const Key& key) const noexcept {
+    if (shard_bits_ == 0) {
+      return shards_[0];
+    }
+    const uint64_t h = uint64_t{Hash{}(key)} * 0x9E3779B97F4A7C15ULL;
+    return shards_[h >> (64 - shard_bits_)];
+  }
+
+  const size_t capacity_;
+  const unsigned shard_bits_;
+  const std::unique_ptr<shard[]> shards_;
+  std::atomic<size_t> count_{0};
+};
+
+}  // namespace server
+}  // namespace cppsim
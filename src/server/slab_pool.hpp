@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace cppsim {
+namespace server {
+
+// Thread-safe pool of equally sized blocks carved out of larger slabs.
+//
+// Sized for long-lived objects that are created and destroyed at connection
+// rate (websocket_session): blocks are recycled through a free list and slabs
+// are only returned to the system when the pool itself is destroyed.  The
+// block size is fixed by the first allocation; requests of any other size
+// fall through to ::operator new so callers never have to know it up front
+// (std::allocate_shared allocates an implementation-defined control block).
+class slab_pool final {
+ public:
+  // Every block (and the fallback path) is cache-line aligned: pooled
+  // objects such as websocket_session contain cache-line-aligned members.
+  static constexpr size_t BLOCK_ALIGNMENT = 64;
+
+  explicit slab_pool(size_t blocks_per_slab = 64) noexcept
+      : blocks_per_slab_(blocks_per_slab == 0 ? 1 : blocks_per_slab) {}
+
+  ~slab_pool() noexcept {
+    for (void* slab : slabs_) {
+      ::operator delete(slab, std::align_val_t{BLOCK_ALIGNMENT});
+    }
+  }
+
+  slab_pool(const slab_pool&) = delete;
+  slab_pool& operator=(const slab_pool&) = delete;
+  slab_pool(slab_pool&&) = delete;
+  slab_pool& operator=(slab_pool&&) = delete;
+
+  // Can throw std::bad_alloc.
+  [[nodiscard]] void* allocate(size_t bytes) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (block_size_ == 0) {
+        block_size_ = round_up(bytes);
+      }
+      if (round_up(bytes) == block_size_) {
+        if (free_list_ == nullptr) {
+          grow();
+        }
+        free_block* block = free_list_;
+        free_list_ = block->next;
+        ++in_use_;
+        return block;
+      }
+    }
+    return ::operator new(bytes, std::align_val_t{BLOCK_ALIGNMENT});
+  }
+
+  void deallocate(void* p, size_t bytes) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (round_up(bytes) != block_size_) {
+      ::operator delete(p, std::align_val_t{BLOCK_ALIGNMENT});
+      return;
+    }
+    auto* block = static_cast<free_block*>(p);
+    block->next = free_list_;
+    free_list_ = block;
+    --in_use_;
+  }
+
+  // Blocks currently handed out / total blocks ever carved from slabs.
+  [[nodiscard]] size_t in_use() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_use_;
+  }
+  [[nodiscard]] size_t capacity() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slabs_.size() * blocks_per_slab_;
+  }
+
+ private:
+  struct free_block {
+    free_block* next;
+  };
+
+  static constexpr size_t round_up(size_t bytes) noexcept {
+    if (bytes < sizeof(free_block)) bytes = sizeof(free_block);
+    return (bytes + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+  }
+
+  // Caller holds mutex_.
+  void grow() {
+    if (block_size_ > std::numeric_limits<size_t>::max() / blocks_per_slab_) {
+      throw std::bad_alloc();
+    }
+    slabs_.reserve(slabs_.size() + 1);
+    auto* slab = static_cast<unsigned char*>(
+        ::operator new(block_size_ * blocks_per_slab_, std::align_val_t{BLOCK_ALIGNMENT}));
+    slabs_.push_back(slab);
+    for (size_t i = blocks_per_slab_; i-- > 0;) {
+      auto* block = reinterpret_cast<free_block*>(slab + i * block_size_);
+      block->next = free_list_;
+      free_list_ = block;
+    }
+  }
+
+  const size_t blocks_per_slab_;
+  mutable std::mutex mutex_;
+  size_t block_size_{0};
+  size_t in_use_{0};
+  free_block* free_list_{nullptr};
+  std::vector<void*> slabs_;
+};
+
+// Standard allocator over a shared slab_pool, for std::allocate_shared.  Each
+// allocator (and so each object's control block) holds a reference to the
+// pool, keeping it alive until the last pooled object is released.
+template <typename T>
+class slab_allocator {
+ public:
+  using value_type = T;
+
+  explicit slab_allocator(std::shared_ptr<slab_pool> pool) noexcept : pool_(std::move(pool)) {}
+  template <typename U>
+  slab_allocator(const slab_allocator<U>& other) noexcept : pool_(other.pool()) {}
+
+  [[nodiscard]] T* allocate(size_t n) {
+    static_assert(alignof(T) <= slab_pool::BLOCK_ALIGNMENT, "slab_pool blocks are not aligned enough for T");
+    if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) noexcept { pool_->deallocate(p, n * sizeof(T)); }
+
+  [[nodiscard]] const std::shared_ptr<slab_pool>& pool() const noexcept { return pool_; }
+
+  template <typename U>
+  bool operator==(const slab_allocator<U>& other) const noexcept { return pool_ == other.pool(); }
+  template <typename U>
+  bool operator!=(const slab_allocator<U>& other) const noexcept { return pool_ != other.pool(); }
+
+ private:
+  std::shared_ptr<slab_pool> pool_;
+};
+
+}  // namespace server
+}  // namespace cppsim
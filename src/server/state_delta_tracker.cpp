@@ -0,0 +1,60 @@
+#include "state_delta_tracker.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace cppsim {
+namespace server {
+
+state_delta_tracker::state_delta_tracker(uint32_t keyframe_interval, size_t max_pending)
+    : keyframe_interval_(std::max<uint32_t>(keyframe_interval, 1)), max_pending_(std::max<size_t>(max_pending, 1)) {}
+
+state_delta_tracker::encoded state_delta_tracker::encode(protocol::state_update_message state,
+                                                         protocol::wire_encoding encoding) {
+  const int64_t seq = next_sequence_++;
+  state.state_sequence = seq;
+
+  const bool keyframe = baseline_sequence_ < 0 || ++since_keyframe_ >= keyframe_interval_;
+  std::string payload;
+  if (keyframe) {
+    since_keyframe_ = 0;
+    payload = protocol::serialize_state_update(state, encoding);
+  } else {
+    auto delta = protocol::make_state_delta(pending_.front(), state);
+    delta.state_sequence = seq;
+    delta.base_sequence = baseline_sequence_;
+    payload = protocol::serialize_state_delta(delta, encoding);
+  }
+
+  pending_.push_back(std::move(state));
+  if (pending_.size() > max_pending_) {
+    if (pending_.front().state_sequence == baseline_sequence_) baseline_sequence_ = -1;
+    pending_.pop_front();
+  }
+  return encoded{std::move(payload), seq, keyframe};
+}
+
+bool state_delta_tracker::acknowledge(int64_t state_sequence) {
+  // A late ack for a state older than the baseline changes nothing.
+  if (baseline_sequence_ >= 0 && state_sequence < baseline_sequence_) return true;
+  const auto it = std::find_if(pending_.begin(), pending_.end(), [state_sequence](const auto& s) {
+    return s.state_sequence == state_sequence;
+  });
+  if (it == pending_.end()) {
+    baseline_sequence_ = -1;
+    return false;
+  }
+  // Older states can no longer become the baseline: acks only move forward.
+  pending_.erase(pending_.begin(), it);
+  baseline_sequence_ = state_sequence;
+  return true;
+}
+
+std::optional<state_delta_tracker::encoded> state_delta_tracker::resync(protocol::wire_encoding encoding) {
+  baseline_sequence_ = -1;
+  if (pending_.empty()) return std::nullopt;
+  return encode(pending_.back(), encoding);
+}
+
+}  // namespace server
+}  // namespace cppsim
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+
+#include "config.hpp"
+#include "protocol.hpp"
+
+namespace cppsim {
+namespace server {
+
+// Chooses between a full STATE_UPDATE (keyframe) and a STATE_DELTA for each
+// state sent to one client.
+//
+// Every state is stamped with a state_sequence and remembered until it falls
+// out of a bounded window.  When the client acknowledges one (STATE_ACK) it
+// becomes the baseline, and later states are sent as deltas against it; the
+// client must therefore keep each state it acknowledges until it acks a newer
+// one.  Clients that never acknowledge keep receiving keyframes, so the
+// mechanism is opt-in.  A keyframe is also forced every `keyframe_interval`
+// states, and whenever the baseline ages out of the window.
+//
+// Not thread-safe: the owner serializes encode() against acknowledge().
+class state_delta_tracker final {
+ public:
+  struct encoded {
+    std::string payload;
+    int64_t state_sequence;
+    bool keyframe;
+  };
+
+  explicit state_delta_tracker(uint32_t keyframe_interval = config::STATE_KEYFRAME_INTERVAL,
+                               size_t max_pending = config::STATE_DELTA_MAX_PENDING);
+
+  // Stamps `state` with the next sequence and serializes it in `encoding`,
+  // as a delta when a baseline is available.  Throws what the serializers
+  // throw (e.g. nlohmann::json::type_error on invalid UTF-8).
+  [[nodiscard]] encoded encode(protocol::state_update_message state, protocol::wire_encoding encoding);
+
+  // Makes `state_sequence` the baseline.  Returns false — and forgets the
+  // baseline, so the next state is a keyframe — when that state is unknown
+  // (never sent, or already out of the window).
+  [[nodiscard]] bool acknowledge(int64_t state_sequence);
+
+  // Drops the baseline and re-sends the latest state as a keyframe under a
+  // new sequence.  Empty when nothing has been sent yet.
+  [[nodiscard]] std::optional<encoded> resync(protocol::wire_encoding encoding);
+
+  [[nodiscard]] int64_t baseline_sequence() const noexcept { return baseline_sequence_; }
+
+ private:
+  const uint32_t keyframe_interval_;
+  const size_t max_pending_;
+  int64_t next_sequence_{1};
+  // Acknowledged baseline, or -1.  When set it is pending_.front().
+  int64_t baseline_sequence_{-1};
+  uint32_t since_keyframe_{0};
+  // Sent states in sequence order, oldest first.
+  std::deque<protocol::state_update_message> pending_;
+};
+
+}  // namespace server
+}  // namespace cppsim
@@ -0,0 +1,230 @@
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "handler_memory.hpp"
+#include "logger.hpp"
+
+namespace cppsim {
+namespace server {
+
+namespace {
+
+int64_t to_ns(timer_wheel::clock::time_point tp) noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+}
+
+}  // namespace
+
+void timer_wheel::timer::expires_after(clock::duration d) noexcept {
+  const int64_t deadline = to_ns(clock::now() + d);
+  deadline_ns_.store(deadline, std::memory_order_seq_cst);
+
+  // Common case (idle timeout pushed later): the existing slot will be
+  // reached first and the wheel re-hashes us then — nothing else to do.
+  // Pairs with the store/load in timer_wheel::sweep() so that a timer the
+  // wheel is just dropping is never left un-scheduled.
+  if (tick_for(deadline) >= scheduled_tick_.load(std::memory_order_seq_cst)) {
+    return;
+  }
+  if (auto wheel = wheel_.lock()) {
+    wheel->schedule(weak_from_this());
+  }
+}
+
+void timer_wheel::timer::cancel() noexcept {
+  // Lazy: the wheel drops the entry when its slot comes round.
+  deadline_ns_.store(DISARMED, std::memory_order_seq_cst);
+}
+
+bool timer_wheel::timer::expired() const noexcept {
+  const int64_t deadline = deadline_ns_.load(std::memory_order_acquire);
+  return deadline != DISARMED && to_ns(clock::now()) >= deadline;
+}
+
+int64_t timer_wheel::timer::tick_for(int64_t deadline_ns) const noexcept {
+  if (deadline_ns == DISARMED) {
+    return DISARMED;
+  }
+  // First tick at or after the deadline.
+  const int64_t offset = std::max<int64_t>(deadline_ns - epoch_ns_, 0);
+  return (offset + tick_ns_ - 1) / tick_ns_;
+}
+
+timer_wheel::timer_wheel(boost::asio::io_context& ioc, clock::duration tick, size_t slots)
+    : tick_timer_(boost::asio::make_strand(ioc)),
+      tick_(std::max<clock::duration>(tick, std::chrono::milliseconds{1})),
+      tick_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(tick_).count()),
+      epoch_ns_(to_ns(clock::now())),
+      slots_(std::max<size_t>(slots, 1)) {}
+
+std::shared_ptr<timer_wheel::timer> timer_wheel::make_timer(std::function<void()> on_expire) {
+  return std::make_shared<timer>(weak_from_this(), epoch_ns_, tick_ns_, std::move(on_expire));
+}
+
+void timer_wheel::start() noexcept {
+  if (running_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  try {
+    boost::asio::post(tick_timer_.get_executor(), [self = shared_from_this()]() {
+      self->arm_tick_timer();
+    });
+  } catch (const std::exception& e) {
+    running_.store(false, std::memory_order_release);
+    try {
+      log_error(std::string("[TimerWheel] Failed to start: ") + e.what());
+    } catch (...) {
+    }
+  }
+}
+
+void timer_wheel::stop() noexcept {
+  if (!running_.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  try {
+    boost::asio::post(tick_timer_.get_executor(), [self = shared_from_this()]() {
+      boost::beast::error_code ec;
+      self->tick_timer_.cancel(ec);
+    });
+  } catch (...) {
+    // on_tick() observes running_ == false and stops the chain anyway.
+  }
+}
+
+void timer_wheel::schedule(std::weak_ptr<timer> t) noexcept {
+  try {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_.push_back(std::move(t));
+  } catch (...) {
+    log_error("[TimerWheel] Failed to schedule timer (allocation failure)");
+  }
+}
+
+void timer_wheel::arm_tick_timer() noexcept {
+  if (!running_.load(std::memory_order_acquire)) {
+    return;
+  }
+  try {
+    // Absolute expiry per tick, so the wheel never drifts behind the clock.
+    tick_timer_.expires_at(clock::time_point(std::chrono::nanoseconds(epoch_ns_ + (current_tick_ + 1) * tick_ns_)));
+    tick_timer_.async_wait(make_recycling_handler(
+        [self = shared_from_this()](boost::beast::error_code ec) { self->on_tick(ec); }));
+  } catch (const std::exception& e) {
+    try {
+      log_error(std::string("[TimerWheel] Failed to arm tick timer: ") + e.what());
+    } catch (...) {
+    }
+  }
+}
+
+void timer_wheel::on_tick(boost::beast::error_code ec) noexcept {
+  if (ec == boost::asio::error::operation_aborted || !running_.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  drain_pending();
+  const int64_t now_tick = (to_ns(clock::now()) - epoch_ns_) / tick_ns_;
+  // Catch up on every tick we slept through (a stalled io thread must not
+  // skip a slot).
+  while (current_tick_ < now_tick) {
+    ++current_tick_;
+    sweep(current_tick_);
+  }
+  arm_tick_timer();
+}
+
+void timer_wheel::drain_pending() noexcept {
+  std::vector<std::weak_ptr<timer>> batch;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    batch.swap(pending_);
+  }
+  for (auto& weak : batch) {
+    auto t = weak.lock();
+    if (!t) {
+      continue;
+    }
+    const int64_t tick = t->tick_for(t->deadline_ns_.load(std::memory_order_seq_cst));
+    if (tick == timer::DISARMED) {
+      continue;
+    }
+    // Only ever move an entry earlier; a later deadline is handled lazily.
+    const int64_t target = std::max(tick, current_tick_ + 1);
+    if (target < t->scheduled_tick_.load(std::memory_order_seq_cst)) {
+      place(t, target);
+    }
+  }
+}
+
+void timer_wheel::sweep(int64_t tick) noexcept {
+  auto& slot = slots_[static_cast<size_t>(tick) % slots_.size()];
+  // Swap out so entries re-hashed into this same slot don't invalidate the
+  // iteration; both vectors keep their capacity, so steady state allocates
+  // nothing.
+  sweep_scratch_.swap(slot);
+
+  for (auto& e : sweep_scratch_) {
+    if (e.tick > tick) {
+      // Due on a later revolution.
+      try {
+        slot.push_back(std::move(e));
+      } catch (...) {
+        log_error("[TimerWheel] Dropped timer entry (allocation failure)");
+      }
+      continue;
+    }
+    auto t = e.target.lock();
+    // Expired owner, or a stale duplicate superseded by a later place().
+    if (!t || t->scheduled_tick_.load(std::memory_order_seq_cst) != e.tick) {
+      continue;
+    }
+
+    const int64_t deadline_tick = t->tick_for(t->deadline_ns_.load(std::memory_order_seq_cst));
+    if (deadline_tick != timer::DISARMED && deadline_tick > tick) {
+      place(t, deadline_tick);
+      continue;
+    }
+
+    // Leaving the wheel.  Publish that before re-reading the deadline: a
+    // concurrent expires_after() either sees DISARMED here and schedules
+    // itself, or we see its new deadline below and keep the timer.
+    t->scheduled_tick_.store(timer::DISARMED, std::memory_order_seq_cst);
+    const int64_t latest_tick = t->tick_for(t->deadline_ns_.load(std::memory_order_seq_cst));
+    if (latest_tick == timer::DISARMED) {
+      continue;
+    }
+    if (latest_tick > tick) {
+      place(t, latest_tick);
+      continue;
+    }
+
+    if (t->on_expire_) {
+      try {
+        t->on_expire_();
+      } catch (const std::exception& ex) {
+        try {
+          log_error(std::string("[TimerWheel] Exception in expiry callback: ") + ex.what());
+        } catch (...) {
+        }
+      } catch (...) {
+        log_error("[TimerWheel] Unknown exception in expiry callback");
+      }
+    }
+  }
+  sweep_scratch_.clear();
+}
+
+void timer_wheel::place(const std::shared_ptr<timer>& t, int64_t tick) noexcept {
+  try {
+    slots_[static_cast<size_t>(tick) % slots_.size()].push_back(entry{t, tick});
+    t->scheduled_tick_.store(tick, std::memory_order_seq_cst);
+  } catch (...) {
+    log_error("[TimerWheel] Dropped timer entry (allocation failure)");
+  }
+}
+
+}  // namespace server
+}  // namespace cppsim
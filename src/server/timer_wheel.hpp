@@ -0,0 +1,130 @@
+#pragma once
+
+#include "boost_wrapper.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "config.hpp"
+
+namespace cppsim {
+namespace server {
+
+// Hashed timer wheel shared by every session of one server (one per shard).
+//
+// A single steady_timer on the wheel's own strand ticks every `tick`
+// (config::TIMER_WHEEL_TICK) and sweeps one slot; timers are hashed into
+// slots by expiry tick, so a wheel of N slots covers any horizon by letting
+// far-off entries sit through several revolutions.
+//
+// Re-arming a timer is a single atomic store of its new deadline — no lock,
+// no heap operation, no handler.  The wheel is lazy: an entry whose deadline
+// moved later is simply re-hashed when its old slot comes round.  Only
+// arming a timer that is not in the wheel, or pulling a deadline earlier
+// than its current slot, goes through the wheel's (mutex-guarded) pending
+// list, which is drained on the next tick.
+//
+// Expiry callbacks run on the wheel's strand and must be cheap (typically a
+// post to the owner's own strand).  A deadline can be extended concurrently
+// with its expiry, so owners should re-check expired() when the callback
+// lands.
+class timer_wheel final : public std::enable_shared_from_this<timer_wheel> {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  class timer final : public std::enable_shared_from_this<timer> {
+   public:
+    // Use timer_wheel::make_timer().
+    timer(std::weak_ptr<timer_wheel> wheel, int64_t epoch_ns, int64_t tick_ns,
+          std::function<void()> on_expire) noexcept
+        : wheel_(std::move(wheel)), epoch_ns_(epoch_ns), tick_ns_(tick_ns), on_expire_(std::move(on_expire)) {}
+
+    timer(const timer&) = delete;
+    timer& operator=(const timer&) = delete;
+    timer(timer&&) = delete;
+    timer& operator=(timer&&) = delete;
+
+    // Thread-safe.  Replaces any previous deadline.
+    void expires_after(clock::duration d) noexcept;
+
+    // Thread-safe.  The callback will not run for this arming (barring a
+    // sweep already in progress — see expired()).
+    void cancel() noexcept;
+
+    // True once the current deadline has passed.  False when disarmed.
+    [[nodiscard]] bool expired() const noexcept;
+
+   private:
+    friend class timer_wheel;
+
+    static constexpr int64_t DISARMED = std::numeric_limits<int64_t>::max();
+
+    [[nodiscard]] int64_t tick_for(int64_t deadline_ns) const noexcept;
+
+    const std::weak_ptr<timer_wheel> wheel_;
+    const int64_t epoch_ns_;
+    const int64_t tick_ns_;
+    const std::function<void()> on_expire_;
+    // Absolute deadline in steady_clock nanoseconds; DISARMED when cancelled.
+    std::atomic<int64_t> deadline_ns_{DISARMED};
+    // Tick whose sweep will next examine this timer; DISARMED when it is not
+    // in the wheel.  Written on the wheel strand, read by expires_after().
+    std::atomic<int64_t> scheduled_tick_{DISARMED};
+  };
+
+  timer_wheel(boost::asio::io_context& ioc,
+              clock::duration tick = config::TIMER_WHEEL_TICK,
+              size_t slots = config::TIMER_WHEEL_SLOTS);
+  ~timer_wheel() noexcept = default;
+
+  timer_wheel(const timer_wheel&) = delete;
+  timer_wheel& operator=(const timer_wheel&) = delete;
+  timer_wheel(timer_wheel&&) = delete;
+  timer_wheel& operator=(timer_wheel&&) = delete;
+
+  // Can throw std::bad_alloc.  The timer starts disarmed.
+  [[nodiscard]] std::shared_ptr<timer> make_timer(std::function<void()> on_expire);
+
+  void start() noexcept;
+  void stop() noexcept;
+
+  [[nodiscard]] clock::duration tick() const noexcept { return tick_; }
+
+ private:
+  struct entry {
+    std::weak_ptr<timer> target;
+    int64_t tick;
+  };
+
+  // Called by timer::expires_after() when the wheel must (re)insert it.
+  void schedule(std::weak_ptr<timer> t) noexcept;
+
+  void arm_tick_timer() noexcept;
+  void on_tick(boost::beast::error_code ec) noexcept;
+  void drain_pending() noexcept;
+  void sweep(int64_t tick) noexcept;
+  void place(const std::shared_ptr<timer>& t, int64_t tick) noexcept;
+
+  boost::asio::steady_timer tick_timer_;
+  const clock::duration tick_;
+  const int64_t tick_ns_;
+  const int64_t epoch_ns_;
+
+  // Wheel-strand only.
+  std::vector<std::vector<entry>> slots_;
+  std::vector<entry> sweep_scratch_;
+  int64_t current_tick_{0};
+
+  std::mutex pending_mutex_;
+  std::vector<std::weak_ptr<timer>> pending_;
+  std::atomic<bool> running_{false};
+};
+
+}  // namespace server
+}  // namespace cppsim
@@ -5,6 +5,7 @@
 #include <stdexcept>
 #include <string>
 #include <memory>
+#include <utility>
 
 #include "config.hpp"
 #include "logger.hpp"
@@ -15,16 +16,30 @@
 namespace cppsim {
 namespace server {
 
+namespace {
+
+#if defined(SO_REUSEPORT)
+using reuse_port_option = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+}  // namespace
+
 websocket_server::~websocket_server() noexcept {
   stop();
 }
 
 websocket_server::websocket_server(boost::asio::io_context& ioc, uint16_t port,
-                                       std::chrono::seconds handshake_timeout)
+                                       std::chrono::seconds handshake_timeout,
+                                       bool reuse_port,
+                                       std::shared_ptr<connection_limit> limit)
     : ioc_(ioc),
       acceptor_(boost::asio::make_strand(ioc)),
-      conn_mgr_(std::make_shared<connection_manager>()),
-      handshake_timeout_(handshake_timeout) {
+      conn_mgr_(limit ? std::make_shared<connection_manager>(std::move(limit))
+                      : std::make_shared<connection_manager>()),
+      session_pool_(std::make_shared<slab_pool>()),
+      timer_wheel_(std::make_shared<timer_wheel>(ioc)),
+      handshake_timeout_(handshake_timeout),
+      connections_accepted_(metrics_collector::register_counter("server_connections_accepted")) {
     
     // Record server creation metrics
     metrics_collector::record_event("server_created");
@@ -47,6 +62,22 @@ websocket_server::websocket_server(boost::asio::io_context& ioc, uint16_t port,
     throw std::runtime_error(std::string("[WebSocketServer] Failed to set reuse_address: ") + ec.message());
   }
 
+  if (reuse_port) {
+#if defined(SO_REUSEPORT)
+    acceptor_.set_option(reuse_port_option(true), ec);
+#else
+    ec = boost::asio::error::operation_not_supported;
+#endif
+    if (ec) {
+      boost::beast::error_code close_ec;
+      acceptor_.close(close_ec);
+      if (close_ec) {
+        log_error(std::string("[WebSocketServer] Additional error closing acceptor: ") + close_ec.message());
+      }
+      throw std::runtime_error(std::string("[WebSocketServer] Failed to set reuse_port: ") + ec.message());
+    }
+  }
+
   acceptor_.bind(endpoint, ec);
   if (ec) {
     boost::beast::error_code close_ec;
@@ -77,6 +108,8 @@ void websocket_server::run() noexcept {
     log_error("[WebSocketServer] Cannot run - initialization failed");
     return;
   }
+  timer_wheel_->start();
+
   // Start accepting connections
   do_accept();
   
@@ -118,6 +151,8 @@ void websocket_server::stop() noexcept {
     }
   }
 
+  timer_wheel_->stop();
+
   // Stop all active sessions
   if (conn_mgr_) {
       conn_mgr_->stop_all();
@@ -223,13 +258,15 @@ void websocket_server::on_accept(boost::beast::error_code ec, boost::asio::ip::t
   }
 
   // Create a new session for this connection.  Wrap in try/catch so that
-  // a bad_alloc from make_shared doesn't propagate through io_context::run()
+  // a bad_alloc from allocate_shared doesn't propagate through io_context::run()
   // and crash the server.  The individual connection is lost but the accept
   // loop must continue.
   try {
-    auto session = std::make_shared<websocket_session>(std::move(socket), conn_mgr_, handshake_timeout_);
+    auto session = std::allocate_shared<websocket_session>(slab_allocator<websocket_session>(session_pool_),
+                                                           std::move(socket), conn_mgr_, timer_wheel_,
+                                                           handshake_timeout_);
     session->run();
-    metrics_collector::increment_counter("server_connections_accepted");
+    connections_accepted_.add();
     log_message("[WebSocketServer] New connection accepted");
   } catch (const std::exception& e) {
     log_error(std::string("[WebSocketServer] Failed to create session: ") + e.what());
@@ -9,6 +9,9 @@
 
 #include "config.hpp"
 #include "connection_manager.hpp"
+#include "metrics_collector.hpp"
+#include "slab_pool.hpp"
+#include "timer_wheel.hpp"
 
 namespace cppsim {
 namespace server {
@@ -17,8 +20,15 @@ class websocket_session;
 
 class websocket_server final : public std::enable_shared_from_this<websocket_server> {
  public:
+  // reuse_port binds the acceptor with SO_REUSEPORT so several servers (one
+  // per io_context shard) can listen on the same port and let the kernel
+  // spread new connections between them.  Shards pass the same `limit` so
+  // that max_connections caps them together; without one the server gets a
+  // limit of config::MAX_CONNECTIONS to itself.
   websocket_server(boost::asio::io_context& ioc, uint16_t port,
-                   std::chrono::seconds handshake_timeout = config::HANDSHAKE_TIMEOUT);
+                   std::chrono::seconds handshake_timeout = config::HANDSHAKE_TIMEOUT,
+                   bool reuse_port = false,
+                   std::shared_ptr<connection_limit> limit = nullptr);
   websocket_server(const websocket_server&) = delete;
   websocket_server& operator=(const websocket_server&) = delete;
   websocket_server(websocket_server&&) = delete;
@@ -28,6 +38,15 @@ class websocket_server final : public std::enable_shared_from_this<websocket_ser
   void run() noexcept;
   void stop() noexcept;
 
+  // Whether SO_REUSEPORT sharding is available on this platform.
+  [[nodiscard]] static constexpr bool reuse_port_supported() noexcept {
+#if defined(SO_REUSEPORT)
+    return true;
+#else
+    return false;
+#endif
+  }
+
   [[nodiscard]] std::shared_ptr<connection_manager> get_connection_manager() const noexcept {
     return conn_mgr_;
   }
@@ -39,7 +58,13 @@ class websocket_server final : public std::enable_shared_from_this<websocket_ser
   boost::asio::io_context& ioc_;
   boost::asio::ip::tcp::acceptor acceptor_;
   std::shared_ptr<connection_manager> conn_mgr_;
+  // Backing store for this server's websocket_session objects (and their
+  // shared_ptr control blocks); outlives the server while sessions remain.
+  std::shared_ptr<slab_pool> session_pool_;
+  // Owns every session's handshake/idle deadline for this server.
+  std::shared_ptr<timer_wheel> timer_wheel_;
   std::chrono::seconds handshake_timeout_;
+  counter_handle connections_accepted_;
   std::shared_ptr<boost::asio::steady_timer> backoff_timer_;
   std::mutex timer_mutex_;
   std::atomic<bool> initialized_{false};
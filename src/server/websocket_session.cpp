@@ -1,10 +1,16 @@
 #include "websocket_session.hpp"
 
 #include <algorithm>
+#include <type_traits>
 #include <utility>
+#include <variant>
 
 #include "connection_manager.hpp"
+#include "handler_memory.hpp"
+#include "log_record.hpp"
+#include "log_sampler.hpp"
 #include "logger.hpp"
+#include "metrics_collector.hpp"
 #include "protocol.hpp"
 #include "sanitize.hpp"
 #include "runtime_config_manager.hpp"
@@ -13,25 +19,57 @@
 namespace cppsim {
 namespace server {
 
+namespace {
+
+// Shared by every session: a malformed frame closes its session, so a flood
+// arrives spread over many short-lived sessions rather than within one.
+log_sampler& malformed_frame_sampler() noexcept {
+  static log_sampler sampler(config::MALFORMED_LOG_BURST, config::MALFORMED_LOG_SAMPLE_EVERY,
+                             config::MALFORMED_LOG_WINDOW);
+  return sampler;
+}
+
+// Server-wide totals; per-session figures live in session_metrics.
+struct traffic_counters {
+  counter_handle messages_received = metrics_collector::register_counter("messages_received");
+  counter_handle messages_sent = metrics_collector::register_counter("messages_sent");
+  counter_handle rate_limited = metrics_collector::register_counter("sessions_rate_limited");
+  // From a frame being read to its handler returning.
+  timing_handle handling_time = metrics_collector::register_timing("message_handling");
+};
+
+// The first call registers the counters and can throw; the constructor makes
+// it so the noexcept paths only ever see the initialized static.
+const traffic_counters& traffic() {
+  static const traffic_counters counters;
+  return counters;
+}
+
+}  // namespace
+
 websocket_session::websocket_session(
     boost::asio::ip::tcp::socket socket,
     std::shared_ptr<connection_manager> mgr,
+    std::shared_ptr<timer_wheel> wheel,
     std::chrono::seconds handshake_timeout)
     : ws_(std::move(socket)),
       conn_mgr_(mgr),
-      deadline_(ws_.get_executor()),
+      wheel_(std::move(wheel)),
       last_activity_(std::chrono::steady_clock::now()),
-      handshake_timeout_(handshake_timeout) {}
+      handshake_timeout_(handshake_timeout) {
+  traffic();
+  session_metrics_registry::instance().track(metrics_);
+}
 
 websocket_session::~websocket_session() noexcept {
-  boost::beast::error_code ec;
-  deadline_.cancel(ec);
+  cancel_deadline();
+  session_metrics_registry::instance().retire(metrics_);
   
   if (state_.load(std::memory_order_acquire) != state::closed) {
-    if (auto mgr = conn_mgr_.lock()) {
-      std::string sid = get_session_id_safe();
-      if (!sid.empty()) {
-        mgr->unregister_session(sid);
+    const session_handle handle = handle_.load(std::memory_order_acquire);
+    if (handle != INVALID_SESSION_HANDLE) {
+      if (auto mgr = conn_mgr_.lock()) {
+        mgr->unregister_session(handle);
       }
     }
   }
@@ -44,28 +82,39 @@ void websocket_session::run() noexcept {
         config::WS_READ_TIMEOUT,
         false});
 
-    ws_.read_message_max(runtime_config_manager::instance().get_max_message_size());
+    refresh_config();
 
-    deadline_.expires_after(handshake_timeout_);
-    check_deadline();
+    // Reserve the whole batch up front so filling it on the write path
+    // never reallocates.  Coalescing is fixed for the session's lifetime.
+    write_coalescing_ = config_->write_coalescing;
+    write_batch_.reserve(write_coalescing_ ? write_queue_.limit() : 1);
+
+    // The wheel calls back on its own strand; hop to ours before touching
+    // session state.
+    deadline_ = wheel_->make_timer([weak_self = weak_from_this(), ex = ws_.get_executor()]() {
+      boost::asio::post(ex, make_recycling_handler([weak_self]() {
+        if (auto self = weak_self.lock()) {
+          self->on_deadline();
+        }
+      }));
+    });
+    deadline_->expires_after(handshake_timeout_);
 
     do_accept();
   } catch (const std::exception& e) {
-    log_error(std::string("[WebSocketSession] run() initialization error: ") + e.what());
+    log<log_id::session_init_failed>(e.what());
     state_.store(state::closed, std::memory_order_release);
-    boost::beast::error_code ec;
-    deadline_.cancel(ec);
+    cancel_deadline();
   } catch (...) {
     log_error("[WebSocketSession] run() unknown initialization error");
     state_.store(state::closed, std::memory_order_release);
-    boost::beast::error_code ec;
-    deadline_.cancel(ec);
+    cancel_deadline();
   }
 }
 
 void websocket_session::do_accept() {
-  ws_.async_accept(boost::beast::bind_front_handler(
-      &websocket_session::on_accept, shared_from_this()));
+  ws_.async_accept(make_recycling_handler(boost::beast::bind_front_handler(
+      &websocket_session::on_accept, shared_from_this())));
 }
 
 void websocket_session::on_accept(boost::beast::error_code ec) {
@@ -78,8 +127,7 @@ void websocket_session::on_accept(boost::beast::error_code ec) {
     // close() may have been called but do_close() hasn't run yet on the
     // strand — suppress the log to avoid noise during graceful shutdown.
     if (close_requested_.load(std::memory_order_acquire)) {
-      boost::beast::error_code timer_ec;
-      deadline_.cancel(timer_ec);
+      cancel_deadline();
       state_.store(state::closed, std::memory_order_release);
       return;
     }
@@ -88,13 +136,12 @@ void websocket_session::on_accept(boost::beast::error_code ec) {
     // to avoid a spurious "Handshake timeout" log when the deadline fires.
     if (ec != boost::beast::websocket::error::closed) {
       try {
-        log_error(std::string("[WebSocketSession] Accept failed: ") + ec.message());
+        log<log_id::accept_failed>(ec.message());
       } catch (...) {
-        // Allocation failure in async handler — log is best-effort.
+        // ec.message() allocates; log is best-effort.
       }
     }
-    boost::beast::error_code timer_ec;
-    deadline_.cancel(timer_ec);
+    cancel_deadline();
     state_.store(state::closed, std::memory_order_release);
     return;
   }
@@ -110,7 +157,7 @@ void websocket_session::on_accept(boost::beast::error_code ec) {
     log_message("[WebSocketSession] Connection accepted. Waiting for handshake...");
     do_read();
   } catch (const std::exception& e) {
-    log_error(std::string("[WebSocketSession] Exception in on_accept: ") + e.what());
+    log<log_id::accept_exception>(e.what());
     close();
   } catch (...) {
     log_error("[WebSocketSession] Unknown exception in on_accept");
@@ -119,14 +166,14 @@ void websocket_session::on_accept(boost::beast::error_code ec) {
 }
 
 void websocket_session::do_read() {
-  boost::asio::dispatch(ws_.get_executor(), [self = shared_from_this()]() {
+  boost::asio::dispatch(ws_.get_executor(), make_recycling_handler([self = shared_from_this()]() {
     if (self->state_.load(std::memory_order_acquire) == state::closed ||
         self->close_requested_.load(std::memory_order_acquire)) {
       return;
     }
-    self->ws_.async_read(self->buffer_, boost::beast::bind_front_handler(
-                                &websocket_session::on_read, self));
-  });
+    self->ws_.async_read(self->buffer_, make_recycling_handler(boost::beast::bind_front_handler(
+                                &websocket_session::on_read, self)));
+  }));
 }
 
 void websocket_session::on_read(boost::beast::error_code ec,
@@ -141,22 +188,15 @@ void websocket_session::on_read(boost::beast::error_code ec,
     if (state_.exchange(state::closed, std::memory_order_acq_rel) == state::closed) {
       return;
     }
-    boost::beast::error_code timer_ec;
-    deadline_.cancel(timer_ec);
-    try {
-      std::string sid = get_session_id_safe();
-      if (sid.empty()) {
-        log_message("[WebSocketSession] Unauthenticated client disconnected");
-      } else {
-        log_message(std::string("[WebSocketSession] Client disconnected: ") + sanitize_session_id(sid));
-        if (auto mgr = conn_mgr_.lock()) {
-          mgr->unregister_session(sid);
-        }
+    cancel_deadline();
+    const session_handle h = handle();
+    if (h == INVALID_SESSION_HANDLE) {
+      log_message("[WebSocketSession] Unauthenticated client disconnected");
+    } else {
+      log<log_id::client_disconnected>(log_session{h});
+      if (auto mgr = conn_mgr_.lock()) {
+        mgr->unregister_session(h);
       }
-    } catch (...) {
-      // Allocation failure in async handler — session state was already
-      // transitioned to closed and the timer cancelled.  unregister_session
-      // will happen when stop_all() runs or the session is destroyed.
     }
     return;
   }
@@ -165,57 +205,58 @@ void websocket_session::on_read(boost::beast::error_code ec,
     if (state_.exchange(state::closed, std::memory_order_acq_rel) == state::closed) {
       return;
     }
-    boost::beast::error_code timer_ec;
-    deadline_.cancel(timer_ec);
+    cancel_deadline();
+    const session_handle h = handle();
     try {
-      std::string sid = get_session_id_safe();
-      if (sid.empty()) {
-        log_error(std::string("[WebSocketSession] Read error (unauthenticated): ") + ec.message());
-      } else {
-        log_error(std::string("[WebSocketSession] Read error for ") + sanitize_session_id(sid) + ": " + ec.message());
-        if (auto mgr = conn_mgr_.lock()) {
-          mgr->unregister_session(sid);
-        }
-      }
+      log<log_id::read_error>(log_session{h}, ec.message());
     } catch (...) {
-      // Allocation failure in async handler — same reasoning as above.
+      // ec.message() allocates; log is best-effort.
+    }
+    if (h != INVALID_SESSION_HANDLE) {
+      if (auto mgr = conn_mgr_.lock()) {
+        mgr->unregister_session(h);
+      }
     }
     return;
   }
 
   try {
-    std::string message = boost::beast::buffers_to_string(buffer_.data());
-    buffer_.consume(buffer_.size());
+    // flat_buffer keeps its readable bytes contiguous, so parse straight out
+    // of it; the view stays valid until release_read_buffer() after dispatch.
+    const auto data = buffer_.data();
+    const std::string_view message(static_cast<const char*>(data.data()), data.size());
+    const auto started = std::chrono::steady_clock::now();
 
     metrics_.increment_messages_received();
     metrics_.increment_bytes_received(bytes_transferred);
+    traffic().messages_received.add();
+
+    refresh_config();
 
-    if (!check_rate_limit_or_close()) {
+    // Every frame costs one unit up front, before any parsing; type-specific
+    // surcharges are applied once the message type is known.
+    if (!check_rate_limit_or_close(1)) {
       return;
     }
 
     if (check_suspicious_activity()) {
-      try {
-        log_error("[WebSocketSession] Suspicious activity detected — closing session " +
-                  sanitize_session_id(get_session_id_safe()));
-      } catch (...) {
-        // Allocation failure in async handler — log is best-effort.
-      }
+      log<log_id::suspicious_activity>(log_session{handle()});
       send_protocol_error(protocol::error_codes::SESSION_CLOSED, "Suspicious activity detected");
       close();
       return;
     }
 
     if (current_state == state::unauthenticated) {
-      handle_handshake_message(message);
+      handle_handshake_message(message, ws_.got_binary());
     } else {
-      handle_authenticated_message(message);
+      handle_authenticated_message(message, ws_.got_binary());
     }
+    traffic().handling_time.record(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started));
+    release_read_buffer();
   } catch (const std::exception& e) {
-    try {
-      log_error(std::string("[WebSocketSession] Unhandled exception in message handler: ") + e.what());
-    } catch (...) {
-    }
+    release_read_buffer();
+    log<log_id::handler_exception>(e.what());
     send_protocol_error(protocol::error_codes::PROTOCOL_ERROR, "Internal server error");
     close();
     // Fall through is safe: close() synchronously sets close_requested_ before
@@ -223,11 +264,8 @@ void websocket_session::on_read(boost::beast::error_code ec,
     // will prevent do_read() from being scheduled.
     return;
   } catch (...) {
-    try {
-      log_error("[WebSocketSession] Unknown exception in message handler for session " +
-                sanitize_session_id(get_session_id_safe()));
-    } catch (...) {
-    }
+    release_read_buffer();
+    log<log_id::handler_unknown_exception>(log_session{handle()});
     send_protocol_error(protocol::error_codes::PROTOCOL_ERROR, "Internal server error");
     close();
     // See above: close() sets close_requested_ synchronously — safe to fall through.
@@ -240,57 +278,54 @@ void websocket_session::on_read(boost::beast::error_code ec,
   // do_read() from being scheduled, avoiding a use-after-close read.
   if (state_.load(std::memory_order_acquire) != state::closed &&
       !close_requested_.load(std::memory_order_acquire)) {
-    deadline_.expires_after(runtime_config_manager::instance().get_ws_idle_timeout());
+    deadline_->expires_after(config_->ws_idle_timeout);
     do_read();
   }
 }
 
-bool websocket_session::check_rate_limit_or_close() noexcept {
-  auto now = std::chrono::steady_clock::now();
-  bool should_close = false;
-
-  {
-    std::lock_guard<std::mutex> lock(rate_limit_mutex_);
-    auto window_start = now - runtime_config_manager::instance().get_rate_limit_window();
-    auto it = std::remove_if(message_timestamps_.begin(), message_timestamps_.end(),
-        [window_start](const auto& timestamp) { return timestamp < window_start; });
-    message_timestamps_.erase(it, message_timestamps_.end());
+void websocket_session::refresh_config() noexcept {
+  // One acquire load per message; only a published reload costs more.
+  const config_snapshot* latest = runtime_config_manager::instance().snapshot();
+  if (latest == config_) {
+    return;
+  }
+  config_ = latest;
+  ws_.read_message_max(config_->max_message_size);
+  rate_limiter_.configure(config_->max_messages_per_window, config_->rate_limit_window);
+  rate_costs_ = config_->rate_limit_costs;
+}
 
-    if (message_timestamps_.size() >= runtime_config_manager::instance().get_max_messages_per_window()) {
-      should_close = true;
-    } else {
-      message_timestamps_.push_back(now);
-    }
+void websocket_session::release_read_buffer() noexcept {
+  buffer_.consume(buffer_.size());
+  // One oversized frame must not pin a max-message-size allocation for the
+  // rest of the session; shrinking an empty buffer just frees it.
+  if (buffer_.capacity() > config::MAX_IDLE_READ_BUFFER_SIZE) {
+    buffer_.shrink_to_fit();
   }
+}
 
-  if (should_close) {
-    // Read session_id outside the rate_limit_mutex_ to avoid nested lock
-    // acquisition (rate_limit_mutex_ -> session_id_mutex_).
-    // String construction is wrapped in try/catch because this function is
-    // noexcept — an allocation failure in concatenation would call std::terminate.
-    try {
-      std::string session_id_str = get_session_id_safe();
-      std::string id_str = session_id_str.empty() ? "(unauthenticated)" : sanitize_session_id(session_id_str);
-      log_error("[WebSocketSession] Rate limit exceeded (max " +
-          std::to_string(runtime_config_manager::instance().get_max_messages_per_window()) + " messages per window) for session " + id_str);
-    } catch (...) {
-      log_error("[WebSocketSession] Rate limit exceeded");
-    }
-    send_protocol_error(protocol::error_codes::SESSION_CLOSED, "Rate limit exceeded");
-    close();
-    return false;
+bool websocket_session::check_rate_limit_or_close(uint32_t cost) noexcept {
+  if (rate_limiter_.try_acquire(cost, std::chrono::steady_clock::now())) {
+    return true;
   }
 
-  return true;
+  traffic().rate_limited.add();
+  log<log_id::rate_limited>(rate_limiter_.max_per_window(), log_session{handle()});
+  send_protocol_error(protocol::error_codes::SESSION_CLOSED, "Rate limit exceeded");
+  close();
+  return false;
 }
 
-void websocket_session::handle_handshake_message(const std::string& message) {
-  auto handshake_opt = protocol::parse_handshake(message);
+void websocket_session::handle_handshake_message(std::string_view message, bool binary) {
+  if (!check_rate_limit_or_close(rate_costs_.handshake - 1)) {
+    return;
+  }
+
+  // The handshake is always JSON text: the encoding is not agreed yet.
+  auto handshake_opt = binary ? std::nullopt : protocol::parse_handshake(message);
 
   if (!handshake_opt) {
-    log_error("[WebSocketSession] Handshake error: Protocol error (Not HANDSHAKE)");
-    send_protocol_error(protocol::error_codes::MALFORMED_HANDSHAKE, "Expected HANDSHAKE message");
-    close();
+    reject_malformed_frame(protocol::error_codes::MALFORMED_HANDSHAKE, "Expected HANDSHAKE message");
     return;
   }
 
@@ -298,7 +333,7 @@ void websocket_session::handle_handshake_message(const std::string& message) {
 
   if (handshake_msg.protocol_version != protocol::PROTOCOL_VERSION) {
     // Truncate version for logging to prevent log injection
-    log_error(std::string("[WebSocketSession] Handshake error: Incompatible version ") + trunc_field(handshake_msg.protocol_version, 32));
+    log<log_id::incompatible_version>(log_field{handshake_msg.protocol_version, 32});
     send_protocol_error(protocol::error_codes::INCOMPATIBLE_VERSION,
                         std::string("Expected ") + protocol::PROTOCOL_VERSION);
     close();
@@ -306,18 +341,13 @@ void websocket_session::handle_handshake_message(const std::string& message) {
   }
 
   if (handshake_msg.client_name) {
-    const auto& cname = *handshake_msg.client_name;
-    try {
-      log_message(std::string("[WebSocketSession] Client Name: ") + trunc_field(cname, 32));
-    } catch (...) {
-      // Non-fatal: log allocation failure must not unwind a successful handshake.
-    }
+    log<log_id::client_name>(log_field{*handshake_msg.client_name, 32});
   }
 
-  std::string new_session_id;
+  session_handle new_handle = INVALID_SESSION_HANDLE;
   if (auto mgr = conn_mgr_.lock()) {
-    new_session_id = mgr->register_session(shared_from_this());
-    if (new_session_id.empty()) {
+    new_handle = mgr->register_session(shared_from_this());
+    if (new_handle == INVALID_SESSION_HANDLE) {
       log_error("[WebSocketSession] Failed to register session - ID collision");
       send_protocol_error(protocol::error_codes::PROTOCOL_ERROR, "Failed to generate unique session ID");
       close();
@@ -330,146 +360,181 @@ void websocket_session::handle_handshake_message(const std::string& message) {
     return;
   }
 
-  {
-    std::lock_guard<std::mutex> lock(session_id_mutex_);
-    session_id_ = new_session_id;
-  }
+  handle_.store(new_handle, std::memory_order_release);
+  const std::string new_session_id = format_session_id(new_handle);
 
   protocol::handshake_response resp;
   resp.session_id = new_session_id;
   resp.seat_number = config::PLACEHOLDER_SEAT;
   resp.starting_stack = config::PLACEHOLDER_STACK;
 
+  // Unknown encodings fall back to JSON; the response says which one won.
+  auto encoding = protocol::wire_encoding::json;
+  if (handshake_msg.encoding) {
+    encoding = protocol::parse_wire_encoding(*handshake_msg.encoding).value_or(protocol::wire_encoding::json);
+    resp.encoding = protocol::wire_encoding_name(encoding);
+  }
+
   if (!send(protocol::serialize_handshake_response(resp))) {
-    log_error("[WebSocketSession] Failed to send handshake response for session: " + new_session_id);
+    log<log_id::handshake_send_failed>(log_session{new_handle});
     close();
     return;
   }
+  // After the (text) response is queued: everything from here on is binary.
+  encoding_.store(encoding, std::memory_order_release);
 
   state_.store(state::authenticated, std::memory_order_release);
 
-  try {
-    log_message(std::string("[WebSocketSession] Handshake successful for session: ") + sanitize_session_id(new_session_id));
-  } catch (...) {
-    // Non-fatal: handshake already succeeded, session is registered and response queued.
-  }
+  log<log_id::handshake_succeeded>(log_session{new_handle});
 }
 
-void websocket_session::handle_authenticated_message(const std::string& message) {
-  auto header_opt = protocol::extract_message_type_and_json(message);
+void websocket_session::handle_authenticated_message(std::string_view message, bool binary) {
+  // Text frames are always JSON; binary frames carry the negotiated encoding.
+  const auto encoding = binary ? encoding_.load(std::memory_order_relaxed) : protocol::wire_encoding::json;
+  if (binary && encoding == protocol::wire_encoding::json) {
+    reject_malformed_frame(protocol::error_codes::MALFORMED_MESSAGE, "Binary frame without a negotiated encoding");
+    return;
+  }
+
+  // ACTION dominates inbound traffic, and garbage is the common attack: the
+  // single-pass parser settles both without building a DOM or throwing.
+  // Only other message types and unusual encodings take the DOM path.
+  const auto fast_status = binary ? protocol::fast_parse_status::unsupported
+                                  : protocol::parse_action_fast(message, parsed_action_);
+  switch (fast_status) {
+    case protocol::fast_parse_status::ok:
+      if (!check_rate_limit_or_close(rate_costs_.action - 1)) {
+        return;
+      }
+      process_action(parsed_action_);
+      return;
+    case protocol::fast_parse_status::malformed:
+      reject_malformed_frame(protocol::error_codes::MALFORMED_MESSAGE, "Missing or invalid message_type field");
+      return;
+    case protocol::fast_parse_status::rejected:
+      if (!check_rate_limit_or_close(rate_costs_.action - 1)) {
+        return;
+      }
+      reject_malformed_frame(protocol::error_codes::MALFORMED_MESSAGE, "Invalid ACTION message format");
+      return;
+    case protocol::fast_parse_status::not_action:
+    case protocol::fast_parse_status::unsupported:
+      break;
+  }
+
+  auto header_opt = protocol::extract_message_type_and_json(message, encoding);
 
   if (!header_opt) {
-    log_error(std::string("[WebSocketSession] Invalid message format from ") + sanitize_session_id(get_session_id_safe()) + ": missing message_type");
-    send_protocol_error(protocol::error_codes::MALFORMED_MESSAGE, "Missing or invalid message_type field");
-    close();
+    reject_malformed_frame(protocol::error_codes::MALFORMED_MESSAGE, "Missing or invalid message_type field");
     return;
   }
 
   const auto& msg_type = header_opt->message_type;
-  const std::string sid = get_session_id_safe();
-
-  if (msg_type == protocol::message_types::ACTION) {
-    handle_action(*header_opt, sid);
-  } else if (msg_type == protocol::message_types::RELOAD_REQUEST) {
-    handle_reload_msg(*header_opt, sid);
-  } else if (msg_type == protocol::message_types::DISCONNECT) {
-    handle_disconnect_msg(*header_opt, sid);
-  } else {
-    try {
-      log_error(std::string("[WebSocketSession] Unknown message type '") + trunc_field(msg_type) + "' from " + sanitize_session_id(sid));
-    } catch (...) {
-      // Allocation failure in log — session will still be closed below.
-    }
-    try {
-      send_protocol_error(protocol::error_codes::PROTOCOL_ERROR,
-                          std::string("Unknown message type: ") + trunc_field(msg_type));
-    } catch (...) {
-      // Allocation failure — close without sending the specific error.
-      // on_read's catch block won't help here because we're not throwing.
-    }
-    close();
+  if (!check_rate_limit_or_close(rate_costs_.cost_for(header_opt->kind) - 1)) {
+    return;
   }
+
+  switch (header_opt->kind) {
+    case protocol::message_kind::action:
+      handle_action(*header_opt);
+      return;
+    case protocol::message_kind::reload_request:
+      handle_reload_msg(*header_opt);
+      return;
+    case protocol::message_kind::disconnect:
+      handle_disconnect_msg(*header_opt);
+      return;
+    case protocol::message_kind::state_ack:
+      handle_state_ack_msg(*header_opt);
+      return;
+    case protocol::message_kind::batch:
+      handle_batch_msg(*header_opt);
+      return;
+    default:
+      break;
+  }
+
+  // Unknown, or a server-to-client type.
+  log<log_id::unknown_message_type>(log_field{msg_type, 64}, log_session{handle()});
+  try {
+    send_protocol_error(protocol::error_codes::PROTOCOL_ERROR,
+                        std::string("Unknown message type: ") + trunc_field(msg_type));
+  } catch (...) {
+    // Allocation failure — close without sending the specific error.
+    // on_read's catch block won't help here because we're not throwing.
+  }
+  close();
 }
 
-void websocket_session::handle_action(const protocol::parsed_message_header& header, const std::string& sid) {
+void websocket_session::handle_action(const protocol::parsed_message_header& header) {
   auto action_opt = protocol::parse_action_from_envelope(header.envelope_json);
   if (!action_opt) {
-    log_error("[WebSocketSession] Failed to parse ACTION message from " + sanitize_session_id(sid));
-    send_protocol_error(protocol::error_codes::MALFORMED_MESSAGE, "Invalid ACTION message format");
-    close();
+    reject_malformed_frame(protocol::error_codes::MALFORMED_MESSAGE, "Invalid ACTION message format");
     return;
   }
 
-  if (!validate_session_id(action_opt->session_id)) {
+  process_action(*action_opt);
+}
+
+void websocket_session::process_action(const protocol::action_message& action) {
+  if (!validate_session_id(action.session_id)) {
     return;
   }
 
-  // Sequence number validation
-  int64_t seq = action_opt->sequence_number;
-  int64_t last_seq = last_sequence_number_.load(std::memory_order_acquire);
+  const int64_t seq = action.sequence_number;
+  if (!accept_sequence_number(seq, last_sequence_number_.load(std::memory_order_acquire))) {
+    return;
+  }
+  last_sequence_number_.store(seq, std::memory_order_release);
+  log<log_id::action_validated>(log_session{handle()}, action.action_type, seq);
+}
+
+bool websocket_session::accept_sequence_number(int64_t seq, int64_t last_seq) noexcept {
   if (seq <= last_seq) {
-    try {
-      log_error("[WebSocketSession] Invalid sequence number " +
-                std::to_string(seq) + " (expected > " +
-                std::to_string(last_seq) + ")");
-    } catch (...) {
-      // Allocation failure in log — session will still be closed below.
-    }
+    log<log_id::sequence_not_increasing>(seq, last_seq);
     send_protocol_error(protocol::error_codes::PROTOCOL_ERROR, "Invalid sequence number - possible replay attack");
     close();
-    return;
+    return false;
   }
   // When last_seq is -1 (initial sentinel), casting to uint64_t wraps to UINT64_MAX,
   // so the subtraction yields seq + 1 — the correct gap from "no prior sequence".
   uint64_t gap = static_cast<uint64_t>(seq) - static_cast<uint64_t>(last_seq);
-  if (gap > static_cast<uint64_t>(runtime_config_manager::instance().get_max_sequence_gap())) {
-    try {
-      log_error("[WebSocketSession] Sequence number too far ahead: " +
-                std::to_string(seq) + " (gap: " + std::to_string(gap) +
-                ", max allowed: " + std::to_string(runtime_config_manager::instance().get_max_sequence_gap()) + ")");
-    } catch (...) {
-      // Allocation failure in log — session will still be closed below.
-    }
+  if (gap > static_cast<uint64_t>(config_->max_sequence_gap)) {
+    log<log_id::sequence_gap>(seq, gap, config_->max_sequence_gap);
     send_protocol_error(protocol::error_codes::PROTOCOL_ERROR, "Sequence number gap too large");
     close();
-    return;
-  }
-  last_sequence_number_.store(seq, std::memory_order_release);
-  try {
-    log_message(std::string("[WebSocketSession] Validated ACTION from ") + sanitize_session_id(sid) + ": type=" +
-                action_opt->action_type + " seq=" + std::to_string(seq));
-  } catch (...) {
-    // Non-fatal: log allocation failure must not close a healthy session.
+    return false;
   }
+  return true;
 }
 
-void websocket_session::handle_reload_msg(const protocol::parsed_message_header& header, const std::string& sid) {
+void websocket_session::handle_reload_msg(const protocol::parsed_message_header& header) {
   auto reload_opt = protocol::parse_reload_from_envelope(header.envelope_json);
   if (!reload_opt) {
-    log_error("[WebSocketSession] Failed to parse RELOAD_REQUEST from " + sanitize_session_id(sid));
+    log<log_id::reload_parse_failed>(log_session{handle()});
     send_protocol_error(protocol::error_codes::MALFORMED_MESSAGE, "Invalid RELOAD_REQUEST format");
     close();
     return;
   }
-  if (!validate_session_id(reload_opt->session_id)) {
+  process_reload(*reload_opt);
+}
+
+void websocket_session::process_reload(const protocol::reload_request_message& reload) {
+  if (!validate_session_id(reload.session_id)) {
     return;
   }
 
-  try {
-    log_message(std::string("[WebSocketSession] Validated RELOAD_REQUEST from ") + sanitize_session_id(sid));
-  } catch (...) {
-    // Non-fatal: log allocation failure must not close a healthy session.
-  }
+  log<log_id::reload_validated>(log_session{handle()});
 
   // Compute the new stack but only commit after the response is queued.
   // Safe without atomics: current_stack_ is only accessed from the session's
   // strand (single-threaded), so the read-then-write is not a data race.
-  int64_t new_stack = std::min(current_stack_ + reload_opt->requested_amount, protocol::MAX_AMOUNT);
+  int64_t new_stack = std::min(current_stack_ + reload.requested_amount, protocol::MAX_AMOUNT);
   protocol::reload_response_message resp;
   resp.granted = true;
   resp.new_stack = new_stack;
-  if (!send(protocol::serialize_reload_response(resp))) {
-    log_error("[WebSocketSession] Failed to send RELOAD_RESPONSE to " + sanitize_session_id(sid));
+  if (!reply(protocol::serialize_reload_response(resp, encoding()))) {
+    log<log_id::reload_send_failed>(log_session{handle()});
     close();
   } else {
     // Only commit the stack update after the response is successfully queued.
@@ -480,123 +545,320 @@ void websocket_session::handle_reload_msg(const protocol::parsed_message_header&
   }
 }
 
-void websocket_session::handle_disconnect_msg(const protocol::parsed_message_header& header, const std::string& sid) {
+void websocket_session::handle_disconnect_msg(const protocol::parsed_message_header& header) {
   auto disconnect_opt = protocol::parse_disconnect_from_envelope(header.envelope_json);
   if (!disconnect_opt) {
-    log_error("[WebSocketSession] Failed to parse DISCONNECT from " + sanitize_session_id(sid));
+    log<log_id::disconnect_parse_failed>(log_session{handle()});
     send_protocol_error(protocol::error_codes::MALFORMED_MESSAGE, "Invalid DISCONNECT format");
     close();
     return;
   }
-  if (!validate_session_id(disconnect_opt->session_id)) {
+  process_disconnect(*disconnect_opt);
+}
+
+void websocket_session::process_disconnect(const protocol::disconnect_message& disconnect) {
+  if (!validate_session_id(disconnect.session_id)) {
     return;
   }
 
-  try {
-    log_message(std::string("[WebSocketSession] Validated DISCONNECT from ") + sanitize_session_id(sid));
-  } catch (...) {
-    // Non-fatal: log allocation failure must not prevent clean disconnect.
-  }
+  log<log_id::disconnect_validated>(log_session{handle()});
+  flush_batch_replies();
   close();
 }
 
-bool websocket_session::queue_message(std::string&& message) noexcept {
-  bool should_post = false;
-  bool queue_full = false;
+void websocket_session::handle_state_ack_msg(const protocol::parsed_message_header& header) {
+  auto ack_opt = protocol::parse_state_ack_from_envelope(header.envelope_json);
+  if (!ack_opt) {
+    reject_malformed_frame(protocol::error_codes::MALFORMED_MESSAGE, "Invalid STATE_ACK format");
+    return;
+  }
+  process_state_ack(*ack_opt);
+}
+
+void websocket_session::process_state_ack(const protocol::state_ack_message& ack) {
+  if (!validate_session_id(ack.session_id)) {
+    return;
+  }
+
+  // An ack for a state we no longer hold, or an explicit resync, means the
+  // client has no usable baseline: answer with a keyframe right away rather
+  // than leaving it unable to apply deltas until the next update.
+  std::optional<state_delta_tracker::encoded> keyframe;
   {
-    std::lock_guard<std::mutex> lock(write_queue_mutex_);
-    if (state_.load(std::memory_order_acquire) == state::closed ||
-        close_requested_.load(std::memory_order_acquire)) {
-      return false;
+    std::lock_guard<std::mutex> lock(state_delta_mutex_);
+    if (!ack.resync && state_delta_.acknowledge(ack.state_sequence)) {
+      return;
     }
-    if (write_queue_.size() >= config::MAX_WRITE_QUEUE_SIZE) {
-      queue_full = true;
-    } else {
-      write_queue_.push(std::move(message));
-      should_post = !writing_;
-      if (should_post) writing_ = true;
+    try {
+      keyframe = state_delta_.resync(encoding());
+    } catch (const std::exception& e) {
+      log<log_id::keyframe_serialize_failed>(e.what());
+      return;
+    }
+    if (keyframe && !send(std::move(keyframe->payload))) {
+      log<log_id::keyframe_send_failed>(log_session{handle()});
     }
   }
+  log<log_id::state_resync>(log_session{handle()}, ack.state_sequence, ack.resync ? "requested" : "unknown");
+}
 
-  if (queue_full) {
-    // Log outside the lock to reduce contention.  Wrapped in try/catch because
-    // this function is noexcept — string concatenation failure would call
-    // std::terminate.
-    try {
-      log_error("[WebSocketSession] Write queue full for session " +
-                sanitize_session_id(get_session_id_safe()) + ", dropping message");
-    } catch (...) {
-      // Allocation failure — message was dropped regardless.
+void websocket_session::handle_batch_msg(protocol::parsed_message_header& header) {
+  auto batch_opt = protocol::parse_batch_from_envelope(std::move(header.envelope_json));
+  if (!batch_opt) {
+    reject_malformed_frame(protocol::error_codes::MALFORMED_MESSAGE, "Invalid BATCH format");
+    return;
+  }
+  if (!validate_session_id(batch_opt->session_id)) {
+    return;
+  }
+
+  // A batch costing more than the whole burst could never be admitted;
+  // refuse it without closing, so the client can resend it in pieces.
+  uint32_t cost = 0;
+  for (const auto& inner : batch_opt->messages) {
+    cost += rate_costs_.cost_for(inner.kind);
+  }
+  if (cost > rate_limiter_.max_per_window()) {
+    log<log_id::batch_too_large>(cost, rate_limiter_.max_per_window(), log_session{handle()});
+    send_protocol_error(protocol::error_codes::PROTOCOL_ERROR,
+                        "BATCH costs " + std::to_string(cost) + " rate-limit units; at most " +
+                            std::to_string(rate_limiter_.max_per_window()) + " allowed");
+    return;
+  }
+
+  // Parse and sequence-check every message before acting on any, so a bad
+  // batch is rejected as a whole.
+  using batch_item = std::variant<protocol::action_message, protocol::reload_request_message,
+                                  protocol::state_ack_message, protocol::disconnect_message>;
+  std::vector<batch_item> items;
+  items.reserve(batch_opt->messages.size());
+  int64_t last_seq = last_sequence_number_.load(std::memory_order_acquire);
+  for (const auto& inner : batch_opt->messages) {
+    bool parsed = false;
+    switch (inner.kind) {
+      case protocol::message_kind::action:
+        if (auto action = protocol::parse_action_from_envelope(inner.envelope_json)) {
+          if (!accept_sequence_number(action->sequence_number, last_seq)) {
+            return;
+          }
+          last_seq = action->sequence_number;
+          items.emplace_back(std::move(*action));
+          parsed = true;
+        }
+        break;
+      case protocol::message_kind::reload_request:
+        if (auto reload = protocol::parse_reload_from_envelope(inner.envelope_json)) {
+          items.emplace_back(std::move(*reload));
+          parsed = true;
+        }
+        break;
+      case protocol::message_kind::state_ack:
+        if (auto ack = protocol::parse_state_ack_from_envelope(inner.envelope_json)) {
+          items.emplace_back(std::move(*ack));
+          parsed = true;
+        }
+        break;
+      case protocol::message_kind::disconnect:
+        if (auto disconnect = protocol::parse_disconnect_from_envelope(inner.envelope_json)) {
+          items.emplace_back(std::move(*disconnect));
+          parsed = true;
+        }
+        break;
+      default:
+        break;
     }
+    if (!parsed) {
+      try {
+        reject_malformed_frame(protocol::error_codes::MALFORMED_MESSAGE,
+                               "Invalid " + trunc_field(inner.message_type) + " in BATCH");
+      } catch (...) {
+        reject_malformed_frame(protocol::error_codes::MALFORMED_MESSAGE, "Invalid BATCH element");
+      }
+      return;
+    }
+  }
+
+  // The batch costs what its messages would cost as separate frames; the
+  // frame itself has already been charged one unit.
+  if (!check_rate_limit_or_close(cost - 1)) {
+    return;
+  }
+
+  std::vector<std::string> replies;
+  batch_replies_ = &replies;
+  try {
+    for (const auto& item : items) {
+      std::visit(
+          [this](const auto& msg) {
+            using message = std::decay_t<decltype(msg)>;
+            if constexpr (std::is_same_v<message, protocol::action_message>) {
+              process_action(msg);
+            } else if constexpr (std::is_same_v<message, protocol::reload_request_message>) {
+              process_reload(msg);
+            } else if constexpr (std::is_same_v<message, protocol::state_ack_message>) {
+              process_state_ack(msg);
+            } else {
+              process_disconnect(msg);
+            }
+          },
+          item);
+      if (close_requested_.load(std::memory_order_acquire)) {
+        break;
+      }
+    }
+  } catch (...) {
+    batch_replies_ = nullptr;
+    throw;
+  }
+  flush_batch_replies();
+  batch_replies_ = nullptr;
+  metrics_.record_batch(items.size());
+}
+
+bool websocket_session::reply(std::string message) {
+  if (batch_replies_) {
+    batch_replies_->push_back(std::move(message));
+    return true;
+  }
+  return send(std::move(message));
+}
+
+void websocket_session::flush_batch_replies() noexcept {
+  if (!batch_replies_ || batch_replies_->empty()) {
+    return;
+  }
+  try {
+    if (!send(protocol::serialize_batch(*batch_replies_, encoding()))) {
+      log<log_id::batch_send_failed>(log_session{handle()});
+    }
+  } catch (const std::exception& e) {
+    log<log_id::batch_serialize_failed>(e.what());
+  }
+  batch_replies_->clear();
+}
+
+bool websocket_session::send_state_update(const protocol::state_update_message& update) noexcept {
+  try {
+    std::lock_guard<std::mutex> lock(state_delta_mutex_);
+    auto encoded = state_delta_.encode(update, encoding());
+    return send(std::move(encoded.payload));
+  } catch (const std::exception& e) {
+    log<log_id::state_update_failed>(e.what());
     return false;
   }
+}
 
-  if (should_post) {
-    boost::asio::post(ws_.get_executor(),
-                      [self = shared_from_this()]() {
-                         self->do_write();
-                      });
+bool websocket_session::queue_message(outbound_message&& message) noexcept {
+  if (state_.load(std::memory_order_acquire) == state::closed ||
+      close_requested_.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  if (!write_queue_.try_push(std::move(message))) {
+    log<log_id::write_queue_full>(log_session{handle()});
+    return false;
+  }
+
+  // Pairs with the fence in release_writer(): either this producer observes
+  // writing_ == false and schedules the write, or the strand observes the
+  // item just published and keeps draining.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!writing_.exchange(true, std::memory_order_acq_rel)) {
+    schedule_write();
   }
   return true;
 }
 
+void websocket_session::schedule_write() noexcept {
+  boost::asio::post(ws_.get_executor(), make_recycling_handler([self = shared_from_this()]() {
+    self->do_write();
+  }));
+}
+
+bool websocket_session::release_writer() noexcept {
+  writing_.store(false, std::memory_order_release);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // A producer may have published after our last empty() check while it
+  // still saw writing_ == true — re-check so its message isn't stranded.
+  if (write_queue_.empty()) {
+    return false;
+  }
+  return !writing_.exchange(true, std::memory_order_acq_rel);
+}
+
 bool websocket_session::send(std::string message) {
-  return queue_message(std::move(message));
+  return queue_message(outbound_message(std::move(message), encoding() != protocol::wire_encoding::json));
 }
 
-void websocket_session::do_write() {
-  // Pop the message string under the lock, then allocate the shared_ptr
-  // outside the lock.  This reduces write_queue_mutex_ hold time and avoids
-  // leaving a moved-from element in the queue if make_shared throws (the old
-  // code moved from front() then called make_shared — if allocation failed,
-  // front() was already empty but pop() hadn't executed).
-  std::string msg_str;
-  {
-    std::lock_guard<std::mutex> lock(write_queue_mutex_);
-    if (state_.load(std::memory_order_acquire) == state::closed) {
-      writing_ = false;
-      return;
+bool websocket_session::send(shared_payload payload) noexcept {
+  if (!payload) {
+    return false;
+  }
+  return queue_message(outbound_message(std::move(payload), encoding() != protocol::wire_encoding::json));
+}
+
+bool websocket_session::fill_write_batch() {
+  write_batch_.clear();
+  write_batch_pos_ = 0;
+
+  // Coalescing drains everything queued right now into one flush; otherwise
+  // each flush carries a single message.
+  const size_t max_frames = write_coalescing_ ? write_queue_.limit() : 1;
+  outbound_message msg;
+  for (;;) {
+    while (write_batch_.size() < max_frames && write_queue_.try_pop(msg)) {
+      write_batch_.push_back(std::move(msg));
     }
-    if (write_queue_.empty()) {
-      writing_ = false;
-      return;
+    if (!write_batch_.empty()) {
+      break;
+    }
+    // Queue looked empty — hand the writer role back; release_writer()
+    // reclaims it if a producer slipped an item in meanwhile.
+    if (!release_writer()) {
+      return false;
     }
-    msg_str = std::move(write_queue_.front());
-    write_queue_.pop();
   }
 
-  std::shared_ptr<std::string> message;
-  try {
-    message = std::make_shared<std::string>(std::move(msg_str));
-  } catch (...) {
-    // Allocation failed — the dequeued message is lost.  Rather than
-    // continuing with a broken write pipeline (client stuck waiting for a
-    // response that will never arrive), close the session so the client
-    // reconnects into a clean state.
-    //
-    // The log message construction is wrapped in a nested try/catch because
-    // we are already in an allocation-failure path — the string concatenation
-    // below could also fail with bad_alloc, and an uncaught exception from
-    // this strand-posted handler would propagate through io_context::run(),
-    // potentially crashing the entire server.
+  metrics_.record_flush(write_batch_.size());
+  return true;
+}
+
+void websocket_session::do_write() {
+  if (state_.load(std::memory_order_acquire) == state::closed) {
+    writing_.store(false, std::memory_order_release);
+    return;
+  }
+
+  if (write_batch_pos_ >= write_batch_.size()) {
     try {
-      log_error("[WebSocketSession] Exception in do_write (allocation failure) - closing session " +
-                sanitize_session_id(get_session_id_safe()));
+      if (!fill_write_batch()) {
+        // A close() that saw this writer scheduled left the close to it, and
+        // with nothing to write no on_write() will run to do it.
+        if (close_requested_.load(std::memory_order_acquire)) {
+          do_close();
+        }
+        return;
+      }
     } catch (...) {
-      // Double allocation failure — nothing useful to log.
-    }
-    {
-      std::lock_guard<std::mutex> lock(write_queue_mutex_);
-      writing_ = false;
+      // Allocation failed — messages popped into the batch are lost.  Rather
+      // than continuing with a broken write pipeline (client stuck waiting
+      // for a response that will never arrive), close the session so the
+      // client reconnects into a clean state.
+      log<log_id::write_exception>(log_session{handle()});
+      write_batch_.clear();
+      write_batch_pos_ = 0;
+      writing_.store(false, std::memory_order_release);
+      close();
+      return;
     }
-    close();
-    return;
   }
 
-  ws_.async_write(boost::asio::buffer(*message),
-                  [self = shared_from_this(), message](boost::beast::error_code ec, std::size_t bytes) {
-                    self->on_write(ec, bytes);
-                  });
+  // write_batch_ owns the payload until on_write runs; the batch is only
+  // refilled once every frame in it has completed.
+  ws_.binary(write_batch_[write_batch_pos_].is_binary());
+  ws_.async_write(boost::asio::buffer(write_batch_[write_batch_pos_].bytes()),
+                  make_recycling_handler(boost::beast::bind_front_handler(
+                      &websocket_session::on_write, shared_from_this())));
 }
 
 void websocket_session::on_write(boost::beast::error_code ec,
@@ -604,48 +866,51 @@ void websocket_session::on_write(boost::beast::error_code ec,
   if (!ec) {
     metrics_.increment_messages_sent();
     metrics_.increment_bytes_sent(bytes_transferred);
+    traffic().messages_sent.add();
   }
   try {
     if (ec) {
-      // String construction for log messages happens before the noexcept
-      // log_error() is entered — wrap in try/catch so a bad_alloc from
-      // concatenation doesn't propagate through io_context::run().
+      // ec.message() allocates — wrap in try/catch so a bad_alloc doesn't
+      // propagate through io_context::run().
       try {
-        log_error(std::string("[WebSocketSession] Write error for ") + sanitize_session_id(get_session_id_safe()) + ": " + ec.message());
+        log<log_id::write_error>(log_session{handle()}, ec.message());
       } catch (...) {
-        // Allocation failure — best-effort fallback
         log_error("[WebSocketSession] Write error (allocation failure constructing log message)");
       }
-      size_t dropped = 0;
-      {
-        std::lock_guard<std::mutex> lock(write_queue_mutex_);
-        writing_ = false;
-        close_requested_.store(true, std::memory_order_release);
-        dropped = write_queue_.size();
-        write_queue_ = std::queue<std::string>();
+      // close_requested_ first so producers stop enqueuing, then drain the
+      // rest of the current flush and whatever is already queued.
+      close_requested_.store(true, std::memory_order_release);
+      size_t dropped = write_batch_.size() - std::min(write_batch_pos_ + 1, write_batch_.size());
+      write_batch_.clear();
+      write_batch_pos_ = 0;
+      outbound_message discarded;
+      while (write_queue_.try_pop(discarded)) {
+        ++dropped;
       }
+      writing_.store(false, std::memory_order_release);
       if (dropped > 0) {
-        try {
-          log_error("[WebSocketSession] Dropped " + std::to_string(dropped) + " queued message(s) on write error");
-        } catch (...) {
-          // Allocation failure — queue was still cleared successfully.
-        }
+        log<log_id::write_queue_dropped>(dropped);
       }
       do_close();
       return;
     }
 
+    // Still inside a coalesced flush: write the next frame straight from
+    // this completion handler (already on the strand) — no post round trip.
+    if (++write_batch_pos_ < write_batch_.size()) {
+      do_write();
+      return;
+    }
+
     bool should_close = false;
     bool has_more = false;
-    {
-      std::lock_guard<std::mutex> lock(write_queue_mutex_);
-      writing_ = false;
-      if (close_requested_.load(std::memory_order_acquire) && write_queue_.empty()) {
-        should_close = true;
-      } else if (!write_queue_.empty()) {
-        writing_ = true;
-        has_more = true;
-      }
+    if (!write_queue_.empty()) {
+      has_more = true;  // Keep the writer role and start the next flush.
+    } else if (close_requested_.load(std::memory_order_acquire)) {
+      writing_.store(false, std::memory_order_release);
+      should_close = true;
+    } else {
+      has_more = release_writer();
     }
 
     if (should_close) {
@@ -654,15 +919,14 @@ void websocket_session::on_write(boost::beast::error_code ec,
     }
 
     if (has_more) {
-      boost::asio::post(ws_.get_executor(), [self = shared_from_this()]() {
-        self->do_write();
-      });
+      if (write_coalescing_) {
+        do_write();
+      } else {
+        schedule_write();
+      }
     }
   } catch (const std::exception& e) {
-    try {
-      log_error(std::string("[WebSocketSession] Exception in on_write: ") + e.what());
-    } catch (...) {
-    }
+    log<log_id::on_write_exception>(e.what());
     do_close();
   } catch (...) {
     log_error("[WebSocketSession] Unknown exception in on_write");
@@ -670,60 +934,32 @@ void websocket_session::on_write(boost::beast::error_code ec,
   }
 }
 
-void websocket_session::check_deadline() {
-  deadline_.async_wait(
-      [self = shared_from_this()](boost::beast::error_code ec) {
-        if (ec == boost::asio::error::operation_aborted) {
-          // Only reschedule if the session is still alive and no close has been
-          // requested.  When do_close() or close() cancels the timer we want to
-          // stop the timer chain, not reschedule.
-          if (self->state_.load(std::memory_order_acquire) != state::closed &&
-              !self->close_requested_.load(std::memory_order_acquire)) {
-            self->check_deadline();
-          }
-          return;
-        }
-
-        if (ec) {
-          if (self->state_.load(std::memory_order_acquire) == state::closed) {
-            return;
-          }
-
-          try {
-            log_error(std::string("[WebSocketSession] Timer error: ") + ec.message());
-          } catch (...) {
-          }
-          // Reschedule the deadline check on transient timer errors so the
-          // session isn't left without timeout protection.  Without this, any
-          // non-aborted timer error would permanently kill the timer chain,
-          // leaving only Beast's 24-hour stream timeout as a backstop.
-          if (!self->close_requested_.load(std::memory_order_acquire)) {
-            self->check_deadline();
-          }
-          return;
-        }
-
-        auto current_state = self->state_.load(std::memory_order_acquire);
+void websocket_session::cancel_deadline() noexcept {
+  if (deadline_) {
+    deadline_->cancel();
+  }
+}
 
-        if (current_state == state::closed) {
-          return;
-        }
+void websocket_session::on_deadline() {
+  auto current_state = state_.load(std::memory_order_acquire);
+  if (current_state == state::closed || close_requested_.load(std::memory_order_acquire)) {
+    return;
+  }
+  // The deadline may have been pushed back (a message arrived) after the
+  // wheel decided to fire.
+  if (!deadline_ || !deadline_->expired()) {
+    return;
+  }
 
-        if (current_state == state::unauthenticated) {
-          log_error("[WebSocketSession] Handshake timeout");
-          self->send_protocol_error(protocol::error_codes::SESSION_CLOSED, "Handshake timeout");
-          self->close();
-        } else {
-          try {
-            log_error(std::string("[WebSocketSession] Idle timeout for session ") + sanitize_session_id(self->get_session_id_safe()));
-          } catch (...) {
-            // Allocation failure in async handler — log is best-effort.
-            log_error("[WebSocketSession] Idle timeout");
-          }
-          self->send_protocol_error(protocol::error_codes::SESSION_CLOSED, "Idle timeout");
-          self->close();
-        }
-      });
+  if (current_state == state::unauthenticated) {
+    log_error("[WebSocketSession] Handshake timeout");
+    send_protocol_error(protocol::error_codes::SESSION_CLOSED, "Handshake timeout");
+    close();
+  } else {
+    log<log_id::idle_timeout>(log_session{handle()});
+    send_protocol_error(protocol::error_codes::SESSION_CLOSED, "Idle timeout");
+    close();
+  }
 }
 
 void websocket_session::close() noexcept {
@@ -739,21 +975,14 @@ void websocket_session::close() noexcept {
     boost::asio::dispatch(ws_.get_executor(), [weak_self]() {
        auto self = weak_self.lock();
        if (!self) return;  // Object being destroyed — destructor handles cleanup
-       bool write_in_flight = false;
-       {
-         std::lock_guard<std::mutex> lock(self->write_queue_mutex_);
-         write_in_flight = self->writing_;
-       }
-       if (!write_in_flight) {
+       // A write in flight will observe close_requested_ in on_write() and
+       // close once the queue has drained.
+       if (!self->writing_.load(std::memory_order_acquire)) {
          self->do_close();
        }
     });
   } catch (const std::exception& e) {
-    try {
-      log_error(std::string("[WebSocketSession] Exception in close(): ") + e.what());
-    } catch (...) {
-      // Allocation failure in noexcept context — nothing useful to do.
-    }
+    log<log_id::close_exception>(e.what());
   } catch (...) {
     log_error("[WebSocketSession] Unknown exception in close()");
   }
@@ -761,14 +990,13 @@ void websocket_session::close() noexcept {
 
 std::string websocket_session::get_session_id_safe() const noexcept {
   try {
-    std::lock_guard<std::mutex> lock(session_id_mutex_);
-    return session_id_;
+    return format_session_id(handle_.load(std::memory_order_acquire));
   } catch (...) {
     return std::string();
   }
 }
 
-bool websocket_session::validate_session_id(const std::string& provided_session_id) noexcept {
+bool websocket_session::validate_session_id(std::string_view provided_session_id) noexcept {
   try {
     if (provided_session_id.empty()) {
       log_error("[WebSocketSession] Empty session ID provided");
@@ -778,19 +1006,17 @@ bool websocket_session::validate_session_id(const std::string& provided_session_
     }
 
     if (provided_session_id.size() > config::MAX_SESSION_ID_LENGTH) {
-      log_error(std::string("[WebSocketSession] Session ID too long: ") +
-                  std::to_string(provided_session_id.size()) + " > " +
-                  std::to_string(config::MAX_SESSION_ID_LENGTH));
+      log<log_id::session_id_too_long>(provided_session_id.size(), config::MAX_SESSION_ID_LENGTH);
       send_protocol_error(protocol::error_codes::PROTOCOL_ERROR, "Session ID exceeds maximum length");
       close();
       return false;
     }
 
-    std::string expected_id = get_session_id_safe();
-
-    if (provided_session_id != expected_id) {
-      log_error(std::string("[WebSocketSession] Session ID mismatch: expected ") + sanitize_session_id(expected_id) + ", got " +
-                  sanitize_session_id(provided_session_id));
+    // Anything that does not parse yields INVALID_SESSION_HANDLE, which never
+    // matches a registered session.
+    const session_handle expected = handle_.load(std::memory_order_acquire);
+    if (expected == INVALID_SESSION_HANDLE || parse_session_id(provided_session_id) != expected) {
+      log<log_id::session_id_mismatch>(log_session{expected}, log_field{provided_session_id, SESSION_ID_LOG_LENGTH});
       send_protocol_error(protocol::error_codes::PROTOCOL_ERROR, "Session ID mismatch");
       close();
       return false;
@@ -802,7 +1028,25 @@ bool websocket_session::validate_session_id(const std::string& provided_session_
   }
 }
 
+void websocket_session::reject_malformed_frame(const char* error_code, std::string_view reason) noexcept {
+  metrics_.record_malformed_frame();
+
+  uint64_t suppressed = 0;
+  if (malformed_frame_sampler().admit(std::chrono::steady_clock::now(), suppressed)) {
+    if (suppressed != 0) {
+      log<log_id::malformed_frame_sampled>(log_session{handle()}, reason, suppressed);
+    } else {
+      log<log_id::malformed_frame>(log_session{handle()}, reason);
+    }
+  }
+
+  send_protocol_error(error_code, reason);
+  close();
+}
+
 void websocket_session::send_protocol_error(const char* error_code, std::string_view message) noexcept {
+  // Replies to earlier messages of a batch go out before the error.
+  flush_batch_replies();
   try {
     protocol::error_message err;
     err.error_code = error_code;
@@ -819,8 +1063,8 @@ void websocket_session::send_protocol_error(const char* error_code, std::string_
     if (!sid.empty()) err.session_id = sid;
     
     try {
-      if (!send(protocol::serialize_error(err))) {
-        log_error("[WebSocketSession] Failed to send protocol error for session " + sanitize_session_id(sid));
+      if (!send(protocol::serialize_error(err, encoding()))) {
+        log<log_id::protocol_error_send_failed>(log_session{handle()});
         metrics_.increment_errors();
       }
     } catch (...) {
@@ -846,14 +1090,12 @@ void websocket_session::do_close() noexcept {
   }
 
   try {
-    boost::beast::error_code timer_ec;
-    deadline_.cancel(timer_ec);
-
-    std::string session_id_copy = get_session_id_safe();
+    cancel_deadline();
 
-    if (!session_id_copy.empty()) {
+    const session_handle handle = handle_.load(std::memory_order_acquire);
+    if (handle != INVALID_SESSION_HANDLE) {
       if (auto mgr = conn_mgr_.lock()) {
-        mgr->unregister_session(session_id_copy);
+        mgr->unregister_session(handle);
       }
     }
 
@@ -864,7 +1106,7 @@ void websocket_session::do_close() noexcept {
       boost::beast::error_code close_ec;
       ws_.next_layer().socket().close(close_ec);
       if (close_ec) {
-        log_error(std::string("[WebSocketSession] TCP close error: ") + close_ec.message());
+        log<log_id::tcp_close_error>(close_ec.message());
       }
     } else {
       // Stream was accepted — send a proper WebSocket close frame.
@@ -872,7 +1114,7 @@ void websocket_session::do_close() noexcept {
                       [self = shared_from_this()](boost::beast::error_code ec) {
                         if (ec) {
                           try {
-                            log_error(std::string("[WebSocketSession] Close error: ") + ec.message());
+                            log<log_id::close_error>(ec.message());
                           } catch (...) {
                             // Allocation failure in async handler — log is best-effort.
                           }
@@ -885,11 +1127,7 @@ void websocket_session::do_close() noexcept {
                       });
     }
   } catch (const std::exception& e) {
-    try {
-      log_error(std::string("[WebSocketSession] Exception in do_close: ") + e.what());
-    } catch (...) {
-      // Allocation failure in noexcept context — nothing useful to do.
-    }
+    log<log_id::do_close_exception>(e.what());
     // Fallback: force-close the TCP socket to prevent FD leak if async_close threw.
     // Use non-throwing socket close directly (Beast's tcp_stream::close() can
     // throw, but raw socket close with error_code cannot).
@@ -921,11 +1159,7 @@ bool websocket_session::check_suspicious_activity() noexcept {
     last_activity_ = now;
 
     if (count > 100 && elapsed == 0) {
-      try {
-        log_error("[WebSocketSession] Rapid message burst detected: " + std::to_string(count) + " messages in < 1s");
-      } catch (...) {
-        // Allocation failure — log is best-effort.
-      }
+      log<log_id::message_burst>(count);
       return true;
     }
 
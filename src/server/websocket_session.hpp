@@ -1,17 +1,23 @@
 #pragma once
 
 #include "boost_wrapper.hpp"
+#include "bounded_mpsc_queue.hpp"
 #include "connection_manager.hpp"
+#include "outbound_message.hpp"
+#include "rate_limiter.hpp"
+#include "runtime_config_manager.hpp"
+#include "session_handle.hpp"
 #include "session_metrics.hpp"
+#include "state_delta_tracker.hpp"
+#include "timer_wheel.hpp"
 #include <atomic>
 #include <chrono>
 #include <cstdint>
-#include <deque>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "config.hpp"
 #include "protocol.hpp"
@@ -24,12 +30,40 @@ class websocket_session final
  public:
   websocket_session(boost::asio::ip::tcp::socket socket,
                     std::shared_ptr<connection_manager> mgr,
+                    std::shared_ptr<timer_wheel> wheel,
                     std::chrono::seconds handshake_timeout = config::HANDSHAKE_TIMEOUT);
   ~websocket_session() noexcept;
 
   void run() noexcept;
 
+  // `message` must already be serialized in encoding(); it goes out as a
+  // binary frame for CBOR / MessagePack sessions and as text otherwise.
   [[nodiscard]] bool send(std::string message);
+
+  /**
+   * @brief Queue a shared, already-serialized payload (e.g. a broadcast).
+   *
+   * The payload is referenced, not copied, so one serialization can be sent
+   * to many sessions — serialize once per encoding() in use.  Returns false
+   * for a null payload, a closing session, or a full write queue.
+   * Thread-safe to call from any thread.
+   */
+  [[nodiscard]] bool send(shared_payload payload) noexcept;
+
+  /**
+   * @brief Send a game state, as a STATE_DELTA once the client acknowledges one.
+   *
+   * Stamps the state with its state_sequence and serializes it in
+   * encoding(); see state_delta_tracker for when a full STATE_UPDATE is
+   * sent instead.  Returns false if serialization fails or the message
+   * cannot be queued.  Thread-safe to call from any thread.
+   */
+  [[nodiscard]] bool send_state_update(const protocol::state_update_message& update) noexcept;
+
+  // Wire encoding negotiated by the handshake; JSON until then.
+  [[nodiscard]] protocol::wire_encoding encoding() const noexcept {
+    return encoding_.load(std::memory_order_acquire);
+  }
   
   [[nodiscard]] bool is_authenticated() const noexcept {
     return state_.load(std::memory_order_acquire) == state::authenticated;
@@ -43,10 +77,16 @@ class websocket_session final
    */
   void close() noexcept;
 
+  // Empty until the handshake registers the session.
   [[nodiscard]] std::string session_id() const noexcept {
     return get_session_id_safe();
   }
 
+  // INVALID_SESSION_HANDLE until the handshake registers the session.
+  [[nodiscard]] session_handle handle() const noexcept {
+    return handle_.load(std::memory_order_acquire);
+  }
+
   websocket_session(const websocket_session&) = delete;
   websocket_session& operator=(const websocket_session&) = delete;
   websocket_session(websocket_session&&) = delete;
@@ -61,50 +101,113 @@ class websocket_session final
 
   void do_write();
   void on_write(boost::beast::error_code ec, std::size_t bytes_transferred);
+  [[nodiscard]] bool fill_write_batch();
 
-  void check_deadline();
+  // Runs on the strand when the wheel reports the handshake/idle deadline.
+  void on_deadline();
+  void cancel_deadline() noexcept;
 
-  // Validates the provided session_id against this session's stored ID.
+  // Validates the client-supplied session_id against this session's handle
+  // (parsed in place — no lock, no allocation on success).
   // On failure: sends a PROTOCOL_ERROR to the client and calls close().
   // Callers should return immediately if this returns false.
-  [[nodiscard]] bool validate_session_id(const std::string& provided_session_id) noexcept;
+  [[nodiscard]] bool validate_session_id(std::string_view provided_session_id) noexcept;
   void send_protocol_error(const char* error_code, std::string_view message) noexcept;
   void do_close() noexcept;
 
-  [[nodiscard]] bool check_rate_limit_or_close() noexcept;
+  void release_read_buffer() noexcept;
+  // Re-reads the cached config snapshot if a reload published a new one.
+  void refresh_config() noexcept;
+
+  // Charges `cost` units; on overflow sends SESSION_CLOSED and closes.
+  [[nodiscard]] bool check_rate_limit_or_close(uint32_t cost) noexcept;
   
   [[nodiscard]] bool check_suspicious_activity() noexcept;
-  
-  void handle_handshake_message(const std::string& message);
-  void handle_authenticated_message(const std::string& message);
-  void handle_action(const protocol::parsed_message_header& header, const std::string& sid);
-  void handle_reload_msg(const protocol::parsed_message_header& header, const std::string& sid);
-  void handle_disconnect_msg(const protocol::parsed_message_header& header, const std::string& sid);
 
-  [[nodiscard]] bool queue_message(std::string&& message) noexcept;
+  // Counts the frame, logs it if the process-wide sampler admits it, replies
+  // with `error_code` and closes.
+  void reject_malformed_frame(const char* error_code, std::string_view reason) noexcept;
+  
+  // `message` views buffer_ and is only valid until release_read_buffer().
+  // `binary` is set for binary WebSocket frames.
+  void handle_handshake_message(std::string_view message, bool binary);
+  void handle_authenticated_message(std::string_view message, bool binary);
+  // handle_* parse one message type; process_* run the session-level checks
+  // (ID, sequence number) on an already-parsed message and act on it.
+  void handle_action(const protocol::parsed_message_header& header);
+  void process_action(const protocol::action_message& action);
+  void handle_reload_msg(const protocol::parsed_message_header& header);
+  void process_reload(const protocol::reload_request_message& reload);
+  void handle_disconnect_msg(const protocol::parsed_message_header& header);
+  void process_disconnect(const protocol::disconnect_message& disconnect);
+  void handle_state_ack_msg(const protocol::parsed_message_header& header);
+  void process_state_ack(const protocol::state_ack_message& ack);
+  // Takes the envelope out of `header`.
+  void handle_batch_msg(protocol::parsed_message_header& header);
+
+  // Checks `seq` against the last accepted one; on failure sends a
+  // PROTOCOL_ERROR and closes.  Does not store `seq`.
+  [[nodiscard]] bool accept_sequence_number(int64_t seq, int64_t last_seq) noexcept;
+
+  // Sends a reply to the client's message — or, while a BATCH is being
+  // handled, holds it for the single BATCH reply flush_batch_replies() sends.
+  [[nodiscard]] bool reply(std::string message);
+  void flush_batch_replies() noexcept;
+
+  [[nodiscard]] bool queue_message(outbound_message&& message) noexcept;
+  void schedule_write() noexcept;
+  [[nodiscard]] bool release_writer() noexcept;
+  // Formats handle_ for logs and replies; empty when unregistered or on
+  // allocation failure.
   [[nodiscard]] std::string get_session_id_safe() const noexcept;
 
   boost::beast::websocket::stream<boost::beast::tcp_stream> ws_;
   boost::beast::flat_buffer buffer_;
-  std::string session_id_;
-  mutable std::mutex session_id_mutex_;
+  // Set once by the handshake (on the strand), read from any thread.
+  std::atomic<session_handle> handle_{INVALID_SESSION_HANDLE};
+  std::atomic<protocol::wire_encoding> encoding_{protocol::wire_encoding::json};
   std::weak_ptr<connection_manager> conn_mgr_;
-  std::queue<std::string> write_queue_;
-  mutable std::mutex write_queue_mutex_;
-  bool writing_{false};  // Protected by write_queue_mutex_. Indicates async_write in flight.
+  // Lock-free outbound queue: any thread may push, only the strand pops.
+  // writing_ is claimed (false -> true) by whichever side schedules
+  // do_write(), and released by the strand once the queue is drained, so at
+  // most one async_write is ever in flight.
+  bounded_mpsc_queue<outbound_message> write_queue_{config::MAX_WRITE_QUEUE_SIZE};
+  std::atomic<bool> writing_{false};
+
+  // Strand-only: messages popped from write_queue_ for the current flush and
+  // the index of the one being written.  The batch keeps the payloads alive
+  // until their async_write completes.
+  std::vector<outbound_message> write_batch_;
+  size_t write_batch_pos_{0};
+  bool write_coalescing_{config::WRITE_COALESCING};
 
   enum class state { unauthenticated, authenticated, closed };
   std::atomic<state> state_{state::unauthenticated};
 
-  boost::asio::steady_timer deadline_;
+  // Handshake deadline until authenticated, then the idle deadline; re-armed
+  // by every read with a single atomic store (see timer_wheel).
+  std::shared_ptr<timer_wheel> wheel_;
+  std::shared_ptr<timer_wheel::timer> deadline_;
 
   std::atomic<int64_t> last_sequence_number_{-1};
 
   std::atomic<bool> close_requested_{false};
   std::atomic<bool> close_initiated_{false};
 
-  std::deque<std::chrono::steady_clock::time_point> message_timestamps_;
-  mutable std::mutex rate_limit_mutex_;
+  // Strand-only.  config_ is the runtime config snapshot the session last
+  // saw; refresh_config() swaps it (and re-derives the limiter settings)
+  // when a reload publishes a new one.
+  const config_snapshot* config_{nullptr};
+  gcra_rate_limiter rate_limiter_;
+  message_cost_table rate_costs_;
+  // Game threads send states while the strand applies the client's acks;
+  // the mutex also keeps queue order equal to state_sequence order.
+  std::mutex state_delta_mutex_;
+  state_delta_tracker state_delta_;
+  // Strand-only: replies collected while a BATCH is handled, else null.
+  std::vector<std::string>* batch_replies_{nullptr};
+  // Reused by the ACTION fast path so its strings keep their capacity.
+  protocol::action_message parsed_action_{};
   
   // Security monitoring
   std::chrono::steady_clock::time_point last_activity_;
@@ -1,10 +1,13 @@
 #include <gtest/gtest.h>
 #include "server/boost_wrapper.hpp"
 #include "server/websocket_server.hpp"
+#include "server/websocket_session.hpp"
 #include "server/config.hpp"
 #include <nlohmann/json.hpp>
+#include <atomic>
 #include <chrono>
 #include <thread>
+#include <vector>
 #include "common/protocol.hpp"
 #include "test_utils.hpp"
 
@@ -391,6 +394,67 @@ TEST_F(ActionTest, ValidReloadRequest) {
     ws.close(websocket::close_code::normal);
 }
 
+// Test: Pipelined requests are answered in order (responses may be flushed
+// together by write coalescing, but never reordered or dropped)
+TEST_F(ActionTest, PipelinedReloadsAnsweredInOrder) {
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    std::string session_id = do_handshake(ws, test_port);
+    ASSERT_FALSE(session_id.empty());
+
+    constexpr int kRequests = 4;
+    cppsim::protocol::message_envelope env;
+    env.message_type = cppsim::protocol::message_types::RELOAD_REQUEST;
+    env.protocol_version = cppsim::protocol::PROTOCOL_VERSION;
+    nlohmann::json j;
+    for (int i = 0; i < kRequests; ++i) {
+        env.payload = nlohmann::json{{"session_id", session_id}, {"requested_amount", 100}};
+        cppsim::protocol::to_json(j, env);
+        ws.write(net::buffer(j.dump()));
+    }
+
+    for (int i = 1; i <= kRequests; ++i) {
+        beast::flat_buffer buf;
+        ws.read(buf);
+        auto resp_json = nlohmann::json::parse(beast::buffers_to_string(buf.data()));
+        EXPECT_EQ(resp_json["message_type"], cppsim::protocol::message_types::RELOAD_RESPONSE);
+        EXPECT_EQ(resp_json["payload"]["new_stack"].get<int64_t>(), 100 * i);
+    }
+
+    ws.close(websocket::close_code::normal);
+}
+
+// Test: A near-max-size message is parsed in place, and the session keeps
+// serving normal-sized messages after its read buffer is shrunk back.
+TEST_F(ActionTest, LargeMessageThenSmallMessage) {
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    std::string session_id = do_handshake(ws, test_port);
+    ASSERT_FALSE(session_id.empty());
+
+    cppsim::protocol::message_envelope env;
+    env.message_type = cppsim::protocol::message_types::RELOAD_REQUEST;
+    env.protocol_version = cppsim::protocol::PROTOCOL_VERSION;
+    env.payload = nlohmann::json{{"session_id", session_id}, {"requested_amount", 100}};
+    nlohmann::json j;
+    cppsim::protocol::to_json(j, env);
+    j["padding"] = std::string(48 * 1024, 'x');
+    ws.write(net::buffer(j.dump()));
+
+    j.erase("padding");
+    ws.write(net::buffer(j.dump()));
+
+    for (int i = 1; i <= 2; ++i) {
+        beast::flat_buffer buf;
+        ws.read(buf);
+        auto resp_json = nlohmann::json::parse(beast::buffers_to_string(buf.data()));
+        EXPECT_EQ(resp_json["message_type"], cppsim::protocol::message_types::RELOAD_RESPONSE);
+        EXPECT_EQ(resp_json["payload"]["new_stack"].get<int64_t>(), 100 * i);
+    }
+
+    ws.close(websocket::close_code::normal);
+}
+
 // Test: Valid DISCONNECT through the server
 TEST_F(ActionTest, ValidDisconnect) {
     net::io_context ioc;
@@ -497,6 +561,54 @@ TEST_F(ActionTest, RateLimitExceeded) {
     }
 }
 
+// Test: Reload requests are charged their higher rate-limit cost
+TEST_F(ActionTest, ReloadCostCountsTowardsRateLimit) {
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    std::string session_id = do_handshake(ws, test_port);
+    ASSERT_FALSE(session_id.empty());
+
+    // Handshake (1) + 5 reloads at RATE_COST_RELOAD_REQUEST (2) = 11 units,
+    // one over MAX_MESSAGES_PER_WINDOW even though only 6 frames were sent.
+    static_assert(cppsim::server::config::RATE_COST_HANDSHAKE +
+                      5 * cppsim::server::config::RATE_COST_RELOAD_REQUEST >
+                  cppsim::server::config::MAX_MESSAGES_PER_WINDOW);
+    cppsim::protocol::message_envelope env;
+    env.message_type = cppsim::protocol::message_types::RELOAD_REQUEST;
+    env.protocol_version = cppsim::protocol::PROTOCOL_VERSION;
+    env.payload = nlohmann::json{{"session_id", session_id}, {"requested_amount", 100}};
+    nlohmann::json j;
+    cppsim::protocol::to_json(j, env);
+    for (int i = 0; i < 5; ++i) {
+        ws.write(net::buffer(j.dump()));
+    }
+
+    int reloads_answered = 0;
+    bool saw_rate_limit = false;
+    try {
+        while (!saw_rate_limit && reloads_answered <= 5) {
+            beast::flat_buffer buf;
+            ws.read(buf);
+            auto resp_json = nlohmann::json::parse(beast::buffers_to_string(buf.data()));
+            if (resp_json["message_type"] == cppsim::protocol::message_types::ERROR) {
+                EXPECT_EQ(resp_json["payload"]["error_code"], cppsim::protocol::error_codes::SESSION_CLOSED);
+                saw_rate_limit = true;
+            } else {
+                EXPECT_EQ(resp_json["message_type"], cppsim::protocol::message_types::RELOAD_RESPONSE);
+                ++reloads_answered;
+            }
+        }
+    } catch (const beast::system_error& se) {
+        bool expected = (se.code() == websocket::error::closed) ||
+                        (se.code() == net::error::eof) ||
+                        (se.code() == net::error::connection_reset);
+        EXPECT_TRUE(expected) << "Unexpected error: " << se.code().message();
+        saw_rate_limit = true;
+    }
+    EXPECT_TRUE(saw_rate_limit);
+    EXPECT_EQ(reloads_answered, 4);
+}
+
 // Test: Sequence number gap exceeding MAX_SEQUENCE_GAP should be rejected
 TEST_F(ActionTest, SequenceGapTooLarge) {
     net::io_context ioc;
@@ -570,3 +682,289 @@ TEST_F(ActionTest, ReplayedSequenceNumber) {
         EXPECT_TRUE(expected) << "Unexpected error: " << se.code().message();
     }
 }
+
+// Helper: handshake requesting `encoding`; returns the parsed response payload.
+static nlohmann::json do_encoding_handshake(websocket::stream<tcp::socket>& ws, uint16_t port,
+                                            const std::string& encoding) {
+    tcp::resolver resolver(ws.get_executor());
+    auto const results = resolver.resolve("localhost", std::to_string(port));
+    net::connect(ws.next_layer(), results.begin(), results.end());
+    ws.handshake("localhost", "/");
+
+    cppsim::protocol::message_envelope env;
+    env.message_type = cppsim::protocol::message_types::HANDSHAKE;
+    env.protocol_version = cppsim::protocol::PROTOCOL_VERSION;
+    env.payload = nlohmann::json{{"protocol_version", cppsim::protocol::PROTOCOL_VERSION},
+                                  {"encoding", encoding}};
+    nlohmann::json j;
+    cppsim::protocol::to_json(j, env);
+    ws.write(net::buffer(j.dump()));
+
+    // The response is always JSON text.
+    beast::flat_buffer buf;
+    ws.read(buf);
+    EXPECT_TRUE(ws.got_text());
+    auto resp_json = nlohmann::json::parse(beast::buffers_to_string(buf.data()));
+    EXPECT_EQ(resp_json["message_type"], cppsim::protocol::message_types::HANDSHAKE_RESPONSE);
+    return resp_json["payload"];
+}
+
+// Test: A CBOR session exchanges binary frames after the handshake
+TEST_F(ActionTest, NegotiatedCborSession) {
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    auto payload = do_encoding_handshake(ws, test_port, cppsim::protocol::encodings::CBOR);
+    ASSERT_EQ(payload["encoding"], cppsim::protocol::encodings::CBOR);
+    const auto session_id = payload["session_id"].get<std::string>();
+
+    cppsim::protocol::message_envelope env;
+    env.message_type = cppsim::protocol::message_types::RELOAD_REQUEST;
+    env.protocol_version = cppsim::protocol::PROTOCOL_VERSION;
+    env.payload = nlohmann::json{{"session_id", session_id}, {"requested_amount", 500}};
+    nlohmann::json j;
+    cppsim::protocol::to_json(j, env);
+    ws.binary(true);
+    ws.write(net::buffer(nlohmann::json::to_cbor(j)));
+
+    beast::flat_buffer buf;
+    ws.read(buf);
+    ASSERT_TRUE(ws.got_binary());
+    const auto bytes = beast::buffers_to_string(buf.data());
+    auto resp_json = nlohmann::json::from_cbor(bytes);
+    EXPECT_EQ(resp_json["message_type"], cppsim::protocol::message_types::RELOAD_RESPONSE);
+    EXPECT_EQ(resp_json["payload"]["new_stack"].get<int64_t>(), 500);
+
+    // Text JSON frames are still understood.
+    env.payload = nlohmann::json{{"session_id", session_id}, {"requested_amount", 100}};
+    cppsim::protocol::to_json(j, env);
+    ws.text(true);
+    ws.write(net::buffer(j.dump()));
+    beast::flat_buffer buf2;
+    ws.read(buf2);
+    ASSERT_TRUE(ws.got_binary());
+    resp_json = nlohmann::json::from_cbor(beast::buffers_to_string(buf2.data()));
+    EXPECT_EQ(resp_json["payload"]["new_stack"].get<int64_t>(), 600);
+
+    ws.close(websocket::close_code::normal);
+}
+
+// Test: An unsupported encoding falls back to JSON, and the response says so
+TEST_F(ActionTest, UnknownEncodingFallsBackToJson) {
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    auto payload = do_encoding_handshake(ws, test_port, "protobuf");
+    EXPECT_EQ(payload["encoding"], cppsim::protocol::encodings::JSON);
+
+    // Binary frames are rejected on a JSON session.
+    ws.binary(true);
+    ws.write(net::buffer(std::string("\xa0")));
+    beast::flat_buffer buf;
+    ws.read(buf);
+    ASSERT_TRUE(ws.got_text());
+    auto resp_json = nlohmann::json::parse(beast::buffers_to_string(buf.data()));
+    EXPECT_EQ(resp_json["payload"]["error_code"], cppsim::protocol::error_codes::MALFORMED_MESSAGE);
+}
+
+// Test: STATE_UPDATE turns into STATE_DELTA once the client acknowledges a state
+TEST_F(ActionTest, StateDeltaAfterAck) {
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    const auto session_id = do_handshake(ws, test_port);
+    auto session = server->get_connection_manager()->get_session(session_id);
+    ASSERT_TRUE(session != nullptr);
+
+    cppsim::protocol::state_update_message state;
+    state.game_phase = "PREFLOP";
+    state.pot_size = 30;
+    state.current_bet = 20;
+    state.player_stacks = {{0, 990}, {1, 980}};
+    state.valid_actions = {"FOLD", "CALL", "RAISE"};
+
+    const auto read_json = [&ws] {
+        beast::flat_buffer buf;
+        ws.read(buf);
+        return nlohmann::json::parse(beast::buffers_to_string(buf.data()));
+    };
+    const auto send_ack = [&ws, &session_id](int64_t seq, bool resync) {
+        cppsim::protocol::message_envelope env;
+        env.message_type = cppsim::protocol::message_types::STATE_ACK;
+        env.protocol_version = cppsim::protocol::PROTOCOL_VERSION;
+        env.payload = nlohmann::json{{"session_id", session_id}, {"state_sequence", seq}, {"resync", resync}};
+        nlohmann::json j;
+        cppsim::protocol::to_json(j, env);
+        ws.write(net::buffer(j.dump()));
+    };
+
+    ASSERT_TRUE(session->send_state_update(state));
+    auto msg = read_json();
+    EXPECT_EQ(msg["message_type"], cppsim::protocol::message_types::STATE_UPDATE);
+    const auto seq = msg["payload"]["state_sequence"].get<int64_t>();
+
+    send_ack(seq, false);
+    // The ack has no reply; wait until the strand has applied it.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{2};
+    bool acked = false;
+    while (!acked && std::chrono::steady_clock::now() < deadline) {
+        state.pot_size += 10;
+        ASSERT_TRUE(session->send_state_update(state));
+        msg = read_json();
+        acked = msg["message_type"] == cppsim::protocol::message_types::STATE_DELTA;
+    }
+    ASSERT_TRUE(acked);
+    EXPECT_EQ(msg["payload"]["base_sequence"].get<int64_t>(), seq);
+    EXPECT_EQ(msg["payload"]["pot_size"].get<int64_t>(), state.pot_size);
+    EXPECT_FALSE(msg["payload"].contains("player_stacks"));
+
+    // A resync request is answered with a keyframe straight away.
+    send_ack(0, true);
+    msg = read_json();
+    EXPECT_EQ(msg["message_type"], cppsim::protocol::message_types::STATE_UPDATE);
+    EXPECT_EQ(msg["payload"]["pot_size"].get<int64_t>(), state.pot_size);
+
+    ws.close(websocket::close_code::normal);
+}
+
+static nlohmann::json envelope_of(const char* type, nlohmann::json payload) {
+    cppsim::protocol::message_envelope env;
+    env.message_type = type;
+    env.protocol_version = cppsim::protocol::PROTOCOL_VERSION;
+    env.payload = std::move(payload);
+    nlohmann::json j;
+    cppsim::protocol::to_json(j, env);
+    return j;
+}
+
+// Test: A BATCH is handled in order and answered with one BATCH frame
+TEST_F(ActionTest, BatchProcessedInOrderWithOneReply) {
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    const std::string session_id = do_handshake(ws, test_port);
+
+    namespace types = cppsim::protocol::message_types;
+    const auto batch = envelope_of(types::BATCH, {
+        {"session_id", session_id},
+        {"messages", {
+            envelope_of(types::ACTION, {{"session_id", session_id}, {"action_type", "FOLD"}, {"sequence_number", 1}}),
+            envelope_of(types::RELOAD_REQUEST, {{"session_id", session_id}, {"requested_amount", 500}}),
+            envelope_of(types::ACTION, {{"session_id", session_id}, {"action_type", "CALL"}, {"sequence_number", 2}}),
+            envelope_of(types::RELOAD_REQUEST, {{"session_id", session_id}, {"requested_amount", 100}}),
+        }}});
+    ws.write(net::buffer(batch.dump()));
+
+    beast::flat_buffer buf;
+    ws.read(buf);
+    auto resp_json = nlohmann::json::parse(beast::buffers_to_string(buf.data()));
+    ASSERT_EQ(resp_json["message_type"], types::BATCH);
+    const auto& replies = resp_json["payload"]["messages"];
+    ASSERT_EQ(replies.size(), 2u);
+    EXPECT_EQ(replies[0]["message_type"], types::RELOAD_RESPONSE);
+    EXPECT_EQ(replies[0]["payload"]["new_stack"].get<int64_t>(), 500);
+    EXPECT_EQ(replies[1]["payload"]["new_stack"].get<int64_t>(), 600);
+
+    // The batch advanced the sequence number: seq 2 is now a replay.
+    ws.write(net::buffer(
+        envelope_of(types::ACTION, {{"session_id", session_id}, {"action_type", "FOLD"}, {"sequence_number", 2}})
+            .dump()));
+    beast::flat_buffer buf2;
+    ws.read(buf2);
+    resp_json = nlohmann::json::parse(beast::buffers_to_string(buf2.data()));
+    EXPECT_EQ(resp_json["payload"]["error_code"], cppsim::protocol::error_codes::PROTOCOL_ERROR);
+}
+
+// Test: A BATCH with a bad sequence number is rejected before any of it runs
+TEST_F(ActionTest, BatchRejectedAsAUnit) {
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    const std::string session_id = do_handshake(ws, test_port);
+
+    namespace types = cppsim::protocol::message_types;
+    const auto batch = envelope_of(types::BATCH, {
+        {"session_id", session_id},
+        {"messages", {
+            envelope_of(types::RELOAD_REQUEST, {{"session_id", session_id}, {"requested_amount", 500}}),
+            envelope_of(types::ACTION, {{"session_id", session_id}, {"action_type", "FOLD"}, {"sequence_number", 5}}),
+            envelope_of(types::ACTION, {{"session_id", session_id}, {"action_type", "FOLD"}, {"sequence_number", 3}}),
+        }}});
+    ws.write(net::buffer(batch.dump()));
+
+    // The first frame back is the error: the reload never ran.
+    beast::flat_buffer buf;
+    ws.read(buf);
+    auto resp_json = nlohmann::json::parse(beast::buffers_to_string(buf.data()));
+    EXPECT_EQ(resp_json["message_type"], types::ERROR);
+    EXPECT_EQ(resp_json["payload"]["error_code"], cppsim::protocol::error_codes::PROTOCOL_ERROR);
+}
+
+// Test: A BATCH costing more than the rate-limit burst is refused without closing
+TEST_F(ActionTest, BatchLargerThanBurstRejectedWithoutClosing) {
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    const std::string session_id = do_handshake(ws, test_port);
+
+    namespace types = cppsim::protocol::message_types;
+    constexpr size_t ACTIONS = cppsim::server::config::MAX_MESSAGES_PER_WINDOW + 1;
+    static_assert(ACTIONS <= cppsim::protocol::MAX_BATCH_MESSAGES);
+    nlohmann::json messages = nlohmann::json::array();
+    for (size_t i = 1; i <= ACTIONS; ++i) {
+        messages.push_back(
+            envelope_of(types::ACTION, {{"session_id", session_id}, {"action_type", "FOLD"}, {"sequence_number", i}}));
+    }
+    ws.write(net::buffer(envelope_of(types::BATCH, {{"session_id", session_id}, {"messages", messages}}).dump()));
+
+    beast::flat_buffer buf;
+    ws.read(buf);
+    auto resp_json = nlohmann::json::parse(beast::buffers_to_string(buf.data()));
+    EXPECT_EQ(resp_json["message_type"], types::ERROR);
+    EXPECT_EQ(resp_json["payload"]["error_code"], cppsim::protocol::error_codes::PROTOCOL_ERROR);
+
+    // The session is still open and the batch consumed no sequence numbers.
+    ws.write(net::buffer(
+        envelope_of(types::ACTION, {{"session_id", session_id}, {"action_type", "FOLD"}, {"sequence_number", 1}})
+            .dump()));
+    ws.write(net::buffer(
+        envelope_of(types::RELOAD_REQUEST, {{"session_id", session_id}, {"requested_amount", 500}}).dump()));
+    beast::flat_buffer buf2;
+    ws.read(buf2);
+    resp_json = nlohmann::json::parse(beast::buffers_to_string(buf2.data()));
+    EXPECT_EQ(resp_json["message_type"], types::RELOAD_RESPONSE);
+
+    ws.close(websocket::close_code::normal);
+}
+
+// Test: close() racing send() from other threads still closes the session
+TEST_F(ActionTest, CloseWhileSendingStillCloses) {
+    // The losing interleaving needs a sender preempted between publishing its
+    // message and claiming the writer, so this is a stress test: it cannot
+    // force that window, only give it many chances.
+    constexpr int ROUNDS = 50;
+    constexpr int SENDERS = 8;
+    for (int round = 0; round < ROUNDS; ++round) {
+        net::io_context ioc;
+        websocket::stream<tcp::socket> ws(ioc);
+        const auto session_id = do_handshake(ws, test_port);
+        auto session = server->get_connection_manager()->get_session(session_id);
+        ASSERT_TRUE(session != nullptr);
+
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> senders;
+        for (int s = 0; s < SENDERS; ++s) {
+            senders.emplace_back([&session, &stop] {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    (void)session->send(std::string("{}"));
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds{100 * (round % 8)});
+        session->close();
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        stop = true;
+        for (auto& sender : senders) sender.join();
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{2};
+        while (server->get_connection_manager()->session_count() != 0 &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        ASSERT_EQ(server->get_connection_manager()->session_count(), 0u) << "round " << round;
+    }
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "server/boost_wrapper.hpp"
+#include "server/metrics_collector.hpp"
+#include "server/metrics_http_server.hpp"
+#include "server/session_metrics.hpp"
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = net::ip::tcp;
+
+using cppsim::server::metrics_collector;
+using cppsim::server::metrics_http_server;
+using cppsim::server::render_openmetrics_page;
+
+namespace {
+
+http::response<http::string_body> request(uint16_t port, http::verb method, const std::string& target) {
+  net::io_context ioc;
+  beast::tcp_stream stream(ioc);
+  stream.expires_after(std::chrono::seconds(5));
+  stream.connect(tcp::endpoint(net::ip::make_address("127.0.0.1"), port));
+
+  http::request<http::empty_body> req{method, target, 11};
+  req.set(http::field::host, "127.0.0.1");
+  http::write(stream, req);
+
+  beast::flat_buffer buffer;
+  http::response<http::string_body> res;
+  http::read(stream, buffer, res);
+  return res;
+}
+
+bool contains(const std::string& text, const std::string& part) {
+  return text.find(part) != std::string::npos;
+}
+
+}  // namespace
+
+TEST(MetricsEndpointTest, ServesOpenMetricsPage) {
+  metrics_collector::register_counter("endpoint_test.requests").add(3);
+  metrics_collector::register_gauge("endpoint_test_depth").set(2.5);
+  const auto timing = metrics_collector::register_timing("endpoint_test_latency");
+  timing.record(std::chrono::microseconds(80));
+  timing.record(std::chrono::microseconds(3000));
+
+  std::atomic<int> scrapes{0};
+  metrics_http_server server("127.0.0.1", 0, [&scrapes] { ++scrapes; });
+  ASSERT_NE(server.port(), 0u);
+  server.start();
+
+  const auto res = request(server.port(), http::verb::get, "/metrics");
+  EXPECT_EQ(res.result(), http::status::ok);
+  EXPECT_TRUE(contains(std::string(res[http::field::content_type]), "application/openmetrics-text"));
+  EXPECT_EQ(scrapes.load(), 1);
+
+  const std::string& body = res.body();
+  EXPECT_TRUE(contains(body, "# TYPE poker_endpoint_test_requests counter\npoker_endpoint_test_requests_total 3\n"))
+      << body;
+  EXPECT_TRUE(contains(body, "# TYPE poker_endpoint_test_depth gauge\npoker_endpoint_test_depth 2.5\n"));
+  EXPECT_TRUE(contains(body, "# TYPE poker_endpoint_test_latency_seconds histogram\n"));
+  EXPECT_TRUE(contains(body, "poker_endpoint_test_latency_seconds_bucket{le=\"0.0001\"} 1\n"));
+  EXPECT_TRUE(contains(body, "poker_endpoint_test_latency_seconds_bucket{le=\"0.0025\"} 1\n"));
+  EXPECT_TRUE(contains(body, "poker_endpoint_test_latency_seconds_bucket{le=\"0.005\"} 2\n"));
+  EXPECT_TRUE(contains(body, "poker_endpoint_test_latency_seconds_bucket{le=\"+Inf\"} 2\n"));
+  EXPECT_TRUE(contains(body, "poker_endpoint_test_latency_seconds_sum 0.00308\n"));
+  EXPECT_TRUE(contains(body, "poker_endpoint_test_latency_seconds_count 2\n"));
+  EXPECT_TRUE(contains(body, "# TYPE poker_errors counter\npoker_errors_total "));
+  EXPECT_TRUE(contains(body, "# TYPE poker_sessions_live gauge\n"));
+  ASSERT_GE(body.size(), 6u);
+  EXPECT_EQ(body.substr(body.size() - 6), "# EOF\n");
+
+  server.stop();
+  server.stop();
+}
+
+TEST(MetricsEndpointTest, RejectsOtherPathsAndMethods) {
+  metrics_http_server server("127.0.0.1", 0);
+  server.start();
+  EXPECT_EQ(request(server.port(), http::verb::get, "/").result(), http::status::not_found);
+  EXPECT_EQ(request(server.port(), http::verb::post, "/metrics").result(), http::status::method_not_allowed);
+  EXPECT_EQ(request(server.port(), http::verb::get, "/metrics").result(), http::status::ok);
+}
+
+TEST(MetricsEndpointTest, BadAddressThrows) {
+  EXPECT_THROW(metrics_http_server("not an address", 0), std::runtime_error);
+}
+
+TEST(MetricsEndpointTest, SessionTotalsKeepClosedSessions) {
+  // A registry of its own: the process-wide one already holds whatever
+  // sessions earlier tests opened.
+  cppsim::server::session_metrics_registry registry;
+  {
+    cppsim::server::session_metrics metrics;
+    registry.track(metrics);
+    metrics.increment_messages_sent(4);
+    metrics.increment_bytes_received(100);
+
+    const std::string live = render_openmetrics_page(registry);
+    EXPECT_TRUE(contains(live, "poker_sessions_live 1\n")) << live;
+    EXPECT_TRUE(contains(live, "poker_session_messages_sent_total 4\n"));
+
+    metrics.increment_messages_sent();
+    registry.retire(metrics);
+    registry.retire(metrics);
+  }
+
+  const std::string closed = render_openmetrics_page(registry);
+  EXPECT_TRUE(contains(closed, "poker_sessions_live 0\n")) << closed;
+  EXPECT_TRUE(contains(closed, "poker_session_messages_sent_total 5\n"));
+  EXPECT_TRUE(contains(closed, "poker_session_bytes_received_total 100\n"));
+}
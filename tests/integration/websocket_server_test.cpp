@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <thread>
@@ -6,6 +7,7 @@
 
 #include "server/boost_wrapper.hpp"
 #include "server/websocket_server.hpp"
+#include "server/websocket_session.hpp"
 #include "server/connection_manager.hpp"
 #include "server/config.hpp"
 #include "common/protocol.hpp"
@@ -41,6 +43,8 @@ TEST(ConnectionManagerTest, GetNonexistentSession) {
   auto mgr = std::make_shared<cppsim::server::connection_manager>();
   auto session = mgr->get_session("sess_nonexistent");
   EXPECT_EQ(session, nullptr);
+  EXPECT_EQ(mgr->get_session("sess_0123456789abcdef"), nullptr);
+  EXPECT_EQ(mgr->get_session(cppsim::server::INVALID_SESSION_HANDLE), nullptr);
 }
 
 TEST(WebSocketServerTest, AcceptsConnection) {
@@ -105,6 +109,221 @@ TEST(WebSocketServerTest, AcceptsConnection) {
   ws.close(websocket::close_code::normal);
 }
 
+TEST(WebSocketServerTest, AcceptsConnectionsOnThreadPool) {
+  constexpr int kIoThreads = 4;
+  constexpr int kClients = 8;
+  net::io_context ioc_server{kIoThreads};
+
+  std::shared_ptr<cppsim::server::websocket_server> server;
+  uint16_t port = cppsim::testing::find_free_port([&](uint16_t p) {
+    server = std::make_shared<cppsim::server::websocket_server>(ioc_server, p);
+  });
+  ASSERT_NE(port, 0u) << "Failed to find a free port after 5 attempts";
+  ASSERT_TRUE(server != nullptr);
+  server->run();
+
+  std::vector<std::thread> io_threads;
+  for (int i = 0; i < kIoThreads; ++i) {
+    io_threads.emplace_back([&ioc_server] { ioc_server.run(); });
+  }
+
+  struct cleanup_guard {
+    std::function<void()> fn;
+    ~cleanup_guard() { if (fn) fn(); }
+  } guard{[&]() {
+    ioc_server.stop();
+    for (auto& t : io_threads) {
+      if (t.joinable()) t.join();
+    }
+    server->stop();
+  }};
+
+  ASSERT_TRUE(wait_for_server(port)) << "Failed to connect to server within 5 seconds";
+
+  // Handshake from several clients concurrently — each must get its own
+  // session ID even though the server's handlers run on different threads.
+  std::vector<std::string> session_ids(kClients);
+  std::vector<std::thread> clients;
+  for (int c = 0; c < kClients; ++c) {
+    clients.emplace_back([&, c] {
+      try {
+        net::io_context ioc_client;
+        tcp::resolver resolver(ioc_client);
+        websocket::stream<tcp::socket> ws(ioc_client);
+        auto const results = resolver.resolve("localhost", std::to_string(port));
+        net::connect(ws.next_layer(), results.begin(), results.end());
+        ws.handshake("localhost", "/");
+
+        nlohmann::json j = {{"message_type", cppsim::protocol::message_types::HANDSHAKE},
+                            {"protocol_version", cppsim::protocol::PROTOCOL_VERSION},
+                            {"payload", {{"protocol_version", cppsim::protocol::PROTOCOL_VERSION}}}};
+        ws.write(net::buffer(j.dump()));
+
+        beast::flat_buffer buffer;
+        ws.read(buffer);
+        auto resp_json = nlohmann::json::parse(beast::buffers_to_string(buffer.data()));
+        session_ids[static_cast<size_t>(c)] = resp_json["payload"]["session_id"].get<std::string>();
+        ws.close(websocket::close_code::normal);
+      } catch (const std::exception&) {
+        // Leave the session ID empty — asserted below.
+      }
+    });
+  }
+  for (auto& t : clients) t.join();
+
+  for (const auto& sid : session_ids) {
+    EXPECT_FALSE(sid.empty());
+  }
+  std::sort(session_ids.begin(), session_ids.end());
+  EXPECT_EQ(std::adjacent_find(session_ids.begin(), session_ids.end()), session_ids.end());
+}
+
+TEST(WebSocketServerTest, ReusePortShardsShareListeningPort) {
+  if (!cppsim::server::websocket_server::reuse_port_supported()) {
+    GTEST_SKIP() << "SO_REUSEPORT not supported on this platform";
+  }
+  constexpr size_t kShards = 2;
+  constexpr size_t kMaxConnections = 4;
+  // One budget for both shards, however the kernel spreads connections.
+  auto limit = std::make_shared<cppsim::server::connection_limit>(kMaxConnections);
+  std::vector<std::unique_ptr<net::io_context>> iocs;
+  std::vector<std::shared_ptr<cppsim::server::websocket_server>> servers;
+
+  // Bind the first shard to a free port, then bind the others to the same port.
+  iocs.push_back(std::make_unique<net::io_context>(1));
+  uint16_t port = cppsim::testing::find_free_port([&](uint16_t p) {
+    servers.push_back(std::make_shared<cppsim::server::websocket_server>(
+        *iocs.front(), p, cppsim::server::config::HANDSHAKE_TIMEOUT, true, limit));
+  });
+  ASSERT_NE(port, 0u) << "Failed to find a free port after 5 attempts";
+  for (size_t i = 1; i < kShards; ++i) {
+    iocs.push_back(std::make_unique<net::io_context>(1));
+    ASSERT_NO_THROW(servers.push_back(std::make_shared<cppsim::server::websocket_server>(
+        *iocs.back(), port, cppsim::server::config::HANDSHAKE_TIMEOUT, true, limit)));
+  }
+  for (auto& server : servers) {
+    EXPECT_EQ(server->get_connection_manager()->max_connections(), kMaxConnections);
+    server->run();
+  }
+
+  std::vector<std::thread> io_threads;
+  for (auto& ioc : iocs) {
+    io_threads.emplace_back([ioc = ioc.get()] { ioc->run(); });
+  }
+
+  struct cleanup_guard {
+    std::function<void()> fn;
+    ~cleanup_guard() { if (fn) fn(); }
+  } guard{[&]() {
+    for (auto& ioc : iocs) ioc->stop();
+    for (auto& t : io_threads) {
+      if (t.joinable()) t.join();
+    }
+    for (auto& server : servers) server->stop();
+  }};
+
+  ASSERT_TRUE(wait_for_server(port)) << "Failed to connect to server within 5 seconds";
+
+  // Whichever shard the kernel picks must complete the handshake, up to the
+  // shared limit and no further.
+  net::io_context ioc_client;
+  std::vector<std::unique_ptr<websocket::stream<tcp::socket>>> clients;
+  auto handshake = [&]() {
+    auto ws = std::make_unique<websocket::stream<tcp::socket>>(ioc_client);
+    tcp::resolver resolver(ioc_client);
+    auto const results = resolver.resolve("localhost", std::to_string(port));
+    net::connect(ws->next_layer(), results.begin(), results.end());
+    ws->handshake("localhost", "/");
+
+    nlohmann::json j = {{"message_type", cppsim::protocol::message_types::HANDSHAKE},
+                        {"protocol_version", cppsim::protocol::PROTOCOL_VERSION},
+                        {"payload", {{"protocol_version", cppsim::protocol::PROTOCOL_VERSION}}}};
+    ws->write(net::buffer(j.dump()));
+
+    beast::flat_buffer buffer;
+    ws->read(buffer);
+    clients.push_back(std::move(ws));
+    return nlohmann::json::parse(beast::buffers_to_string(buffer.data()))["message_type"].get<std::string>();
+  };
+  for (size_t c = 0; c < kMaxConnections; ++c) {
+    EXPECT_EQ(handshake(), cppsim::protocol::message_types::HANDSHAKE_RESPONSE);
+  }
+  EXPECT_EQ(limit->size(), kMaxConnections);
+  EXPECT_EQ(handshake(), cppsim::protocol::message_types::ERROR);
+  EXPECT_EQ(limit->size(), kMaxConnections);
+}
+
+TEST(WebSocketServerTest, BroadcastsSharedPayloadToSessions) {
+  net::io_context ioc_server;
+
+  std::shared_ptr<cppsim::server::websocket_server> server;
+  uint16_t port = cppsim::testing::find_free_port([&](uint16_t p) {
+    server = std::make_shared<cppsim::server::websocket_server>(ioc_server, p);
+  });
+  ASSERT_NE(port, 0u) << "Failed to find a free port after 5 attempts";
+  ASSERT_TRUE(server != nullptr);
+  server->run();
+
+  std::thread server_thread([&ioc_server] { ioc_server.run(); });
+
+  struct cleanup_guard {
+    std::function<void()> fn;
+    ~cleanup_guard() { if (fn) fn(); }
+  } guard{[&]() {
+    server->stop();
+    ioc_server.stop();
+    if (server_thread.joinable()) {
+      server_thread.join();
+    }
+  }};
+
+  ASSERT_TRUE(wait_for_server(port)) << "Failed to connect to server within 5 seconds";
+
+  constexpr size_t kClients = 3;
+  net::io_context ioc_client;
+  tcp::resolver resolver(ioc_client);
+  std::vector<std::unique_ptr<websocket::stream<tcp::socket>>> clients;
+  std::vector<std::string> session_ids;
+  for (size_t c = 0; c < kClients; ++c) {
+    auto ws = std::make_unique<websocket::stream<tcp::socket>>(ioc_client);
+    auto const results = resolver.resolve("localhost", std::to_string(port));
+    net::connect(ws->next_layer(), results.begin(), results.end());
+    ws->handshake("localhost", "/");
+
+    nlohmann::json j = {{"message_type", cppsim::protocol::message_types::HANDSHAKE},
+                        {"protocol_version", cppsim::protocol::PROTOCOL_VERSION},
+                        {"payload", {{"protocol_version", cppsim::protocol::PROTOCOL_VERSION}}}};
+    ws->write(net::buffer(j.dump()));
+
+    beast::flat_buffer buffer;
+    ws->read(buffer);
+    auto resp_json = nlohmann::json::parse(beast::buffers_to_string(buffer.data()));
+    session_ids.push_back(resp_json["payload"]["session_id"].get<std::string>());
+    clients.push_back(std::move(ws));
+  }
+
+  // One serialization, queued on every session by reference.
+  const std::string text = R"({"message_type":"STATE_UPDATE","payload":{"pot":42}})";
+  auto payload = cppsim::server::make_shared_payload(text);
+  auto mgr = server->get_connection_manager();
+  for (const auto& sid : session_ids) {
+    auto session = mgr->get_session(sid);
+    ASSERT_NE(session, nullptr);
+    EXPECT_EQ(session->handle(), cppsim::server::parse_session_id(sid));
+    EXPECT_EQ(mgr->get_session(session->handle()), session);
+    EXPECT_EQ(session->session_id(), sid);
+    EXPECT_TRUE(session->send(payload));
+  }
+  EXPECT_FALSE(mgr->get_session(session_ids.front())->send(cppsim::server::shared_payload{}));
+
+  for (auto& ws : clients) {
+    beast::flat_buffer buffer;
+    ws->read(buffer);
+    EXPECT_EQ(beast::buffers_to_string(buffer.data()), text);
+    ws->close(websocket::close_code::normal);
+  }
+}
+
 TEST(WebSocketServerTest, StopIsIdempotent) {
   net::io_context ioc;
 
@@ -0,0 +1,196 @@
+#include "server/async_logger.hpp"
+#include "server/log_record.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using cppsim::server::async_log_options;
+using cppsim::server::async_logger;
+using cppsim::server::log_level;
+using cppsim::server::log_overflow_policy;
+
+namespace {
+
+// A temporary file standing in for stdout / stderr.
+class capture_file {
+public:
+    capture_file() : file_(std::tmpfile()) {}
+    ~capture_file() {
+        if (file_) std::fclose(file_);
+    }
+    capture_file(const capture_file&) = delete;
+    capture_file& operator=(const capture_file&) = delete;
+
+    [[nodiscard]] std::FILE* get() const { return file_; }
+
+    [[nodiscard]] std::vector<std::string> lines() const {
+        std::fflush(file_);
+        std::rewind(file_);
+        std::string contents;
+        char buf[4096];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), file_)) > 0) contents.append(buf, n);
+        std::fseek(file_, 0, SEEK_END);
+
+        std::vector<std::string> out;
+        std::istringstream in(contents);
+        for (std::string line; std::getline(in, line);) out.push_back(line);
+        return out;
+    }
+
+private:
+    std::FILE* file_;
+};
+
+async_log_options options_for(const capture_file& info, const capture_file& error, log_overflow_policy policy,
+                              size_t ring_records = 64) {
+    async_log_options options;
+    options.ring_records = ring_records;
+    options.overflow = policy;
+    options.flush_interval = std::chrono::milliseconds{5};
+    options.info_stream = info.get();
+    options.error_stream = error.get();
+    return options;
+}
+
+// The message part of a formatted line: "<date> <time> [LEVEL] <message>".
+std::string message_of(const std::string& line) {
+    const auto level_end = line.find("] ");
+    return level_end == std::string::npos ? std::string{} : line.substr(level_end + 2);
+}
+
+}  // namespace
+
+TEST(AsyncLoggerTest, BlockingPolicyKeepsEveryLineInThreadOrder) {
+    capture_file info, error;
+    constexpr int THREADS = 4;
+    constexpr int LINES_PER_THREAD = 2000;
+    {
+        async_logger logger(options_for(info, error, log_overflow_policy::block));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&logger, t] {
+                for (int i = 0; i < LINES_PER_THREAD; ++i) {
+                    EXPECT_TRUE(logger.log(log_level::info, "t" + std::to_string(t) + " " + std::to_string(i)));
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        logger.stop();
+        EXPECT_EQ(logger.dropped(), 0u);
+    }
+
+    std::map<int, int> next;
+    const auto lines = info.lines();
+    ASSERT_EQ(lines.size(), static_cast<size_t>(THREADS * LINES_PER_THREAD));
+    for (const auto& line : lines) {
+        EXPECT_NE(line.find(" [INFO] t"), std::string::npos) << line;
+        int thread = -1, index = -1;
+        ASSERT_EQ(std::sscanf(message_of(line).c_str(), "t%d %d", &thread, &index), 2) << line;
+        EXPECT_EQ(index, next[thread]++) << line;
+    }
+    EXPECT_TRUE(error.lines().empty());
+}
+
+TEST(AsyncLoggerTest, DropPolicyCountsWhatItDiscards) {
+    capture_file info, error;
+    constexpr int LINES = 20000;
+    uint64_t dropped = 0;
+    {
+        // An interval long enough that the ring overflows before the flusher
+        // gets to it by itself.
+        auto options = options_for(info, error, log_overflow_policy::drop, 16);
+        options.flush_interval = std::chrono::seconds{10};
+        async_logger logger(options);
+        for (int i = 0; i < LINES; ++i) {
+            EXPECT_TRUE(logger.log(log_level::info, "line " + std::to_string(i)));
+        }
+        logger.stop();
+        dropped = logger.dropped();
+    }
+
+    EXPECT_GT(dropped, 0u);
+    EXPECT_EQ(info.lines().size() + dropped, static_cast<size_t>(LINES));
+
+    uint64_t reported = 0;
+    for (const auto& line : error.lines()) {
+        unsigned long long n = 0;
+        ASSERT_EQ(std::sscanf(message_of(line).c_str(), "[Logger] Dropped %llu", &n), 1) << line;
+        reported += n;
+    }
+    EXPECT_EQ(reported, dropped);
+}
+
+TEST(AsyncLoggerTest, LongLinesSpanRecordsAndOverlongOnesAreTruncated) {
+    capture_file info, error;
+    const std::string long_line(1000, 'x');
+    const std::string overlong(100 * 1024, 'y');
+    {
+        async_logger logger(options_for(info, error, log_overflow_policy::block));
+        logger.log(log_level::info, long_line);
+        logger.log(log_level::info, overlong);
+        logger.log(log_level::info, "");
+        logger.stop();
+    }
+
+    const auto lines = info.lines();
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(message_of(lines[0]), long_line);
+    const std::string truncated = message_of(lines[1]);
+    EXPECT_LT(truncated.size(), overlong.size());
+    EXPECT_GT(truncated.size(), long_line.size());
+    EXPECT_EQ(truncated.substr(truncated.size() - 3), "...");
+    EXPECT_EQ(truncated.find_first_not_of('y'), truncated.size() - 3);
+    EXPECT_NE(lines[2].find("[INFO]"), std::string::npos);
+}
+
+TEST(AsyncLoggerTest, FlushWritesEarlierLines) {
+    capture_file info, error;
+    auto options = options_for(info, error, log_overflow_policy::block);
+    options.flush_interval = std::chrono::seconds{10};
+    async_logger logger(options);
+
+    logger.log(log_level::info, "before flush");
+    logger.log(log_level::error, "an error");
+    logger.flush();
+
+    const auto out = info.lines();
+    ASSERT_EQ(out.size(), 1u);
+    EXPECT_EQ(message_of(out[0]), "before flush");
+    const auto err = error.lines();
+    ASSERT_EQ(err.size(), 1u);
+    EXPECT_NE(err[0].find(" [ERROR] an error"), std::string::npos);
+}
+
+TEST(AsyncLoggerTest, StructuredRecordsAreFormattedByTheFlusher) {
+    capture_file info, error;
+    {
+        async_logger logger(options_for(info, error, log_overflow_policy::block));
+        cppsim::server::log_record_builder record(cppsim::server::log_id::session_unregistered);
+        record.add_session(0xabcULL);
+        record.add_uint(2);
+        EXPECT_TRUE(logger.log_record(log_level::info, record.view()));
+        logger.log(log_level::info, "plain");
+        logger.stop();
+    }
+
+    const auto lines = info.lines();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(message_of(lines[0]), "[ConnectionManager] Unregistered session: sess_0000000000000abc (remaining: 2)");
+    EXPECT_EQ(message_of(lines[1]), "plain");
+}
+
+TEST(AsyncLoggerTest, StoppedLoggerRefusesLines) {
+    capture_file info, error;
+    async_logger logger(options_for(info, error, log_overflow_policy::drop));
+    logger.stop();
+    logger.stop();
+    EXPECT_FALSE(logger.log(log_level::info, "too late"));
+    logger.flush();
+    EXPECT_TRUE(info.lines().empty());
+}
@@ -0,0 +1,242 @@
+#include "server/async_logger.hpp"
+#include "server/binary_log.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using cppsim::server::append_log_entry_text;
+using cppsim::server::async_log_options;
+using cppsim::server::async_logger;
+using cppsim::server::binary_log_entry;
+using cppsim::server::binary_log_reader;
+using cppsim::server::binary_log_writer;
+using cppsim::server::log_entry_filter;
+using cppsim::server::log_entry_kind;
+using cppsim::server::log_id;
+using cppsim::server::log_level;
+using cppsim::server::log_record_builder;
+using cppsim::server::parse_log_time;
+
+namespace {
+
+// A fresh directory under the system temp dir, removed afterwards.
+class BinaryLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        dir_ = std::filesystem::temp_directory_path() / (std::string("cppsim_binary_log_") + info->name());
+        std::filesystem::remove_all(dir_);
+        std::filesystem::create_directories(dir_);
+    }
+    void TearDown() override { std::filesystem::remove_all(dir_); }
+
+    [[nodiscard]] std::string path(const std::string& name) const { return (dir_ / name).string(); }
+
+    std::filesystem::path dir_;
+};
+
+struct decoded {
+    int64_t timestamp_ns;
+    log_level level;
+    log_entry_kind kind;
+    std::string payload;
+};
+
+std::vector<decoded> read_all(const std::string& file, std::string* error = nullptr) {
+    std::vector<decoded> out;
+    binary_log_reader reader(file);
+    binary_log_entry entry;
+    while (reader.next(entry)) {
+        out.push_back({entry.timestamp_ns, entry.level, entry.kind, std::string(entry.payload)});
+    }
+    if (error) *error = reader.error();
+    return out;
+}
+
+std::string session_record(log_id id, uint64_t handle, uint64_t count) {
+    log_record_builder record(id);
+    record.add_session(handle);
+    record.add_uint(count);
+    return std::string(record.view());
+}
+
+constexpr int64_t T0 = 1'700'000'000'000'000'000;
+
+}  // namespace
+
+TEST_F(BinaryLogTest, RoundTripsTextAndRecords) {
+    const std::string file = path("server.plog");
+    const std::string record = session_record(log_id::session_registered, 0x42, 1);
+    {
+        binary_log_writer writer(file, 1 << 20, 2);
+        writer.append(T0, log_level::info, log_entry_kind::text, "plain line");
+        writer.append(T0 + 5'000, log_level::info, log_entry_kind::record, record);
+        // Timestamps from different threads need not be monotonic.
+        writer.append(T0 + 1'000, log_level::error, log_entry_kind::text, "");
+        ASSERT_TRUE(writer.flush());
+        writer.append(T0 + 2'000'000'000, log_level::debug, log_entry_kind::text, std::string(300, 'x'));
+    }
+
+    std::string error;
+    const auto entries = read_all(file, &error);
+    EXPECT_TRUE(error.empty()) << error;
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries[0].timestamp_ns, T0);
+    EXPECT_EQ(entries[0].payload, "plain line");
+    EXPECT_EQ(entries[1].timestamp_ns, T0 + 5'000);
+    EXPECT_EQ(entries[1].kind, log_entry_kind::record);
+    EXPECT_EQ(entries[1].payload, record);
+    EXPECT_EQ(entries[2].timestamp_ns, T0 + 1'000);
+    EXPECT_EQ(entries[2].level, log_level::error);
+    EXPECT_EQ(entries[3].timestamp_ns, T0 + 2'000'000'000);
+    EXPECT_EQ(entries[3].level, log_level::debug);
+    EXPECT_EQ(entries[3].payload, std::string(300, 'x'));
+
+    binary_log_entry entry{entries[1].timestamp_ns, entries[1].level, entries[1].kind, entries[1].payload};
+    std::string text;
+    append_log_entry_text(entry, text);
+    EXPECT_EQ(text, "2023-11-14 22:13:20.000 [INFO] [ConnectionManager] Registered session: sess_0000000000000042 "
+                    "(total: 1)\n");
+}
+
+TEST_F(BinaryLogTest, RotatesAndKeepsOnlyTheNewestFiles) {
+    const std::string file = path("server.plog");
+    constexpr int BATCHES = 20;
+    {
+        binary_log_writer writer(file, 256, 2);
+        for (int b = 0; b < BATCHES; ++b) {
+            for (int i = 0; i < 4; ++i) {
+                writer.append(T0 + b * 1000 + i, log_level::info, log_entry_kind::text,
+                              "batch " + std::to_string(b) + " line " + std::to_string(i));
+            }
+            ASSERT_TRUE(writer.flush());
+        }
+    }
+
+    EXPECT_TRUE(std::filesystem::exists(file + ".1"));
+    EXPECT_TRUE(std::filesystem::exists(file + ".2"));
+    EXPECT_FALSE(std::filesystem::exists(file + ".3"));
+
+    // Oldest first, each file decodes on its own and the timestamps carry on.
+    std::vector<decoded> all;
+    for (const auto& f : {file + ".2", file + ".1", file}) {
+        std::string error;
+        auto entries = read_all(f, &error);
+        EXPECT_TRUE(error.empty()) << f << ": " << error;
+        EXPECT_LE(std::filesystem::file_size(f), 256u);
+        all.insert(all.end(), entries.begin(), entries.end());
+    }
+    ASSERT_FALSE(all.empty());
+    ASSERT_EQ(all.size() % 4, 0u);
+    const int first_batch = BATCHES - static_cast<int>(all.size() / 4);
+    for (size_t i = 0; i < all.size(); ++i) {
+        const int b = first_batch + static_cast<int>(i / 4);
+        EXPECT_EQ(all[i].timestamp_ns, T0 + b * 1000 + static_cast<int64_t>(i % 4));
+        EXPECT_EQ(all[i].payload, "batch " + std::to_string(b) + " line " + std::to_string(i % 4));
+    }
+
+    // A new writer moves the previous run's file aside rather than appending.
+    { binary_log_writer writer(file, 256, 2); }
+    EXPECT_FALSE(std::filesystem::exists(file));
+    EXPECT_TRUE(std::filesystem::exists(file + ".1"));
+}
+
+TEST_F(BinaryLogTest, ReportsCorruptAndForeignFiles) {
+    const std::string file = path("server.plog");
+    {
+        binary_log_writer writer(file, 1 << 20, 0);
+        writer.append(T0, log_level::info, log_entry_kind::text, "first");
+        writer.append(T0 + 1, log_level::info, log_entry_kind::text, "second entry");
+    }
+    std::filesystem::resize_file(file, std::filesystem::file_size(file) - 3);
+
+    std::string error;
+    const auto entries = read_all(file, &error);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].payload, "first");
+    EXPECT_NE(error.find("truncated"), std::string::npos) << error;
+
+    const std::string text_file = path("text.log");
+    std::ofstream(text_file) << "2024-01-01 00:00:00.000 [INFO] hello\n";
+    read_all(text_file, &error);
+    EXPECT_NE(error.find("not a binary log"), std::string::npos) << error;
+
+    read_all(path("missing.plog"), &error);
+    EXPECT_FALSE(error.empty());
+}
+
+TEST_F(BinaryLogTest, FilterBySessionTimeAndLevel) {
+    const std::string record = session_record(log_id::session_unregistered, 0xabc, 0);
+    const binary_log_entry structured{T0, log_level::info, log_entry_kind::record, record};
+    const binary_log_entry text{T0 + 10, log_level::error, log_entry_kind::text,
+                                "[WebSocketSession] Failed to register sess_0000000000000abc"};
+    const binary_log_entry other{T0 + 20, log_level::info, log_entry_kind::text, "[Main] Server running"};
+
+    log_entry_filter any;
+    EXPECT_TRUE(any.matches(structured));
+    EXPECT_TRUE(any.matches(other));
+
+    log_entry_filter by_session;
+    by_session.session = 0xabc;
+    EXPECT_TRUE(by_session.matches(structured));
+    EXPECT_TRUE(by_session.matches(text));
+    EXPECT_FALSE(by_session.matches(other));
+    by_session.session = 0xabd;
+    EXPECT_FALSE(by_session.matches(structured));
+
+    log_entry_filter by_time;
+    by_time.since_ns = T0 + 10;
+    by_time.until_ns = T0 + 20;
+    EXPECT_FALSE(by_time.matches(structured));
+    EXPECT_TRUE(by_time.matches(text));
+    EXPECT_FALSE(by_time.matches(other));
+
+    log_entry_filter errors_only;
+    errors_only.min_level = log_level::error;
+    EXPECT_FALSE(errors_only.matches(structured));
+    EXPECT_TRUE(errors_only.matches(text));
+}
+
+TEST_F(BinaryLogTest, ParsesTimes) {
+    EXPECT_EQ(parse_log_time("1700000000"), T0);
+    EXPECT_EQ(parse_log_time("2023-11-14T22:13:20"), T0);
+    EXPECT_EQ(parse_log_time("2023-11-14 22:13:20.250"), T0 + 250'000'000);
+    EXPECT_FALSE(parse_log_time(""));
+    EXPECT_FALSE(parse_log_time("-5"));
+    EXPECT_FALSE(parse_log_time("2023-13-14T22:13:20"));
+    EXPECT_FALSE(parse_log_time("2023-11-14T22:13"));
+    EXPECT_FALSE(parse_log_time("2023-11-14T22:13:20.5"));
+}
+
+TEST_F(BinaryLogTest, AsyncLoggerWritesEntriesToTheBinaryLog) {
+    const std::string file = path("server.plog");
+    std::FILE* info = std::tmpfile();
+    std::FILE* error = std::tmpfile();
+    ASSERT_TRUE(info && error);
+    {
+        async_log_options options;
+        options.info_stream = info;
+        options.error_stream = error;
+        options.binary_path = file;
+        async_logger logger(options);
+        const std::string record = session_record(log_id::session_registered, 7, 3);
+        logger.log_record(log_level::info, record);
+        logger.log(log_level::error, "something failed");
+        logger.stop();
+    }
+
+    const auto entries = read_all(file);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].kind, log_entry_kind::record);
+    EXPECT_EQ(entries[1].payload, "something failed");
+
+    // Errors are also written to the console as text; nothing else is.
+    EXPECT_EQ(std::ftell(info), 0);
+    EXPECT_GT(std::ftell(error), 0);
+    std::fclose(info);
+    std::fclose(error);
+}
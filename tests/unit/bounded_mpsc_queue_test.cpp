@@ -0,0 +1,86 @@
+#include "server/bounded_mpsc_queue.hpp"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using cppsim::server::bounded_mpsc_queue;
+
+TEST(BoundedMpscQueueTest, FifoOrder) {
+    bounded_mpsc_queue<std::string> queue(4);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_TRUE(queue.try_push("a"));
+    EXPECT_TRUE(queue.try_push("b"));
+    EXPECT_FALSE(queue.empty());
+
+    std::string out;
+    ASSERT_TRUE(queue.try_pop(out));
+    EXPECT_EQ(out, "a");
+    ASSERT_TRUE(queue.try_pop(out));
+    EXPECT_EQ(out, "b");
+    EXPECT_FALSE(queue.try_pop(out));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(BoundedMpscQueueTest, EnforcesExactLimit) {
+    // A non-power-of-two limit must still be honoured exactly (the ring
+    // itself rounds up to 128 cells).
+    bounded_mpsc_queue<std::string> queue(100);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(queue.try_push(std::to_string(i)));
+    }
+    std::string rejected = "overflow";
+    EXPECT_FALSE(queue.try_push(std::move(rejected)));
+    EXPECT_EQ(queue.size(), 100u);
+
+    // Popping frees a slot again, and the ring wraps correctly.
+    std::string out;
+    for (int round = 0; round < 300; ++round) {
+        ASSERT_TRUE(queue.try_pop(out));
+        ASSERT_TRUE(queue.try_push("wrap"));
+    }
+    EXPECT_EQ(queue.size(), 100u);
+}
+
+TEST(BoundedMpscQueueTest, ConcurrentProducersDeliverEveryItemOnce) {
+    constexpr int num_producers = 4;
+    constexpr int items_per_producer = 10000;
+    bounded_mpsc_queue<std::string> queue(64);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < items_per_producer; ++i) {
+                std::string item = std::to_string(p) + ":" + std::to_string(i);
+                while (!queue.try_push(std::move(item))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Per-producer order must be preserved even though producers interleave.
+    std::vector<int> next_expected(num_producers, 0);
+    int received = 0;
+    std::string out;
+    while (received < num_producers * items_per_producer) {
+        if (!queue.try_pop(out)) {
+            std::this_thread::yield();
+            continue;
+        }
+        auto colon = out.find(':');
+        int p = std::stoi(out.substr(0, colon));
+        int i = std::stoi(out.substr(colon + 1));
+        // EXPECT, not ASSERT: returning early would leave the producers
+        // joinable and std::terminate the whole binary.
+        EXPECT_EQ(i, next_expected[static_cast<size_t>(p)]);
+        next_expected[static_cast<size_t>(p)] = i + 1;
+        ++received;
+    }
+
+    for (auto& t : producers) t.join();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.size(), 0u);
+}
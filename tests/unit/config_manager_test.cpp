@@ -1,4 +1,5 @@
 #include "server/runtime_config_manager.hpp"
+#include "server/config.hpp"
 #include "server/metrics_collector.hpp"
 
 #include <gtest/gtest.h>
@@ -200,6 +201,111 @@ TEST_F(ConfigManagerTest, ConfigValidation) {
     ASSERT_FALSE(config.load_from_file(config_file_.string()));
 }
 
+TEST_F(ConfigManagerTest, IoThreadsConfig) {
+    auto& config = runtime_config_manager::instance();
+
+    nlohmann::json threads_config = {{"io_threads", 8}};
+    std::ofstream config_file(config_file_);
+    config_file << threads_config.dump(2);
+    config_file.close();
+
+    ASSERT_TRUE(config.load_from_file(config_file_.string()));
+    EXPECT_EQ(config.get_io_threads(), 8u);
+
+    // Out-of-range values fall back to the default (0 = hardware concurrency)
+    nlohmann::json invalid_config = {{"io_threads", -1}};
+    std::ofstream config_file2(config_file_);
+    config_file2 << invalid_config.dump(2);
+    config_file2.close();
+
+    ASSERT_TRUE(config.load_from_file(config_file_.string()));
+    EXPECT_EQ(config.get_io_threads(), 0u);
+}
+
+TEST_F(ConfigManagerTest, RateLimitCostsConfig) {
+    auto& config = runtime_config_manager::instance();
+
+    nlohmann::json costs_config = {
+        {"max_messages_per_window", 20},
+        {"rate_limit_costs", {{"RELOAD_REQUEST", 5}, {"ACTION", 50}, {"BOGUS", 2}}}
+    };
+    std::ofstream config_file(config_file_);
+    config_file << costs_config.dump(2);
+    config_file.close();
+
+    ASSERT_TRUE(config.load_from_file(config_file_.string()));
+    auto costs = config.get_rate_limit_costs();
+    EXPECT_EQ(costs.reload_request, 5u);
+    // Costs above max_messages_per_window fall back to the default.
+    EXPECT_EQ(costs.action, config::RATE_COST_ACTION);
+    EXPECT_EQ(costs.handshake, config::RATE_COST_HANDSHAKE);
+
+    auto exported = nlohmann::json::parse(config.export_to_json());
+    EXPECT_EQ(exported["rate_limit_costs"]["RELOAD_REQUEST"], 5);
+}
+
+TEST_F(ConfigManagerTest, RateLimitCostsNeverExceedWindow) {
+    auto& config = runtime_config_manager::instance();
+
+    nlohmann::json tiny_window = {
+        {"max_messages_per_window", 1},
+        {"rate_limit_costs", {{"ACTION", 3}}}
+    };
+    std::ofstream config_file(config_file_);
+    config_file << tiny_window.dump(2);
+    config_file.close();
+
+    ASSERT_TRUE(config.load_from_file(config_file_.string()));
+    auto costs = config.get_rate_limit_costs();
+    // Neither the default RELOAD_REQUEST cost nor a fallback may exceed the window.
+    EXPECT_EQ(costs.reload_request, 1u);
+    EXPECT_EQ(costs.action, 1u);
+    EXPECT_EQ(costs.handshake, 1u);
+}
+
+TEST_F(ConfigManagerTest, SnapshotsAndChangeListeners) {
+    auto& config = runtime_config_manager::instance();
+
+    auto write_config = [this](const nlohmann::json& j) {
+        std::ofstream config_file(config_file_);
+        config_file << j.dump(2);
+    };
+
+    write_config({{"max_sequence_gap", 500}});
+    ASSERT_TRUE(config.load_from_file(config_file_.string()));
+    const config_snapshot* before = config.snapshot();
+    ASSERT_NE(before, nullptr);
+    EXPECT_EQ(before->max_sequence_gap, 500);
+
+    int notified = 0;
+    uint64_t notified_version = 0;
+    size_t id = config.add_change_listener([&](const config_snapshot& snap) {
+        ++notified;
+        notified_version = snap.version;
+    });
+
+    // Reloading identical values publishes nothing.
+    ASSERT_TRUE(config.load_from_file(config_file_.string()));
+    EXPECT_EQ(config.snapshot(), before);
+    EXPECT_EQ(notified, 0);
+
+    write_config({{"max_sequence_gap", 600}});
+    ASSERT_TRUE(config.load_from_file(config_file_.string()));
+    const config_snapshot* after = config.snapshot();
+    EXPECT_NE(after, before);
+    EXPECT_EQ(after->version, before->version + 1);
+    EXPECT_EQ(config.get_max_sequence_gap(), 600);
+    EXPECT_EQ(notified, 1);
+    EXPECT_EQ(notified_version, after->version);
+    // A cached pointer stays valid and keeps the values it was published with.
+    EXPECT_EQ(before->max_sequence_gap, 500);
+
+    config.remove_change_listener(id);
+    write_config({{"max_sequence_gap", 700}});
+    ASSERT_TRUE(config.load_from_file(config_file_.string()));
+    EXPECT_EQ(notified, 1);
+}
+
 // Metrics Collector Tests
 class MetricsCollectorTest : public ::testing::Test {
 protected:
@@ -372,4 +478,85 @@ TEST_F(MetricsCollectorTest, ThreadSafety) {
     
     std::string json_export = metrics_collector::export_metrics();
     EXPECT_FALSE(json_export.empty());
-}
\ No newline at end of file
+}
+
+TEST_F(MetricsCollectorTest, HandlesShareStorageWithNamesAndSurviveReset) {
+    const auto counter = metrics_collector::register_counter("handle_counter");
+    const auto gauge = metrics_collector::register_gauge("handle_gauge");
+    const auto timing = metrics_collector::register_timing("handle_timing");
+
+    // Registered metrics are exported before their first update.
+    nlohmann::json exported = nlohmann::json::parse(metrics_collector::export_metrics());
+    EXPECT_EQ(exported["counters"]["handle_counter"], 0);
+    EXPECT_DOUBLE_EQ(exported["gauges"]["handle_gauge"], 0.0);
+    EXPECT_EQ(exported["timings"]["handle_timing"]["count"], 0);
+
+    counter.add(3);
+    metrics_collector::increment_counter("handle_counter", 2);
+    EXPECT_EQ(counter.value(), 5);
+    EXPECT_EQ(metrics_collector::get_counter("handle_counter"), 5);
+    EXPECT_EQ(metrics_collector::register_counter("handle_counter").value(), 5);
+
+    gauge.set(7.5);
+    EXPECT_DOUBLE_EQ(metrics_collector::get_gauge("handle_gauge"), 7.5);
+
+    timing.record(std::chrono::milliseconds(10));
+    metrics_collector::record_timing("handle_timing", std::chrono::milliseconds(30));
+    exported = nlohmann::json::parse(metrics_collector::export_metrics());
+    EXPECT_EQ(exported["timings"]["handle_timing"]["count"], 2);
+    EXPECT_EQ(exported["timings"]["handle_timing"]["sum_us"], 40000);
+    EXPECT_EQ(exported["timings"]["handle_timing"]["min_us"], 10000);
+    EXPECT_EQ(exported["timings"]["handle_timing"]["max_us"], 30000);
+
+    metrics_collector::reset();
+    EXPECT_EQ(counter.value(), 0);
+    EXPECT_DOUBLE_EQ(gauge.value(), 0.0);
+    counter.add();
+    EXPECT_EQ(metrics_collector::get_counter("handle_counter"), 1);
+    exported = nlohmann::json::parse(metrics_collector::export_metrics());
+    EXPECT_EQ(exported["counters"]["handle_counter"], 1);
+    EXPECT_EQ(exported["timings"]["handle_timing"]["count"], 0);
+}
+
+TEST_F(MetricsCollectorTest, HandleUpdatesFromManyThreadsAddUp) {
+    const auto counter = metrics_collector::register_counter("handle_thread_counter");
+    const auto timing = metrics_collector::register_timing("handle_thread_timing");
+    constexpr int THREADS = 24;  // More than there are stripes.
+    constexpr int OPS = 5000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&counter, &timing, t] {
+            for (int i = 0; i < OPS; ++i) {
+                counter.add();
+                timing.record(std::chrono::microseconds(t));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(counter.value(), THREADS * OPS);
+    const nlohmann::json exported = nlohmann::json::parse(metrics_collector::export_metrics());
+    const auto& stats = exported["timings"]["handle_thread_timing"];
+    EXPECT_EQ(stats["count"], THREADS * OPS);
+    EXPECT_EQ(stats["min_us"], 0);
+    EXPECT_EQ(stats["max_us"], THREADS - 1);
+    // Every value is below 64 us, where buckets are exact.
+    EXPECT_EQ(stats["p50_us"], THREADS / 2 - 1);
+    EXPECT_EQ(stats["p999_us"], THREADS - 1);
+}
+
+TEST_F(MetricsCollectorTest, ErrorCountersAreCreatedOncePerType) {
+    for (int i = 0; i < 3; ++i) {
+        metrics_collector::record_error("repeat_error");
+    }
+    EXPECT_EQ(metrics_collector::get_counter("errors.repeat_error"), 3);
+    EXPECT_EQ(metrics_collector::get_counter("errors.total"), 3);
+
+    metrics_collector::reset();
+    nlohmann::json exported = nlohmann::json::parse(metrics_collector::export_metrics());
+    EXPECT_FALSE(exported["counters"].contains("errors.repeat_error"));
+    metrics_collector::record_error("repeat_error");
+    exported = nlohmann::json::parse(metrics_collector::export_metrics());
+    EXPECT_EQ(exported["counters"]["errors.repeat_error"], 1);
+}
@@ -0,0 +1,91 @@
+#include "server/latency_histogram.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using cppsim::server::histogram_snapshot;
+using cppsim::server::latency_histogram;
+namespace layout = cppsim::server::histogram_layout;
+
+TEST(LatencyHistogramTest, BucketsAreContiguousAndTight) {
+    EXPECT_EQ(layout::bucket_index(0), 0u);
+    EXPECT_EQ(layout::bucket_index(63), 63u);
+    EXPECT_EQ(layout::bucket_index(layout::MAX_VALUE), layout::BUCKETS - 1);
+    EXPECT_EQ(layout::bucket_index(layout::MAX_VALUE + 1000), layout::BUCKETS - 1);
+    EXPECT_EQ(layout::bucket_highest(layout::BUCKETS - 1), layout::MAX_VALUE);
+
+    uint64_t next_lowest = 0;
+    for (size_t i = 0; i < layout::BUCKETS; ++i) {
+        const uint64_t highest = layout::bucket_highest(i);
+        ASSERT_GE(highest, next_lowest) << i;
+        EXPECT_EQ(layout::bucket_index(next_lowest), i);
+        EXPECT_EQ(layout::bucket_index(highest), i);
+        // Width relative to the bucket's values stays within 1/64.
+        EXPECT_LE((highest - next_lowest + 1) * layout::SUB_BUCKETS, next_lowest + layout::SUB_BUCKETS) << i;
+        next_lowest = highest + 1;
+    }
+}
+
+TEST(LatencyHistogramTest, PercentilesCoverEveryRecordedValue) {
+    latency_histogram histogram;
+    for (uint64_t us = 1; us <= 100000; ++us) {
+        histogram.record(us);
+    }
+    histogram_snapshot snapshot;
+    histogram.add_to(snapshot);
+    EXPECT_EQ(snapshot.total, 100000u);
+
+    const auto near = [](uint64_t actual, uint64_t expected) {
+        return actual >= expected && actual <= expected + expected / layout::SUB_BUCKETS;
+    };
+    EXPECT_TRUE(near(snapshot.value_at_percentile(50.0), 50000)) << snapshot.value_at_percentile(50.0);
+    EXPECT_TRUE(near(snapshot.value_at_percentile(99.0), 99000)) << snapshot.value_at_percentile(99.0);
+    EXPECT_TRUE(near(snapshot.value_at_percentile(99.9), 99900)) << snapshot.value_at_percentile(99.9);
+    EXPECT_TRUE(near(snapshot.value_at_percentile(100.0), 100000)) << snapshot.value_at_percentile(100.0);
+    EXPECT_EQ(snapshot.value_at_percentile(0.0), 1u);
+
+    histogram.clear();
+    histogram_snapshot empty;
+    histogram.add_to(empty);
+    EXPECT_EQ(empty.total, 0u);
+    EXPECT_EQ(empty.value_at_percentile(99.0), 0u);
+}
+
+TEST(LatencyHistogramTest, SnapshotsMerge) {
+    latency_histogram fast, slow;
+    for (int i = 0; i < 990; ++i) fast.record(10);
+    for (int i = 0; i < 10; ++i) slow.record(5000000);
+
+    histogram_snapshot a, b;
+    fast.add_to(a);
+    slow.add_to(b);
+    a.merge(b);
+    EXPECT_EQ(a.total, 1000u);
+    EXPECT_EQ(a.value_at_percentile(99.0), 10u);
+    EXPECT_GE(a.value_at_percentile(99.9), 5000000u);
+
+    // add_to() on several histograms merges them just the same.
+    histogram_snapshot c;
+    fast.add_to(c);
+    slow.add_to(c);
+    EXPECT_EQ(c.counts, a.counts);
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecordsAreAllCounted) {
+    latency_histogram histogram;
+    constexpr int THREADS = 8;
+    constexpr int RECORDS = 20000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&histogram] {
+            for (int i = 0; i < RECORDS; ++i) histogram.record(static_cast<uint64_t>(i % 200));
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    histogram_snapshot snapshot;
+    histogram.add_to(snapshot);
+    EXPECT_EQ(snapshot.total, static_cast<uint64_t>(THREADS * RECORDS));
+}
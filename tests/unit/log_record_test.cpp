@@ -0,0 +1,89 @@
+#include "server/log_record.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+
+using cppsim::server::format_log_record;
+using cppsim::server::INVALID_SESSION_HANDLE;
+using cppsim::server::log_field;
+using cppsim::server::log_id;
+using cppsim::server::log_level;
+using cppsim::server::log_record_builder;
+using cppsim::server::log_session;
+using cppsim::server::LOG_STRING_ARG_MAX;
+
+namespace {
+
+template <typename... Args>
+std::string format(log_id id, const Args&... args) {
+    log_record_builder record(id);
+    (cppsim::server::add_log_arg(record, args), ...);
+    std::string out;
+    EXPECT_TRUE(format_log_record(record.view(), out));
+    return out;
+}
+
+}  // namespace
+
+TEST(LogRecordTest, FormatsTypedArguments) {
+    EXPECT_EQ(format(log_id::session_registered, log_session{0x1234abcd5678ef90ULL}, size_t{7}),
+              "[ConnectionManager] Registered session: sess_1234abcd5678ef90 (total: 7)");
+    EXPECT_EQ(format(log_id::sequence_not_increasing, int64_t{-5}, int64_t{-1}),
+              "[WebSocketSession] Invalid sequence number -5 (expected > -1)");
+    EXPECT_EQ(format(log_id::sequence_gap, int64_t{900}, uint64_t{UINT64_MAX}, 100),
+              "[WebSocketSession] Sequence number too far ahead: 900 (gap: 18446744073709551615, max allowed: 100)");
+    EXPECT_EQ(format(log_id::state_resync, log_session{INVALID_SESSION_HANDLE}, int64_t{3}, "requested"),
+              "[WebSocketSession] State resync for (unauthenticated) (acked 3, requested)");
+    EXPECT_EQ(format(log_id::sessions_stopped, 0), "[ConnectionManager] Stopped 0 session(s).");
+}
+
+TEST(LogRecordTest, LongStringsAreCutAndMarked) {
+    const std::string long_text(1000, 'z');
+    EXPECT_EQ(format(log_id::handler_exception, long_text),
+              "[WebSocketSession] Unhandled exception in message handler: " + std::string(LOG_STRING_ARG_MAX, 'z') +
+                  "...");
+    EXPECT_EQ(format(log_id::client_name, log_field{"abcdefghij", 4}), "[WebSocketSession] Client Name: abcd...");
+    EXPECT_EQ(format(log_id::client_name, log_field{"abcd", 4}), "[WebSocketSession] Client Name: abcd");
+    EXPECT_EQ(format(log_id::client_name, std::string()), "[WebSocketSession] Client Name: ");
+}
+
+TEST(LogRecordTest, RejectsMalformedRecords) {
+    log_record_builder record(log_id::read_error);
+    record.add_session(42);
+    record.add_string("End of file");
+    const std::string bytes(record.view());
+
+    std::string out;
+    ASSERT_TRUE(format_log_record(bytes, out));
+    for (size_t cut = 0; cut < bytes.size(); ++cut) {
+        out.clear();
+        EXPECT_FALSE(format_log_record(bytes.substr(0, cut), out)) << cut;
+    }
+    out.clear();
+    EXPECT_FALSE(format_log_record(bytes + "x", out));
+
+    // Too few arguments for the template.
+    log_record_builder short_record(log_id::read_error);
+    short_record.add_session(42);
+    out.clear();
+    EXPECT_FALSE(format_log_record(short_record.view(), out));
+
+    // Unknown template ID.
+    std::string unknown = bytes;
+    unknown[0] = '\xff';
+    unknown[1] = '\xff';
+    out.clear();
+    EXPECT_FALSE(format_log_record(unknown, out));
+}
+
+TEST(LogRecordTest, LinesBelowTheMinimumLevelAreCompiledOut) {
+    testing::internal::CaptureStdout();
+    cppsim::server::log<log_id::action_validated>(log_session{1}, "FOLD", int64_t{1});
+    cppsim::server::log<log_id::sessions_stopped>(3);
+    const std::string out = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(out.find("[INFO] [ConnectionManager] Stopped 3 session(s)."), std::string::npos) << out;
+    const bool debug_enabled = cppsim::server::LOG_MIN_LEVEL <= log_level::debug;
+    EXPECT_EQ(out.find("Validated ACTION") != std::string::npos, debug_enabled) << out;
+}
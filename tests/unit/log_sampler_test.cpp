@@ -0,0 +1,77 @@
+#include "server/log_sampler.hpp"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using cppsim::server::log_sampler;
+using namespace std::chrono_literals;
+
+TEST(LogSamplerTest, AdmitsBurstThenSamples) {
+    log_sampler sampler(3, 10, 1s);
+    const auto now = log_sampler::clock::now();
+    uint64_t suppressed = 99;
+
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(sampler.admit(now, suppressed)) << "event " << i;
+        EXPECT_EQ(suppressed, 0u);
+    }
+    for (int i = 0; i < 9; ++i) {
+        EXPECT_FALSE(sampler.admit(now, suppressed)) << "event " << i;
+    }
+    EXPECT_EQ(sampler.pending_suppressed(), 9u);
+
+    // The tenth event past the burst is admitted and reports the drops.
+    ASSERT_TRUE(sampler.admit(now, suppressed));
+    EXPECT_EQ(suppressed, 9u);
+    EXPECT_EQ(sampler.pending_suppressed(), 0u);
+}
+
+TEST(LogSamplerTest, NewWindowRestoresBurst) {
+    log_sampler sampler(2, 1000, 1s);
+    auto now = log_sampler::clock::now();
+    uint64_t suppressed = 0;
+
+    ASSERT_TRUE(sampler.admit(now, suppressed));
+    ASSERT_TRUE(sampler.admit(now, suppressed));
+    EXPECT_FALSE(sampler.admit(now, suppressed));
+    EXPECT_FALSE(sampler.admit(now + 500ms, suppressed));
+
+    now += 1s;
+    ASSERT_TRUE(sampler.admit(now, suppressed));
+    EXPECT_EQ(suppressed, 2u);
+    EXPECT_TRUE(sampler.admit(now, suppressed));
+    EXPECT_EQ(suppressed, 0u);
+}
+
+TEST(LogSamplerTest, AccountsForEveryEventAcrossThreads) {
+    constexpr int THREADS = 8;
+    static constexpr int PER_THREAD = 10000;
+    // A window that never rolls over, so the expected counts are exact.
+    log_sampler sampler(5, 100, log_sampler::clock::duration::max());
+    const auto now = log_sampler::clock::now();
+
+    std::atomic<uint64_t> admitted{0};
+    std::atomic<uint64_t> reported{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&sampler, &admitted, &reported, now]() {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                uint64_t suppressed = 0;
+                if (sampler.admit(now, suppressed)) {
+                    ++admitted;
+                    reported += suppressed;
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    // One window: 5 burst events plus one in 100 of the rest.
+    constexpr uint64_t TOTAL = THREADS * PER_THREAD;
+    EXPECT_EQ(admitted.load(), 5 + (TOTAL - 5) / 100);
+    EXPECT_EQ(admitted.load() + reported.load() + sampler.pending_suppressed(), TOTAL);
+}
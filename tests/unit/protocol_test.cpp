@@ -1,7 +1,13 @@
 #include "common/protocol.hpp"
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
 #include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 using namespace cppsim::protocol;
 
@@ -971,3 +977,620 @@ TEST(ProtocolTest, EmptyPayloadProtocolVersion) {
 // The InfinityAmount and NanAmount tests above validate the end-to-end
 // behavior (parse rejects them), but the specific rejection reason differs
 // from what one might expect ("requires amount" vs "invalid amount").
+
+namespace {
+
+// Reference result for the ACTION fast path: the DOM path the session used
+// before it, with the same status classification.
+fast_parse_status dom_action_status(const std::string& frame, std::optional<action_message>& out) {
+  auto header = extract_message_type_and_json(frame);
+  if (!header) return fast_parse_status::malformed;
+  if (header->message_type != message_types::ACTION) return fast_parse_status::not_action;
+  out = parse_action_from_envelope(header->envelope_json);
+  return out ? fast_parse_status::ok : fast_parse_status::rejected;
+}
+
+std::string action_frame(const std::string& payload_members) {
+  return std::string(R"({"message_type":"ACTION","protocol_version":"v1.0","payload":{)") + payload_members + "}}";
+}
+
+}  // namespace
+
+// Test: the ACTION fast path agrees with the DOM path on every frame it decides
+TEST(ProtocolTest, ActionFastPathMatchesDomPath) {
+  const std::string sid = R"("session_id":"sess_0123456789abcdef")";
+  const std::vector<std::string> frames = {
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"RAISE","amount":500,"sequence_number":2)"),
+      action_frame(sid + R"(,"action_type":"ALL_IN","amount":1000000000000000,"sequence_number":0)"),
+      action_frame(sid + R"(,"action_type":"CALL","amount":null,"sequence_number":3)"),
+      action_frame(R"("sequence_number":9,"amount":7,"action_type":"RAISE",)" + sid),
+      action_frame(sid + R"(,"action_type":"CHECK","sequence_number":4,"extra":{"a":[1,2.5,true,null,"x\n"]})"),
+      " \n\t" + action_frame(sid + R"(,"action_type":"FOLD","sequence_number":5)") + " \r\n",
+      R"({"payload":{"session_id":"sess_ab","action_type":"FOLD","sequence_number":6},"protocol_version":"v1.0","message_type":"ACTION","x":"é"})",
+      // Rejections.
+      "",
+      "not json",
+      "[1,2,3]",
+      "{}",
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1)") + "x",
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1,)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":-1)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":"1")"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":null)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":18446744073709551615)"),
+      action_frame(sid + R"(,"action_type":"FOLD")"),
+      action_frame(sid + R"(,"action_type":"FOLD","amount":5,"sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"RAISE","sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"RAISE","amount":0,"sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"RAISE","amount":-5,"sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"RAISE","amount":1000000000000001,"sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"RAISE","amount":"5","sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"JUMP","sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"","sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":7,"sequence_number":1)"),
+      action_frame(R"("session_id":"SESS_1","action_type":"FOLD","sequence_number":1)"),
+      action_frame(R"("session_id":"sess_","action_type":"FOLD","sequence_number":1)"),
+      action_frame(R"("action_type":"FOLD","sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1,"x":01)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1,"x":"\q")"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1,"x":"\xff")"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1,"x":"\xc0\xaf")"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1,"x":"\xed\xa0\x80")"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1,"x":tru)"),
+      action_frame(sid + std::string(R"(,"action_type":"FOLD","sequence_number":1,"x":"a)") + '\x01' + "\""),
+      R"({"message_type":"ACTION","protocol_version":"v2.0","payload":{"session_id":"sess_a","action_type":"FOLD","sequence_number":1}})",
+      R"({"message_type":"ACTION","protocol_version":1,"payload":{"session_id":"sess_a","action_type":"FOLD","sequence_number":1}})",
+      R"({"message_type":"ACTION","payload":{"session_id":"sess_a","action_type":"FOLD","sequence_number":1}})",
+      R"({"message_type":"ACTION","protocol_version":"v1.0","payload":[]})",
+      R"({"message_type":"ACTION","protocol_version":"v1.0"})",
+      R"({"message_type":5,"protocol_version":"v1.0","payload":{}})",
+      R"({"message_type":"ACTIONACTIONACTIONACTIONACTIONACTION","protocol_version":"v1.0","payload":{}})",
+      // Other message types.
+      R"({"message_type":"RELOAD_REQUEST","protocol_version":"v1.0","payload":{"session_id":"sess_a","requested_amount":5}})",
+      R"({"message_type":"DISCONNECT","protocol_version":"v1.0","payload":{}})",
+  };
+
+  for (const auto& frame : frames) {
+    SCOPED_TRACE(frame);
+    std::optional<action_message> dom;
+    const auto expected = dom_action_status(frame, dom);
+    action_message fast{};
+    const auto status = parse_action_fast(frame, fast);
+    ASSERT_NE(status, fast_parse_status::unsupported);
+    EXPECT_EQ(status, expected);
+    if (status == fast_parse_status::ok) {
+      ASSERT_TRUE(dom.has_value());
+      EXPECT_EQ(fast.session_id, dom->session_id);
+      EXPECT_EQ(fast.action_type, dom->action_type);
+      EXPECT_EQ(fast.amount, dom->amount);
+      EXPECT_EQ(fast.sequence_number, dom->sequence_number);
+    }
+  }
+}
+
+// Test: encodings only the DOM path reproduces are handed back to it
+TEST(ProtocolTest, ActionFastPathDefersUnusualEncodings) {
+  const std::string sid = R"("session_id":"sess_0123456789abcdef")";
+  const std::vector<std::string> frames = {
+      action_frame(R"("session_id":"sess_\u0061b","action_type":"FOLD","sequence_number":1)"),
+      action_frame(R"("session_id":"sess_a\/b","action_type":"FOLD","sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1.0)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":true)"),
+      action_frame(sid + R"(,"action_type":"RAISE","amount":10.57,"sequence_number":1)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1,"sequence_number":2)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":99999999999999999999)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1,"a\/b":1)"),
+      action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1,"x":"\u00e9")"),
+      "\xEF\xBB\xBF" + action_frame(sid + R"(,"action_type":"FOLD","sequence_number":1)"),
+  };
+  for (const auto& frame : frames) {
+    SCOPED_TRACE(frame);
+    action_message fast{};
+    EXPECT_EQ(parse_action_fast(frame, fast), fast_parse_status::unsupported);
+  }
+}
+
+// Test: malformed frames are rejected through the error logger, not by throwing
+TEST(ProtocolTest, MalformedFramesRejectWithoutThrowing) {
+  int logged = 0;
+  set_error_logger([&logged](std::string_view) { ++logged; });
+
+  const std::vector<std::string> frames = {
+      "",
+      "not json",
+      "{\"message_type\":",
+      "[1,2,3]",
+      R"({"message_type":"ACTION","protocol_version":"v1.0"})",
+      R"({"message_type":"ACTION","protocol_version":1,"payload":{}})",
+      R"({"message_type":"HANDSHAKE","payload":{}})",
+  };
+  for (const auto& frame : frames) {
+    SCOPED_TRACE(frame);
+    EXPECT_NO_THROW({
+      EXPECT_FALSE(parse_action(frame).has_value());
+      EXPECT_FALSE(parse_handshake(frame).has_value());
+    });
+  }
+  EXPECT_GE(logged, static_cast<int>(frames.size()));
+
+  set_error_logger([](std::string_view msg) {
+    std::fprintf(stderr, "%.*s\n", static_cast<int>(msg.size()), msg.data());
+  });
+}
+
+namespace {
+
+// What serialize_* produced before the direct writer: the to_json() envelope
+// dumped by nlohmann.
+template <typename Message>
+std::string dom_serialize(const Message& msg, const char* message_type,
+                          wire_encoding encoding = wire_encoding::json) {
+  message_envelope env;
+  env.message_type = message_type;
+  env.protocol_version = PROTOCOL_VERSION;
+  to_json(env.payload, msg);
+  nlohmann::json j;
+  to_json(j, env);
+  std::string out;
+  if (encoding == wire_encoding::cbor) {
+    nlohmann::json::to_cbor(j, out);
+  } else if (encoding == wire_encoding::msgpack) {
+    nlohmann::json::to_msgpack(j, out);
+  } else {
+    out = j.dump();
+  }
+  return out;
+}
+
+const std::vector<std::string> awkward_strings = {
+    "",
+    "plain",
+    "quote\" backslash\\ slash/",
+    "\b\f\n\r\t",
+    std::string("nul\0byte", 8),
+    "\x01\x1f\x7f",
+    "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x82\xa1",
+};
+
+}  // namespace
+
+// Test: the direct writer is byte-identical to the DOM serializer
+TEST(ProtocolTest, DirectSerializerMatchesDom) {
+  constexpr int64_t min64 = std::numeric_limits<int64_t>::min();
+  constexpr int64_t max64 = std::numeric_limits<int64_t>::max();
+
+  for (const auto& s : awkward_strings) {
+    SCOPED_TRACE(s);
+
+    state_update_message full;
+    full.game_phase = s;
+    full.pot_size = max64;
+    full.current_bet = min64;
+    full.player_stacks = {{0, 100}, {-1, -5}, {std::numeric_limits<int>::max(), 0}};
+    full.community_cards = std::vector<std::string>{"Ah", s, "Td"};
+    full.hole_cards = std::vector<std::string>{};
+    full.valid_actions = {"FOLD", s};
+    full.acting_seat = std::numeric_limits<int>::min();
+    EXPECT_EQ(serialize_state_update(full), dom_serialize(full, message_types::STATE_UPDATE));
+
+    state_update_message bare;
+    bare.game_phase = s;
+    bare.pot_size = 0;
+    bare.current_bet = 7;
+    EXPECT_EQ(serialize_state_update(bare), dom_serialize(bare, message_types::STATE_UPDATE));
+
+    error_message err{"MALFORMED_MESSAGE", s, std::nullopt};
+    EXPECT_EQ(serialize_error(err), dom_serialize(err, message_types::ERROR));
+    err.session_id = s;
+    EXPECT_EQ(serialize_error(err), dom_serialize(err, message_types::ERROR));
+
+    handshake_response hs{s, -1, max64, std::nullopt};
+    EXPECT_EQ(serialize_handshake_response(hs), dom_serialize(hs, message_types::HANDSHAKE_RESPONSE));
+    hs.encoding = s;
+    EXPECT_EQ(serialize_handshake_response(hs), dom_serialize(hs, message_types::HANDSHAKE_RESPONSE));
+  }
+
+  for (bool granted : {true, false}) {
+    reload_response_message reload{granted, -42};
+    EXPECT_EQ(serialize_reload_response(reload), dom_serialize(reload, message_types::RELOAD_RESPONSE));
+  }
+}
+
+// Test: the writer appends, so one buffer can be reused across messages
+TEST(ProtocolTest, DirectSerializerAppendsToBuffer) {
+  reload_response_message reload{true, 5};
+  std::string buffer = "prefix";
+  write_reload_response(buffer, reload);
+  EXPECT_EQ(buffer, "prefix" + serialize_reload_response(reload));
+
+  buffer.clear();
+  write_reload_response(buffer, reload);
+  EXPECT_EQ(buffer, serialize_reload_response(reload));
+}
+
+// Test: invalid UTF-8 fails exactly as nlohmann::json::dump() does
+TEST(ProtocolTest, DirectSerializerRejectsInvalidUtf8LikeDom) {
+  for (const std::string bad : {"\xff", "a\xc3", "\xc0\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80"}) {
+    error_message err{"PROTOCOL_ERROR", bad, std::nullopt};
+    std::string dom_what;
+    try {
+      (void)dom_serialize(err, message_types::ERROR);
+    } catch (const nlohmann::json::type_error& e) {
+      dom_what = e.what();
+    }
+    ASSERT_FALSE(dom_what.empty());
+    try {
+      (void)serialize_error(err);
+      ADD_FAILURE() << "expected type_error";
+    } catch (const nlohmann::json::type_error& e) {
+      EXPECT_EQ(std::string(e.what()), dom_what);
+    }
+  }
+}
+
+// Test: every message round-trips through CBOR and MessagePack
+TEST(ProtocolTest, BinaryEncodingsRoundTrip) {
+  for (const auto encoding : {wire_encoding::cbor, wire_encoding::msgpack}) {
+    SCOPED_TRACE(wire_encoding_name(encoding));
+    ASSERT_EQ(parse_wire_encoding(wire_encoding_name(encoding)), encoding);
+
+    state_update_message update;
+    update.game_phase = "FLOP";
+    update.pot_size = 1500;
+    update.current_bet = 200;
+    update.player_stacks = {{0, 1000}, {1, 2000}};
+    update.community_cards = std::vector<std::string>{"Ah", "Kd", "7c"};
+    update.valid_actions = {"FOLD", "CALL"};
+    const auto update_bytes = serialize_state_update(update, encoding);
+    const std::string json_text = serialize_state_update(update);
+    EXPECT_LT(update_bytes.size(), json_text.size());
+    // Same envelope as the JSON text.
+    auto header = extract_message_type_and_json(update_bytes, encoding);
+    ASSERT_TRUE(header.has_value());
+    EXPECT_EQ(header->message_type, message_types::STATE_UPDATE);
+    EXPECT_EQ(header->envelope_json, nlohmann::json::parse(json_text));
+
+    const auto error_bytes = serialize_error({"PROTOCOL_ERROR", "bad", std::string("sess_a")}, encoding);
+    EXPECT_EQ(extract_message_type(error_bytes).value_or(""), "");  // not JSON text
+    EXPECT_EQ(extract_message_type_and_json(error_bytes, encoding)->envelope_json,
+              nlohmann::json::parse(serialize_error({"PROTOCOL_ERROR", "bad", std::string("sess_a")})));
+
+    nlohmann::json action_env = {
+        {"message_type", message_types::ACTION},
+        {"protocol_version", PROTOCOL_VERSION},
+        {"payload", {{"session_id", "sess_0123456789abcdef"}, {"action_type", "RAISE"}, {"amount", 300},
+                     {"sequence_number", 4}}}};
+    std::string action_bytes;
+    if (encoding == wire_encoding::cbor) {
+      nlohmann::json::to_cbor(action_env, action_bytes);
+    } else {
+      nlohmann::json::to_msgpack(action_env, action_bytes);
+    }
+    auto action = parse_action(action_bytes, encoding);
+    ASSERT_TRUE(action.has_value());
+    EXPECT_EQ(action->amount, 300);
+    EXPECT_EQ(action->sequence_number, 4);
+
+    // Truncated documents are rejected without throwing.
+    EXPECT_NO_THROW(EXPECT_FALSE(parse_action(action_bytes.substr(0, action_bytes.size() / 2), encoding)));
+  }
+  EXPECT_FALSE(parse_wire_encoding("CBOR").has_value());
+}
+
+// Test: handshake negotiation fields are optional on both sides
+TEST(ProtocolTest, HandshakeEncodingField) {
+  auto plain = parse_handshake(R"({"message_type":"HANDSHAKE","protocol_version":"v1.0","payload":{"protocol_version":"v1.0"}})");
+  ASSERT_TRUE(plain.has_value());
+  EXPECT_FALSE(plain->encoding.has_value());
+
+  auto cbor = parse_handshake(
+      R"({"message_type":"HANDSHAKE","protocol_version":"v1.0","payload":{"protocol_version":"v1.0","encoding":"cbor"}})");
+  ASSERT_TRUE(cbor.has_value());
+  EXPECT_EQ(cbor->encoding, std::optional<std::string>("cbor"));
+
+  const std::string long_name(64, 'x');
+  EXPECT_FALSE(parse_handshake(R"({"message_type":"HANDSHAKE","protocol_version":"v1.0","payload":{"protocol_version":"v1.0","encoding":")" +
+                               long_name + "\"}}")
+                   .has_value());
+
+  handshake_response resp{"sess_a", 1, 100, std::nullopt};
+  EXPECT_EQ(serialize_handshake_response(resp).find("encoding"), std::string::npos);
+  resp.encoding = encodings::MSGPACK;
+  EXPECT_NE(serialize_handshake_response(resp).find(R"("encoding":"msgpack")"), std::string::npos);
+}
+
+// Test: the direct CBOR / MessagePack writers match nlohmann's encoders byte for byte
+TEST(ProtocolTest, DirectBinarySerializerMatchesDom) {
+  const std::vector<int64_t> integers = {0, 1, 23, 24, 127, 128, 255, 256, 65535, 65536, 4294967295LL,
+                                         4294967296LL, std::numeric_limits<int64_t>::max(),
+                                         -1, -24, -25, -32, -33, -128, -129, -256, -257, -32768, -32769,
+                                         -65536, -65537, -2147483648LL, -2147483649LL,
+                                         std::numeric_limits<int64_t>::min()};
+  const std::vector<size_t> lengths = {0, 23, 24, 31, 32, 255, 256, 65535, 65536};
+
+  for (const auto encoding : {wire_encoding::cbor, wire_encoding::msgpack}) {
+    SCOPED_TRACE(wire_encoding_name(encoding));
+    for (const int64_t v : integers) {
+      SCOPED_TRACE(v);
+      reload_response_message reload{v < 0, v};
+      EXPECT_EQ(serialize_reload_response(reload, encoding),
+                dom_serialize(reload, message_types::RELOAD_RESPONSE, encoding));
+    }
+    for (const size_t n : lengths) {
+      SCOPED_TRACE(n);
+      error_message err{"E", std::string(n, 'x'), std::string("sess_a")};
+      EXPECT_EQ(serialize_error(err, encoding), dom_serialize(err, message_types::ERROR, encoding));
+
+      state_update_message update;
+      update.game_phase = "RIVER";
+      update.pot_size = static_cast<int64_t>(n);
+      update.current_bet = -static_cast<int64_t>(n);
+      for (size_t i = 0; i < std::min<size_t>(n, 300); ++i) {
+        update.player_stacks.push_back({static_cast<int>(i), static_cast<int64_t>(i) * 1000});
+      }
+      update.valid_actions.assign(std::min<size_t>(n, 20), "CALL");
+      update.hole_cards = std::vector<std::string>{"Ah", "Kd"};
+      update.acting_seat = -1;
+      EXPECT_EQ(serialize_state_update(update, encoding),
+                dom_serialize(update, message_types::STATE_UPDATE, encoding));
+    }
+    for (const auto& s : awkward_strings) {
+      error_message err{"E", s, std::nullopt};
+      EXPECT_EQ(serialize_error(err, encoding), dom_serialize(err, message_types::ERROR, encoding));
+    }
+  }
+}
+
+namespace {
+
+state_update_message sample_state() {
+  state_update_message s;
+  s.game_phase = "FLOP";
+  s.pot_size = 300;
+  s.current_bet = 50;
+  s.player_stacks = {{0, 1000}, {1, 950}, {2, 700}};
+  s.community_cards = std::vector<std::string>{"Ah", "Kd", "7c"};
+  s.hole_cards = std::vector<std::string>{"Qs", "Qh"};
+  s.valid_actions = {"FOLD", "CALL", "RAISE"};
+  s.acting_seat = 1;
+  return s;
+}
+
+}  // namespace
+
+TEST(ProtocolTest, StateDeltaRoundTrip) {
+  const auto base = sample_state();
+
+  auto next = base;
+  next.game_phase = "TURN";
+  next.pot_size = 400;
+  next.player_stacks = {{0, 1000}, {1, 900}, {3, 500}};  // seat 1 changed, 2 left, 3 joined
+  next.community_cards->push_back("2s");
+  next.hole_cards.reset();
+  next.acting_seat = 3;
+  next.state_sequence = 8;
+
+  auto delta = make_state_delta(base, next);
+  delta.state_sequence = 8;
+  delta.base_sequence = 7;
+  EXPECT_FALSE(delta.current_bet.has_value());
+  EXPECT_FALSE(delta.valid_actions.has_value());
+  ASSERT_EQ(delta.player_stacks.size(), 2u);
+  EXPECT_EQ(delta.player_stacks[0].seat, 1);
+  EXPECT_EQ(delta.player_stacks[1].seat, 3);
+  EXPECT_EQ(delta.removed_seats, std::vector<int>{2});
+  EXPECT_EQ(delta.cleared, std::vector<std::string>{"hole_cards"});
+
+  // The client side: decode the wire form and apply it to its copy of base.
+  for (const auto encoding : {wire_encoding::json, wire_encoding::cbor, wire_encoding::msgpack}) {
+    SCOPED_TRACE(wire_encoding_name(encoding));
+    auto header = extract_message_type_and_json(serialize_state_delta(delta, encoding), encoding);
+    ASSERT_TRUE(header.has_value());
+    EXPECT_EQ(header->message_type, message_types::STATE_DELTA);
+    state_delta_message received{};
+    from_json(header->envelope_json.at("payload"), received);
+    EXPECT_EQ(received.base_sequence, 7);
+
+    auto rebuilt = base;
+    apply_state_delta(rebuilt, received);
+    std::sort(rebuilt.player_stacks.begin(), rebuilt.player_stacks.end(),
+              [](const player_stack& a, const player_stack& b) { return a.seat < b.seat; });
+    EXPECT_EQ(serialize_state_update(rebuilt), serialize_state_update(next));
+  }
+
+  // Nothing changed: only the sequence numbers go out.
+  const auto empty = make_state_delta(base, base);
+  EXPECT_EQ(serialize_state_delta(empty),
+            R"({"message_type":"STATE_DELTA","payload":{"base_sequence":0,"state_sequence":0},"protocol_version":"v1.0"})");
+}
+
+TEST(ProtocolTest, StateDeltaSerializerMatchesDom) {
+  auto update = sample_state();
+  update.state_sequence = 42;
+
+  state_delta_message delta{};
+  delta.state_sequence = std::numeric_limits<int64_t>::max();
+  delta.base_sequence = 41;
+  delta.game_phase = "RIVER";
+  delta.pot_size = 0;
+  delta.current_bet = -1;
+  delta.player_stacks = {{4, 10}, {5, 0}};
+  delta.removed_seats = {0, 7};
+  delta.community_cards = std::vector<std::string>{};
+  delta.hole_cards = std::vector<std::string>{"2c", "\xC3\xA9"};
+  delta.valid_actions = std::vector<std::string>{"CHECK"};
+  delta.acting_seat = 5;
+  delta.cleared = {"acting_seat"};
+
+  state_delta_message minimal{};
+  minimal.state_sequence = 3;
+  minimal.base_sequence = 1;
+
+  for (const auto encoding : {wire_encoding::json, wire_encoding::cbor, wire_encoding::msgpack}) {
+    SCOPED_TRACE(wire_encoding_name(encoding));
+    EXPECT_EQ(serialize_state_update(update, encoding),
+              dom_serialize(update, message_types::STATE_UPDATE, encoding));
+    EXPECT_EQ(serialize_state_delta(delta, encoding), dom_serialize(delta, message_types::STATE_DELTA, encoding));
+    EXPECT_EQ(serialize_state_delta(minimal, encoding),
+              dom_serialize(minimal, message_types::STATE_DELTA, encoding));
+  }
+}
+
+TEST(ProtocolTest, ParseStateAck) {
+  const auto make = [](const nlohmann::json& payload) {
+    message_envelope env;
+    env.message_type = message_types::STATE_ACK;
+    env.protocol_version = PROTOCOL_VERSION;
+    env.payload = payload;
+    nlohmann::json j;
+    to_json(j, env);
+    return j.dump();
+  };
+
+  auto ack = parse_state_ack(make({{"session_id", "sess_cafed00dcafebabe"}, {"state_sequence", 12}}));
+  ASSERT_TRUE(ack.has_value());
+  EXPECT_EQ(ack->state_sequence, 12);
+  EXPECT_FALSE(ack->resync);
+
+  ack = parse_state_ack(make({{"session_id", "sess_cafed00dcafebabe"}, {"state_sequence", 0}, {"resync", true}}));
+  ASSERT_TRUE(ack.has_value());
+  EXPECT_TRUE(ack->resync);
+
+  EXPECT_FALSE(parse_state_ack(make({{"session_id", "sess_cafed00dcafebabe"}, {"state_sequence", -1}})));
+  EXPECT_FALSE(parse_state_ack(make({{"session_id", "bogus"}, {"state_sequence", 1}})));
+  EXPECT_FALSE(parse_state_ack(make({{"session_id", "sess_cafed00dcafebabe"}})));
+}
+
+TEST(ProtocolTest, MessageAndActionKindLookup) {
+  static_assert(lookup_message_kind("ACTION") == message_kind::action);
+  static_assert(lookup_action_kind("ALL_IN") == action_kind::all_in);
+  static_assert(lookup_message_kind("ACTIONS") == message_kind::unknown);
+
+  for (size_t i = 0; i < static_cast<size_t>(message_kind::unknown); ++i) {
+    const auto kind = static_cast<message_kind>(i);
+    const std::string name(message_kind_name(kind));
+    SCOPED_TRACE(name);
+    EXPECT_FALSE(name.empty());
+    EXPECT_EQ(lookup_message_kind(name), kind);
+  }
+  EXPECT_EQ(message_kind_name(message_kind::action), message_types::ACTION);
+  EXPECT_EQ(message_kind_name(message_kind::unknown), "");
+
+  for (const char* name : {action_types::FOLD, action_types::CHECK, action_types::CALL, action_types::RAISE,
+                           action_types::ALL_IN}) {
+    EXPECT_EQ(action_kind_name(lookup_action_kind(name)), name);
+  }
+  EXPECT_TRUE(action_requires_amount(action_kind::raise));
+  EXPECT_FALSE(action_requires_amount(action_kind::call));
+
+  // Near misses share length and the hashed bytes with a real name.
+  for (const char* name : {"", "A", "action", "ACTIOn", "AXTION", "HANDSHAKE_RESPONSEX", "STATE_ACX", "FOLDS",
+                           "CALLL", "RAIZE", "ALL-IN"}) {
+    SCOPED_TRACE(name);
+    EXPECT_EQ(lookup_message_kind(name), message_kind::unknown);
+    EXPECT_EQ(lookup_action_kind(name), action_kind::unknown);
+  }
+
+  EXPECT_TRUE(validation::is_valid_message_type("ACTION", {message_kind::action, message_kind::disconnect}));
+  EXPECT_FALSE(validation::is_valid_message_type("ACTION", {message_kind::disconnect}));
+  EXPECT_FALSE(validation::is_valid_message_type("BOGUS", {message_kind::unknown}));
+}
+
+TEST(ProtocolTest, ParsersSetActionKind) {
+  const std::string raise =
+      R"({"message_type":"ACTION","protocol_version":"v1.0","payload":)"
+      R"({"session_id":"sess_cafed00dcafebabe","action_type":"RAISE","amount":500,"sequence_number":1}})";
+  auto header = extract_message_type_and_json(raise);
+  ASSERT_TRUE(header.has_value());
+  EXPECT_EQ(header->kind, message_kind::action);
+
+  auto dom = parse_action(raise);
+  ASSERT_TRUE(dom.has_value());
+  EXPECT_EQ(dom->kind, action_kind::raise);
+
+  action_message fast{};
+  ASSERT_EQ(parse_action_fast(raise, fast), fast_parse_status::ok);
+  EXPECT_EQ(fast.kind, action_kind::raise);
+}
+
+namespace {
+
+nlohmann::json inner_envelope(const char* type, nlohmann::json payload) {
+  return nlohmann::json{{"message_type", type}, {"protocol_version", PROTOCOL_VERSION}, {"payload", std::move(payload)}};
+}
+
+std::string batch_frame(nlohmann::json messages) {
+  return inner_envelope(message_types::BATCH,
+                        {{"session_id", "sess_cafed00dcafebabe"}, {"messages", std::move(messages)}})
+      .dump();
+}
+
+}  // namespace
+
+TEST(ProtocolTest, ParseBatch) {
+  const auto fold = inner_envelope(message_types::ACTION, {{"session_id", "sess_cafed00dcafebabe"},
+                                                           {"action_type", "FOLD"},
+                                                           {"sequence_number", 1}});
+  const auto reload = inner_envelope(message_types::RELOAD_REQUEST,
+                                     {{"session_id", "sess_cafed00dcafebabe"}, {"requested_amount", 100}});
+
+  auto batch = parse_batch(batch_frame({fold, reload}));
+  ASSERT_TRUE(batch.has_value());
+  EXPECT_EQ(batch->session_id, "sess_cafed00dcafebabe");
+  ASSERT_EQ(batch->messages.size(), 2u);
+  EXPECT_EQ(batch->messages[0].kind, message_kind::action);
+  EXPECT_EQ(batch->messages[1].kind, message_kind::reload_request);
+  auto action = parse_action_from_envelope(batch->messages[0].envelope_json);
+  ASSERT_TRUE(action.has_value());
+  EXPECT_EQ(action->kind, action_kind::fold);
+
+  // Binary encodings carry the same structure.
+  const auto cbor = nlohmann::json::to_cbor(nlohmann::json::parse(batch_frame({fold})));
+  batch = parse_batch(std::string(cbor.begin(), cbor.end()), wire_encoding::cbor);
+  ASSERT_TRUE(batch.has_value());
+  EXPECT_EQ(batch->messages.size(), 1u);
+
+  // Elements are checked only for shape and type here.
+  const auto bad_payload = inner_envelope(message_types::ACTION, {{"action_type", "FOLD"}});
+  EXPECT_TRUE(parse_batch(batch_frame({bad_payload})).has_value());
+
+  EXPECT_FALSE(parse_batch(batch_frame(nlohmann::json::array())));
+  EXPECT_FALSE(parse_batch(batch_frame(std::vector<nlohmann::json>(MAX_BATCH_MESSAGES + 1, fold))));
+  EXPECT_TRUE(parse_batch(batch_frame(std::vector<nlohmann::json>(MAX_BATCH_MESSAGES, fold))));
+  EXPECT_FALSE(parse_batch(batch_frame(fold)));  // not an array
+  EXPECT_FALSE(parse_batch(batch_frame({42})));
+  EXPECT_FALSE(parse_batch(batch_frame({inner_envelope(message_types::BATCH, {})})));
+  EXPECT_FALSE(parse_batch(batch_frame({inner_envelope(message_types::HANDSHAKE, {})})));
+  EXPECT_FALSE(parse_batch(batch_frame({inner_envelope("BOGUS", {})})));
+  EXPECT_FALSE(parse_batch(
+      inner_envelope(message_types::BATCH, {{"session_id", "nope"}, {"messages", {fold}}}).dump()));
+  EXPECT_FALSE(parse_batch(inner_envelope(message_types::ACTION, {{"messages", {fold}}}).dump()));
+  EXPECT_FALSE(parse_batch("not json"));
+}
+
+TEST(ProtocolTest, SerializeBatchMatchesDom) {
+  for (const auto encoding : {wire_encoding::json, wire_encoding::cbor, wire_encoding::msgpack}) {
+    SCOPED_TRACE(wire_encoding_name(encoding));
+    const std::vector<std::string> replies = {serialize_reload_response({true, 600}, encoding),
+                                              serialize_error({"E", "boom", std::nullopt}, encoding)};
+
+    const auto decode = [encoding](const std::string& bytes) {
+      if (encoding == wire_encoding::cbor) return nlohmann::json::from_cbor(bytes);
+      if (encoding == wire_encoding::msgpack) return nlohmann::json::from_msgpack(bytes);
+      return nlohmann::json::parse(bytes);
+    };
+    nlohmann::json messages = nlohmann::json::array();
+    for (const auto& r : replies) messages.push_back(decode(r));
+    nlohmann::json expected{{"message_type", message_types::BATCH},
+                            {"protocol_version", PROTOCOL_VERSION},
+                            {"payload", {{"messages", messages}}}};
+
+    const auto bytes = serialize_batch(replies, encoding);
+    EXPECT_EQ(decode(bytes), expected);
+    std::string appended = "x";
+    write_batch(appended, replies, encoding);
+    EXPECT_EQ(appended, "x" + bytes);
+  }
+  EXPECT_EQ(serialize_batch({}), R"({"message_type":"BATCH","payload":{"messages":[]},"protocol_version":"v1.0"})");
+}
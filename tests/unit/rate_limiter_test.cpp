@@ -0,0 +1,61 @@
+#include "server/rate_limiter.hpp"
+
+#include <gtest/gtest.h>
+#include <chrono>
+
+using cppsim::server::gcra_rate_limiter;
+using cppsim::server::message_cost_table;
+using namespace std::chrono_literals;
+
+TEST(RateLimiterTest, AllowsBurstUpToLimit) {
+    gcra_rate_limiter limiter;
+    limiter.configure(10, 1s);
+    const auto now = gcra_rate_limiter::clock::now();
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(limiter.try_acquire(1, now)) << "message " << i;
+    }
+    EXPECT_FALSE(limiter.try_acquire(1, now));
+    // A rejected request is not charged.
+    EXPECT_FALSE(limiter.try_acquire(1, now));
+}
+
+TEST(RateLimiterTest, RefillsAtSteadyRate) {
+    gcra_rate_limiter limiter;
+    limiter.configure(10, 1s);
+    auto now = gcra_rate_limiter::clock::now();
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(limiter.try_acquire(1, now));
+    }
+    ASSERT_FALSE(limiter.try_acquire(1, now));
+
+    // One emission interval (window / limit) frees exactly one unit.
+    now += 100ms;
+    EXPECT_TRUE(limiter.try_acquire(1, now));
+    EXPECT_FALSE(limiter.try_acquire(1, now));
+
+    // A full idle window restores the whole burst.
+    now += 1s;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(limiter.try_acquire(1, now));
+    }
+}
+
+TEST(RateLimiterTest, ChargesWeightedCosts) {
+    gcra_rate_limiter limiter;
+    limiter.configure(10, 1s);
+    const auto now = gcra_rate_limiter::clock::now();
+    EXPECT_TRUE(limiter.try_acquire(4, now));
+    EXPECT_TRUE(limiter.try_acquire(4, now));
+    EXPECT_FALSE(limiter.try_acquire(4, now));  // Would need 12 units.
+    EXPECT_TRUE(limiter.try_acquire(2, now));
+    EXPECT_TRUE(limiter.try_acquire(0, now));   // Zero cost is always free.
+    EXPECT_FALSE(limiter.try_acquire(1, now));
+}
+
+TEST(RateLimiterTest, CostTableLookup) {
+    message_cost_table costs;
+    costs.reload_request = 3;
+    EXPECT_EQ(costs.cost_for(cppsim::protocol::message_types::RELOAD_REQUEST), 3u);
+    EXPECT_EQ(costs.cost_for(cppsim::protocol::message_types::ACTION), 1u);
+    EXPECT_EQ(costs.cost_for("SOMETHING_ELSE"), 1u);
+}
@@ -0,0 +1,39 @@
+#include "server/session_handle.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace cppsim::server;
+
+TEST(SessionHandleTest, FormatAndParseRoundTrip) {
+    const session_handle handle = 0x0123456789abcdefULL;
+    const std::string id = format_session_id(handle);
+    EXPECT_EQ(id, "sess_0123456789abcdef");
+    EXPECT_EQ(id.size(), SESSION_ID_LENGTH);
+    EXPECT_EQ(parse_session_id(id), handle);
+
+    EXPECT_EQ(parse_session_id(format_session_id(~session_handle{0})), ~session_handle{0});
+    EXPECT_EQ(parse_session_id(format_session_id(1)), 1u);
+}
+
+TEST(SessionHandleTest, InvalidHandleFormatsEmpty) {
+    EXPECT_TRUE(format_session_id(INVALID_SESSION_HANDLE).empty());
+    EXPECT_EQ(parse_session_id("sess_0000000000000000"), INVALID_SESSION_HANDLE);
+}
+
+TEST(SessionHandleTest, RejectsMalformedIds) {
+    EXPECT_EQ(parse_session_id(""), INVALID_SESSION_HANDLE);
+    EXPECT_EQ(parse_session_id("sess_"), INVALID_SESSION_HANDLE);
+    EXPECT_EQ(parse_session_id("sess_nonexistent"), INVALID_SESSION_HANDLE);
+    EXPECT_EQ(parse_session_id("sess_0123456789abcde"), INVALID_SESSION_HANDLE);    // too short
+    EXPECT_EQ(parse_session_id("sess_0123456789abcdef0"), INVALID_SESSION_HANDLE);  // too long
+    EXPECT_EQ(parse_session_id("sess_0123456789ABCDEF"), INVALID_SESSION_HANDLE);   // uppercase
+    EXPECT_EQ(parse_session_id("ssss_0123456789abcdef"), INVALID_SESSION_HANDLE);
+    EXPECT_EQ(parse_session_id("sess_0123456789abcdeg"), INVALID_SESSION_HANDLE);
+}
+
+TEST(SessionHandleTest, ParsesAtCompileTime) {
+    static_assert(parse_session_id("sess_00000000000000ff") == 0xff);
+    static_assert(format_session_id_chars(0xff)[SESSION_ID_LENGTH - 1] == 'f');
+    SUCCEED();
+}
@@ -0,0 +1,104 @@
+#include "server/session_registry.hpp"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using registry = cppsim::server::session_registry<std::string, std::shared_ptr<int>>;
+
+}  // namespace
+
+TEST(SessionRegistryTest, InsertFindErase) {
+    registry reg(10, 4);
+    EXPECT_EQ(reg.shard_count(), 4u);
+
+    auto value = std::make_shared<int>(7);
+    ASSERT_EQ(reg.try_insert("sess_a", std::move(value)), registry::insert_result::inserted);
+    EXPECT_EQ(value, nullptr);
+    EXPECT_EQ(reg.size(), 1u);
+    ASSERT_NE(reg.find("sess_a"), nullptr);
+    EXPECT_EQ(*reg.find("sess_a"), 7);
+    EXPECT_EQ(reg.find("sess_b"), nullptr);
+
+    EXPECT_TRUE(reg.erase("sess_a"));
+    EXPECT_FALSE(reg.erase("sess_a"));
+    EXPECT_EQ(reg.size(), 0u);
+}
+
+TEST(SessionRegistryTest, CollisionLeavesValueAndCountUntouched) {
+    registry reg(10, 4);
+    auto first = std::make_shared<int>(1);
+    ASSERT_EQ(reg.try_insert("sess_a", std::move(first)), registry::insert_result::inserted);
+
+    auto second = std::make_shared<int>(2);
+    EXPECT_EQ(reg.try_insert("sess_a", std::move(second)), registry::insert_result::collision);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(*second, 2);
+    EXPECT_EQ(reg.size(), 1u);
+    EXPECT_EQ(*reg.find("sess_a"), 1);
+}
+
+TEST(SessionRegistryTest, ShardCountRoundsUpToPowerOfTwo) {
+    EXPECT_EQ(registry(1, 0).shard_count(), 1u);
+    EXPECT_EQ(registry(1, 5).shard_count(), 8u);
+    EXPECT_EQ(registry(1, 64).shard_count(), 64u);
+}
+
+TEST(SessionRegistryTest, DrainRemovesEverything) {
+    registry reg(100, 8);
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_EQ(reg.try_insert("sess_" + std::to_string(i), std::make_shared<int>(i)),
+                  registry::insert_result::inserted);
+    }
+    EXPECT_EQ(reg.keys().size(), 50u);
+
+    int visited = 0;
+    EXPECT_EQ(reg.drain([&visited](const std::string&, const std::shared_ptr<int>&) { ++visited; }), 50u);
+    EXPECT_EQ(visited, 50);
+    EXPECT_EQ(reg.size(), 0u);
+    EXPECT_TRUE(reg.keys().empty());
+}
+
+TEST(SessionRegistryTest, CapacityIsExactUnderConcurrentInserts) {
+    static constexpr size_t CAPACITY = 100;
+    constexpr int THREADS = 8;
+    static constexpr int PER_THREAD = 50;
+    registry reg(CAPACITY, 16);
+
+    std::atomic<size_t> inserted{0};
+    std::atomic<size_t> rejected{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&reg, &inserted, &rejected, t]() {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                auto key = "sess_" + std::to_string(t) + "_" + std::to_string(i);
+                auto result = reg.try_insert(key, std::make_shared<int>(i));
+                if (result == registry::insert_result::inserted) {
+                    ++inserted;
+                } else {
+                    EXPECT_EQ(result, registry::insert_result::full);
+                    ++rejected;
+                }
+                EXPECT_LE(reg.size(), CAPACITY);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    EXPECT_EQ(inserted.load(), CAPACITY);
+    EXPECT_EQ(rejected.load(), THREADS * PER_THREAD - CAPACITY);
+    EXPECT_EQ(reg.size(), CAPACITY);
+    EXPECT_EQ(reg.keys().size(), CAPACITY);
+
+    // A freed slot is immediately reusable.
+    auto victim = reg.keys().front();
+    EXPECT_TRUE(reg.erase(victim));
+    EXPECT_EQ(reg.try_insert("sess_new", std::make_shared<int>(0)), registry::insert_result::inserted);
+    EXPECT_EQ(reg.try_insert("sess_newer", std::make_shared<int>(0)), registry::insert_result::full);
+}
@@ -0,0 +1,105 @@
+#include "server/state_delta_tracker.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+
+using cppsim::protocol::state_update_message;
+using cppsim::protocol::wire_encoding;
+using cppsim::server::state_delta_tracker;
+
+namespace {
+
+state_update_message make_state(int64_t pot) {
+    state_update_message s;
+    s.game_phase = "PREFLOP";
+    s.pot_size = pot;
+    s.current_bet = 10;
+    s.player_stacks = {{0, 1000}, {1, 1000}};
+    s.valid_actions = {"FOLD", "CALL"};
+    return s;
+}
+
+bool is_delta(const std::string& payload) {
+    return payload.find("\"STATE_DELTA\"") != std::string::npos;
+}
+
+}  // namespace
+
+TEST(StateDeltaTrackerTest, KeyframesUntilAcknowledged) {
+    state_delta_tracker tracker(32, 16);
+
+    for (int64_t i = 1; i <= 3; ++i) {
+        const auto out = tracker.encode(make_state(i), wire_encoding::json);
+        EXPECT_TRUE(out.keyframe);
+        EXPECT_EQ(out.state_sequence, i);
+        EXPECT_NE(out.payload.find("\"state_sequence\":" + std::to_string(i)), std::string::npos);
+    }
+    EXPECT_EQ(tracker.baseline_sequence(), -1);
+}
+
+TEST(StateDeltaTrackerTest, DeltasAgainstAcknowledgedBaseline) {
+    state_delta_tracker tracker(32, 16);
+    ASSERT_TRUE(tracker.encode(make_state(1), wire_encoding::json).keyframe);
+    (void)tracker.encode(make_state(2), wire_encoding::json);
+
+    ASSERT_TRUE(tracker.acknowledge(1));
+    EXPECT_EQ(tracker.baseline_sequence(), 1);
+
+    const auto out = tracker.encode(make_state(3), wire_encoding::json);
+    EXPECT_FALSE(out.keyframe);
+    ASSERT_TRUE(is_delta(out.payload));
+    EXPECT_NE(out.payload.find("\"base_sequence\":1"), std::string::npos);
+    EXPECT_NE(out.payload.find("\"pot_size\":3"), std::string::npos);
+    // Unchanged fields stay off the wire.
+    EXPECT_EQ(out.payload.find("player_stacks"), std::string::npos);
+
+    // Acks only move forward; a late one for an older state is ignored.
+    ASSERT_TRUE(tracker.acknowledge(2));
+    EXPECT_TRUE(tracker.acknowledge(1));
+    EXPECT_EQ(tracker.baseline_sequence(), 2);
+}
+
+TEST(StateDeltaTrackerTest, KeyframeInterval) {
+    state_delta_tracker tracker(4, 16);
+    (void)tracker.encode(make_state(0), wire_encoding::json);
+    ASSERT_TRUE(tracker.acknowledge(1));
+
+    int keyframes = 0;
+    for (int64_t i = 1; i <= 8; ++i) {
+        if (tracker.encode(make_state(i), wire_encoding::json).keyframe) ++keyframes;
+    }
+    EXPECT_EQ(keyframes, 2);
+}
+
+TEST(StateDeltaTrackerTest, UnknownAckDropsBaseline) {
+    state_delta_tracker tracker(32, 2);
+    (void)tracker.encode(make_state(1), wire_encoding::json);
+    ASSERT_TRUE(tracker.acknowledge(1));
+
+    EXPECT_FALSE(tracker.acknowledge(99));
+    EXPECT_EQ(tracker.baseline_sequence(), -1);
+    EXPECT_TRUE(tracker.encode(make_state(2), wire_encoding::json).keyframe);
+
+    // The baseline also goes once it ages out of the pending window.
+    ASSERT_TRUE(tracker.acknowledge(2));
+    EXPECT_FALSE(tracker.encode(make_state(3), wire_encoding::json).keyframe);
+    EXPECT_FALSE(tracker.encode(make_state(4), wire_encoding::json).keyframe);
+    EXPECT_EQ(tracker.baseline_sequence(), -1);
+    EXPECT_TRUE(tracker.encode(make_state(5), wire_encoding::json).keyframe);
+}
+
+TEST(StateDeltaTrackerTest, ResyncResendsLatestAsKeyframe) {
+    state_delta_tracker tracker(32, 16);
+    EXPECT_FALSE(tracker.resync(wire_encoding::json).has_value());
+
+    (void)tracker.encode(make_state(1), wire_encoding::json);
+    ASSERT_TRUE(tracker.acknowledge(1));
+    (void)tracker.encode(make_state(2), wire_encoding::json);
+
+    const auto out = tracker.resync(wire_encoding::cbor);
+    ASSERT_TRUE(out.has_value());
+    EXPECT_TRUE(out->keyframe);
+    EXPECT_EQ(out->state_sequence, 3);
+    EXPECT_EQ(tracker.baseline_sequence(), -1);
+}
@@ -0,0 +1,120 @@
+#include "server/timer_wheel.hpp"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+using cppsim::server::timer_wheel;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Small ticks keep the tests fast; 4 slots forces multi-revolution entries.
+std::shared_ptr<timer_wheel> make_wheel(boost::asio::io_context& ioc, size_t slots = 64) {
+    auto wheel = std::make_shared<timer_wheel>(ioc, 10ms, slots);
+    wheel->start();
+    return wheel;
+}
+
+}  // namespace
+
+TEST(TimerWheelTest, FiresAfterDeadline) {
+    boost::asio::io_context ioc;
+    auto wheel = make_wheel(ioc);
+    std::atomic<int> fired{0};
+    auto t = wheel->make_timer([&fired]() { ++fired; });
+
+    const auto start = std::chrono::steady_clock::now();
+    t->expires_after(50ms);
+    EXPECT_FALSE(t->expired());
+    while (fired == 0 && std::chrono::steady_clock::now() - start < 2s) {
+        ioc.run_for(10ms);
+    }
+    EXPECT_EQ(fired, 1);
+    EXPECT_TRUE(t->expired());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+    wheel->stop();
+}
+
+TEST(TimerWheelTest, ExtendingDeadlineDefersExpiry) {
+    boost::asio::io_context ioc;
+    auto wheel = make_wheel(ioc);
+    std::atomic<int> fired{0};
+    auto t = wheel->make_timer([&fired]() { ++fired; });
+
+    // Keep touching the timer like a chatty session would.
+    t->expires_after(50ms);
+    for (int i = 0; i < 10; ++i) {
+        ioc.run_for(20ms);
+        t->expires_after(50ms);
+    }
+    EXPECT_EQ(fired, 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    while (fired == 0 && std::chrono::steady_clock::now() - start < 2s) {
+        ioc.run_for(10ms);
+    }
+    EXPECT_EQ(fired, 1);
+    wheel->stop();
+}
+
+TEST(TimerWheelTest, ShorteningDeadlineReschedules) {
+    boost::asio::io_context ioc;
+    auto wheel = make_wheel(ioc);
+    std::atomic<int> fired{0};
+    auto t = wheel->make_timer([&fired]() { ++fired; });
+
+    t->expires_after(1h);
+    ioc.run_for(30ms);
+    t->expires_after(20ms);
+
+    const auto start = std::chrono::steady_clock::now();
+    while (fired == 0 && std::chrono::steady_clock::now() - start < 2s) {
+        ioc.run_for(10ms);
+    }
+    EXPECT_EQ(fired, 1);
+    wheel->stop();
+}
+
+TEST(TimerWheelTest, DeadlineBeyondOneRevolution) {
+    boost::asio::io_context ioc;
+    auto wheel = make_wheel(ioc, 4);  // One revolution is 40ms.
+    std::atomic<int> fired{0};
+    auto t = wheel->make_timer([&fired]() { ++fired; });
+
+    const auto start = std::chrono::steady_clock::now();
+    t->expires_after(150ms);
+    while (fired == 0 && std::chrono::steady_clock::now() - start < 2s) {
+        ioc.run_for(10ms);
+    }
+    EXPECT_EQ(fired, 1);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 150ms);
+    wheel->stop();
+}
+
+TEST(TimerWheelTest, CancelAndDestroyPreventExpiry) {
+    boost::asio::io_context ioc;
+    auto wheel = make_wheel(ioc);
+    std::atomic<int> fired{0};
+    auto cancelled = wheel->make_timer([&fired]() { ++fired; });
+    auto destroyed = wheel->make_timer([&fired]() { ++fired; });
+
+    cancelled->expires_after(20ms);
+    destroyed->expires_after(20ms);
+    cancelled->cancel();
+    destroyed.reset();
+
+    ioc.run_for(150ms);
+    EXPECT_EQ(fired, 0);
+    EXPECT_FALSE(cancelled->expired());
+
+    // A cancelled timer can be re-armed.
+    cancelled->expires_after(20ms);
+    const auto start = std::chrono::steady_clock::now();
+    while (fired == 0 && std::chrono::steady_clock::now() - start < 2s) {
+        ioc.run_for(10ms);
+    }
+    EXPECT_EQ(fired, 1);
+    wheel->stop();
+}